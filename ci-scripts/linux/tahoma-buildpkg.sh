@@ -85,6 +85,7 @@ export LD_LIBRARY_PATH=appdir/usr/lib/tahoma2d
    -executable=appdir/usr/bin/tcleanup \
    -executable=appdir/usr/bin/tcomposer \
    -executable=appdir/usr/bin/tconverter \
+   -executable=appdir/usr/bin/tvectorizer \
    -executable=appdir/usr/bin/tfarmcontroller \
    -executable=appdir/usr/bin/tfarmserver 
 
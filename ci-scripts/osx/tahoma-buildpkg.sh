@@ -97,6 +97,7 @@ $QTDIR/bin/macdeployqt $TOONZDIR/Tahoma2D.app -verbose=0 -always-overwrite \
    -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tcleanup \
    -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tcomposer \
    -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tconverter \
+   -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tvectorizer \
    -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tfarmcontroller \
    -executable=$TOONZDIR/Tahoma2D.app/Contents/MacOS/tfarmserver 
 
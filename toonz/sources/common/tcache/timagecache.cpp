@@ -39,6 +39,7 @@
 
 #include "tstream.h"
 #include "tenv.h"
+#include "taliashash.h"
 #include <deque>
 #include <numeric>
 #include <sstream>
@@ -48,6 +49,11 @@
 
 // Qt includes
 #include <QThreadStorage>
+#ifndef TNZCORE_LIGHT
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#endif
 
 //------------------------------------------------------------------------------
 
@@ -66,28 +72,38 @@ class ImageInfo;
 
 // std::ofstream os("C:\\cache.txt");
 
-TUINT32 HistoryCount = 0;
 //------------------------------------------------------------------------------
 
 class TheCodec final : public TRasterCodecLz4 {
+  TThread::Mutex m_mutex;
+
 public:
   static TheCodec *instance() {
-    if (!_instance) _instance = new TheCodec();
+    static TheCodec theInstance;
+    return &theInstance;
+  }
+
+  //! Compresses the specified raster. Compressions share the codec buffer, so
+  //! they are serialized.
+  TRasterP compress(const TRasterP &ras) {
+    TThread::MutexLocker sl(&m_mutex);
 
-    return _instance;
+    TINT32 buffSize = 0;
+    return TRasterCodecLz4::compress(ras, 1, buffSize);
   }
 
   void reset() {
-    if (_instance) _instance->TRasterCodecLz4::reset();
+    // Called on memory shortages, possibly while another thread is compressing
+    if (m_mutex.tryLock()) {
+      TRasterCodecLz4::reset();
+      m_mutex.unlock();
+    }
   }
 
 private:
-  static TheCodec *_instance;
   TheCodec() : TRasterCodecLz4("Lz4_Codec", false) {}
 };
 
-TheCodec *TheCodec::_instance = 0;
-
 //------------------------------------------------------------------------------
 
 class CacheItem : public TSmartObject {
@@ -98,15 +114,18 @@ public:
       , m_builder(0)
       , m_imageInfo(0)
       , m_modified(false)
-      , m_palette(0) {}
+      , m_palette(0)
+      , m_lruPrev(0)
+      , m_lruNext(0) {}
 
   CacheItem(ImageBuilder *builder, ImageInfo *imageInfo, TPalette *palette)
       : m_cantCompress(false)
       , m_builder(builder)
       , m_imageInfo(imageInfo)
-      , m_historyCount(0)
       , m_modified(false)
-      , m_palette(palette) {}
+      , m_palette(palette)
+      , m_lruPrev(0)
+      , m_lruNext(0) {}
 
   virtual ~CacheItem() {}
 
@@ -119,9 +138,11 @@ public:
   ImageBuilder *m_builder;
   ImageInfo *m_imageInfo;
   std::string m_id;
-  TUINT32 m_historyCount;
   bool m_modified;
   TPalette *m_palette;
+
+  // Links in the least recently used list of uncompressed items
+  CacheItem *m_lruPrev, *m_lruNext;
 };
 
 #ifdef _WIN32
@@ -412,9 +433,7 @@ CompressedOnMemoryCacheItem::CompressedOnMemoryCacheItem(const TImageP &img)
   if (ri) {
     m_imageInfo     = new RasterImageInfo(ri);
     m_builder       = new RasterImageBuilder();
-    TINT32 buffSize = 0;
-    m_compressedRas =
-        TheCodec::instance()->compress(ri->getRaster(), 1, buffSize);
+    m_compressedRas = TheCodec::instance()->compress(ri->getRaster());
     m_palette       = img->getPalette();
   }
 #ifndef TNZCORE_LIGHT
@@ -424,9 +443,8 @@ CompressedOnMemoryCacheItem::CompressedOnMemoryCacheItem(const TImageP &img)
       m_imageInfo          = new ToonzImageInfo(ti);
       m_builder            = new ToonzImageBuilder();
       TRasterCM32P rasCM32 = ti->getRaster();
-      TINT32 buffSize      = 0;
-      m_compressedRas = TheCodec::instance()->compress(rasCM32, 1, buffSize);
-      m_palette       = ti->getPalette();
+      m_compressedRas      = TheCodec::instance()->compress(rasCM32);
+      m_palette            = ti->getPalette();
     } else
       assert(false);
   }
@@ -703,32 +721,152 @@ std::string TImageCache::getUniqueId(void) {
   return "IMAGECACHEUNIQUEID" + ss.str();
 }
 
+//------------------------------------------------------------------------------
+
+namespace {
+
+/*
+  A CacheShard is a partition of the image cache, holding the items whose id
+  hash falls in it. Each shard has its own mutex, so threads accessing images
+  of different shards do not wait for each other.
+
+  Deadlocks are avoided with the following rules:
+
+    - A thread may block on a shard mutex only while holding no other shard
+      mutex - except remap(), which locks two shards by increasing address.
+    - Shards are only try-locked when the cache is entered while allocating
+      memory (see TImageCache::compressAndMalloc()).
+    - TImageCache::Imp::m_aliasesMutex is the innermost mutex.
+*/
+
+class CacheShard {
+public:
+  TThread::Mutex m_mutex;
+
+  std::map<TAliasHash, CacheItemP> m_uncompressedItems;
+  std::map<TAliasHash, CacheItemP> m_compressedItems;
+
+  // Uncompressed items, from the least to the most recently used
+  CacheItem *m_lruFirst, *m_lruLast;
+
+public:
+  CacheShard() : m_lruFirst(0), m_lruLast(0) {}
+
+  void lruAppend(CacheItem *item) {
+    item->m_lruPrev = m_lruLast, item->m_lruNext = 0;
+    (m_lruLast ? m_lruLast->m_lruNext : m_lruFirst) = item;
+    m_lruLast                                       = item;
+  }
+
+  void lruRemove(CacheItem *item) {
+    (item->m_lruPrev ? item->m_lruPrev->m_lruNext : m_lruFirst) =
+        item->m_lruNext;
+    (item->m_lruNext ? item->m_lruNext->m_lruPrev : m_lruLast) =
+        item->m_lruPrev;
+    item->m_lruPrev = item->m_lruNext = 0;
+  }
+
+  //! Marks the item as the most recently used.
+  void lruTouch(CacheItem *item) {
+    if (item != m_lruLast) lruRemove(item), lruAppend(item);
+  }
+
+  void setUncompressed(const TAliasHash &key, const CacheItemP &item) {
+    CacheItemP &slot = m_uncompressedItems[key];
+    if (slot) lruRemove(slot.getPointer());
+
+    slot = item;
+    lruAppend(item.getPointer());
+  }
+
+  void eraseUncompressed(std::map<TAliasHash, CacheItemP>::iterator it) {
+    lruRemove(it->second.getPointer());
+    m_uncompressedItems.erase(it);
+  }
+
+  void clear() {
+    m_uncompressedItems.clear();
+    m_compressedItems.clear();
+    m_lruFirst = m_lruLast = 0;
+  }
+};
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+
 class TImageCache::Imp {
 public:
-  Imp() : m_rootDir() {
+  Imp()
+      : m_rootDir()
+#ifndef TNZCORE_LIGHT
+      , m_workRequested(false)
+      , m_quitWorker(false)
+#endif
+  {
     // ATTENZIONE: e' molto piu' veloce se si usa memoria fisica
     // invece che virtuale: la virtuale e' tanta, non c'e' quindi bisogno
     // di comprimere le immagini, che grandi come sono vengono swappate su disco
+    m_hasMemoryStatus = false;
     if (TBigMemoryManager::instance()->isActive()) return;
 
-    m_reservedMemory = (TINT64)(TSystem::getMemorySize(true) * 0.10);
+    TINT64 totalKb, availableKb;
+    m_hasMemoryStatus = TSystem::getPhysicalMemoryStatus(totalKb, availableKb);
+    if (!m_hasMemoryStatus) totalKb = TSystem::getMemorySize(true);
+
+    m_reservedMemory = (TINT64)(totalKb * 0.10);
     if (m_reservedMemory < 64 * 1024) m_reservedMemory = 64 * 1024;
   }
 
-  ~Imp() {
-    if (m_rootDir != TFilePath()) TSystem::rmDirTree(m_rootDir);
-  }
+  ~Imp();
 
-  bool inline notEnoughMemory() {
-    if (TBigMemoryManager::instance()->isActive())
+  /*!
+    Memory usage thresholds. Above the high water mark, a background worker
+    compresses images until usage falls below the low water mark; callers
+    compress synchronously only once memory is exhausted.
+  */
+  enum MemoryLevel { Exhausted, HighWaterMark, LowWaterMark };
+
+  //! Returns true if memory usage exceeds the specified level.
+  bool inline notEnoughMemory(MemoryLevel level = Exhausted) {
+    if (TBigMemoryManager::instance()->isActive()) {
+      static const TUINT32 availableKb[] = {50 * 1024, 100 * 1024,
+                                            150 * 1024};
       return TBigMemoryManager::instance()->getAvailableMemoryinKb() <
-             50 * 1024;
-    else
-      return TSystem::memoryShortage();
+             availableKb[level];
+    } else if (level != Exhausted && TSystem::memoryShortage())
+      return true;
+    else if (m_hasMemoryStatus) {
+      // The system shortage check is too eager (or unimplemented) to block
+      // the caller on: that takes available memory under half the reserve
+      static const double reserveFactor[] = {0.5, 1.0, 1.5};
+      TINT64 totalKb, availableKb;
+      return TSystem::getPhysicalMemoryStatus(totalKb, availableKb) &&
+             availableKb < m_reservedMemory * reserveFactor[level];
+    } else
+      return false;
   }
 
-  void doCompress();
+  CacheShard &getShard(const TAliasHash &key) {
+    return m_shards[key.toUInt64() % ShardsCount];
+  }
+
+  TFilePath newSwapFile() {
+    assert(m_rootDir != TFilePath());
+    return m_rootDir + TFilePath(std::to_string(++m_fileid));
+  }
+
+  void bindImagePointer(void *pointer, const std::string &id);
+  void unbindImagePointer(void *pointer, const std::string &id);
+  bool getMainId(const std::string &id, std::string &mainId);
+
+  void compressItem(CacheShard &shard, CacheItem *item, bool toDisk);
+  bool compressOldest(CacheShard &shard, bool toDisk);
+  bool moveToDisk(CacheItemP &item);
+
+  void doCompress(MemoryLevel level = Exhausted);
   void doCompress(std::string id);
+  void checkMemory();
   UCHAR *compressAndMalloc(TUINT32 requestedSize);  // compress in the cache
                                                     // till it can nallocate the
                                                     // requested memory
@@ -745,9 +883,10 @@ public:
   bool m_isEnabled;
 #endif
 
-  std::map<std::string, CacheItemP> m_uncompressedItems;
-  std::map<TUINT32, std::string> m_itemHistory;
-  std::map<std::string, CacheItemP> m_compressedItems;
+  enum { ShardsCount = 16 };
+  CacheShard m_shards[ShardsCount];
+
+  TThread::Mutex m_aliasesMutex;  // Protects the maps below
   std::map<void *, std::string>
       m_itemsByImagePointer;  // items ordered by ImageP.getPointer()
   std::map<std::string, std::string> m_duplicatedItems;  // for duplicated items
@@ -755,14 +894,74 @@ public:
                                                          // image1==image2) in
                                                          // the map: key is dup
                                                          // id, value is main id
+  TAtomicVar m_duplicatesCount;  // m_duplicatedItems' size, read unlocked
+
   // memoria fisica totale della macchina che non puo' essere utilizzata;
   TINT64 m_reservedMemory;
-  TThread::Mutex m_mutex;
+  bool m_hasMemoryStatus;  // Whether the system reports the available memory
+
+  TAtomicVar m_hits, m_misses, m_compressions, m_diskSpills;
+
+  static TAtomicVar m_fileid;
+
+#ifndef TNZCORE_LIGHT
+  class Worker;
 
-  static int m_fileid;
+  std::unique_ptr<Worker> m_worker;  // Started on the first request
+  QMutex m_workerMutex;              // Protects the variables below
+  QWaitCondition m_workerCondition;
+  bool m_workRequested, m_quitWorker;
+#endif
 };
 
-int TImageCache::Imp::m_fileid;
+TAtomicVar TImageCache::Imp::m_fileid;
+
+//------------------------------------------------------------------------------
+
+#ifndef TNZCORE_LIGHT
+
+//! The thread compressing images in the background. It sleeps until memory
+//! usage goes over the high water mark.
+class TImageCache::Imp::Worker final : public QThread {
+  Imp *m_imp;
+
+public:
+  Worker(Imp *imp) : m_imp(imp) {}
+
+  void run() override {
+    for (;;) {
+      {
+        QMutexLocker sl(&m_imp->m_workerMutex);
+        while (!m_imp->m_workRequested && !m_imp->m_quitWorker)
+          m_imp->m_workerCondition.wait(&m_imp->m_workerMutex);
+
+        if (m_imp->m_quitWorker) return;
+        m_imp->m_workRequested = false;
+      }
+
+      m_imp->doCompress(LowWaterMark);
+    }
+  }
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+TImageCache::Imp::~Imp() {
+#ifndef TNZCORE_LIGHT
+  if (m_worker) {
+    {
+      QMutexLocker sl(&m_workerMutex);
+      m_quitWorker = true;
+      m_workerCondition.wakeOne();
+    }
+    m_worker->wait();
+  }
+#endif
+
+  if (m_rootDir != TFilePath()) TSystem::rmDirTree(m_rootDir);
+}
 
 //------------------------------------------------------------------------------
 namespace {
@@ -799,71 +998,151 @@ inline TINT32 hasExternalReferences(const TImageP &img) {
 
   return std::max(refCount, img->getRefCount()) > 1;
 }
+
+inline bool isCompressible(CacheItem *item) {
+  UncompressedOnMemoryCacheItemP uitem = CacheItemP(item);
+  return !(item->m_cantCompress ||
+           (uitem && (!uitem->m_image || hasExternalReferences(uitem->m_image))));
 }
+
+}  // namespace
+
 //------------------------------------------------------------------------------
 
-void TImageCache::Imp::doCompress() {
-  // se la memoria usata per mantenere le immagini decompresse e' superiore
-  // a un dato valore, comprimo alcune immagini non compresse non checked-out
-  // in modo da liberare memoria
+void TImageCache::Imp::bindImagePointer(void *pointer, const std::string &id) {
+  TThread::MutexLocker sl(&m_aliasesMutex);
+  m_itemsByImagePointer[pointer] = id;
+}
 
-  // per il momento scorre tutte le immagini alla ricerca di immagini
-  // non compresse non checked-out
+//------------------------------------------------------------------------------
 
-  TThread::MutexLocker sl(&m_mutex);
+void TImageCache::Imp::unbindImagePointer(void *pointer,
+                                          const std::string &id) {
+  TThread::MutexLocker sl(&m_aliasesMutex);
 
-  std::map<TUINT32, std::string>::iterator itu = m_itemHistory.begin();
+  std::map<void *, std::string>::iterator it =
+      m_itemsByImagePointer.find(pointer);
+  if (it != m_itemsByImagePointer.end() && it->second == id)
+    m_itemsByImagePointer.erase(it);
+}
 
-  for (; itu != m_itemHistory.end() && notEnoughMemory();) {
-    std::map<std::string, CacheItemP>::iterator it =
-        m_uncompressedItems.find(itu->second);
-    assert(it != m_uncompressedItems.end());
-    CacheItemP item = it->second;
+//------------------------------------------------------------------------------
 
-    UncompressedOnMemoryCacheItemP uitem = item;
-    if (item->m_cantCompress ||
-        (uitem && (!uitem->m_image || hasExternalReferences(uitem->m_image)))) {
-      ++itu;
-      continue;
-    }
-    std::string id = it->first;
+//! Returns the id of the item that the specified duplicated id refers to.
+bool TImageCache::Imp::getMainId(const std::string &id, std::string &mainId) {
+  if (m_duplicatesCount <= 0L) return false;
 
-#ifdef _WIN32
-    assert(itu->first == it->second->m_historyCount);
-    itu = m_itemHistory.erase(itu);
-    m_itemsByImagePointer.erase(getPointer(item->getImage()));
-    m_uncompressedItems.erase(it);
-#else
-    std::map<TUINT32, std::string>::iterator itu2 = itu;
-    itu++;
-    m_itemHistory.erase(itu2);
-    m_itemsByImagePointer.erase(item->getImage().getPointer());
-    m_uncompressedItems.erase(it);
-#endif
+  TThread::MutexLocker sl(&m_aliasesMutex);
+
+  std::map<std::string, std::string>::iterator it = m_duplicatedItems.find(id);
+  if (it == m_duplicatedItems.end()) return false;
+
+  assert(m_duplicatedItems.find(it->second) == m_duplicatedItems.end());
+  mainId = it->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+//! Replaces the specified uncompressed item with a compressed one - or with
+//! an uncompressed copy on disk. The shard must be locked.
+void TImageCache::Imp::compressItem(CacheShard &shard, CacheItem *item,
+                                    bool toDisk) {
+  CacheItemP holder(item);
+  TAliasHash key(item->m_id);
+
+  shard.eraseUncompressed(shard.m_uncompressedItems.find(key));
+  unbindImagePointer(getPointer(item->getImage()), item->m_id);
+
+  if (shard.m_compressedItems.find(key) != shard.m_compressedItems.end())
+    return;  // A compressed copy is already available
 
-    if (m_compressedItems.find(id) == m_compressedItems.end()) {
-      assert(uitem);
-      item->m_cantCompress = true;
-      CacheItemP newItem   = new CompressedOnMemoryCacheItem(
-          item->getImage());  // WARNING the codec buffer allocation can CHANGE
-                              // the cache.
-      item->m_cantCompress = false;
-      if (newItem->getSize() ==
+  assert((UncompressedOnMemoryCacheItemP)holder);
+
+  CacheItemP newItem;
+  if (!toDisk) {
+    item->m_cantCompress = true;
+    newItem              = new CompressedOnMemoryCacheItem(
+        item->getImage());  // WARNING the codec buffer allocation can CHANGE
+                            // the cache.
+    item->m_cantCompress = false;
+  }
+
+  if (toDisk ||
+      newItem->getSize() ==
           0)  /// non c'era memoria sufficiente per il buffer compresso....
-      {
-        assert(m_rootDir != TFilePath());
-        TFilePath fp =
-            m_rootDir + TFilePath(std::to_string(TImageCache::Imp::m_fileid++));
-        newItem = new UncompressedOnDiskCacheItem(
-            fp, item->getImage(), item->getImage()->getPalette());
-      }
-      m_compressedItems[id] = newItem;
-      item                  = CacheItemP();
-      uitem                 = UncompressedOnMemoryCacheItemP();
-      // doCompress();//restart, since iterators could have been changed (see
-      // comment above)
-      // return;
-      itu = m_itemHistory.begin();
+  {
+    newItem = new UncompressedOnDiskCacheItem(newSwapFile(), item->getImage(),
+                                              item->getImage()->getPalette());
+    ++m_diskSpills;
+  } else
+    ++m_compressions;
+
+  newItem->m_id                = item->m_id;
+  shard.m_compressedItems[key] = newItem;
+}
+
+//------------------------------------------------------------------------------
+
+//! Compresses the least recently used compressible item of the shard. The
+//! shard must be locked. Returns false if no item could be compressed.
+bool TImageCache::Imp::compressOldest(CacheShard &shard, bool toDisk) {
+  // Items referenced outside the cache are in use: they are moved to the
+  // back of the list, so that each item is visited at most once
+  int count = (int)shard.m_uncompressedItems.size();
+  for (CacheItem *item = shard.m_lruFirst; item && count > 0;
+       item            = shard.m_lruFirst, --count) {
+    if (isCompressible(item)) {
+      compressItem(shard, item, toDisk);
+      return true;
+    }
+
+    shard.lruTouch(item);
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+
+//! Moves a compressed item from memory to disk. The item's shard must be
+//! locked. Returns false if the item could not be moved.
+bool TImageCache::Imp::moveToDisk(CacheItemP &item) {
+  if (item->m_cantCompress) return false;
+
+  CompressedOnMemoryCacheItemP citem = item;
+  if (!citem) return false;
+
+  CacheItemP newItem = new CompressedOnDiskCacheItem(
+      newSwapFile(), citem->m_compressedRas, citem->m_builder->clone(),
+      citem->m_imageInfo->clone(), citem->m_palette);
+  newItem->m_id = item->m_id;
+  item          = newItem;
+
+  ++m_diskSpills;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void TImageCache::Imp::doCompress(MemoryLevel level) {
+  // se la memoria usata per mantenere le immagini decompresse e' superiore
+  // a un dato valore, comprimo alcune immagini non compresse non checked-out
+  // in modo da liberare memoria
+
+  // Free raster buffers kept for reuse are the cheapest memory to give back
+  TBigMemoryManager::instance()->releaseCachedMemory();
+
+  // Shards are visited in turn, compressing their least recently used images
+  bool compressed = true;
+  while (compressed && notEnoughMemory(level)) {
+    compressed = false;
+
+    for (int s = 0; s < ShardsCount && notEnoughMemory(level); ++s) {
+      CacheShard &shard = m_shards[s];
+
+      TThread::MutexLocker sl(&shard.m_mutex);
+      if (compressOldest(shard, false)) compressed = true;
     }
   }
 
@@ -871,127 +1150,67 @@ void TImageCache::Imp::doCompress() {
   // sposto
   // su disco alcune immagini compresse in modo da liberare memoria
 
-  if (itu != m_itemHistory.end())  // memory is enough!
-    return;
+  for (int s = 0; s < ShardsCount && notEnoughMemory(level); ++s) {
+    CacheShard &shard = m_shards[s];
 
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.begin();
-  for (; itc != m_compressedItems.end() && notEnoughMemory(); ++itc) {
-    CacheItemP item = itc->second;
-    if (item->m_cantCompress) continue;
+    TThread::MutexLocker sl(&shard.m_mutex);
 
-    CompressedOnMemoryCacheItemP citem = itc->second;
-    if (citem) {
-      assert(m_rootDir != TFilePath());
-      TFilePath fp =
-          m_rootDir + TFilePath(std::to_string(TImageCache::Imp::m_fileid++));
+    std::map<TAliasHash, CacheItemP>::iterator itc =
+        shard.m_compressedItems.begin();
+    for (; itc != shard.m_compressedItems.end() && notEnoughMemory(level);
+         ++itc)
+      moveToDisk(itc->second);
+  }
+}
 
-      CacheItemP newItem = new CompressedOnDiskCacheItem(
-          fp, citem->m_compressedRas, citem->m_builder->clone(),
-          citem->m_imageInfo->clone(), citem->m_palette);
+//------------------------------------------------------------------------------
 
-      itc->second                   = 0;
-      m_compressedItems[itc->first] = newItem;
+//! Frees memory after an image has been added to the cache. Must be invoked
+//! with no shard locked.
+void TImageCache::Imp::checkMemory() {
+  if (notEnoughMemory())
+    doCompress();  // The caller must wait
+  else if (notEnoughMemory(HighWaterMark)) {
+#ifndef TNZCORE_LIGHT
+    QMutexLocker sl(&m_workerMutex);
+    if (!m_worker) {
+      m_worker.reset(new Worker(this));
+      m_worker->start(QThread::LowestPriority);
     }
+
+    m_workRequested = true;
+    m_workerCondition.wakeOne();
+#else
+    doCompress(LowWaterMark);
+#endif
   }
 }
 
 //------------------------------------------------------------------------------
 
 void TImageCache::Imp::doCompress(std::string id) {
-  TThread::MutexLocker sl(&m_mutex);
+  TAliasHash key(id);
+  CacheShard &shard = getShard(key);
+
+  TThread::MutexLocker sl(&shard.m_mutex);
 
   // search id in m_uncompressedItems
-  std::map<std::string, CacheItemP>::iterator it = m_uncompressedItems.find(id);
-  if (it == m_uncompressedItems.end()) return;  // id not found: return
+  std::map<TAliasHash, CacheItemP>::iterator it =
+      shard.m_uncompressedItems.find(key);
+  if (it == shard.m_uncompressedItems.end()) return;  // id not found: return
 
   // is item suitable for compression ?
-  CacheItemP item                      = it->second;
-  UncompressedOnMemoryCacheItemP uitem = item;
-  if (item->m_cantCompress ||
-      (uitem && (!uitem->m_image || hasExternalReferences(uitem->m_image))))
-    return;
-
-  // search id in m_itemHistory
-  std::map<TUINT32, std::string>::iterator itu = m_itemHistory.begin();
-  while (itu != m_itemHistory.end() && itu->second != id) ++itu;
-  if (itu == m_itemHistory.end()) return;  // id not found: return
-
-// delete itu from m_itemHistory
-#ifdef _WIN32
-  assert(itu->first == it->second->m_historyCount);
-  itu = m_itemHistory.erase(itu);
-  m_itemsByImagePointer.erase(getPointer(item->getImage()));
-#else
-  std::map<TUINT32, std::string>::iterator itu2 = itu;
-  itu++;
-  m_itemHistory.erase(itu2);
-  m_itemsByImagePointer.erase(item->getImage().getPointer());
-#endif
-
-  // delete item from m_uncompressedItems
-  m_uncompressedItems.erase(it);
-
-  // check if item has been already compressed. this should never happen
-  if (m_compressedItems.find(id) != m_compressedItems.end()) return;
-
-  assert(uitem);
-  item->m_cantCompress = true;  // ??
-  CacheItemP newItem   = new CompressedOnMemoryCacheItem(
-      item->getImage());  // WARNING the codec buffer  allocation can CHANGE the
-                          // cache.
-  item->m_cantCompress = false;  // ??
-  if (newItem->getSize() ==
-      0)  /// non c'era memoria sufficiente per il buffer compresso....
-  {
-    assert(m_rootDir != TFilePath());
-    TFilePath fp =
-        m_rootDir + TFilePath(std::to_string(TImageCache::Imp::m_fileid++));
-    newItem = new UncompressedOnDiskCacheItem(fp, item->getImage(),
-                                              item->getImage()->getPalette());
-  }
-  m_compressedItems[id] = newItem;
-  item                  = CacheItemP();
-  uitem                 = UncompressedOnMemoryCacheItemP();
+  if (isCompressible(it->second.getPointer()))
+    compressItem(shard, it->second.getPointer(), false);
 }
 
-/*
-  // se il quantitativo di memoria utilizzata e' superiore a un dato valore,
-  sposto
-  // su disco alcune immagini compresse in modo da liberare memoria
-
-  if (itu != m_itemHistory.end()) //memory is enough!
-    return;
-
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.begin();
-  for ( ; itc != m_compressedItems.end() && notEnoughMemory(); ++itc)
-        {
-          CacheItemP item = itc->second;
-          if (item->m_cantCompress)
-                  continue;
-
-          CompressedOnMemoryCacheItemP citem = itc->second;
-          if (citem)
-                {
-                  assert(m_rootDir!=TFilePath());
-                  TFilePath fp = m_rootDir +
-  TFilePath(toString(TImageCache::Imp::m_fileid++));
-
-                  CacheItemP newItem = new CompressedOnDiskCacheItem(fp,
-  citem->m_compressedRas,
-                                                                                                                                                                                                                           citem->m_builder->clone(), citem->m_imageInfo->clone());
-
-                  itc->second = 0;
-                  m_compressedItems[itc->first] = newItem;
-                }
-        }
-  */
-
 //------------------------------------------------------------------------------
 
 UCHAR *TImageCache::Imp::compressAndMalloc(TUINT32 size) {
-  UCHAR *buf = 0;
+  // NOTE: This is invoked by memory allocations, which may happen while the
+  // calling thread holds a shard's mutex. So, shards are just try-locked.
 
-  TThread::MutexLocker sl(&m_mutex);
+  UCHAR *buf = 0;
 
   TheCodec::instance()->reset();
 
@@ -1000,77 +1219,40 @@ UCHAR *TImageCache::Imp::compressAndMalloc(TUINT32 size) {
 
   // assert(size==0 || TBigMemoryManager::instance()->isActive());
 
-  std::map<TUINT32, std::string>::iterator itu = m_itemHistory.begin();
-  while (
-      (buf = TBigMemoryManager::instance()->getBuffer(size)) == 0 &&
-      itu !=
-          m_itemHistory
-              .end())  //>TBigMemoryManager::instance()->getAvailableMemoryinKb()))
-  {
-    std::map<std::string, CacheItemP>::iterator it =
-        m_uncompressedItems.find(itu->second);
-    assert(it != m_uncompressedItems.end());
-    CacheItemP item = it->second;
-
-    UncompressedOnMemoryCacheItemP uitem = item;
-    if (item->m_cantCompress ||
-        (uitem && (!uitem->m_image || hasExternalReferences(uitem->m_image)))) {
-      ++itu;
-      continue;
-    }
+  // Move uncompressed images to disk, least recently used first. Compressing
+  // them would require memory.
+  bool moved = true;
+  while ((buf = TBigMemoryManager::instance()->getBuffer(size)) == 0 &&
+         moved) {
+    moved = false;
 
-    if (m_compressedItems.find(it->first) == m_compressedItems.end()) {
-      assert(uitem);
-      CacheItemP newItem;
-      // newItem = new CompressedOnMemoryCacheItem(item->getImage());
-      // if (newItem->getSize()==0)
-      //  {
-      assert(m_rootDir != TFilePath());
-      TFilePath fp =
-          m_rootDir + TFilePath(std::to_string(TImageCache::Imp::m_fileid++));
-      newItem = new UncompressedOnDiskCacheItem(fp, item->getImage(),
-                                                item->getImage()->getPalette());
-      //  }
-
-      m_compressedItems[it->first] = newItem;
-    }
+    for (int s = 0; s < ShardsCount; ++s) {
+      CacheShard &shard = m_shards[s];
+      if (!shard.m_mutex.tryLock()) continue;
 
-#ifdef _WIN32
-    assert(itu->first == it->second->m_historyCount);
-    itu = m_itemHistory.erase(itu);
-    m_itemsByImagePointer.erase(getPointer(item->getImage()));
-    m_uncompressedItems.erase(it);
-#else
-    std::map<TUINT32, std::string>::iterator itu2 = itu;
-    itu++;
-    m_itemHistory.erase(itu2);
-    m_itemsByImagePointer.erase(item->getImage().getPointer());
-    m_uncompressedItems.erase(it);
-#endif
+      if (compressOldest(shard, true)) moved = true;
+      shard.m_mutex.unlock();
+
+      if ((buf = TBigMemoryManager::instance()->getBuffer(size)) != 0)
+        return buf;
+    }
   }
 
   if (buf != 0) return buf;
 
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.begin();
-  for (; itc != m_compressedItems.end() &&
-         (buf = TBigMemoryManager::instance()->getBuffer(size)) == 0;
-       ++itc) {
-    CacheItemP item = itc->second;
-    if (item->m_cantCompress) continue;
-
-    CompressedOnMemoryCacheItemP citem = itc->second;
-    if (citem) {
-      assert(m_rootDir != TFilePath());
-      TFilePath fp =
-          m_rootDir + TFilePath(std::to_string(TImageCache::Imp::m_fileid++));
-
-      CacheItemP newItem = new CompressedOnDiskCacheItem(
-          fp, citem->m_compressedRas, citem->m_builder->clone(),
-          citem->m_imageInfo->clone(), citem->m_palette);
-
-      itc->second                   = 0;
-      m_compressedItems[itc->first] = newItem;
-    }
+  // Then, move compressed images to disk
+  for (int s = 0; s < ShardsCount && buf == 0; ++s) {
+    CacheShard &shard = m_shards[s];
+    if (!shard.m_mutex.tryLock()) continue;
+
+    std::map<TAliasHash, CacheItemP>::iterator itc =
+        shard.m_compressedItems.begin();
+    for (; itc != shard.m_compressedItems.end() &&
+           (buf = TBigMemoryManager::instance()->getBuffer(size)) == 0;
+         ++itc)
+      moveToDisk(itc->second);
+
+    shard.m_mutex.unlock();
   }
 
   return buf;
@@ -1184,96 +1366,78 @@ void TImageCache::add(const std::string &id, const TImageP &img,
 
 void TImageCache::Imp::add(const std::string &id, const TImageP &img,
                            bool overwrite) {
-  TThread::MutexLocker sl(&m_mutex);
-
-#ifdef LEVO
-  std::map<std::string, CacheItemP>::iterator it1 = m_uncompressedItems.begin();
+  TAliasHash key(id);
+  CacheShard &shard = getShard(key);
 
-  for (; it1 != m_uncompressedItems.end(); ++it1) {
-    UncompressedOnMemoryCacheItemP item =
-        (UncompressedOnMemoryCacheItemP)it1->second;
-    // m_memUsage -= item->getSize();
-    assert(item);
-    TImageP refImg = item->getImage();
-    if (refImg.getPointer() == img.getPointer() && it1->first != id)
-      assert(!"opps gia' esiste in cache!");
-  }
-#endif
+  {
+    TThread::MutexLocker sl(&shard.m_mutex);
 
-  std::map<std::string, CacheItemP>::iterator itUncompr =
-      m_uncompressedItems.find(id);
-  std::map<std::string, CacheItemP>::iterator itCompr =
-      m_compressedItems.find(id);
+    std::map<TAliasHash, CacheItemP>::iterator itUncompr =
+        shard.m_uncompressedItems.find(key);
+    std::map<TAliasHash, CacheItemP>::iterator itCompr =
+        shard.m_compressedItems.find(key);
 
 #ifdef _DEBUGTOONZ
-  TRasterImageP rimg = (TRasterImageP)img;
-  TToonzImageP timg  = (TToonzImageP)img;
+    TRasterImageP rimg = (TRasterImageP)img;
+    TToonzImageP timg  = (TToonzImageP)img;
 #endif
 
-  if (itUncompr != m_uncompressedItems.end() ||
-      itCompr !=
-          m_compressedItems.end())  // already present in cache with same id...
-  {
-    if (overwrite) {
-#ifdef _DEBUGTOONZ
-      if (rimg)
-        rimg->getRaster()->m_cashed = true;
-      else if (timg)
-        timg->getRaster()->m_cashed = true;
-#endif
-      std::map<std::string, CacheItemP>::iterator it;
-
-      if (itUncompr != m_uncompressedItems.end()) {
-        assert(m_itemHistory.find(itUncompr->second->m_historyCount) !=
-               m_itemHistory.end());
-        m_itemHistory.erase(itUncompr->second->m_historyCount);
-        m_itemsByImagePointer.erase(getPointer(itUncompr->second->getImage()));
-        m_uncompressedItems.erase(itUncompr);
-      }
-      if (itCompr != m_compressedItems.end()) m_compressedItems.erase(id);
-    } else
-      return;
-  } else {
-    std::map<std::string, std::string>::iterator dt =
-        m_duplicatedItems.find(id);
-    if ((dt != m_duplicatedItems.end()) && !overwrite) return;
-
-    std::map<void *, std::string>::iterator it;
-    if ((it = m_itemsByImagePointer.find(getPointer(img))) !=
-        m_itemsByImagePointer
-            .end())  // already present in cache with another id...
+    if (itUncompr != shard.m_uncompressedItems.end() ||
+        itCompr !=
+            shard.m_compressedItems.end())  // already present in cache with
+                                            // same id...
     {
-      m_duplicatedItems[id] = it->second;
-      return;
-    }
+      if (!overwrite) return;
 
-    if (dt != m_duplicatedItems.end()) m_duplicatedItems.erase(dt);
-  }
+      if (itUncompr != shard.m_uncompressedItems.end()) {
+        unbindImagePointer(getPointer(itUncompr->second->getImage()), id);
+        shard.eraseUncompressed(itUncompr);
+      }
+      if (itCompr != shard.m_compressedItems.end())
+        shard.m_compressedItems.erase(itCompr);
+    } else {
+      TThread::MutexLocker sl(&m_aliasesMutex);
+
+      std::map<std::string, std::string>::iterator dt =
+          m_duplicatedItems.find(id);
+      if ((dt != m_duplicatedItems.end()) && !overwrite) return;
 
-  CacheItemP item;
+      std::map<void *, std::string>::iterator it;
+      if ((it = m_itemsByImagePointer.find(getPointer(img))) !=
+          m_itemsByImagePointer
+              .end())  // already present in cache with another id...
+      {
+        if (dt == m_duplicatedItems.end()) ++m_duplicatesCount;
+        m_duplicatedItems[id] = it->second;
+        return;
+      }
+
+      if (dt != m_duplicatedItems.end()) {
+        m_duplicatedItems.erase(dt);
+        --m_duplicatesCount;
+      }
+    }
 
 #ifdef _DEBUGTOONZ
-  if (rimg)
-    rimg->getRaster()->m_cashed = true;
-  else if (timg)
-    timg->getRaster()->m_cashed = true;
+    if (rimg)
+      rimg->getRaster()->m_cashed = true;
+    else if (timg)
+      timg->getRaster()->m_cashed = true;
 #endif
 
-  item = new UncompressedOnMemoryCacheItem(img);
+    CacheItemP item = new UncompressedOnMemoryCacheItem(img);
 #ifdef TNZCORE_LIGHT
-  item->m_cantCompress = false;
+    item->m_cantCompress = false;
 #else
-  item->m_cantCompress =
-      (TVectorImageP(img) || TMeshImageP(img) ? true : false);
+    item->m_cantCompress =
+        (TVectorImageP(img) || TMeshImageP(img) ? true : false);
 #endif
-  item->m_id                             = id;
-  m_uncompressedItems[id]                = item;
-  m_itemsByImagePointer[getPointer(img)] = id;
-  item->m_historyCount                   = HistoryCount;
-  m_itemHistory[HistoryCount]            = id;
-  HistoryCount++;
+    item->m_id = id;
+    shard.setUncompressed(key, item);
+    bindImagePointer(getPointer(img), id);
+  }
 
-  doCompress();
+  checkMemory();
 
 #ifdef _DEBUGTOONZ
 // int itemCount =
@@ -1292,38 +1456,53 @@ void TImageCache::Imp::remove(const std::string &id) {
              // imagecache was already freed!
 
   assert(check == magic);
-  TThread::MutexLocker sl(&m_mutex);
 
-  std::map<std::string, std::string>::iterator it1;
-  if ((it1 = m_duplicatedItems.find(id)) !=
-      m_duplicatedItems.end())  // it's a duplicated id...
-  {
-    m_duplicatedItems.erase(it1);
-    return;
+  if (m_duplicatesCount > 0) {
+    std::string sonId;
+    {
+      TThread::MutexLocker sl(&m_aliasesMutex);
+
+      std::map<std::string, std::string>::iterator it1;
+      if ((it1 = m_duplicatedItems.find(id)) !=
+          m_duplicatedItems.end())  // it's a duplicated id...
+      {
+        m_duplicatedItems.erase(it1);
+        --m_duplicatesCount;
+        return;
+      }
+
+      for (it1 = m_duplicatedItems.begin(); it1 != m_duplicatedItems.end();
+           ++it1)
+        if (it1->second == id) break;
+
+      if (it1 != m_duplicatedItems.end()) {
+        sonId = it1->first;
+        m_duplicatedItems.erase(it1);
+        --m_duplicatesCount;
+      }
+    }
+
+    if (!sonId.empty())  // it has duplicated, so cannot erase it;
+                         // I erase the duplicate, and assign its
+                         // id has the main id
+    {
+      remap(sonId, id);
+      return;
+    }
   }
 
-  for (it1 = m_duplicatedItems.begin(); it1 != m_duplicatedItems.end(); ++it1)
-    if (it1->second == id) break;
+  TAliasHash key(id);
+  CacheShard &shard = getShard(key);
 
-  if (it1 != m_duplicatedItems.end())  // it has duplicated, so cannot erase it;
-                                       // I erase the duplicate, and assign its
-                                       // id has the main id
-  {
-    std::string sonId = it1->first;
-    m_duplicatedItems.erase(it1);
-    remap(sonId, id);
-    return;
-  }
-
-  std::map<std::string, CacheItemP>::iterator it = m_uncompressedItems.find(id);
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.find(id);
-  if (it != m_uncompressedItems.end()) {
-    const CacheItemP &item = it->second;
-    assert((UncompressedOnMemoryCacheItemP)item);
-    assert(m_itemHistory.find(it->second->m_historyCount) !=
-           m_itemHistory.end());
-    m_itemHistory.erase(it->second->m_historyCount);
-    m_itemsByImagePointer.erase(getPointer(it->second->getImage()));
+  TThread::MutexLocker sl(&shard.m_mutex);
+
+  std::map<TAliasHash, CacheItemP>::iterator it =
+      shard.m_uncompressedItems.find(key);
+  std::map<TAliasHash, CacheItemP>::iterator itc =
+      shard.m_compressedItems.find(key);
+  if (it != shard.m_uncompressedItems.end()) {
+    assert((UncompressedOnMemoryCacheItemP)it->second);
+    unbindImagePointer(getPointer(it->second->getImage()), id);
 
 #ifdef _DEBUGTOONZ
     if ((TRasterImageP)it->second->getImage())
@@ -1332,9 +1511,9 @@ void TImageCache::Imp::remove(const std::string &id) {
       ((TToonzImageP)it->second->getImage())->getRaster()->m_cashed = false;
 #endif
 
-    m_uncompressedItems.erase(it);
+    shard.eraseUncompressed(it);
   }
-  if (itc != m_compressedItems.end()) m_compressedItems.erase(itc);
+  if (itc != shard.m_compressedItems.end()) shard.m_compressedItems.erase(itc);
 }
 
 //------------------------------------------------------------------------------
@@ -1345,49 +1524,67 @@ void TImageCache::remap(const std::string &dstId, const std::string &srcId) {
 
 void TImageCache::Imp::remap(const std::string &dstId,
                              const std::string &srcId) {
-  TThread::MutexLocker sl(&m_mutex);
-  std::map<std::string, CacheItemP>::iterator it =
-      m_uncompressedItems.find(srcId);
-  if (it != m_uncompressedItems.end()) {
-    CacheItemP citem = it->second;
-    assert(m_itemHistory.find(citem->m_historyCount) != m_itemHistory.end());
-    m_itemHistory.erase(citem->m_historyCount);
-    m_itemsByImagePointer.erase(getPointer(citem->getImage()));
-    m_uncompressedItems.erase(it);
+  TAliasHash srcKey(srcId), dstKey(dstId);
+  CacheShard &srcShard = getShard(srcKey), &dstShard = getShard(dstKey);
 
-    m_uncompressedItems[dstId]                           = citem;
-    m_itemHistory[citem->m_historyCount]                 = dstId;
-    m_itemsByImagePointer[getPointer(citem->getImage())] = dstId;
-  }
-  it = m_compressedItems.find(srcId);
-  if (it != m_compressedItems.end()) {
-    CacheItemP citem = it->second;
-    m_compressedItems.erase(it);
-    m_compressedItems[dstId] = citem;
+  {
+    // Lock both shards, in a fixed order
+    TThread::MutexLocker sl1(&std::min(&srcShard, &dstShard)->m_mutex);
+    TThread::MutexLocker sl2(&std::max(&srcShard, &dstShard)->m_mutex);
+
+    std::map<TAliasHash, CacheItemP>::iterator it =
+        srcShard.m_uncompressedItems.find(srcKey);
+    if (it != srcShard.m_uncompressedItems.end()) {
+      CacheItemP citem = it->second;
+      srcShard.eraseUncompressed(it);
+
+      citem->m_id = dstId;
+      dstShard.setUncompressed(dstKey, citem);
+      bindImagePointer(getPointer(citem->getImage()), dstId);
+    }
+    it = srcShard.m_compressedItems.find(srcKey);
+    if (it != srcShard.m_compressedItems.end()) {
+      CacheItemP citem = it->second;
+      srcShard.m_compressedItems.erase(it);
+
+      citem->m_id                        = dstId;
+      dstShard.m_compressedItems[dstKey] = citem;
+    }
   }
-  std::map<std::string, std::string>::iterator it2 =
-      m_duplicatedItems.find(srcId);
-  if (it2 != m_duplicatedItems.end()) {
-    std::string id = it2->second;
-    m_duplicatedItems.erase(it2);
-    m_duplicatedItems[dstId] = id;
+
+  if (m_duplicatesCount > 0) {
+    TThread::MutexLocker sl(&m_aliasesMutex);
+
+    std::map<std::string, std::string>::iterator it2 =
+        m_duplicatedItems.find(srcId);
+    if (it2 != m_duplicatedItems.end()) {
+      std::string id = it2->second;
+      m_duplicatedItems.erase(it2);
+      m_duplicatedItems[dstId] = id;
+    }
+    for (it2 = m_duplicatedItems.begin(); it2 != m_duplicatedItems.end(); ++it2)
+      if (it2->second == srcId) it2->second = dstId;
+    m_duplicatesCount += (long)m_duplicatedItems.size() - m_duplicatesCount;
   }
-  for (it2 = m_duplicatedItems.begin(); it2 != m_duplicatedItems.end(); ++it2)
-    if (it2->second == srcId) it2->second = dstId;
 }
 
 //------------------------------------------------------------------------------
 
 void TImageCache::remapIcons(const std::string &dstId,
                              const std::string &srcId) {
-  std::map<std::string, CacheItemP>::iterator it;
+  std::map<TAliasHash, CacheItemP>::iterator it;
   std::map<std::string, std::string> table;
   std::string prefix = srcId + ":";
   int j              = (int)prefix.length();
-  for (it = m_imp->m_uncompressedItems.begin();
-       it != m_imp->m_uncompressedItems.end(); ++it) {
-    std::string id                      = it->first;
-    if (id.find(prefix) == 0) table[id] = dstId + ":" + id.substr(j);
+  for (int s = 0; s < Imp::ShardsCount; ++s) {
+    CacheShard &shard = m_imp->m_shards[s];
+
+    TThread::MutexLocker sl(&shard.m_mutex);
+    for (it = shard.m_uncompressedItems.begin();
+         it != shard.m_uncompressedItems.end(); ++it) {
+      const std::string &id               = it->second->m_id;
+      if (id.find(prefix) == 0) table[id] = dstId + ":" + id.substr(j);
+    }
   }
   for (std::map<std::string, std::string>::iterator it2 = table.begin();
        it2 != table.end(); ++it2) {
@@ -1398,74 +1595,101 @@ void TImageCache::remapIcons(const std::string &dstId,
 //------------------------------------------------------------------------------
 
 void TImageCache::clear(bool deleteFolder) {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
-  m_imp->m_uncompressedItems.clear();
-  m_imp->m_itemHistory.clear();
-  m_imp->m_compressedItems.clear();
-  m_imp->m_duplicatedItems.clear();
-  m_imp->m_itemsByImagePointer.clear();
+  for (int s = 0; s < Imp::ShardsCount; ++s) {
+    CacheShard &shard = m_imp->m_shards[s];
+
+    TThread::MutexLocker sl(&shard.m_mutex);
+    shard.clear();
+  }
+
+  {
+    TThread::MutexLocker sl(&m_imp->m_aliasesMutex);
+    m_imp->m_duplicatedItems.clear();
+    m_imp->m_duplicatesCount += -m_imp->m_duplicatesCount;
+    m_imp->m_itemsByImagePointer.clear();
+  }
+
   if (deleteFolder && m_imp->m_rootDir != TFilePath())
     TSystem::rmDirTree(m_imp->m_rootDir);
 }
 
 //------------------------------------------------------------------------------
 
+namespace {
+
+// Scene-independent images are assumed to have the "$:" id prefix.
+inline bool isSceneImageId(const std::string &id) {
+  return !(id.size() >= 2 && id[0] == '$' && id[1] == ':');
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+
 void TImageCache::clearSceneImages() {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
+  for (int s = 0; s < Imp::ShardsCount; ++s) {
+    CacheShard &shard = m_imp->m_shards[s];
 
-  // note the ';' - which follows ':' in the ascii table
-  m_imp->m_uncompressedItems.erase(
-      m_imp->m_uncompressedItems.begin(),
-      m_imp->m_uncompressedItems.lower_bound("$:"));
-  m_imp->m_uncompressedItems.erase(m_imp->m_uncompressedItems.lower_bound("$;"),
-                                   m_imp->m_uncompressedItems.end());
+    TThread::MutexLocker sl(&shard.m_mutex);
 
-  m_imp->m_compressedItems.erase(m_imp->m_compressedItems.begin(),
-                                 m_imp->m_compressedItems.lower_bound("$:"));
-  m_imp->m_compressedItems.erase(m_imp->m_compressedItems.lower_bound("$;"),
-                                 m_imp->m_compressedItems.end());
+    std::map<TAliasHash, CacheItemP>::iterator it;
+    for (it = shard.m_uncompressedItems.begin();
+         it != shard.m_uncompressedItems.end();) {
+      if (isSceneImageId(it->second->m_id))
+        shard.eraseUncompressed(it++);
+      else
+        ++it;
+    }
 
-  m_imp->m_duplicatedItems.erase(m_imp->m_duplicatedItems.begin(),
-                                 m_imp->m_duplicatedItems.lower_bound("$:"));
-  m_imp->m_duplicatedItems.erase(m_imp->m_duplicatedItems.lower_bound("$;"),
-                                 m_imp->m_duplicatedItems.end());
+    for (it = shard.m_compressedItems.begin();
+         it != shard.m_compressedItems.end();) {
+      if (isSceneImageId(it->second->m_id))
+        shard.m_compressedItems.erase(it++);
+      else
+        ++it;
+    }
+  }
 
   // Clear maps whose id is on the second of map pairs.
 
-  std::map<TUINT32, std::string>::iterator it;
-  for (it = m_imp->m_itemHistory.begin(); it != m_imp->m_itemHistory.end();) {
-    if (it->second.size() >= 2 && it->second[0] == '$' && it->second[1] == ':')
+  TThread::MutexLocker sl(&m_imp->m_aliasesMutex);
+
+  std::map<std::string, std::string>::iterator it;
+  for (it = m_imp->m_duplicatedItems.begin();
+       it != m_imp->m_duplicatedItems.end();) {
+    if (isSceneImageId(it->first)) {
+      m_imp->m_duplicatedItems.erase(it++);
+      --m_imp->m_duplicatesCount;
+    } else
       ++it;
-    else {
-      std::map<TUINT32, std::string>::iterator app = it;
-      app++;
-      m_imp->m_itemHistory.erase(it);
-      it = app;
-    }
   }
 
   std::map<void *, std::string>::iterator jt;
   for (jt = m_imp->m_itemsByImagePointer.begin();
        jt != m_imp->m_itemsByImagePointer.end();) {
-    if (jt->second.size() >= 2 && jt->second[0] == '$' && jt->second[1] == ':')
+    if (isSceneImageId(jt->second))
+      m_imp->m_itemsByImagePointer.erase(jt++);
+    else
       ++jt;
-    else {
-      std::map<void *, std::string>::iterator app = jt;
-      app++;
-      m_imp->m_itemsByImagePointer.erase(jt);
-      jt = app;
-    }
   }
 }
 
 //------------------------------------------------------------------------------
 
 bool TImageCache::isCached(const std::string &id) const {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
-  return (m_imp->m_uncompressedItems.find(id) !=
-              m_imp->m_uncompressedItems.end() ||
-          m_imp->m_compressedItems.find(id) != m_imp->m_compressedItems.end() ||
-          m_imp->m_duplicatedItems.find(id) != m_imp->m_duplicatedItems.end());
+  TAliasHash key(id);
+  CacheShard &shard = m_imp->getShard(key);
+
+  {
+    TThread::MutexLocker sl(&shard.m_mutex);
+    if (shard.m_uncompressedItems.find(key) !=
+            shard.m_uncompressedItems.end() ||
+        shard.m_compressedItems.find(key) != shard.m_compressedItems.end())
+      return true;
+  }
+
+  std::string mainId;
+  return m_imp->getMainId(id, mainId);
 }
 
 //------------------------------------------------------------------------------
@@ -1615,80 +1839,82 @@ bool TImageCache::getDpi(const std::string &id, double &dpiX,
 #endif
 
 bool TImageCache::getSubsampling(const std::string &id, int &subs) const {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
+  TAliasHash key(id);
+  CacheShard &shard = m_imp->getShard(key);
 
-  std::map<std::string, std::string>::iterator it1;
-  if ((it1 = m_imp->m_duplicatedItems.find(id)) !=
-      m_imp->m_duplicatedItems.end()) {
-    assert(m_imp->m_duplicatedItems.find(it1->second) ==
-           m_imp->m_duplicatedItems.end());
-    return getSubsampling(it1->second, subs);
-  }
+  {
+    TThread::MutexLocker sl(&shard.m_mutex);
 
-  std::map<std::string, CacheItemP>::iterator it =
-      m_imp->m_uncompressedItems.find(id);
-  if (it != m_imp->m_uncompressedItems.end()) {
-    UncompressedOnMemoryCacheItemP uncompressed = it->second;
-    assert(uncompressed);
+    std::map<TAliasHash, CacheItemP>::iterator it =
+        shard.m_uncompressedItems.find(key);
+    if (it != shard.m_uncompressedItems.end()) {
+      UncompressedOnMemoryCacheItemP uncompressed = it->second;
+      assert(uncompressed);
 #ifndef TNZCORE_LIGHT
-    if (TToonzImageP ti = uncompressed->getImage()) {
-      subs = ti->getSubsampling();
-      return true;
-    }
+      if (TToonzImageP ti = uncompressed->getImage()) {
+        subs = ti->getSubsampling();
+        return true;
+      }
 
-    else
+      else
 #endif
-        if (TRasterImageP ri = uncompressed->getImage()) {
-      subs = ri->getSubsampling();
-      return true;
-    } else
-      return false;
-  }
-  std::map<std::string, CacheItemP>::iterator itc =
-      m_imp->m_compressedItems.find(id);
-  if (itc == m_imp->m_compressedItems.end()) return false;
-  CacheItemP cacheItem = itc->second;
-  assert(cacheItem->m_imageInfo);
-  if (RasterImageInfo *rimageInfo =
-          dynamic_cast<RasterImageInfo *>(cacheItem->m_imageInfo)) {
-    subs = rimageInfo->m_subs;
-    return true;
-  }
+          if (TRasterImageP ri = uncompressed->getImage()) {
+        subs = ri->getSubsampling();
+        return true;
+      } else
+        return false;
+    }
+    std::map<TAliasHash, CacheItemP>::iterator itc =
+        shard.m_compressedItems.find(key);
+    if (itc != shard.m_compressedItems.end()) {
+      CacheItemP cacheItem = itc->second;
+      assert(cacheItem->m_imageInfo);
+      if (RasterImageInfo *rimageInfo =
+              dynamic_cast<RasterImageInfo *>(cacheItem->m_imageInfo)) {
+        subs = rimageInfo->m_subs;
+        return true;
+      }
 #ifndef TNZCORE_LIGHT
-  else if (ToonzImageInfo *timageInfo =
-               dynamic_cast<ToonzImageInfo *>(cacheItem->m_imageInfo)) {
-    subs = timageInfo->m_subs;
-    return true;
-  }
+      else if (ToonzImageInfo *timageInfo =
+                   dynamic_cast<ToonzImageInfo *>(cacheItem->m_imageInfo)) {
+        subs = timageInfo->m_subs;
+        return true;
+      }
 #endif
-  else
-    return false;
+      else
+        return false;
+    }
+  }
+
+  std::string mainId;
+  if (m_imp->getMainId(id, mainId)) return getSubsampling(mainId, subs);
+
+  return false;
 }
 
 //------------------------------------------------------------------------------
 
 bool TImageCache::hasBeenModified(const std::string &id, bool reset) const {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
+  TAliasHash key(id);
+  CacheShard &shard = m_imp->getShard(key);
 
-  std::map<std::string, std::string>::iterator it;
-  if ((it = m_imp->m_duplicatedItems.find(id)) !=
-      m_imp->m_duplicatedItems.end()) {
-    assert(m_imp->m_duplicatedItems.find(it->second) ==
-           m_imp->m_duplicatedItems.end());
-    return hasBeenModified(it->second, reset);
+  {
+    TThread::MutexLocker sl(&shard.m_mutex);
+
+    std::map<TAliasHash, CacheItemP>::iterator itu =
+        shard.m_uncompressedItems.find(key);
+    if (itu != shard.m_uncompressedItems.end()) {
+      if (reset && itu->second->m_modified) {
+        itu->second->m_modified = false;
+        return true;
+      } else
+        return itu->second->m_modified;
+    }
   }
 
-  TImageP img;
+  std::string mainId;
+  if (m_imp->getMainId(id, mainId)) return hasBeenModified(mainId, reset);
 
-  std::map<std::string, CacheItemP>::iterator itu =
-      m_imp->m_uncompressedItems.find(id);
-  if (itu != m_imp->m_uncompressedItems.end()) {
-    if (reset && itu->second->m_modified) {
-      itu->second->m_modified = false;
-      return true;
-    } else
-      return itu->second->m_modified;
-  }
   return true;  // not present in cache==modified (for particle purposes...)
 }
 
@@ -1701,76 +1927,79 @@ TImageP TImageCache::get(const std::string &id, bool toBeModified) const {
 //------------------------------------------------------------------------------
 
 TImageP TImageCache::Imp::get(const std::string &id, bool toBeModified) {
-  TThread::MutexLocker sl(&m_mutex);
-
-  std::map<std::string, std::string>::const_iterator it;
-  if ((it = m_duplicatedItems.find(id)) != m_duplicatedItems.end()) {
-    assert(m_duplicatedItems.find(it->second) == m_duplicatedItems.end());
-    return get(it->second, toBeModified);
-  }
+  TAliasHash key(id);
+  CacheShard &shard = getShard(key);
 
   TImageP img;
+  CacheItemP uncompressed;
 
-  std::map<std::string, CacheItemP>::iterator itu =
-      m_uncompressedItems.find(id);
-  if (itu != m_uncompressedItems.end()) {
-    img = itu->second->getImage();
-    if (itu->second->m_historyCount !=
-        HistoryCount - 1)  // significa che l'ultimo get non era sulla stessa
-                           // immagine, quindi  serve aggiornare l'history!
-    {
-      assert(m_itemHistory.find(itu->second->m_historyCount) !=
-             m_itemHistory.end());
-      m_itemHistory.erase(itu->second->m_historyCount);
-      m_itemHistory[HistoryCount] = id;
-      itu->second->m_historyCount = HistoryCount;
-      HistoryCount++;
-    }
-    if (toBeModified) {
-      itu->second->m_modified = true;
-      std::map<std::string, CacheItemP>::iterator itc =
-          m_compressedItems.find(id);
-      if (itc != m_compressedItems.end()) m_compressedItems.erase(itc);
+  {
+    TThread::MutexLocker sl(&shard.m_mutex);
+
+    std::map<TAliasHash, CacheItemP>::iterator itu =
+        shard.m_uncompressedItems.find(key);
+    if (itu != shard.m_uncompressedItems.end()) {
+      ++m_hits;
+
+      img = itu->second->getImage();
+      shard.lruTouch(itu->second.getPointer());
+
+      if (toBeModified) {
+        itu->second->m_modified = true;
+        std::map<TAliasHash, CacheItemP>::iterator itc =
+            shard.m_compressedItems.find(key);
+        if (itc != shard.m_compressedItems.end())
+          shard.m_compressedItems.erase(itc);
+      }
+      return img;
     }
-    return img;
-  }
 
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.find(id);
-  if (itc == m_compressedItems.end()) return 0;
+    std::map<TAliasHash, CacheItemP>::iterator itc =
+        shard.m_compressedItems.find(key);
+    if (itc != shard.m_compressedItems.end()) {
+      ++m_hits;
 
-  CacheItemP cacheItem = itc->second;
+      CacheItemP cacheItem = itc->second;
 
-  img = cacheItem->getImage();
+      img = cacheItem->getImage();
 
-  CacheItemP uncompressed;
-  uncompressed                    = new UncompressedOnMemoryCacheItem(img);
-  m_uncompressedItems[itc->first] = uncompressed;
-  m_itemsByImagePointer[getPointer(img)] = itc->first;
+      uncompressed         = new UncompressedOnMemoryCacheItem(img);
+      uncompressed->m_id   = id;
+      shard.setUncompressed(key, uncompressed);
+      bindImagePointer(getPointer(img), id);
 
-  m_itemHistory[HistoryCount]  = itc->first;
-  uncompressed->m_historyCount = HistoryCount;
-  HistoryCount++;
+      if (CompressedOnMemoryCacheItemP(cacheItem))
+      // l'immagine compressa non la tengo insieme alla
+      // uncompressa se e' troppo grande
+      {
+        if (10 * cacheItem->getSize() > uncompressed->getSize()) {
+          shard.m_compressedItems.erase(itc);
+          itc = shard.m_compressedItems.end();
+        }
+      } else
+        assert((CompressedOnDiskCacheItemP)cacheItem ||
+               (UncompressedOnDiskCacheItemP)cacheItem);  // deve essere
+                                                          // compressa!
+
+      if (toBeModified && itc != shard.m_compressedItems.end()) {
+        uncompressed->m_modified = true;
+        shard.m_compressedItems.erase(itc);
+      }
 
-  if (CompressedOnMemoryCacheItemP(cacheItem))
-  // l'immagine compressa non la tengo insieme alla
-  // uncompressa se e' troppo grande
-  {
-    if (10 * cacheItem->getSize() > uncompressed->getSize()) {
-      m_compressedItems.erase(itc);
-      itc = m_compressedItems.end();
+      uncompressed->m_cantCompress = toBeModified;
     }
-  } else
-    assert((CompressedOnDiskCacheItemP)cacheItem ||
-           (UncompressedOnDiskCacheItemP)cacheItem);  // deve essere compressa!
+  }
+
+  if (!uncompressed) {
+    std::string mainId;
+    if (getMainId(id, mainId)) return get(mainId, toBeModified);
 
-  if (toBeModified && itc != m_compressedItems.end()) {
-    uncompressed->m_modified = true;
-    m_compressedItems.erase(itc);
+    ++m_misses;
+    return 0;
   }
 
-  uncompressed->m_cantCompress = toBeModified;
   // se la memoria utilizzata e' superiore al massimo consentito, comprime
-  doCompress();
+  checkMemory();
 
   uncompressed->m_cantCompress = false;
 
@@ -1784,26 +2013,45 @@ TImageP TImageCache::Imp::get(const std::string &id, bool toBeModified) {
 
 //------------------------------------------------------------------------------
 
+TImageCache::Statistics TImageCache::getStatistics() const {
+  Statistics stats;
+  stats.m_hits         = m_imp->m_hits;
+  stats.m_misses       = m_imp->m_misses;
+  stats.m_compressions = m_imp->m_compressions;
+  stats.m_diskSpills   = m_imp->m_diskSpills;
+
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+
 namespace {
 
 class AccumulateMemUsage {
 public:
-  int operator()(int oldValue, std::pair<std::string, CacheItemP> item) {
+  int operator()(int oldValue, std::pair<TAliasHash, CacheItemP> item) {
     return oldValue + item.second->getSize();
   }
 };
 }
 
 UINT TImageCache::getMemUsage() const {
-  TThread::MutexLocker sl(&m_imp->m_mutex);
+  int ret = 0;
+
+  for (int s = 0; s < Imp::ShardsCount; ++s) {
+    CacheShard &shard = m_imp->m_shards[s];
+
+    TThread::MutexLocker sl(&shard.m_mutex);
 
-  int ret = std::accumulate(m_imp->m_uncompressedItems.begin(),
-                            m_imp->m_uncompressedItems.end(), 0,
-                            AccumulateMemUsage());
+    ret = std::accumulate(shard.m_uncompressedItems.begin(),
+                          shard.m_uncompressedItems.end(), ret,
+                          AccumulateMemUsage());
+    ret = std::accumulate(shard.m_compressedItems.begin(),
+                          shard.m_compressedItems.end(), ret,
+                          AccumulateMemUsage());
+  }
 
-  return ret + std::accumulate(m_imp->m_compressedItems.begin(),
-                               m_imp->m_compressedItems.end(), 0,
-                               AccumulateMemUsage());
+  return ret;
 }
 
 //------------------------------------------------------------------------------
@@ -1813,12 +2061,17 @@ UINT TImageCache::getDiskUsage() const { return 0; }
 //------------------------------------------------------------------------------
 
 UINT TImageCache::getMemUsage(const std::string &id) const {
-  std::map<std::string, CacheItemP>::iterator it =
-      m_imp->m_uncompressedItems.find(id);
-  if (it != m_imp->m_uncompressedItems.end()) return it->second->getSize();
+  TAliasHash key(id);
+  CacheShard &shard = m_imp->getShard(key);
 
-  it = m_imp->m_compressedItems.find(id);
-  if (it != m_imp->m_compressedItems.end()) return it->second->getSize();
+  TThread::MutexLocker sl(&shard.m_mutex);
+
+  std::map<TAliasHash, CacheItemP>::iterator it =
+      shard.m_uncompressedItems.find(key);
+  if (it != shard.m_uncompressedItems.end()) return it->second->getSize();
+
+  it = shard.m_compressedItems.find(key);
+  if (it != shard.m_compressedItems.end()) return it->second->getSize();
   return 0;
 }
 
@@ -1827,14 +2080,7 @@ UINT TImageCache::getMemUsage(const std::string &id) const {
 //! Returns the uncompressed image size (in KB) of the image associated with
 //! passd id, or 0 if none was found.
 UINT TImageCache::getUncompressedMemUsage(const std::string &id) const {
-  std::map<std::string, CacheItemP>::iterator it =
-      m_imp->m_uncompressedItems.find(id);
-  if (it != m_imp->m_uncompressedItems.end()) return it->second->getSize();
-
-  it = m_imp->m_compressedItems.find(id);
-  if (it != m_imp->m_compressedItems.end()) return it->second->getSize();
-
-  return 0;
+  return getMemUsage(id);
 }
 
 //------------------------------------------------------------------------------
@@ -1853,10 +2099,16 @@ UINT TImageCache::getDiskUsage(const std::string &id) const { return 0; }
 
 void TImageCache::dump(std::ostream &os) const {
   os << "mem: " << getMemUsage() << std::endl;
-  std::map<std::string, CacheItemP>::iterator it =
-      m_imp->m_uncompressedItems.begin();
-  for (; it != m_imp->m_uncompressedItems.end(); ++it) {
-    os << it->first << std::endl;
+  for (int s = 0; s < Imp::ShardsCount; ++s) {
+    CacheShard &shard = m_imp->m_shards[s];
+
+    TThread::MutexLocker sl(&shard.m_mutex);
+
+    std::map<TAliasHash, CacheItemP>::iterator it =
+        shard.m_uncompressedItems.begin();
+    for (; it != shard.m_uncompressedItems.end(); ++it) {
+      os << it->second->m_id << std::endl;
+    }
   }
 }
 
@@ -1869,7 +2121,6 @@ void TImageCache::outputMap(UINT chunkRequested, std::string filename) {
 //------------------------------------------------------------------------------
 
 void TImageCache::Imp::outputMap(UINT chunkRequested, std::string filename) {
-  TThread::MutexLocker sl(&m_mutex);
   //#ifdef _DEBUG
   // static int Count = 0;
 
@@ -1893,37 +2144,44 @@ void TImageCache::Imp::outputMap(UINT chunkRequested, std::string filename) {
   TUINT64 umsize  = 0;
   TUINT64 udsize  = 0;
 
-  std::map<std::string, CacheItemP>::iterator itu = m_uncompressedItems.begin();
-
-  for (; itu != m_uncompressedItems.end(); ++itu) {
-    UncompressedOnMemoryCacheItemP uitem = itu->second;
-    if (uitem->m_image && hasExternalReferences(uitem->m_image)) {
-      umcount1++;
-      umsize1 += (TUINT64)(itu->second->getSize() / 1024.0);
-    } else if (uitem->m_cantCompress) {
-      umcount2++;
-      umsize2 += (TUINT64)(itu->second->getSize() / 1024.0);
-    } else {
-      umcount3++;
-      umsize3 += (TUINT64)(itu->second->getSize() / 1024.0);
+  for (int s = 0; s < ShardsCount; ++s) {
+    CacheShard &shard = m_shards[s];
+
+    TThread::MutexLocker sl(&shard.m_mutex);
+
+    std::map<TAliasHash, CacheItemP>::iterator itu =
+        shard.m_uncompressedItems.begin();
+    for (; itu != shard.m_uncompressedItems.end(); ++itu) {
+      UncompressedOnMemoryCacheItemP uitem = itu->second;
+      if (uitem->m_image && hasExternalReferences(uitem->m_image)) {
+        umcount1++;
+        umsize1 += (TUINT64)(itu->second->getSize() / 1024.0);
+      } else if (uitem->m_cantCompress) {
+        umcount2++;
+        umsize2 += (TUINT64)(itu->second->getSize() / 1024.0);
+      } else {
+        umcount3++;
+        umsize3 += (TUINT64)(itu->second->getSize() / 1024.0);
+      }
     }
-  }
-  std::map<std::string, CacheItemP>::iterator itc = m_compressedItems.begin();
-  for (; itc != m_compressedItems.end(); ++itc) {
-    CacheItemP boh                      = itc->second;
-    CompressedOnMemoryCacheItemP cmitem = itc->second;
-    CompressedOnDiskCacheItemP cditem   = itc->second;
-    UncompressedOnDiskCacheItemP uditem = itc->second;
-    if (cmitem) {
-      cmcount++;
-      cmsize += cmitem->getSize();
-    } else if (cditem) {
-      cdcount++;
-      cdsize += cditem->getSize();
-    } else {
-      assert(uditem);
-      udcount++;
-      udsize += uditem->getSize();
+    std::map<TAliasHash, CacheItemP>::iterator itc =
+        shard.m_compressedItems.begin();
+    for (; itc != shard.m_compressedItems.end(); ++itc) {
+      CacheItemP boh                      = itc->second;
+      CompressedOnMemoryCacheItemP cmitem = itc->second;
+      CompressedOnDiskCacheItemP cditem   = itc->second;
+      UncompressedOnDiskCacheItemP uditem = itc->second;
+      if (cmitem) {
+        cmcount++;
+        cmsize += cmitem->getSize();
+      } else if (cditem) {
+        cdcount++;
+        cdsize += cditem->getSize();
+      } else {
+        assert(uditem);
+        udcount++;
+        udsize += uditem->getSize();
+      }
     }
   }
 
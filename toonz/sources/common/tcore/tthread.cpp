@@ -14,18 +14,18 @@
 
 // STL includes
 #include <set>
+#include <map>
 #include <deque>
-
-// tcg includes
-#include "tcg/tcg_pool.h"
+#include <memory>
+#include <algorithm>
 
 // Qt includes
-#include <QMultiMap>
-#include <QMutableMapIterator>
 #include <QMutex>
 #include <QWaitCondition>
 #include <QMetaType>
 #include <QCoreApplication>
+#include <QThreadPool>
+#include <QRunnable>
 
 //==============================================================================
 
@@ -34,12 +34,14 @@
 //--------------------------------------------------
 
 // Basics:
-//  * Tasks added by Executors are always stored in a global QMultiMap first -
+//  * Tasks added by Executors are stored in a queue of their Executor -
 //    ordering primarily being the schedulingPriority(), and insertion instant
-//    (implicit) when they have the same scheduling priority.
-//  * The QMultiMap needs to be reverse-iterated to do that, since values with
-//    the same key are ordered from the most recent to the oldest one (see Qt's
-//    manual).
+//    when they have the same scheduling priority.
+//  * The global order of tasks is the merge of the Executors' queues: a global
+//    map sorts the Executors by the position of the first task in their queue.
+//    Tasks are therefore polled scanning Executors rather than tasks - an
+//    Executor whose custom conditions fail is skipped as a whole, no matter
+//    how many tasks it has queued.
 //  * Worker threads are stored in a global set.
 //  * When a task is added or a task has been performed, the workers list is
 //    refreshed, possibly adding new Workers for some executable tasks.
@@ -209,6 +211,29 @@ public:
 
 //=====================================================================
 
+//======================
+//    TaskKey struct
+//-----------------------
+
+//! Key of a task in the execution order: higher scheduling priorities come
+//! first, then earlier insertions.
+struct TaskKey {
+  int m_priority;
+  TUINT64 m_serial;
+
+  TaskKey(int priority, TUINT64 serial)
+      : m_priority(priority), m_serial(serial) {}
+
+  bool operator<(const TaskKey &other) const {
+    return m_priority > other.m_priority ||
+           (m_priority == other.m_priority && m_serial < other.m_serial);
+  }
+};
+
+typedef std::map<TaskKey, RunnableP> TaskQueue;
+
+//=====================================================================
+
 //========================
 //    ExecutorId class
 //------------------------
@@ -222,7 +247,7 @@ public:
 //! \sa Executor and Runnable class.
 class ExecutorId final : public TSmartObject {
 public:
-  size_t m_id;
+  TaskQueue m_tasks;  // Tasks waiting for execution
 
   int m_activeTasks;
   int m_maxActiveTasks;
@@ -256,11 +281,12 @@ public:
 //! and event-looped thread - typically the main thread in GUI applications.
 class ExecutorImp {
 public:
-  QMultiMap<int, RunnableP> m_tasks;
+  typedef std::map<TaskKey, ExecutorId *> HeadsMap;
+
+  HeadsMap m_heads;  // Executors with queued tasks, by their first task
   std::set<Worker *> m_workers;  // Used just for debugging purposes
 
-  tcg::indices_pool<> m_executorIdPool;
-  std::vector<UCHAR> m_waitingFlagsPool;
+  TUINT64 m_tasksSerial;
 
   int m_activeLoad;
   int m_maxLoad;
@@ -270,7 +296,14 @@ public:
   ExecutorImp();
   ~ExecutorImp();
 
+  inline static TaskKey taskKey(const RunnableP &task) {
+    return TaskKey(task->m_schedulingPriority, task->m_serial);
+  }
+
   inline void insertTask(int schedulingPriority, RunnableP &task);
+  inline void eraseTask(ExecutorId *id, TaskQueue::iterator it);
+  bool removeTask(const RunnableP &task);
+  void clearTasks(ExecutorId *id);
 
   void refreshAssignments();
 
@@ -300,7 +333,8 @@ bool shutdownVar                 = false;
 //-----------------------------
 
 ExecutorImp::ExecutorImp()
-    : m_activeLoad(0)
+    : m_tasksSerial(0)
+    , m_activeLoad(0)
     , m_maxLoad(TSystem::getProcessorCount() * 100)
     , m_transitionMutex()  // NOTE: We'll wait on this mutex - so it can't be
                            // recursive
@@ -323,7 +357,63 @@ inline bool ExecutorImp::isExecutable(RunnableP &task) {
 
 inline void ExecutorImp::insertTask(int schedulingPriority, RunnableP &task) {
   task->m_schedulingPriority = schedulingPriority;
-  m_tasks.insert(schedulingPriority, task);
+  task->m_serial             = ++m_tasksSerial;
+
+  ExecutorId *id = task->m_id;
+  TaskQueue::iterator it =
+      id->m_tasks.insert(std::make_pair(taskKey(task), task)).first;
+
+  if (it == id->m_tasks.begin()) {
+    // The task is the new head of the Executor's queue
+    if (++it != id->m_tasks.end()) m_heads.erase(it->first);
+    m_heads.insert(std::make_pair(taskKey(task), id));
+  }
+}
+
+//---------------------------------------------------------------------
+
+inline void ExecutorImp::eraseTask(ExecutorId *id, TaskQueue::iterator it) {
+  if (it == id->m_tasks.begin()) {
+    m_heads.erase(it->first);
+
+    TaskQueue::iterator jt = it;
+    if (++jt != id->m_tasks.end())
+      m_heads.insert(std::make_pair(jt->first, id));
+  }
+
+  id->m_tasks.erase(it);
+}
+
+//---------------------------------------------------------------------
+
+//! Removes the task from its Executor's queue. Returns false if the task was
+//! not queued.
+bool ExecutorImp::removeTask(const RunnableP &task) {
+  ExecutorId *id         = task->m_id;
+  TaskQueue::iterator it = id->m_tasks.find(taskKey(task));
+  if (it == id->m_tasks.end() || it->second != task) return false;
+
+  eraseTask(id, it);
+  return true;
+}
+
+//---------------------------------------------------------------------
+
+//! Removes all the tasks queued by the specified Executor, emitting their
+//! canceled() signal.
+void ExecutorImp::clearTasks(ExecutorId *id) {
+  if (id->m_tasks.empty()) return;
+
+  m_heads.erase(id->m_tasks.begin()->first);
+
+  TaskQueue tasks;
+  tasks.swap(id->m_tasks);
+
+  TaskQueue::iterator it;
+  for (it = tasks.begin(); it != tasks.end(); ++it) {
+    RunnableP task = it->second;
+    Q_EMIT task->canceled(task);
+  }
 }
 
 //=====================================================================
@@ -332,7 +422,7 @@ inline void ExecutorImp::insertTask(int schedulingPriority, RunnableP &task) {
 //    Runnable methods
 //------------------------
 
-Runnable::Runnable() : TSmartObject(m_classCode), m_id(0) {}
+Runnable::Runnable() : TSmartObject(m_classCode), m_id(0), m_serial(0) {}
 
 //---------------------------------------------------------------------
 
@@ -518,12 +608,7 @@ ExecutorId::ExecutorId()
     , m_activeLoad(0)
     , m_maxActiveLoad((std::numeric_limits<int>::max)())
     , m_dedicatedThreads(false)
-    , m_persistentThreads(false) {
-  QMutexLocker transitionLocker(&globalImp->m_transitionMutex);
-
-  m_id = globalImp->m_executorIdPool.acquire();
-  globalImp->m_waitingFlagsPool.resize(globalImp->m_executorIdPool.size());
-}
+    , m_persistentThreads(false) {}
 
 //---------------------------------------------------------------------
 
@@ -534,8 +619,6 @@ ExecutorId::~ExecutorId() {
     m_persistentThreads = 0;
     refreshDedicatedList();
   }
-
-  globalImp->m_executorIdPool.release(m_id);
 }
 
 //---------------------------------------------------------------------
@@ -737,14 +820,9 @@ void Executor::shutdown() {
       if (task) Q_EMIT task->canceled(task);
     }
 
-    // Finally, deal with the global queue tasks
-    QMutableMapIterator<int, RunnableP> jt(globalImp->m_tasks);
-    while (jt.hasNext()) {
-      jt.next();
-      RunnableP task = jt.value();
-      Q_EMIT task->canceled(task);
-      jt.remove();
-    }
+    // Finally, deal with the queued tasks
+    while (!globalImp->m_heads.empty())
+      globalImp->clearTasks(globalImp->m_heads.begin()->second);
 
     // Now, send the terminate() signal to all active tasks
     for (it = globalImp->m_workers.begin(); it != globalImp->m_workers.end();
@@ -835,9 +913,9 @@ void Executor::removeTask(RunnableP task) {
   // Updating tasks list - lock against state transitions
   QMutexLocker transitionLocker(&globalImp->m_transitionMutex);
 
-  // Then, look in the global queue - if it is found, emiminate the task and
-  // send the canceled signal.
-  if (globalImp->m_tasks.remove(task->m_schedulingPriority, task)) {
+  // Then, look in the Executor's queue - if it is found, emiminate the task
+  // and send the canceled signal.
+  if (globalImp->removeTask(task)) {
     Q_EMIT task->canceled(task);
     return;
   }
@@ -870,18 +948,8 @@ void Executor::cancelAll() {
     if (task && task->m_id == m_id) Q_EMIT task->canceled(task);
   }
 
-  // Finally, clear the global tasks list from all tasks inserted by this
-  // executor
-  // NOTE: An easier way here?
-  QMutableMapIterator<int, RunnableP> jt(globalImp->m_tasks);
-  while (jt.hasNext()) {
-    jt.next();
-    if (jt.value()->m_id == m_id) {
-      RunnableP task = jt.value();
-      Q_EMIT task->canceled(task);
-      jt.remove();
-    }
-  }
+  // Finally, clear the executor's tasks queue
+  globalImp->clearTasks(m_id);
 }
 
 //---------------------------------------------------------------------
@@ -1021,36 +1089,31 @@ void ExecutorImp::refreshAssignments() {
   // QMutexLocker transitionLocker(&globalImp->m_transitionMutex);  //Already
   // covered
 
-  if (m_tasks.isEmpty()) return;
-
-  // Erase the id vector data
-  assert(m_executorIdPool.size() == m_waitingFlagsPool.size());
-  memset(&m_waitingFlagsPool.front(), 0, m_waitingFlagsPool.size());
-
-  // c) Try with the global queue
-  int e, executorsCount = m_executorIdPool.acquiredSize();
-
-  int i, tasksCount = m_tasks.size();
-  QMultiMap<int, RunnableP>::iterator it;
-  for (i = 0, e = 0, it = m_tasks.end() - 1;
-       i < tasksCount && e < executorsCount; ++i, --it) {
+  // c) Try with the queued tasks. Only the first task of each Executor is a
+  // candidate, since tasks are started in order inside the same Executor.
+  HeadsMap::iterator it = m_heads.begin();
+  while (it != m_heads.end()) {
     // std::cout<< "global tasks-refreshAss" << std::endl;
     // Take the task
-    RunnableP task = it.value();
+    ExecutorId *id = it->second;
+    RunnableP task = id->m_tasks.begin()->second;
     task->m_load   = task->taskLoad();
 
-    UCHAR &idWaitingForAnotherTask = m_waitingFlagsPool[task->m_id->m_id];
-    if (idWaitingForAnotherTask) continue;
-
     if (!isExecutable(task)) break;
 
     if (!task->customConditions()) {
-      ++e;
-      idWaitingForAnotherTask = 1;
-    } else {
-      task->m_id->newWorker(task);
-      it = m_tasks.erase(it);
+      // The executor waits for another of its tasks to end
+      ++it;
+      continue;
     }
+
+    TaskKey key = it->first;
+    eraseTask(id, id->m_tasks.begin());
+    id->newWorker(task);
+
+    // Go on from the task following the taken one - which may be the new
+    // head of the same executor
+    it = m_heads.upper_bound(key);
   }
 }
 
@@ -1091,27 +1154,16 @@ inline void Worker::takeTask() {
 
   globalImp->m_transitionMutex.lock();
 
-  // Erase the executor id status pool
-  tcg::indices_pool<> &executorIdPool  = globalImp->m_executorIdPool;
-  std::vector<UCHAR> &waitingFlagsPool = globalImp->m_waitingFlagsPool;
-
-  assert(waitingFlagsPool.size() == globalImp->m_executorIdPool.size());
-  memset(&waitingFlagsPool.front(), 0, waitingFlagsPool.size());
-
-  int e, executorsCount = executorIdPool.acquiredSize();
+  ExecutorImp::HeadsMap &heads = globalImp->m_heads;
 
-  int i, tasksCount = globalImp->m_tasks.size();
-  QMultiMap<int, RunnableP>::iterator it;
-  for (i = 0, e = 0, it = globalImp->m_tasks.end() - 1;
-       i < tasksCount && e < executorsCount; ++i, --it) {
+  ExecutorImp::HeadsMap::iterator it;
+  for (it = heads.begin(); it != heads.end(); ++it) {
     // std::cout<< "global tasks-takeTask" << std::endl;
     // Take the first task
-    RunnableP task = it.value();
+    ExecutorId *id = it->second;
+    RunnableP task = id->m_tasks.begin()->second;
     task->m_load   = task->taskLoad();
 
-    UCHAR &idWaitingForAnotherTask = waitingFlagsPool[task->m_id->m_id];
-    if (idWaitingForAnotherTask) continue;
-
     if (!globalImp->isExecutable(task)) break;
 
     // In case the worker was captured for dedication, check the task
@@ -1123,15 +1175,106 @@ inline void Worker::takeTask() {
     }
 
     // Test its custom conditions
-    if (!task->customConditions()) {
-      ++e;
-      idWaitingForAnotherTask = 1;
-    } else {
+    if (task->customConditions()) {
+      globalImp->eraseTask(id, id->m_tasks.begin());
       adoptTask(task);
-      it = globalImp->m_tasks.erase(it);
 
       globalImpSlots->emitRefreshAssignments();
       break;
     }
   }
 }
+
+//==============================================================================
+
+//==========================================
+//    Concurrent runs on the helpers pool
+//------------------------------------------
+
+namespace {
+
+//! The state of a runConcurrently() call, shared with its helpers.
+struct ConcurrentRun {
+  std::function<void()> m_work;
+
+  QMutex m_mutex;
+  QWaitCondition m_finished;
+  int m_runningCount;
+
+  ConcurrentRun(const std::function<void()> &work)
+      : m_work(work), m_runningCount(0) {}
+};
+
+//------------------------------------------------------------------------------
+
+class ConcurrentRunHelper final : public QRunnable {
+  std::shared_ptr<ConcurrentRun> m_run;
+
+public:
+  ConcurrentRunHelper(const std::shared_ptr<ConcurrentRun> &run) : m_run(run) {}
+
+  void run() override {
+    try {
+      m_run->m_work();
+    } catch (...) {
+    }
+
+    QMutexLocker locker(&m_run->m_mutex);
+    if (--m_run->m_runningCount == 0) m_run->m_finished.wakeAll();
+  }
+};
+
+//------------------------------------------------------------------------------
+
+//! The calling thread always takes part: the pool holds one thread less than
+//! the processors.
+QThreadPool *helpersPool() {
+  static QThreadPool *pool = []() {
+    QThreadPool *pool = new QThreadPool;
+    pool->setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+    return pool;
+  }();
+  return pool;
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+
+void TThread::runConcurrently(const std::function<void()> &work,
+                              int helpersCount) {
+  std::shared_ptr<ConcurrentRun> run;
+
+  if (helpersCount > 0) {
+    run.reset(new ConcurrentRun(work));
+
+    QThreadPool *pool = helpersPool();
+    for (int h = 0; h < helpersCount; ++h) {
+      {
+        QMutexLocker locker(&run->m_mutex);
+        ++run->m_runningCount;
+      }
+
+      ConcurrentRunHelper *helper = new ConcurrentRunHelper(run);
+      if (!pool->tryStart(helper)) {
+        delete helper;
+
+        QMutexLocker locker(&run->m_mutex);
+        --run->m_runningCount;
+        break;
+      }
+    }
+  }
+
+  struct Waiter {
+    ConcurrentRun *m_run;
+    ~Waiter() {
+      if (!m_run) return;
+
+      QMutexLocker locker(&m_run->m_mutex);
+      while (m_run->m_runningCount > 0) m_run->m_finished.wait(&m_run->m_mutex);
+    }
+  } waiter = {run.get()};  // Waits for the helpers even if work() throws
+
+  work();
+}
@@ -192,13 +192,15 @@ TCacheResource *TCacheResourcePool::getResource(const std::string &name,
 
   // NOTA: Passa ad un oggetto lockatore. Quello e' in grado di gestire i casi
   // di eccezioni ecc..
+  TAliasHash key(name);
+
   beginCachedSearch();
 
   // Search for an already allocated resource
   if (m_searchIterator == m_memResources.end()) {
-    m_searchIterator = m_memResources.lower_bound(name);
+    m_searchIterator = m_memResources.lower_bound(key);
     if (m_searchIterator != m_memResources.end()) {
-      if (!(name < m_searchIterator->first)) {
+      if (!(key < m_searchIterator->first)) {
         m_foundIterator = true;
       } else if (m_searchIterator != m_memResources.begin()) {
         m_searchIterator--;
@@ -244,8 +246,9 @@ TCacheResource *TCacheResourcePool::getResource(const std::string &name,
 
     if (!resourcePath.isEmpty() || createIfNone) {
       TCacheResource *result = new TCacheResource;
+      result->m_name         = name;
       result->m_pos          = m_searchIterator =
-          m_memResources.insert(m_searchIterator, std::make_pair(name, result));
+          m_memResources.insert(m_searchIterator, std::make_pair(key, result));
 
 // DIAGNOSTICS_STRSET("#resources.txt | RISORSE | " + QString::number((UINT)
 // result) + " | Name",
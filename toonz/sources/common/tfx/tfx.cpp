@@ -4,6 +4,7 @@
 #include "tconst.h"
 #include "tutil.h"
 #include "tstream.h"
+#include "tatomicvar.h"
 
 // TnzBase includes
 #include "tparamcontainer.h"
@@ -633,13 +634,23 @@ TFxTimeRegion TFx::getActiveTimeRegion() const {
 
 //--------------------------------------------------
 
+namespace {
+TAtomicVar paramChangesCount;
+}
+
 void TFx::onChange(const TParamChange &c) {
+  ++paramChangesCount;
+
   TFxParamChange change(this, c);
   notify(change);
 }
 
 //--------------------------------------------------
 
+long TFx::getParamChangesCount() { return paramChangesCount; }
+
+//--------------------------------------------------
+
 void TFx::addObserver(TFxObserver *obs) { m_imp->m_observers.insert(obs); }
 
 //--------------------------------------------------
@@ -6,6 +6,7 @@
 #include "tcacheresourcepool.h"
 
 #include "tfxcachemanager.h"
+#include "taliashash.h"
 
 // Debug
 //#define DIAGNOSTICS
@@ -132,7 +133,7 @@ MANAGER_FILESCOPE_DECLARATION(TFxCacheManager, TFxCacheManagerGenerator);
 
 class TFxCacheManager::Imp {
 public:
-  typedef std::map<std::string, ResourceDeclaration> ResourceInstanceDataMap;
+  typedef std::map<TAliasHash, ResourceDeclaration> ResourceInstanceDataMap;
 
   ResourceInstanceDataMap m_resourcesData;
   std::map<ResourceDeclaration *, ResourceDeclaration::RawData> m_rawData;
@@ -246,7 +247,7 @@ void TFxCacheManager::declareResource(const std::string &alias, const TFxP &fx,
                                       bool subtileable) {
   Imp::ResourceInstanceDataMap::iterator it;
   it = m_imp->m_resourcesData
-           .insert(std::make_pair(alias, ResourceDeclaration()))
+           .insert(std::make_pair(TAliasHash(alias), ResourceDeclaration()))
            .first;
   it->second.m_rawData =
       &m_imp->m_rawData
@@ -275,7 +276,7 @@ ResourceData TFxCacheManager::getResource(const std::string &alias,
 
   // Seek the associated infos
   Imp::ResourceInstanceDataMap::iterator jt =
-      m_imp->m_resourcesData.find(alias);
+      m_imp->m_resourcesData.find(TAliasHash(alias));
   ResourceDeclaration *decl =
       (jt == m_imp->m_resourcesData.end()) ? 0 : &jt->second;
 
@@ -386,7 +387,7 @@ continue;
     if (resMap.size() > 0) {
       for (it = resMap.begin(); it != resMap.end(); ++it) {
         DIAGNOSTICS_STR(prefixErr + "Survived Declarations | " +
-                        QString::fromStdString(it->first).left(40));
+                        QString::fromStdString(it->first.toString()));
       }
     }
   }
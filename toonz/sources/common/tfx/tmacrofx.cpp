@@ -420,7 +420,7 @@ std::string TMacroFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
     }
     alias += ",";
   }
@@ -64,7 +64,7 @@ inserted, moved or removed.
 
 Level changes are delivered immediately to the ::invalidateLevel(..) method,
 which removes all resources
-whose name contains the level's name. Unfortunately, this cannot be done at
+whose fx alias contains the level's name. Unfortunately, this cannot be done at
 frame precision (ie you cannot
 invalidate a single frame of the level, but ALL the level).
 
@@ -346,13 +346,17 @@ public:
 
 struct LockedResourceP {
   TCacheResourceP m_resource;
+  std::string m_alias;  //!< Whole alias of the resource's fx, searched for
+                        //!  level names. Resource names only hash it.
 
-  LockedResourceP(const TCacheResourceP &resource) : m_resource(resource) {
+  LockedResourceP(const TCacheResourceP &resource,
+                  const std::string &alias = std::string())
+      : m_resource(resource), m_alias(alias) {
     m_resource->addLock();
   }
 
   LockedResourceP(const LockedResourceP &resource)
-      : m_resource(resource.m_resource) {
+      : m_resource(resource.m_resource), m_alias(resource.m_alias) {
     m_resource->addLock();
   }
 
@@ -362,6 +366,7 @@ struct LockedResourceP {
     src.m_resource->addLock();
     if (m_resource) m_resource->releaseLock();
     m_resource = src.m_resource;
+    m_alias    = src.m_alias;
     return *this;
   }
 
@@ -768,7 +773,7 @@ void TPassiveCacheManager::invalidateLevel(const std::string &levelName) {
     std::set<LockedResourceP> &resources = *it;
     std::set<LockedResourceP>::iterator jt, kt;
     for (jt = resources.begin(); jt != resources.end();) {
-      if ((*jt)->getName().find(levelName) != std::string::npos) {
+      if (jt->m_alias.find(levelName) != std::string::npos) {
         kt = jt++;
         it->erase(kt);
       } else
@@ -890,7 +895,16 @@ void TPassiveCacheManager::getResource(TCacheResourceP &resource,
     int passiveCacheId =
         m_fxDataVector[fx->getAttributes()->passiveCacheDataIdx()]
             .m_passiveCacheId;
-    m_resources->getTable().value(contextName, passiveCacheId).insert(resource);
+
+    // Level invalidation searches the whole fx alias, which is built only
+    // for the resources stored here
+    std::set<LockedResourceP> &resources =
+        m_resources->getTable().value(contextName, passiveCacheId);
+    if (resources.find(resource) == resources.end()) {
+      TRasterFxP rfx(fx);
+      resources.insert(LockedResourceP(
+          resource, rfx ? rfx->getCachedAlias(frame, rs) : alias));
+    }
   }
 }
 
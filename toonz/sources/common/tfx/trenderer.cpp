@@ -88,6 +88,85 @@ inline void interlace(TRasterP f0, const TRasterP &f1, int field) {
   f1->unlock();
   f0->unlock();
 }
+
+//-------------------------------------------------------------------------------
+
+// Frames rendered by fewer tasks than the available threads are split into
+// horizontal bands, computed concurrently. Bands are at least this tall.
+const int c_minBandHeight = 32;
+
+//! Splits a frame of the specified size into horizontal bands. No band is
+//! returned if the frame should not be split.
+void buildBands(const TDimension &size, int count, std::vector<TRect> &bands) {
+  bands.clear();
+
+  count = std::min(count, size.ly / c_minBandHeight);
+  if (count <= 1) return;
+
+  for (int b = 0; b < count; ++b)
+    bands.push_back(TRect(0, size.ly * b / count, size.lx - 1,
+                          size.ly * (b + 1) / count - 1));
+}
+
+//-------------------------------------------------------------------------------
+
+//! The computation of a tile, split into bands. Bands are taken in order by
+//! every thread invoking run(), until none is left.
+class BandsJob {
+  TRasterFxP m_fx;
+  TTile &m_tile;
+  double m_frame;
+  const TRenderSettings &m_info;
+  const std::vector<TRect> &m_bands;
+
+  QAtomicInt m_nextBand;
+
+  QMutex m_mutex;  // Protects the error message
+  bool m_failed;
+  std::wstring m_error;
+
+public:
+  BandsJob(const TRasterFxP &fx, TTile &tile, double frame,
+           const TRenderSettings &info, const std::vector<TRect> &bands)
+      : m_fx(fx)
+      , m_tile(tile)
+      , m_frame(frame)
+      , m_info(info)
+      , m_bands(bands)
+      , m_nextBand(0)
+      , m_failed(false) {}
+
+  void run() {
+    int b;
+    while ((b = m_nextBand.fetchAndAddOrdered(1)) < (int)m_bands.size()) {
+      TRect rect(m_bands[b]);
+
+      TRasterP ras(m_tile.getRaster()->extract(rect));
+      ras->setLinear(m_info.m_linearColorSpace);
+
+      TTile band(ras, m_tile.m_pos + TPointD(rect.x0, rect.y0));
+
+      try {
+        m_fx->compute(band, m_frame, m_info);
+      } catch (TException &e) {
+        fail(e.getMessage());
+      } catch (...) {
+        fail(L"Unknown render exception");
+      }
+    }
+  }
+
+  //! Rethrows the first failure met by the bands' computation.
+  void rethrow() {
+    if (m_failed) throw TException(m_error);
+  }
+
+private:
+  void fail(const std::wstring &error) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_failed) m_failed = true, m_error = error;
+  }
+};
 }  // anonymous namespace
 
 //================================================================================
@@ -401,6 +480,9 @@ class RenderTask final : public TThread::Runnable {
   TTile m_tileB;  // in  field rendering, rendered at frame + 0.5; in
                   // stereoscopic, rendered right frame
 
+  std::vector<TRect> m_bands;  // Bands computed concurrently, if any
+  int m_bandThreadsCount;       // Threads computing the bands
+
 public:
   RenderTask(unsigned long renderId, unsigned long taskId, double frame,
              const TRenderSettings &ri, const TFxPair &fx,
@@ -410,8 +492,11 @@ public:
   ~RenderTask() {}
 
   void addFrame(double frame) { m_frames.push_back(frame); }
+  void setBandsCount(int threadsCount);
 
   void buildTile(TTile &tile);
+  void computeTile(const TRasterFxP &fx, TTile &tile, double t);
+  void dryComputeTile(const TRasterFxP &fx, double t);
   void releaseTiles();
 
   void onFrameStarted();
@@ -931,7 +1016,8 @@ RenderTask::RenderTask(unsigned long renderId, unsigned long taskId,
     , m_framePos(framePos)
     , m_rendererImp(rendererImp)
     , m_fieldRender(ri.m_fieldPrevalence != TRenderSettings::NoField)
-    , m_stereoscopic(ri.m_stereoscopic) {
+    , m_stereoscopic(ri.m_stereoscopic)
+    , m_bandThreadsCount(1) {
   m_frames.push_back(frame);
 
   // Connect the onFinished slot
@@ -948,14 +1034,98 @@ RenderTask::RenderTask(unsigned long renderId, unsigned long taskId,
 
 //---------------------------------------------------------
 
-void RenderTask::preRun() {
+//! Splits the frame into bands, to be computed concurrently by the specified
+//! number of threads. Like in the cache manager, bands are made small enough
+//! to comply with the maximum tile size of the render settings, and fxs
+//! declaring a negative memory requirement are not subdivided.
+void RenderTask::setBandsCount(int threadsCount) {
+  m_bands.clear();
+  m_bandThreadsCount = 1;
+
+  if (threadsCount <= 1) return;
+
   TRectD geom(m_framePos, TDimensionD(m_frameSize.lx, m_frameSize.ly));
+  if ((m_fx.m_frameA &&
+       m_fx.m_frameA->getMemoryRequirement(geom, m_frames[0], m_info) < 0) ||
+      (m_fx.m_frameB &&
+       m_fx.m_frameB->getMemoryRequirement(geom, m_frames[0], m_info) < 0))
+    return;
 
-  if (m_fx.m_frameA) m_fx.m_frameA->dryCompute(geom, m_frames[0], m_info);
+  int count    = threadsCount;
+  int tileSize = TRasterFx::memorySize(geom, m_info.m_bpp);
+  if (tileSize > m_info.m_maxTileSize)
+    count = std::max(count, (tileSize - 1) / m_info.m_maxTileSize + 1);
+
+  buildBands(m_frameSize, count, m_bands);
+  m_bandThreadsCount = std::min(threadsCount, (int)m_bands.size());
+}
+
+//---------------------------------------------------------
+
+void RenderTask::preRun() {
+  if (m_fx.m_frameA) dryComputeTile(m_fx.m_frameA, m_frames[0]);
 
   if (m_fx.m_frameB)
-    m_fx.m_frameB->dryCompute(
-        geom, m_fieldRender ? m_frames[0] + 0.5 : m_frames[0], m_info);
+    dryComputeTile(m_fx.m_frameB,
+                   m_fieldRender ? m_frames[0] + 0.5 : m_frames[0]);
+}
+
+//---------------------------------------------------------
+
+//! Predicts the computation of a frame tile. The frame's bands are declared
+//! separately, just like computeTile() will request them.
+void RenderTask::dryComputeTile(const TRasterFxP &fx, double t) {
+  if (m_bands.empty()) {
+    TRectD geom(m_framePos, TDimensionD(m_frameSize.lx, m_frameSize.ly));
+    fx->dryCompute(geom, t, m_info);
+    return;
+  }
+
+  for (const TRect &band : m_bands) {
+    TRectD bandGeom(m_framePos + TPointD(band.x0, band.y0),
+                    TDimensionD(band.getLx(), band.getLy()));
+    fx->dryCompute(bandGeom, t, m_info);
+  }
+}
+
+//---------------------------------------------------------
+
+//! Computes a frame tile. If the frame was split into bands, they are
+//! computed concurrently by the invoking thread and the helper threads of the
+//! shared pool that are idle, which bounds the threads of all the tasks.
+//! Upstream resources shared by bands are computed once, as the cache
+//! manager makes concurrent requests of a resource wait for each other.
+void RenderTask::computeTile(const TRasterFxP &fx, TTile &tile, double t) {
+  if (m_bands.empty()) {
+    fx->compute(tile, t, m_info);
+    return;
+  }
+
+  BandsJob job(fx, tile, t, m_info, m_bands);
+
+  QThread *taskThread       = QThread::currentThread();
+  TRendererImp *rendererImp = m_rendererImp.getPointer();
+  unsigned long renderId    = m_renderId;
+
+  TThread::runConcurrently(
+      [&job, taskThread, rendererImp, renderId]() {
+        if (QThread::currentThread() == taskThread) {
+          job.run();
+          return;
+        }
+
+        // Install the renderer in the helper thread
+        rendererStorage.setLocalData(new (TRendererImp *)(rendererImp));
+        renderIdsStorage.setLocalData(new unsigned long(renderId));
+
+        job.run();
+
+        rendererStorage.setLocalData(0);
+        renderIdsStorage.setLocalData(0);
+      },
+      m_bandThreadsCount - 1);
+
+  job.rethrow();
 }
 
 //---------------------------------------------------------
@@ -993,31 +1163,31 @@ void RenderTask::run() {
       // Common case - just build the first tile
       buildTile(m_tileA);
       /*-- Normally, Fx rendering process is performed here --*/
-      m_fx.m_frameA->compute(m_tileA, t, m_info);
+      computeTile(m_fx.m_frameA, m_tileA, t);
     } else {
       assert(!(m_stereoscopic && m_fieldRender));
       // Field rendering  or stereoscopic case
       if (m_stereoscopic) {
         buildTile(m_tileA);
-        m_fx.m_frameA->compute(m_tileA, t, m_info);
+        computeTile(m_fx.m_frameA, m_tileA, t);
 
         buildTile(m_tileB);
-        m_fx.m_frameB->compute(m_tileB, t, m_info);
+        computeTile(m_fx.m_frameB, m_tileB, t);
       }
       // if fieldPrevalence, Decide the rendering frames depending on field
       // prevalence
       else if (m_info.m_fieldPrevalence == TRenderSettings::EvenField) {
         buildTile(m_tileA);
-        m_fx.m_frameA->compute(m_tileA, t, m_info);
+        computeTile(m_fx.m_frameA, m_tileA, t);
 
         buildTile(m_tileB);
-        m_fx.m_frameB->compute(m_tileB, t + 0.5, m_info);
+        computeTile(m_fx.m_frameB, m_tileB, t + 0.5);
       } else {
         buildTile(m_tileB);
-        m_fx.m_frameA->compute(m_tileB, t, m_info);
+        computeTile(m_fx.m_frameA, m_tileB, t);
 
         buildTile(m_tileA);
-        m_fx.m_frameB->compute(m_tileA, t + 0.5, m_info);
+        computeTile(m_fx.m_frameB, m_tileA, t + 0.5);
       }
     }
 
@@ -1452,6 +1622,18 @@ void TRendererImp::startRendering(
   clusters.clear();
 
   std::vector<RenderTask *>::iterator kt, kEnd = tasksVector.end();
+
+  // When there are fewer frames than threads, the idle threads help
+  // computing each frame in bands
+  {
+    int threadsCount = std::min(m_executor.maxActiveTasks(),
+                                TSystem::getProcessorCount());
+    int tasksCount   = (int)tasksVector.size();
+
+    if (tasksCount > 0 && tasksCount < threadsCount)
+      for (kt = tasksVector.begin(); kt != kEnd; ++kt)
+        (*kt)->setBandsCount(threadsCount / tasksCount);
+  }
   {
     // Install TRenderer on current thread before proceeding
     locals::StorageDeclaration storageDecl(this, renderId);
@@ -83,7 +83,7 @@ std::string TGeometryFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
     }
     alias += ",";
   }
@@ -182,7 +182,7 @@ std::string ColumnColorFilterFx::getAlias(double frame,
   if (m_port.isConnected()) {
     TRasterFxP ifx = m_port.getFx();
     assert(ifx);
-    alias += ifx->getAlias(frame, info);
+    alias += ifx->getCachedAlias(frame, info);
   }
   alias += ",";
 
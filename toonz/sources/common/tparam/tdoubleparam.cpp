@@ -15,8 +15,15 @@
 #include "tparser.h"
 #include "tunit.h"
 
+// Qt includes
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+
 // STD includes
 #include <set>
+#include <cmath>
+#include <memory>
 
 #include "tdoubleparam.h"
 
@@ -294,6 +301,91 @@ inline double getSimilarShapeValue(const TActualDoubleKeyframe &k0,
 
 //===================================================================
 
+//! A keyframe based segment of the curve, with everything that does not
+//! depend on the frame already computed.
+struct CompiledDoubleSegment {
+  int m_type, m_step;         // m_step is 0 on segments without step
+  double m_frame0, m_frame1;  // m_frame1 is the last step frame, if stepped
+  double m_value0, m_value1;
+  TPointD m_speed0, m_speed1;  // Truncated speeds (SpeedInOut)
+  double m_x1, m_x2, m_x3, m_v, m_e0, m_e1;  // Ease in/out shape
+
+  double getValue(double frame) const;
+};
+
+//---------------------------------------------------------
+
+double CompiledDoubleSegment::getValue(double frame) const {
+  if (m_step > 0) {
+    if (frame > m_frame1) frame = m_frame1;
+    frame = m_frame0 + tfloor(tfloor(frame - m_frame0), m_step);
+  }
+
+  switch (m_type) {
+  case TDoubleKeyframe::Constant:
+    return (frame == m_frame1) ? m_value1 : m_value0;
+
+  case TDoubleKeyframe::Exponential:
+    if (m_value0 > 0 && m_value1 > 0) {
+      double t = (frame - m_frame0) / (m_frame1 - m_frame0);
+      if (m_value1 < m_value0)
+        return m_value1 * exp((1 - t) * log(m_value0 / m_value1));
+      return m_value0 * exp(t * log(m_value1 / m_value0));
+    }
+    // fall through: not positive values are interpolated linearly
+
+  case TDoubleKeyframe::Linear:
+    return m_value0 +
+           (frame - m_frame0) * (m_value1 - m_value0) / (m_frame1 - m_frame0);
+
+  case TDoubleKeyframe::SpeedInOut:
+    if (frame <= m_frame0)
+      return m_value0;
+    else if (frame >= m_frame1)
+      return m_value1;
+    return getCubicBezierY(frame, TPointD(m_frame0, m_value0), m_speed0,
+                           m_speed1, TPointD(m_frame1, m_value1));
+
+  case TDoubleKeyframe::EaseInOut:
+  case TDoubleKeyframe::EaseInOutPercentage: {
+    if (m_x3 <= 0.0) return m_value0;
+    double x = frame - m_frame0;
+    if (x <= 0)
+      return m_value0;
+    else if (x >= m_x3)
+      return m_value1;
+    double value;
+    if (x < m_x1)
+      value = 0.5 * (m_v / m_e0) * x * x;
+    else if (x > m_x2)
+      value = 1 - 0.5 * (m_v / m_e1) * (m_x3 - x) * (m_x3 - x);
+    else
+      value = x * m_v - 0.5 * m_v * m_e0;
+    return (1 - value) * m_value0 + value * m_value1;
+  }
+
+  default:
+    return 0.0;
+  }
+}
+
+//---------------------------------------------------------
+
+//! The compiled form of a whole curve. Once published it is never modified:
+//! a change builds a new one, while readers keep the one they hold.
+struct CompiledDoubleCurve {
+  int m_changeCount;  // Of the curve it was built from
+  bool m_isCompilable;
+  bool m_cycleEnabled;
+  double m_cycleValueOffset;  // Last minus first keyframe value
+  std::vector<double> m_frames;
+  std::vector<CompiledDoubleSegment> m_segments;
+
+  double getValue(double frame, bool leftmost) const;
+};
+
+//===================================================================
+
 class TDoubleParam::Imp {
 public:
   const TSyntax::Grammar *m_grammar;
@@ -305,6 +397,14 @@ public:
 
   std::set<TParamObserver *> m_observers;
 
+  // Compiled form of the curve. It is built on the first getValue() after a
+  // change, and used only when every segment is keyframe based - expressions
+  // and files may depend on other curves. Accessed with std::atomic_load()
+  // and std::atomic_store(), as readers don't lock.
+  std::shared_ptr<const CompiledDoubleCurve> m_compiled;
+  QAtomicInt m_changeCount;
+  QMutex m_compileMutex;
+
   Imp(double v = 0.0)
       : m_grammar(0)
       , m_measureName()
@@ -312,7 +412,8 @@ public:
       , m_defaultValue(v)
       , m_minValue(-(std::numeric_limits<double>::max)())
       , m_maxValue((std::numeric_limits<double>::max)())
-      , m_cycleEnabled(false) {}
+      , m_cycleEnabled(false)
+      , m_changeCount(0) {}
 
   ~Imp() {}
 
@@ -325,9 +426,13 @@ public:
     m_maxValue     = src->m_maxValue;
     m_keyframes    = src->m_keyframes;
     m_cycleEnabled = src->m_cycleEnabled;
+    invalidate();
   }
 
   void notify(const TParamChange &change) {
+    // Every change to the curve is notified
+    invalidate();
+
     std::set<TParamObserver *>::iterator it = m_observers.begin();
     for (; it != m_observers.end(); ++it) (*it)->onChange(change);
   }
@@ -336,10 +441,155 @@ public:
   double getSpeed(int segmentIndex, double frame);
   TPointD getSpeedIn(int kIndex);
   TPointD getSpeedOut(int kIndex);
+
+  void invalidate() { m_changeCount.fetchAndAddOrdered(1); }
+  std::shared_ptr<const CompiledDoubleCurve> getCompiled();
+  std::shared_ptr<const CompiledDoubleCurve> compile(int changeCount);
 };
 
 //---------------------------------------------------------
 
+//! Returns the compiled form of the curve, or 0 if it can't be compiled.
+std::shared_ptr<const CompiledDoubleCurve> TDoubleParam::Imp::getCompiled() {
+  int changeCount = m_changeCount.loadAcquire();
+
+  std::shared_ptr<const CompiledDoubleCurve> compiled =
+      std::atomic_load(&m_compiled);
+  if (!compiled || compiled->m_changeCount != changeCount) {
+    QMutexLocker locker(&m_compileMutex);
+    compiled = std::atomic_load(&m_compiled);
+    if (!compiled || compiled->m_changeCount != changeCount) {
+      compiled = compile(changeCount);
+      std::atomic_store(&m_compiled, compiled);
+    }
+  }
+
+  if (!compiled->m_isCompilable) compiled.reset();
+  return compiled;
+}
+
+//---------------------------------------------------------
+
+//! Builds the compiled form of the curve, which readers may use as soon as
+//! it is published.
+std::shared_ptr<const CompiledDoubleCurve> TDoubleParam::Imp::compile(
+    int changeCount) {
+  std::shared_ptr<CompiledDoubleCurve> compiled(new CompiledDoubleCurve);
+  compiled->m_changeCount = changeCount;
+
+  int k, kCount = m_keyframes.size();
+  for (k = 0; k + 1 < kCount; ++k)
+    if (!TDoubleKeyframe::isKeyframeBased(m_keyframes[k].m_type)) break;
+
+  compiled->m_isCompilable = (kCount > 1 && k + 1 >= kCount);
+  if (!compiled->m_isCompilable) return compiled;
+
+  compiled->m_cycleEnabled = m_cycleEnabled;
+  compiled->m_cycleValueOffset =
+      m_keyframes.back().m_value - m_keyframes.front().m_value;
+
+  std::vector<double> &frames                  = compiled->m_frames;
+  std::vector<CompiledDoubleSegment> &segments = compiled->m_segments;
+  frames.resize(kCount);
+  segments.resize(kCount - 1);
+
+  for (k = 0; k < kCount; ++k) frames[k] = m_keyframes[k].m_frame;
+
+  for (k = 0; k + 1 < kCount; ++k) {
+    const TActualDoubleKeyframe &a = m_keyframes[k], &b = m_keyframes[k + 1];
+    CompiledDoubleSegment &seg     = segments[k];
+
+    seg.m_type   = a.m_type;
+    seg.m_step   = 0;
+    seg.m_frame0 = a.m_frame, seg.m_value0 = a.m_value;
+    seg.m_frame1 = b.m_frame, seg.m_value1 = b.m_value;
+
+    if (a.m_step > 1) {
+      int relPos = tfloor(b.m_frame - a.m_frame);
+      if (relPos < 1) {
+        // Stepped segment shorter than a frame: leave it to getValue()
+        compiled->m_isCompilable = false;
+        return compiled;
+      }
+      seg.m_step   = std::min(a.m_step, relPos);
+      seg.m_frame1 = a.m_frame + tfloor(relPos, seg.m_step);
+    }
+
+    if (seg.m_type == TDoubleKeyframe::SpeedInOut) {
+      seg.m_speed0 = getSpeedOut(k), seg.m_speed1 = getSpeedIn(k + 1);
+      truncateSpeeds(seg.m_frame0, seg.m_frame1, seg.m_speed0, seg.m_speed1);
+    } else if (seg.m_type == TDoubleKeyframe::EaseInOut ||
+               seg.m_type == TDoubleKeyframe::EaseInOutPercentage) {
+      double x3 = seg.m_frame1 - seg.m_frame0;
+      double e0 = std::max(a.m_speedOut.x, 0.0);
+      double e1 = std::max(-b.m_speedIn.x, 0.0);
+      if (seg.m_type == TDoubleKeyframe::EaseInOutPercentage) {
+        e0 *= x3 * 0.01;
+        e1 *= x3 * 0.01;
+      }
+      if (e0 + e1 >= x3) {
+        double x = tcrop((e0 + x3 - e1) / 2, 0.0, x3);
+        e0       = x;
+        e1       = x3 - x;
+      }
+      double x1 = e0, x2 = x3 - e1;
+      if (0 < x1 - x2 && x1 - x2 < 0.1e-5)
+        x1 = x2 = (x1 + x2) * 0.5;  // against rounding problems
+
+      seg.m_x1 = x1, seg.m_x2 = x2, seg.m_x3 = x3;
+      seg.m_e0 = e0, seg.m_e1 = e1;
+      seg.m_v  = (x3 > 0.0) ? 2 / (x3 + x2 - x1) : 0.0;
+    }
+  }
+
+  return compiled;
+}
+
+//---------------------------------------------------------
+
+double CompiledDoubleCurve::getValue(double frame, bool leftmost) const {
+  const std::vector<double> &frames = m_frames;
+
+  double f0 = frames.front(), f1 = frames.back();
+  if (frame < f0)
+    frame = f0;
+  else if (frame > f1 && !m_cycleEnabled)
+    frame = f1;
+  double valueOffset = 0;
+
+  if (m_cycleEnabled && frame >= f1 && (frame != f1 || !leftmost)) {
+    double dist   = f1 - f0;
+    double dvalue = m_cycleValueOffset;
+
+    // Wrap the frame back into [f0, f1); with leftmost, cycle boundaries
+    // belong to the previous cycle
+    double cycles = std::floor((frame - f0) / dist);
+    frame -= cycles * dist;
+    if (frame >= f1)
+      frame -= dist, cycles += 1;
+    else if (frame < f0)
+      frame = f0;
+    if (leftmost && frame == f0) frame = f1, cycles -= 1;
+
+    valueOffset = cycles * dvalue;
+  }
+
+  // frame is in [f0,f1]
+  int b = std::lower_bound(frames.begin(), frames.end(), frame) -
+          frames.begin(),
+      a;
+  if (frames[b] == frame && b + 1 < (int)frames.size())
+    a = b;
+  else
+    a = b - 1;
+
+  if (leftmost && frame - frames[a] < 0.00001 && a > 0) --a;
+
+  return m_segments[a].getValue(frame) + valueOffset;
+}
+
+//---------------------------------------------------------
+
 double TDoubleParam::Imp::getValue(int segmentIndex, double frame) {
   assert(0 <= segmentIndex && segmentIndex + 1 < (int)m_keyframes.size());
   const TActualDoubleKeyframe &k0 = m_keyframes[segmentIndex];
@@ -535,6 +785,9 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
   } else if (keyframes.size() == 1) {
     // a single keyframe. Type must be keyframe based (no expression/file)
     value = keyframes[0].m_value;
+  } else if (std::shared_ptr<const CompiledDoubleCurve> compiled =
+                 m_imp->getCompiled()) {
+    value = compiled->getValue(frame, leftmost);
   } else {
     // keyframes range is [f0,f1]
     double f0 = keyframes.begin()->m_frame;
@@ -671,6 +924,22 @@ double TDoubleParam::getValue(double frame, bool leftmost) const {
 
 //---------------------------------------------------------
 
+void TDoubleParam::getValues(const double *frames, int count, double *values,
+                             bool leftmost) const {
+  assert(m_imp);
+  std::shared_ptr<const CompiledDoubleCurve> compiled;
+  if (m_imp->m_keyframes.size() > 1) compiled = m_imp->getCompiled();
+
+  if (compiled) {
+    for (int i = 0; i < count; ++i)
+      values[i] = compiled->getValue(frames[i], leftmost);
+  } else {
+    for (int i = 0; i < count; ++i) values[i] = getValue(frames[i], leftmost);
+  }
+}
+
+//---------------------------------------------------------
+
 bool TDoubleParam::setValue(double frame, double value) {
   assert(m_imp);
   DoubleKeyframeVector &keyframes = m_imp->m_keyframes;
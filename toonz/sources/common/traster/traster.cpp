@@ -26,6 +26,7 @@ TRaster::TRaster(int lx, int ly, int pixelSize)
     , m_wrap(lx)
     , m_parent(0)
     , m_bufferOwner(true)
+    , m_arenaBuffer(false)
     , m_buffer(0)
     , m_lockCount(0)
     , m_isLinear(false)
@@ -83,6 +84,7 @@ TRaster::TRaster(int lx, int ly, int pixelSize, int wrap, UCHAR *buffer,
     , m_wrap(wrap)
     , m_buffer(buffer)
     , m_bufferOwner(bufferOwner)
+    , m_arenaBuffer(false)
     , m_lockCount(0)
     , m_isLinear(false)
 #ifdef _DEBUG
@@ -419,25 +421,6 @@ void TRaster::clear() {
 
 //------------------------------------------------------------
 
-void TRaster::remap(UCHAR *newLocation) {
-  if (m_parent) {
-    assert(m_parent->m_buffer > newLocation);
-
-    assert(m_parent->m_parent == 0);
-
-    int offset = (int)(m_buffer - m_parent->m_buffer);
-    assert(offset >= 0);
-
-    // m_parent->remap(newLocation);
-    m_buffer = newLocation + offset;
-  } else {
-    assert(m_buffer > newLocation);
-    m_buffer = newLocation;
-  }
-}
-
-//------------------------------------------------------------
-
 void TRaster::clearOutside(const TRect &rect) {
   if (m_lx == 0 || m_ly == 0) return;
   TRect r = rect * getBounds();
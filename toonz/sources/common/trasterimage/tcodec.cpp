@@ -16,9 +16,8 @@
 #include "lz4frame.h"
 #endif
 
-#include <QDir>
-#include <QProcess>
-#include <QCoreApplication>
+#include "lzo/lzoconf.h"
+#include "lzo/lzo1x.h"
 
 using namespace std;
 
@@ -569,31 +568,45 @@ void TRasterCodecLz4::decompress(const TRasterP &compressedRas,
 
 namespace {
 
-bool lzoCompress(const QByteArray src, QByteArray &dst) {
-  QDir exeDir(QCoreApplication::applicationDirPath());
-  QString compressExe = exeDir.filePath("lzocompress");
-  QProcess process;
-  process.start(compressExe, QStringList() << QString::number(src.size()));
-  if (!process.waitForStarted()) return false;
-  process.write(src);
-  if (!process.waitForFinished()) return false;
-  dst = process.readAll();
-  return process.exitCode() == 0;
+bool lzoInit() {
+  static const bool initialized = (lzo_init() == LZO_E_OK);
+  return initialized;
 }
 
-bool lzoDecompress(const QByteArray src, int dstSize, QByteArray &dst) {
-  QDir exeDir(QCoreApplication::applicationDirPath());
-  QString decompressExe = exeDir.filePath("lzodecompress");
-  QProcess process;
-  process.start(decompressExe, QStringList() << QString::number(dstSize)
-                                             << QString::number(src.size()));
-  if (!process.waitForStarted()) return false;
-  process.write(src);
-  if (!process.waitForFinished()) return false;
-  dst = process.readAll();
-  return process.exitCode() == 0 && dst.size() == dstSize;
+//------------------------------------------------------------------------------
+
+// The LZO1X routines keep no global state: each call works on its own
+// buffers, so frames can be (de)compressed from any number of threads.
+
+bool lzoCompress(const char *src, size_t srcSize, std::vector<char> &dst) {
+  if (!lzoInit()) return false;
+
+  // Worst case expansion of LZO1X, see the LZO FAQ
+  dst.resize(srcSize + srcSize / 16 + 64 + 3);
+  std::vector<lzo_align_t> wrkmem(
+      (LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+
+  lzo_uint dstSize = 0;
+  if (lzo1x_1_compress((const lzo_bytep)src, srcSize, (lzo_bytep)&dst[0],
+                       &dstSize, &wrkmem[0]) != LZO_E_OK)
+    return false;
+
+  dst.resize(dstSize);
+  return true;
 }
+
+//------------------------------------------------------------------------------
+
+bool lzoDecompress(const char *src, size_t srcSize, char *dst,
+                   size_t dstSize) {
+  if (!lzoInit()) return false;
+
+  lzo_uint outSize = dstSize;
+  return lzo1x_decompress_safe((const lzo_bytep)src, srcSize, (lzo_bytep)dst,
+                               &outSize, 0) == LZO_E_OK &&
+         outSize == dstSize;
 }
+}  // namespace
 
 //------------------------------------------------------------------------------
 
@@ -622,9 +635,11 @@ UINT TRasterCodecLZO::doCompress(const TRasterP &inRas, int allocUnit,
   // compress data
   inRas->lock();
   char *inData = (char *)inRas->getRawData();
-  QByteArray compressedBuffer;
-  if (!lzoCompress(QByteArray(inData, inDataSize), compressedBuffer))
+  std::vector<char> compressedBuffer;
+  if (!lzoCompress(inData, inDataSize, compressedBuffer)) {
+    inRas->unlock();
     throw TException("LZO compression failed");
+  }
 
   inRas->unlock();
 
@@ -716,29 +731,14 @@ bool TRasterCodecLZO::decompress(const UCHAR *inData, TINT32 inDataSize,
 
   size_t outSize = outDataSize;  // Calculate output buffer size
 
-  QByteArray decompressedBuffer;
-  if (!lzoDecompress(QByteArray(mc, ds), outSize, decompressedBuffer))
-    throw TException("LZO decompression failed");
-
   outRas->lock();
-  memcpy(outRas->getRawData(), decompressedBuffer.data(),
-         decompressedBuffer.size());
-  bool rc = true;
-
+  bool rc = lzoDecompress(mc, ds, (char *)outRas->getRawData(), outSize);
   outRas->unlock();
 
-  /*
-if (rc != true)                                     // Check success code here
-{
-if (safeMode)
-return false;
-else
-{
-throw TException("decompress... something goes bad");
-return false;
-}
-}
-  */
+  if (!rc) {
+    if (safeMode) return false;
+    throw TException("LZO decompression failed");
+  }
 
   assert(outSize == (size_t)outDataSize);
   return true;
@@ -772,21 +772,13 @@ void TRasterCodecLZO::decompress(const TRasterP &compressedRas,
 
   size_t outSize = outDataSize;  // Calculate output buffer size
 
-  char *outData = (char *)outRas->getRawData();
-
-  QByteArray decompressedBuffer;
-  if (!lzoDecompress(QByteArray(mc, ds), outSize, decompressedBuffer))
-    throw TException("LZO decompression failed");
   outRas->lock();
-  memcpy(outRas->getRawData(), decompressedBuffer.data(),
-         decompressedBuffer.size());
-  bool rc = true;
-
+  bool rc = lzoDecompress(mc, ds, (char *)outRas->getRawData(), outSize);
   outRas->unlock();
   compressedRas->unlock();
 
   if (rc != true)  // Check success code here
-    throw TException("decompress... something goes bad");
+    throw TException("LZO decompression failed");
 
   assert(outSize == (size_t)outDataSize);
 }
@@ -4,18 +4,13 @@
 #include "trop.h"
 #include "tpixelgr.h"
 
-#if defined(_WIN32) && defined(x64)
-#define USE_SSE2
-#endif
-
-#ifdef USE_SSE2
-#include <emmintrin.h>
-#include <stdlib.h>
-#endif
+#include "tropsimdP.h"
 
 namespace {
 
-#ifdef _WIN32
+// Same channel order of the raster pixels: the SSE2 code moves whole pixels
+// between rasters and blur buffers
+#if defined(TNZ_MACHINE_CHANNEL_ORDER_BGRM)
 template <class T>
 struct BlurPixel {
   T b;
@@ -24,6 +19,15 @@ struct BlurPixel {
   T m;
 };
 
+#elif defined(TNZ_MACHINE_CHANNEL_ORDER_MRGB)
+template <class T>
+struct BlurPixel {
+  T m;
+  T r;
+  T g;
+  T b;
+};
+
 #else
 template <class T>
 struct BlurPixel {
@@ -248,8 +252,8 @@ inline void blur_code_SSE2(T *row1, BlurPixel<P> *row2, int length, float coeff,
   pix2 = row1 - 1;
 
   //
-  __m128i piPix1 = _mm_cvtsi32_si128(*(DWORD *)pix1);
-  __m128i piPix2 = _mm_cvtsi32_si128(*(DWORD *)pix2);
+  __m128i piPix1 = _mm_cvtsi32_si128(*(TUINT32 *)pix1);
+  __m128i piPix2 = _mm_cvtsi32_si128(*(TUINT32 *)pix2);
 
   piPix1 = _mm_unpacklo_epi8(piPix1, zeros);
   piPix2 = _mm_unpacklo_epi8(piPix2, zeros);
@@ -266,8 +270,8 @@ inline void blur_code_SSE2(T *row1, BlurPixel<P> *row2, int length, float coeff,
   sigma3     = _mm_load1_ps(&zero);
 
   for (i = 1; i < brad; i++) {
-    piPix1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix1), zeros);
-    piPix2 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix2), zeros);
+    piPix1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix1), zeros);
+    piPix2 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix2), zeros);
 
     __m128 pPix1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(piPix1, zeros));
     __m128 pPix2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(piPix2, zeros));
@@ -302,13 +306,13 @@ inline void blur_code_SSE2(T *row1, BlurPixel<P> *row2, int length, float coeff,
 isum = _mm_packs_epi32(isum, zeros);
 isum = _mm_packs_epi16(isum, zeros);
 
-*(DWORD*)row2 = _mm_cvtsi128_si32(isum);
+*(TUINT32 *)row2 = _mm_cvtsi128_si32(isum);
 */
   _mm_store_ps((float *)row2, sum);
   row2++;
 
   __m128i piPixMin =
-      _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)(row1 - brad)), zeros);
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)(row1 - brad)), zeros);
   __m128 pPixMin = _mm_cvtepi32_ps(_mm_unpacklo_epi16(piPixMin, zeros));
   sigma2         = _mm_add_ps(sigma2, pPixMin);
   /*
@@ -326,12 +330,12 @@ sigma2.m += row1[-brad].m;
   desigma = _mm_sub_ps(sigma1, sigma2);
 
   for (i = 1; i < length; i++) {
-    piPix1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix1), zeros);
-    piPix2 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix2), zeros);
+    piPix1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix1), zeros);
+    piPix2 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix2), zeros);
     __m128i piPix3 =
-        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix3), zeros);
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix3), zeros);
     __m128i piPix4 =
-        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)pix4), zeros);
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)pix4), zeros);
 
     __m128 pPix1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(piPix1, zeros));
     __m128 pPix2 =
@@ -355,7 +359,7 @@ isum = _mm_cvtps_epi32(sum);
 isum = _mm_packs_epi32(isum, zeros);
 isum = _mm_packs_epi16(isum, zeros);
 
-*(DWORD*)row2 = _mm_cvtsi128_si32(isum);
+*(TUINT32 *)row2 = _mm_cvtsi128_si32(isum);
 */
     _mm_store_ps((float *)row2, sum);
 
@@ -427,8 +431,8 @@ inline void blur_code_SSE2(BlurPixel<P> *row1, T *row2, int length, float coeff,
   __m128i isum = _mm_cvtps_epi32(sum);
   isum         = _mm_packs_epi32(isum, zeros);
   // isum = _mm_packs_epi16(isum, zeros);
-  isum           = _mm_packus_epi16(isum, zeros);
-  *(DWORD *)row2 = _mm_cvtsi128_si32(isum);
+  isum             = _mm_packus_epi16(isum, zeros);
+  *(TUINT32 *)row2 = _mm_cvtsi128_si32(isum);
 
   row2++;
 
@@ -468,15 +472,15 @@ inline void blur_code_SSE2(BlurPixel<P> *row1, T *row2, int length, float coeff,
     isum         = _mm_packs_epi32(isum, zeros);
     // isum = _mm_packs_epi16(isum, zeros);  // QUESTA RIGA E' SBAGLIATA
     // assert(false);
-    isum           = _mm_packus_epi16(isum, zeros);
-    *(DWORD *)row2 = _mm_cvtsi128_si32(isum);
+    isum             = _mm_packus_epi16(isum, zeros);
+    *(TUINT32 *)row2 = _mm_cvtsi128_si32(isum);
 
     row2++;
     pix1++, pix2++, pix3++, pix4++;
   }
 }
 
-#endif  // _WIN32
+#endif  // USE_SSE2
 
 //-------------------------------------------------------------------
 
@@ -788,7 +792,7 @@ void do_filtering_floatRgb(T *row1, BlurPixel<P> *row2, int length, float coeff,
 
 
 #ifdef USE_SSE2
-  if (useSSE)
+  if (useSSE && T::maxChannelValue == 255)
     blur_code_SSE2<T, P>(row1, row2, length, coeff, coeffq, brad, diff, 0);
   else
 #endif
@@ -826,14 +830,14 @@ void doBlurRgb(TRasterPT<T> &dstRas, TRasterPT<T> &srcRas, double blur, int dx,
   BlurPixel<P> *row2, *col1, *fbuffer;
   TRasterGR8P r1;
 
-#ifdef _WIN32
+#ifdef USE_SSE2
   if (useSSE) {
-    fbuffer =
-        (BlurPixel<P> *)_aligned_malloc(llx * ly * sizeof(BlurPixel<P>), 16);
-    row1 = (T *)_aligned_malloc((llx + 2 * brad) * sizeof(T), 16);
-    col1 = (BlurPixel<P> *)_aligned_malloc(
+    fbuffer = (BlurPixel<P> *)TRopSimd::alignedMalloc(
+        llx * ly * sizeof(BlurPixel<P>), 16);
+    row1 = (T *)TRopSimd::alignedMalloc((llx + 2 * brad) * sizeof(T), 16);
+    col1 = (BlurPixel<P> *)TRopSimd::alignedMalloc(
         (lly + 2 * brad) * sizeof(BlurPixel<P>), 16);
-    col2 = (T *)_aligned_malloc(lly * sizeof(T), 16);
+    col2 = (T *)TRopSimd::alignedMalloc(lly * sizeof(T), 16);
   } else
 #endif
   {
@@ -848,12 +852,12 @@ void doBlurRgb(TRasterPT<T> &dstRas, TRasterPT<T> &srcRas, double blur, int dx,
 
   if ((!fbuffer) || (!row1) || (!col1) || (!col2)) {
     if (!useSSE) r1->unlock();
-#ifdef _WIN32
+#ifdef USE_SSE2
     if (useSSE) {
-      _aligned_free(col2);
-      _aligned_free(col1);
-      _aligned_free(row1);
-      _aligned_free(fbuffer);
+      TRopSimd::alignedFree(col2);
+      TRopSimd::alignedFree(col1);
+      TRopSimd::alignedFree(row1);
+      TRopSimd::alignedFree(fbuffer);
     } else
 #endif
     {
@@ -891,12 +895,12 @@ void doBlurRgb(TRasterPT<T> &dstRas, TRasterPT<T> &srcRas, double blur, int dx,
     dstRas->clear();
   }
 
-#ifdef _WIN32
+#ifdef USE_SSE2
   if (useSSE) {
-    _aligned_free(col2);
-    _aligned_free(col1);
-    _aligned_free(row1);
-    _aligned_free(fbuffer);
+    TRopSimd::alignedFree(col2);
+    TRopSimd::alignedFree(col1);
+    TRopSimd::alignedFree(row1);
+    TRopSimd::alignedFree(fbuffer);
   } else
 #endif
   {
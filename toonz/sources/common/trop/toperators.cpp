@@ -3,6 +3,8 @@
 #include "trop.h"
 #include "tpixel.h"
 #include "tpixelutils.h"
+#include "tsystem.h"
+#include "tropsimdP.h"
 
 // calls to _mm_* functions disabled in code for now (marked as comment)
 // so disable include <emmintrin.h>
@@ -1878,12 +1880,155 @@ void TRop::overlay(const TRasterP &rup, const TRasterP &rdown,
 */
 //-----------------------------------------------------------------------------
 
+namespace {
+
+/*
+  Vectorized premult() over a row of TPixel32. Each channel is computed as
+  (t + (t >> 8)) >> 8 with t = c * m + 128, which gives the same values as
+  premult() for every c and m. Returns the number of pixels processed; the
+  caller completes the remaining ones.
+*/
+#if defined(USE_SSE2)
+
+#define MATTE_SHUFFLE                                                          \
+  _MM_SHUFFLE(TRopSimd::MatteIndex, TRopSimd::MatteIndex,                      \
+              TRopSimd::MatteIndex, TRopSimd::MatteIndex)
+
+int premultRow_SSE2(TPixel32 *pix, int count) {
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i half  = _mm_set1_epi16(128);
+
+  // the matte lane is multiplied by 255, so that it stays unchanged
+  short colorMask[8], matteFac[8];
+  for (int i = 0; i < 8; ++i) {
+    bool isMatte = (i % 4) == TRopSimd::MatteIndex;
+    colorMask[i] = isMatte ? 0 : -1;
+    matteFac[i]  = isMatte ? 255 : 0;
+  }
+  const __m128i colorMask_packed = _mm_loadu_si128((const __m128i *)colorMask);
+  const __m128i matteFac_packed  = _mm_loadu_si128((const __m128i *)matteFac);
+
+  int n = count & ~3;
+  for (int i = 0; i < n; i += 4) {
+    __m128i pix_packed = _mm_loadu_si128((const __m128i *)(pix + i));
+
+    __m128i half_packed[2] = {_mm_unpacklo_epi8(pix_packed, zeros),
+                              _mm_unpackhi_epi8(pix_packed, zeros)};
+    for (int h = 0; h < 2; ++h) {
+      __m128i fac = _mm_shufflehi_epi16(
+          _mm_shufflelo_epi16(half_packed[h], MATTE_SHUFFLE), MATTE_SHUFFLE);
+      fac = _mm_or_si128(_mm_and_si128(fac, colorMask_packed), matteFac_packed);
+
+      __m128i t = _mm_add_epi16(_mm_mullo_epi16(half_packed[h], fac), half);
+      t         = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+      // (t + (t >> 8)) >> 8
+      half_packed[h] = _mm_srli_epi16(t, 8);
+    }
+
+    _mm_storeu_si128((__m128i *)(pix + i),
+                     _mm_packus_epi16(half_packed[0], half_packed[1]));
+  }
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+
+#if defined(USE_AVX2)
+
+// Same as premultRow_SSE2(), on 8 pixels at a time
+TROPSIMD_AVX2 int premultRow_AVX2(TPixel32 *pix, int count) {
+  const __m256i zeros = _mm256_setzero_si256();
+  const __m256i half  = _mm256_set1_epi16(128);
+
+  short colorMask[16], matteFac[16];
+  for (int i = 0; i < 16; ++i) {
+    bool isMatte = (i % 4) == TRopSimd::MatteIndex;
+    colorMask[i] = isMatte ? 0 : -1;
+    matteFac[i]  = isMatte ? 255 : 0;
+  }
+  const __m256i colorMask_packed =
+      _mm256_loadu_si256((const __m256i *)colorMask);
+  const __m256i matteFac_packed = _mm256_loadu_si256((const __m256i *)matteFac);
+
+  // Unpacking and packing work within 128-bit lanes, so pixels get back
+  // to their places
+  int n = count & ~7;
+  for (int i = 0; i < n; i += 8) {
+    __m256i pix_packed = _mm256_loadu_si256((const __m256i *)(pix + i));
+
+    __m256i half_packed[2] = {_mm256_unpacklo_epi8(pix_packed, zeros),
+                              _mm256_unpackhi_epi8(pix_packed, zeros)};
+    for (int h = 0; h < 2; ++h) {
+      __m256i fac = _mm256_shufflehi_epi16(
+          _mm256_shufflelo_epi16(half_packed[h], MATTE_SHUFFLE),
+          MATTE_SHUFFLE);
+      fac = _mm256_or_si256(_mm256_and_si256(fac, colorMask_packed),
+                            matteFac_packed);
+
+      __m256i t =
+          _mm256_add_epi16(_mm256_mullo_epi16(half_packed[h], fac), half);
+      t = _mm256_add_epi16(t, _mm256_srli_epi16(t, 8));
+      // (t + (t >> 8)) >> 8
+      half_packed[h] = _mm256_srli_epi16(t, 8);
+    }
+
+    _mm256_storeu_si256((__m256i *)(pix + i),
+                        _mm256_packus_epi16(half_packed[0], half_packed[1]));
+  }
+  return n;
+}
+
+#endif
+
+#undef MATTE_SHUFFLE
+
+#elif defined(USE_NEON)
+
+int premultRow_NEON(TPixel32 *pix, int count) {
+  int n = count & ~7;
+  for (int i = 0; i < n; i += 8) {
+    uint8x8x4_t pix_packed = vld4_u8((const uint8_t *)(pix + i));
+    uint8x8_t m            = pix_packed.val[TRopSimd::MatteIndex];
+
+    for (int c = 0; c < 4; ++c) {
+      if (c == TRopSimd::MatteIndex) continue;
+      uint16x8_t t = vmull_u8(pix_packed.val[c], m);
+      // (t + 128 + ((t + 128) >> 8)) >> 8
+      pix_packed.val[c] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+    }
+
+    vst4_u8((uint8_t *)(pix + i), pix_packed);
+  }
+  return n;
+}
+
+#endif
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
 void TRop::premultiply(const TRasterP &ras) {
   ras->lock();
   TRaster32P ras32 = ras;
   TRaster64P ras64 = ras;
   TRasterFP rasF   = ras;
   if (ras32) {
+    // Vectorized row kernel, if any
+    int (*premultRow)(TPixel32 *, int) = 0;
+#if defined(USE_SSE2)
+#if defined(USE_AVX2)
+    if (TSystem::getCPUExtensions() & TSystem::CpuSupportsAvx2)
+      premultRow = premultRow_AVX2;
+    else
+#endif
+    if (TSystem::getCPUExtensions() & TSystem::CpuSupportsSse2)
+      premultRow = premultRow_SSE2;
+#elif defined(USE_NEON)
+    if (TSystem::getCPUExtensions() & TSystem::CpuSupportsNeon)
+      premultRow = premultRow_NEON;
+#endif
+
     TPixel32 *endPix, *upPix = 0, *upRow = ras32->pixels();
     TPixel32 *lastPix =
         upRow + ras32->getWrap() * (ras32->getLy() - 1) + ras32->getLx();
@@ -1891,6 +2036,7 @@ void TRop::premultiply(const TRasterP &ras) {
     while (upPix < lastPix) {
       upPix  = upRow;
       endPix = upPix + ras32->getLx();
+      if (premultRow) upPix += premultRow(upPix, ras32->getLx());
       while (upPix < endPix) {
         premult(*upPix);
         ++upPix;
@@ -7,13 +7,7 @@
 #include "tropcm.h"
 #include "tpalette.h"
 
-#if defined(_WIN32) && defined(x64)
-#define USE_SSE2
-#endif
-
-#ifdef USE_SSE2
-#include <emmintrin.h>  // per SSE2
-#endif
+#include "tropsimdP.h"
 
 //-----------------------------------------------------------------------------
 namespace {
@@ -162,15 +156,132 @@ void do_overT2(TRasterPT<T> rout, const TRasterPT<T> &rup) {
 
 #ifdef USE_SSE2
 
+inline void overPixel_SSE2(TPixel32 *out_pix, const TPixel32 *up_pix) {
+  if (up_pix->m == 0xff)
+    *out_pix = *up_pix;
+  else if (up_pix->m > 0) {
+    const __m128i zeros                = _mm_setzero_si128();
+    const __m128 maxChanneValue_packed = _mm_set1_ps(255.0f);
+
+    float factor         = (255.0f - up_pix->m) / 255.0f;
+    __m128 factor_packed = _mm_load1_ps(&factor);
+
+    // carica up_pix e out_pix in due registri a 128 bit
+    __m128i up_pix_packed_i =
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const TUINT32 *)up_pix), zeros);
+    __m128 up_pix_packed =
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(up_pix_packed_i, zeros));
+
+    __m128i out_pix_packed_i =
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(TUINT32 *)out_pix), zeros);
+    __m128 out_pix_packed =
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(out_pix_packed_i, zeros));
+
+    out_pix_packed =
+        _mm_add_ps(up_pix_packed, _mm_mul_ps(out_pix_packed, factor_packed));
+    out_pix_packed = _mm_min_ps(maxChanneValue_packed, out_pix_packed);
+
+    out_pix_packed_i      = _mm_cvtps_epi32(out_pix_packed);
+    out_pix_packed_i      = _mm_packs_epi32(out_pix_packed_i, zeros);
+    out_pix_packed_i      = _mm_packus_epi16(out_pix_packed_i, zeros);
+    *(TUINT32 *)(out_pix) = _mm_cvtsi128_si32(out_pix_packed_i);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 void do_over_SSE2(TRaster32P rout, const TRaster32P &rup) {
-  __m128i zeros = _mm_setzero_si128();
-  __m128i out_pix_packed_i, up_pix_packed_i;
-  __m128 out_pix_packed, up_pix_packed;
+  assert(rout->getSize() == rup->getSize());
+  for (int y = 0; y < rout->getLy(); y++) {
+    TPixel32 *out_pix       = rout->pixels(y);
+    TPixel32 *const out_end = out_pix + rout->getLx();
+    const TPixel32 *up_pix  = rup->pixels(y);
+
+    for (; out_pix < out_end; ++out_pix, ++up_pix)
+      overPixel_SSE2(out_pix, up_pix);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+#ifdef USE_AVX2
+
+// Blends 8 pixels at a time, one per 32-bit lane, with the same float
+// arithmetic as overPixel_SSE2() - so that results don't depend on the CPU
+TROPSIMD_AVX2 void do_over_AVX2(TRaster32P rout, const TRaster32P &rup) {
+  const __m256i channelMask           = _mm256_set1_epi32(0xff);
+  const __m256i zeros                 = _mm256_setzero_si256();
+  const __m256 maxChannelValue_packed = _mm256_set1_ps(255.0f);
+
+  const __m128i matteShift = _mm_cvtsi32_si128(8 * TRopSimd::MatteIndex);
+
+  assert(rout->getSize() == rup->getSize());
+  for (int y = 0; y < rout->getLy(); y++) {
+    TPixel32 *out_pix       = rout->pixels(y);
+    TPixel32 *const out_end = out_pix + rout->getLx();
+    const TPixel32 *up_pix  = rup->pixels(y);
 
-  float maxChannelValue    = 255.0;
-  float maxChannelValueInv = 1.0f / maxChannelValue;
+    for (; out_end - out_pix >= 8; out_pix += 8, up_pix += 8) {
+      __m256i up_packed = _mm256_loadu_si256((const __m256i *)up_pix);
+      __m256i m_packed  = _mm256_and_si256(
+          _mm256_srl_epi32(up_packed, matteShift), channelMask);
 
-  __m128 maxChanneValue_packed = _mm_load1_ps(&maxChannelValue);
+      __m256i transparent = _mm256_cmpeq_epi32(m_packed, zeros);
+      if (_mm256_movemask_epi8(transparent) == -1) continue;
+
+      if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(m_packed, channelMask)) ==
+          -1) {
+        _mm256_storeu_si256((__m256i *)out_pix, up_packed);
+        continue;
+      }
+
+      __m256i out_packed = _mm256_loadu_si256((const __m256i *)out_pix);
+      __m256 factor_packed =
+          _mm256_div_ps(_mm256_sub_ps(maxChannelValue_packed,
+                                      _mm256_cvtepi32_ps(m_packed)),
+                        maxChannelValue_packed);
+
+      __m256i result_packed = zeros;
+      for (int c = 0; c < 4; ++c) {
+        __m128i shift = _mm_cvtsi32_si128(8 * c);
+
+        __m256 up_c = _mm256_cvtepi32_ps(
+            _mm256_and_si256(_mm256_srl_epi32(up_packed, shift), channelMask));
+        __m256 out_c = _mm256_cvtepi32_ps(
+            _mm256_and_si256(_mm256_srl_epi32(out_packed, shift), channelMask));
+
+        out_c = _mm256_add_ps(up_c, _mm256_mul_ps(out_c, factor_packed));
+        out_c = _mm256_min_ps(maxChannelValue_packed, out_c);
+
+        result_packed = _mm256_or_si256(
+            result_packed, _mm256_sll_epi32(_mm256_cvtps_epi32(out_c), shift));
+      }
+
+      // Fully transparent up pixels leave the output unchanged
+      result_packed =
+          _mm256_blendv_epi8(result_packed, out_packed, transparent);
+      _mm256_storeu_si256((__m256i *)out_pix, result_packed);
+    }
+
+    for (; out_pix < out_end; ++out_pix, ++up_pix)
+      overPixel_SSE2(out_pix, up_pix);
+  }
+}
+
+#endif
+
+#elif defined(USE_NEON)
+
+// Expands the channels of a pixel to four floats, in memory order
+inline float32x4_t unpackPixel_NEON(const TPixel32 *pix) {
+  uint8x8_t pix_u8 = vreinterpret_u8_u32(vdup_n_u32(*(const TUINT32 *)pix));
+  return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(pix_u8))));
+}
+
+//-----------------------------------------------------------------------------
+
+void do_over_NEON(TRaster32P rout, const TRaster32P &rup) {
+  const float32x4_t maxChannelValue_packed = vdupq_n_f32(255.0f);
 
   assert(rout->getSize() == rup->getSize());
   for (int y = 0; y < rout->getLy(); y++) {
@@ -182,28 +293,18 @@ void do_over_SSE2(TRaster32P rout, const TRaster32P &rup) {
       if (up_pix->m == 0xff)
         *out_pix = *up_pix;
       else if (up_pix->m > 0) {
-        float factor         = (255.0f - up_pix->m) / 255.0f;
-        __m128 factor_packed = _mm_load1_ps(&factor);
-
-        // carica up_pix e out_pix in due registri a 128 bit
-        up_pix_packed_i =
-            _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)up_pix), zeros);
-        up_pix_packed =
-            _mm_cvtepi32_ps(_mm_unpacklo_epi16(up_pix_packed_i, zeros));
-
-        out_pix_packed_i =
-            _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(DWORD *)out_pix), zeros);
-        out_pix_packed =
-            _mm_cvtepi32_ps(_mm_unpacklo_epi16(out_pix_packed_i, zeros));
-
-        out_pix_packed = _mm_add_ps(up_pix_packed,
-                                    _mm_mul_ps(out_pix_packed, factor_packed));
-        out_pix_packed = _mm_min_ps(maxChanneValue_packed, out_pix_packed);
-
-        out_pix_packed_i    = _mm_cvtps_epi32(out_pix_packed);
-        out_pix_packed_i    = _mm_packs_epi32(out_pix_packed_i, zeros);
-        out_pix_packed_i    = _mm_packus_epi16(out_pix_packed_i, zeros);
-        *(DWORD *)(out_pix) = _mm_cvtsi128_si32(out_pix_packed_i);
+        float factor = (255.0f - up_pix->m) / 255.0f;
+
+        float32x4_t up_pix_packed  = unpackPixel_NEON(up_pix);
+        float32x4_t out_pix_packed = unpackPixel_NEON(out_pix);
+
+        out_pix_packed = vmlaq_n_f32(up_pix_packed, out_pix_packed, factor);
+        out_pix_packed = vminq_f32(maxChannelValue_packed, out_pix_packed);
+
+        // rounds and packs the channels back to bytes
+        uint16x4_t out_u16    = vqmovun_s32(vcvtnq_s32_f32(out_pix_packed));
+        uint8x8_t out_u8      = vqmovn_u16(vcombine_u16(out_u16, out_u16));
+        *(TUINT32 *)(out_pix) = vget_lane_u32(vreinterpret_u32_u8(out_u8), 0);
       }
     }
   }
@@ -358,10 +459,19 @@ void TRop::over(const TRasterP &rout, const TRasterP &rup, const TPoint &pos) {
 
   // TRaster64P rout64 = rout, rin64 = rin;
   if (rout32 && rup32) {
-#ifdef USE_SSE2
+#if defined(USE_SSE2)
+#ifdef USE_AVX2
+    if (TSystem::getCPUExtensions() & TSystem::CpuSupportsAvx2)
+      do_over_AVX2(rout32, rup32);
+    else
+#endif
     if (TSystem::getCPUExtensions() & TSystem::CpuSupportsSse2)
       do_over_SSE2(rout32, rup32);
     else
+#elif defined(USE_NEON)
+    if (TSystem::getCPUExtensions() & TSystem::CpuSupportsNeon)
+      do_over_NEON(rout32, rup32);
+    else
 #endif
       do_overT2<TPixel32, UCHAR>(rout32, rup32);
   } else if (rout64) {
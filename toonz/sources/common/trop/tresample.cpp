@@ -18,13 +18,7 @@
 
 using namespace TConsts;
 
-#if defined(_WIN32) && defined(x64)
-#define USE_SSE2
-#endif
-
-#ifdef USE_SSE2
-#include <emmintrin.h>  // per SSE2
-#endif
+#include "tropsimdP.h"
 
 #include <memory>
 
@@ -1602,17 +1596,7 @@ void resample_main_rgbm<TPixelF, double>(
 
 namespace {
 
-DV_ALIGNED(16) class TPixelFloat {
-public:
-  TPixelFloat() : b(0), g(0), r(0), m(0) {}
-
-  TPixelFloat(float rr, float gg, float bb, float mm)
-      : b(bb), g(gg), r(rr), m(mm) {}
-
-  TPixelFloat(const TPixel32 &pix) : b(pix.b), g(pix.g), r(pix.r), m(pix.m) {}
-
-  float b, g, r, m;
-};
+typedef TRopSimd::TPixelFloat TPixelFloat;
 
 }  // anonymous namespace
 
@@ -1740,7 +1724,7 @@ void resample_main_rgbm_SSE2(TRasterPT<T> rout, const TRasterPT<T> &rin,
 
             pix_value          = buffer_in[pix_u + pix_v * wrap_in];
             pix_value_packed_i = _mm_unpacklo_epi8(
-                _mm_cvtsi32_si128(*(DWORD *)&pix_value), zeros);
+                _mm_cvtsi32_si128(*(TUINT32 *)&pix_value), zeros);
             pix_value_packed =
                 _mm_cvtepi32_ps(_mm_unpacklo_epi16(pix_value_packed_i, zeros));
 
@@ -1761,9 +1745,9 @@ void resample_main_rgbm_SSE2(TRasterPT<T> rout, const TRasterPT<T> &rin,
           out_fval_packed = _mm_min_ps(out_fval_packed, maxChanneValue_packed);
 
           __m128i out_value_packed_i = _mm_cvtps_epi32(out_fval_packed);
-          out_value_packed_i  = _mm_packs_epi32(out_value_packed_i, zeros);
-          out_value_packed_i  = _mm_packus_epi16(out_value_packed_i, zeros);
-          *(DWORD *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
+          out_value_packed_i    = _mm_packs_epi32(out_value_packed_i, zeros);
+          out_value_packed_i    = _mm_packus_epi16(out_value_packed_i, zeros);
+          *(TUINT32 *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
         } else
           *pix_out = buffer_in[ref_u + ref_v * wrap_in];
       } else
@@ -1807,7 +1791,7 @@ void resample_main_rgbm_SSE2(TRasterPT<T> rout, const TRasterPT<T> &rin,
 
               pix_value          = buffer_in[pix_u + pix_v * wrap_in];
               pix_value_packed_i = _mm_unpacklo_epi8(
-                  _mm_cvtsi32_si128(*(DWORD *)&pix_value), zeros);
+                  _mm_cvtsi32_si128(*(TUINT32 *)&pix_value), zeros);
               pix_value_packed = _mm_cvtepi32_ps(
                   _mm_unpacklo_epi16(pix_value_packed_i, zeros));
 
@@ -1829,9 +1813,9 @@ void resample_main_rgbm_SSE2(TRasterPT<T> rout, const TRasterPT<T> &rin,
                 _mm_min_ps(out_fval_packed, maxChanneValue_packed);
 
             __m128i out_value_packed_i = _mm_cvtps_epi32(out_fval_packed);
-            out_value_packed_i  = _mm_packs_epi32(out_value_packed_i, zeros);
-            out_value_packed_i  = _mm_packus_epi16(out_value_packed_i, zeros);
-            *(DWORD *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
+            out_value_packed_i    = _mm_packs_epi32(out_value_packed_i, zeros);
+            out_value_packed_i    = _mm_packus_epi16(out_value_packed_i, zeros);
+            *(TUINT32 *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
           } else
             *pix_out = buffer_in[ref_u + ref_v * wrap_in];
         } else {
@@ -1867,7 +1851,7 @@ void inline blendBySSE2(TPixel32 *pix_out, float *ink, float *paint,
   pix_value_packed_i         = _mm_packs_epi32(pix_value_packed_i, zeros);
   pix_value_packed_i         = _mm_packus_epi16(pix_value_packed_i, zeros);
 
-  *(DWORD *)(pix_out) = _mm_cvtsi128_si32(pix_value_packed_i);
+  *(TUINT32 *)(pix_out) = _mm_cvtsi128_si32(pix_value_packed_i);
 }
 
 //---------------------------------------------------------------------------
@@ -1891,7 +1875,7 @@ void inline blendBySSE2(__m128 &pix_out_packed, float *ink, float *paint,
 
 }  // namespace
 
-#endif  // _WIN32
+#endif  // USE_SSE2
 //---------------------------------------------------------------------------
 
 static void get_prow_gr8(const TRasterGR8P &rin, double a11, double a12,
@@ -3562,9 +3546,9 @@ void resample_main_cm32_rgbm_SSE2(TRasterPT<T> rout, const TRasterCM32P &rin,
       std::max({count, TPixelCM32::getMaxInk(), TPixelCM32::getMaxPaint()});
 
   TPixelFloat *paints =
-      (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
+      (TPixelFloat *)TRopSimd::alignedMalloc(count2 * sizeof(TPixelFloat), 16);
   TPixelFloat *inks =
-      (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
+      (TPixelFloat *)TRopSimd::alignedMalloc(count2 * sizeof(TPixelFloat), 16);
 
   std::vector<TPixel32> paints2(count2);
   std::vector<TPixel32> inks2(count2);
@@ -3641,9 +3625,9 @@ void resample_main_cm32_rgbm_SSE2(TRasterPT<T> rout, const TRasterCM32P &rin,
           out_fval_packed = _mm_min_ps(out_fval_packed, maxChanneValue_packed);
 
           __m128i out_value_packed_i = _mm_cvtps_epi32(out_fval_packed);
-          out_value_packed_i  = _mm_packs_epi32(out_value_packed_i, zeros);
-          out_value_packed_i  = _mm_packus_epi16(out_value_packed_i, zeros);
-          *(DWORD *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
+          out_value_packed_i    = _mm_packs_epi32(out_value_packed_i, zeros);
+          out_value_packed_i    = _mm_packus_epi16(out_value_packed_i, zeros);
+          *(TUINT32 *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
         } else {
           int pix_in_pos           = ref_u + ref_v * wrap_in;
           const TPixelCM32 *pix_in = buffer_in + pix_in_pos;
@@ -3723,9 +3707,9 @@ void resample_main_cm32_rgbm_SSE2(TRasterPT<T> rout, const TRasterCM32P &rin,
           out_fval_packed = _mm_min_ps(out_fval_packed, maxChanneValue_packed);
 
           __m128i out_value_packed_i = _mm_cvtps_epi32(out_fval_packed);
-          out_value_packed_i  = _mm_packs_epi32(out_value_packed_i, zeros);
-          out_value_packed_i  = _mm_packus_epi16(out_value_packed_i, zeros);
-          *(DWORD *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
+          out_value_packed_i    = _mm_packs_epi32(out_value_packed_i, zeros);
+          out_value_packed_i    = _mm_packus_epi16(out_value_packed_i, zeros);
+          *(TUINT32 *)(pix_out) = _mm_cvtsi128_si32(out_value_packed_i);
         } else {
           int pix_in_pos           = ref_u + ref_v * wrap_in;
           const TPixelCM32 *pix_in = buffer_in + pix_in_pos;
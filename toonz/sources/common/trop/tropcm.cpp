@@ -23,28 +23,15 @@ extern "C" {
 #include "toonz4.6/raster.h"
 }
 
-#if defined(_WIN32) && defined(x64)
-#define USE_SSE2
-#endif
+#include "tropsimdP.h"
 
 #ifdef USE_SSE2
-#include <emmintrin.h>
 
 //---------------------------------------------------------
 
 namespace {
 
-DV_ALIGNED(16) class TPixelFloat {
-public:
-  TPixelFloat() : b(0), g(0), r(0), m(0) {}
-
-  TPixelFloat(float rr, float gg, float bb, float mm)
-      : b(bb), g(gg), r(rr), m(mm) {}
-
-  TPixelFloat(const TPixel32 &pix) : b(pix.b), g(pix.g), r(pix.r), m(pix.m) {}
-
-  float b, g, r, m;
-};
+typedef TRopSimd::TPixelFloat TPixelFloat;
 
 }  // anonymous namespace
 
@@ -78,10 +65,10 @@ void TRop::convert(const TRaster32P &rasOut, const TRasterCM32P &rasIn,
 #ifdef USE_SSE2
   if (TSystem::getCPUExtensions() & TSystem::CpuSupportsSse2) {
     __m128i zeros = _mm_setzero_si128();
-    TPixelFloat *paints =
-        (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
-    TPixelFloat *inks =
-        (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
+    TPixelFloat *paints = (TPixelFloat *)TRopSimd::alignedMalloc(
+        count2 * sizeof(TPixelFloat), 16);
+    TPixelFloat *inks = (TPixelFloat *)TRopSimd::alignedMalloc(
+        count2 * sizeof(TPixelFloat), 16);
 
     std::vector<TPixel32> paints2(count2);
     std::vector<TPixel32> inks2(count2);
@@ -158,7 +145,7 @@ paints[i]  = TPixelFloat(paints2[i]);
           outPix_packed_i         = _mm_packs_epi32(outPix_packed_i, zeros);
           outPix_packed_i         = _mm_packus_epi16(outPix_packed_i, zeros);
 
-          *(DWORD *)(pix32) = _mm_cvtsi128_si32(outPix_packed_i);
+          *(TUINT32 *)(pix32) = _mm_cvtsi128_si32(outPix_packed_i);
           ++pix32;
         }
         }
@@ -166,11 +153,11 @@ paints[i]  = TPixelFloat(paints2[i]);
       }
     }
 
-    _aligned_free(paints);
-    _aligned_free(inks);
+    TRopSimd::alignedFree(paints);
+    TRopSimd::alignedFree(inks);
 
   } else  // SSE2 not supported
-#endif    // _WIN32
+#endif    // USE_SSE2
   {
 
     std::vector<TPixel32> paints(count2, TPixel32(255, 0, 0));
@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef TROPSIMDP_H
+#define TROPSIMDP_H
+
+#include "tpixel.h"
+
+#include <stdlib.h>
+
+/*
+  SIMD support shared by the raster operations.
+
+  SSE2 is part of the x86-64 instruction set and NEON of the AArch64 one, so
+  their kernels are built for every 64-bit platform of those families, not
+  only on Windows. TSystem::getCPUExtensions() is still checked before
+  using them.
+
+  AVX2 kernels are built on x86-64 too, each function being marked with
+  TROPSIMD_AVX2 so that the rest of the code keeps targeting plain x86-64.
+  They must only run when TSystem::getCPUExtensions() reports AVX2.
+*/
+
+#if (defined(_WIN32) && defined(x64)) || defined(__x86_64__) || defined(_M_X64)
+#define USE_SSE2
+#include <emmintrin.h>  // per SSE2
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#define USE_AVX2
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TROPSIMD_AVX2 __attribute__((target("avx2")))
+#else
+#define TROPSIMD_AVX2
+#endif
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define USE_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+//-----------------------------------------------------------------------------
+
+namespace TRopSimd {
+
+//! Allocates memory with the alignment required by aligned SIMD loads.
+inline void *alignedMalloc(size_t size, size_t alignment = 16) {
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void *ptr = 0;
+  return posix_memalign(&ptr, alignment, size) ? 0 : ptr;
+#endif
+}
+
+//! Frees memory returned by alignedMalloc().
+inline void alignedFree(void *ptr) {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+//! Index of the matte channel in the memory layout of TPixel32 and
+//! TPixel64.
+#if defined(TNZ_MACHINE_CHANNEL_ORDER_MBGR) ||                                 \
+    defined(TNZ_MACHINE_CHANNEL_ORDER_MRGB)
+const int MatteIndex = 0;
+#else
+const int MatteIndex = 3;
+#endif
+
+//-----------------------------------------------------------------------------
+
+//! A TPixel32 with float channels, laid out in memory like TPixel32 so that
+//! vector registers map the same channels of both.
+class DV_ALIGNED(16) TPixelFloat {
+public:
+  TPixelFloat() : r(0), g(0), b(0), m(0) {}
+
+  TPixelFloat(float rr, float gg, float bb, float mm)
+      : r(rr), g(gg), b(bb), m(mm) {}
+
+  TPixelFloat(const TPixel32 &pix) : r(pix.r), g(pix.g), b(pix.b), m(pix.m) {}
+
+#if defined(TNZ_MACHINE_CHANNEL_ORDER_BGRM)
+  float b, g, r, m;
+#elif defined(TNZ_MACHINE_CHANNEL_ORDER_MBGR)
+  float m, b, g, r;
+#elif defined(TNZ_MACHINE_CHANNEL_ORDER_MRGB)
+  float m, r, g, b;
+#else
+  float r, g, b, m;
+#endif
+};
+
+}  // namespace TRopSimd
+
+#endif
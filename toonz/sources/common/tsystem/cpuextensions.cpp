@@ -6,13 +6,53 @@
 #include <winnt.h>
 #include <emmintrin.h>
 #endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
 using namespace TSystem;
 
-#ifdef x64
+#if defined(x64) || defined(__x86_64__) || defined(_M_X64)
+namespace {
+
+// AVX2 requires both the CPU support and the OS saving the ymm registers
+bool CPUCheckForAvx2Support() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+
+  __cpuid(info, 1);
+  bool osXSave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+  if (!(osXSave && avx) || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+}  // anonymous namespace
+
+//------------------------------------------------------------------------------
+
+long TSystem::getCPUExtensions() {
+  // SSE and SSE2 are part of the x86-64 instruction set, AVX2 is checked once
+  static const long extensions =
+      TSystem::CpuSupportsSse | TSystem::CpuSupportsSse2 |
+      (CPUCheckForAvx2Support() ? TSystem::CpuSupportsAvx2 : 0);
+  return extensions;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
 long TSystem::getCPUExtensions() {
-  return TSystem::CpuSupportsSse |
-         TSystem::CpuSupportsSse2;  // TSystem::CPUExtensionsNone
+  // NEON is part of the AArch64 instruction set
+  return TSystem::CpuSupportsNeon;
 }
 
 #else
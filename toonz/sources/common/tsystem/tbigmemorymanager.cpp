@@ -1,49 +1,289 @@
-
-
 #include "traster.h"
 #include "tbigmemorymanager.h"
 #include "timagecache.h"
-#include "tsystem.h"
-#include "tconvert.h"
+
+#include <QThreadStorage>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <atomic>
+#include <cstring>
+#include <map>
 #include <set>
-#include "tfilepath_io.h"
+#include <vector>
 
 #ifdef _DEBUG
 std::set<TRaster *> Rasters;
 #endif
 
-#ifdef TNZCORE_LIGHT
-#ifdef MessageBox
-#undef MessageBox
-#endif
+namespace {
 
-#define MessageBox MessageBoxA
-#endif
+// Buffers smaller than this are left to the C runtime
+const size_t c_minArenaSize = 64 << 10;
+
+// Default maximum amount of memory kept in the buffer caches
+const TINT64 c_maxCachedSize = 512 << 20;
+
+// Maximum amount of memory kept in the cache of each thread
+const TINT64 c_maxThreadCachedSize = 64 << 20;
+
+const int c_shardsCount = 8;
+
+// Frames at the common camera sizes, at 32, 64 and 128 bits per pixel. The
+// 512x512 tiles of TCacheResource fall on the geometric classes.
+const size_t c_frameSizes[] = {
+    1280 * 720 * 4,  1280 * 720 * 8,   1920 * 1080 * 4, 1280 * 720 * 16,
+    1920 * 1080 * 8, 1920 * 1080 * 16, 3840 * 2160 * 8, 3840 * 2160 * 16};
+
+//------------------------------------------------------------------------------
+
+//! Returns the size of the class of the buffers of the specified size.
+size_t getClassSize(size_t size) {
+  if (size < c_minArenaSize) return size;
+
+  // Four classes for each power of 2, so that less than 25% of a buffer is
+  // wasted
+  size_t step = c_minArenaSize / 4;
+  while (step * 8 < size) step <<= 1;
+
+  size_t classSize = (size + step - 1) / step * step;
+
+  for (size_t frameSize : c_frameSizes)
+    if (size <= frameSize) return std::min(frameSize, classSize);
+
+  return classSize;
+}
+
+//------------------------------------------------------------------------------
+
+int getShard(size_t classSize) {
+  int shard = 0;
+  while ((classSize >>= 1) >= c_minArenaSize) ++shard;
+  return shard % c_shardsCount;
+}
+
+//------------------------------------------------------------------------------
+
+void updateMax(std::atomic<TINT64> &max, TINT64 value) {
+  TINT64 current = max;
+  while (current < value && !max.compare_exchange_weak(current, value)) {
+  }
+}
+
+//------------------------------------------------------------------------------
+
+typedef std::map<size_t, std::vector<UCHAR *>> FreeBuffers;  // by class
+
+//! Frees the buffers, and returns their total size.
+TINT64 freeAll(FreeBuffers &buffers) {
+  TINT64 size = 0;
+  for (auto &it : buffers) {
+    for (UCHAR *buffer : it.second) free(buffer);
+    size += it.first * it.second.size();
+  }
+  buffers.clear();
+  return size;
+}
+
+//------------------------------------------------------------------------------
+
+UCHAR *popBuffer(FreeBuffers &buffers, size_t classSize) {
+  FreeBuffers::iterator it = buffers.find(classSize);
+  if (it == buffers.end() || it->second.empty()) return 0;
+
+  UCHAR *buffer = it->second.back();
+  it->second.pop_back();
+  return buffer;
+}
+
+}  // namespace
+
+//==============================================================================
+// TBigMemoryManager::Arena
+//==============================================================================
+
+/*!
+  Recycles the raster buffers by size class. Large buffers fresh from the
+  system must be faulted in page by page each time, which costs far more
+  than clearing a recycled one.
+
+  Each thread keeps its own cache, with no locking; beyond it, buffers go to
+  a shared cache split in shards, each with its own mutex. Buffers are never
+  moved, once given to a raster.
+*/
+class TBigMemoryManager::Arena {
+  struct ThreadCache {
+    Arena *m_arena;
+    FreeBuffers m_buffers;
+    TINT64 m_size;
+    int m_trimCount;
+
+    ThreadCache(Arena *arena)
+        : m_arena(arena), m_size(0), m_trimCount(arena->m_trimCount) {}
+    ~ThreadCache() { clear(); }
+
+    void clear() {
+      m_arena->m_cachedSize -= freeAll(m_buffers);
+      m_size = 0;
+    }
+  };
+
+  struct Shard {
+    QMutex m_mutex;
+    FreeBuffers m_buffers;
+  };
+
+  QThreadStorage<ThreadCache *> m_threadCaches;
+  Shard m_shards[c_shardsCount];
+
+  std::atomic<TINT64> m_usedSize, m_peakUsedSize, m_cachedSize;
+  std::atomic<int> m_trimCount;  // Thread caches are cleared when it changes
+
+  std::atomic<TINT64> m_allocationsCount, m_recycledCount, m_allocationsSize,
+      m_maxAllocationSize;
 
-class Chunkinfo {
 public:
-  TUINT32 m_size;
-  // int m_locks;
-  std::vector<TRaster *> m_rasters;
-  // bool m_putInNormalMemory;
-  Chunkinfo(TUINT32 size, TRaster *ras)  //, bool putInNormalMemory=false)
-      : m_size(size)
-        //, m_locks(0)
-        ,
-        m_rasters()
-  //, m_putInNormalMemory(putInNormalMemory)
-  {
-    if (ras) m_rasters.push_back(ras);
+  Arena()
+      : m_usedSize(0)
+      , m_peakUsedSize(0)
+      , m_cachedSize(0)
+      , m_trimCount(0)
+      , m_allocationsCount(0)
+      , m_recycledCount(0)
+      , m_allocationsSize(0)
+      , m_maxAllocationSize(0) {}
+
+  //! Returns a zeroed buffer, or 0 if it can't be allocated within the
+  //! specified budget (0 for none).
+  UCHAR *allocate(TUINT32 size, TINT64 budget) {
+    size_t classSize = getClassSize(size);
+
+    TINT64 usedSize = (m_usedSize += classSize);
+    if (budget && usedSize > budget) {
+      m_usedSize -= classSize;
+      return 0;
+    }
+
+    UCHAR *buffer = takeCached(classSize);
+    if (buffer) {
+      memset(buffer, 0, size);
+      ++m_recycledCount;
+    } else {
+      // Cached buffers hold memory of the budget too
+      if (budget && usedSize + m_cachedSize > budget) trim();
+
+      buffer = (UCHAR *)calloc(classSize, 1);
+      if (!buffer && m_cachedSize > 0) {
+        trim();
+        buffer = (UCHAR *)calloc(classSize, 1);
+      }
+      if (!buffer) {
+        m_usedSize -= classSize;
+        return 0;
+      }
+    }
+
+    updateMax(m_peakUsedSize, usedSize);
+    return buffer;
   }
 
-  Chunkinfo()
-      : m_size(0)
-      //, m_locks(0)
-      , m_rasters()
-  /*, m_putInNormalMemory(false)*/ {}
+  void release(UCHAR *buffer, TUINT32 size, TINT64 budget) {
+    size_t classSize = getClassSize(size);
+    m_usedSize -= classSize;
+
+    TINT64 maxCachedSize = budget ? budget - m_usedSize : c_maxCachedSize;
+    if (classSize < c_minArenaSize ||
+        m_cachedSize + (TINT64)classSize > maxCachedSize) {
+      free(buffer);
+      return;
+    }
+
+    m_cachedSize += classSize;
+
+    ThreadCache &cache = threadCache();
+    if (cache.m_size + (TINT64)classSize <= c_maxThreadCachedSize) {
+      cache.m_buffers[classSize].push_back(buffer);
+      cache.m_size += classSize;
+      return;
+    }
+
+    Shard &shard = m_shards[getShard(classSize)];
+    QMutexLocker sl(&shard.m_mutex);
+    shard.m_buffers[classSize].push_back(buffer);
+  }
+
+  //! Returns the cached buffers to the system. The caches of the other
+  //! threads are cleared the next time they are used.
+  void trim() {
+    ++m_trimCount;
+    threadCache();
+
+    for (Shard &shard : m_shards) {
+      QMutexLocker sl(&shard.m_mutex);
+      m_cachedSize -= freeAll(shard.m_buffers);
+    }
+  }
+
+  void recordAllocation(TUINT32 size) {
+    ++m_allocationsCount;
+    m_allocationsSize += size;
+    updateMax(m_maxAllocationSize, size);
+  }
+
+  TINT64 getUsedSize() const { return m_usedSize; }
+
+  int getAllocationPeakKb() const { return (int)(m_maxAllocationSize >> 10); }
+
+  int getAllocationMeanKb() const {
+    TINT64 count = m_allocationsCount;
+    return count ? (int)((m_allocationsSize / count) >> 10) : 0;
+  }
+
+  Statistics getStatistics() const {
+    Statistics stats;
+    stats.m_allocationsCount = m_allocationsCount;
+    stats.m_recycledCount    = m_recycledCount;
+    stats.m_usedKb           = m_usedSize >> 10;
+    stats.m_peakUsedKb       = m_peakUsedSize >> 10;
+    stats.m_cachedKb         = m_cachedSize >> 10;
+    return stats;
+  }
+
+private:
+  ThreadCache &threadCache() {
+    if (!m_threadCaches.hasLocalData())
+      m_threadCaches.setLocalData(new ThreadCache(this));
+
+    ThreadCache &cache = *m_threadCaches.localData();
+    int trimCount      = m_trimCount;
+    if (cache.m_trimCount != trimCount) {
+      cache.clear();
+      cache.m_trimCount = trimCount;
+    }
+    return cache;
+  }
+
+  UCHAR *takeCached(size_t classSize) {
+    if (classSize < c_minArenaSize || m_cachedSize == 0) return 0;
+
+    ThreadCache &cache = threadCache();
+    UCHAR *buffer      = popBuffer(cache.m_buffers, classSize);
+    if (buffer)
+      cache.m_size -= classSize;
+    else if (m_cachedSize > cache.m_size) {
+      Shard &shard = m_shards[getShard(classSize)];
+      QMutexLocker sl(&shard.m_mutex);
+      buffer = popBuffer(shard.m_buffers, classSize);
+    }
+
+    if (buffer) m_cachedSize -= classSize;
+    return buffer;
+  }
 };
 
-//------------------------------------------------------------
+//==============================================================================
+// TBigMemoryManager
+//==============================================================================
 
 //! Sets the global callback handler for the 'Run out of contiguous memory'
 //! event
@@ -56,164 +296,78 @@ void TBigMemoryManager::setRunOutOfContiguousMemoryHandler(
 
 //------------------------------------------------------------------------------
 
-namespace {
-int allocationPeakKB               = 0;
-unsigned long long allocationSumKB = 0;
-unsigned long allocationCount      = 0;
-}
-
-//------------------------------------------------------------------------------
-
 //! Returns the \b peak size, in KB, of the allocated rasters in current Toonz
 //! session.
-int TBigMemoryManager::getAllocationPeak() { return allocationPeakKB; }
+int TBigMemoryManager::getAllocationPeak() {
+  return m_arena->getAllocationPeakKb();
+}
 
 //------------------------------------------------------------------------------
 
 //! Returns the \b mean size, in KB, of the allocated rasters in current Toonz
 //! session.
 int TBigMemoryManager::getAllocationMean() {
-  return allocationSumKB / allocationCount;
+  return m_arena->getAllocationMeanKb();
 }
 
 //------------------------------------------------------------------------------
 
-TBigMemoryManager *TBigMemoryManager::instance() {
-  static TBigMemoryManager *theManager = 0;
-
-  if (theManager) return theManager;
-
-  return theManager = new TBigMemoryManager();
+TBigMemoryManager::Statistics TBigMemoryManager::getStatistics() const {
+  return m_arena->getStatistics();
 }
 
 //------------------------------------------------------------------------------
-/*
-TBigMemoryManager::~TBigMemoryManager()
-{
-
-if (m_theMemory==0) return;
-QMutexLocker sl(m_mutex);
-assert(m_chunks.empty());
 
-free(m_theMemory);
-theManager = 0;
-}
-*/
+void TBigMemoryManager::releaseCachedMemory() { m_arena->trim(); }
 
 //------------------------------------------------------------------------------
 
-UCHAR *TBigMemoryManager::allocate(UINT &size) {
-  TThread::MutexLocker sl(&m_mutex);
-  UCHAR *chunk = (UCHAR *)calloc(size, 1);
-  while (chunk == 0 && size > 128 * 1024 * 1024) {
-    size -= 128 * 1024 * 1024;
-    chunk = (UCHAR *)calloc(size, 1);
-  }
-  return chunk;
+TBigMemoryManager *TBigMemoryManager::instance() {
+  static TBigMemoryManager *theManager = 0;
+
+  if (theManager) return theManager;
+
+  return theManager = new TBigMemoryManager();
 }
 
 //------------------------------------------------------------------------------
 
 TBigMemoryManager::TBigMemoryManager()
-    : m_chunks()
-    , m_theMemory(0)
-    , m_availableMemory(0)
-    , m_allocatedMemory(0)
+    : m_arena(new Arena)
+    , m_budget(0)
 #ifdef _DEBUG
     , m_totRasterMemInKb(0)
 #endif
-{
+    , m_runOutCallback(0) {
 }
 
 //------------------------------------------------------------------------------
 
-bool TBigMemoryManager::init(TUINT32 sizeinKb) {
-  TThread::MutexLocker sl(&m_mutex);
-
-  if (sizeinKb == 0) return true;
+TBigMemoryManager::~TBigMemoryManager() {}
 
-  if (sizeinKb >= 2 * 1024 * 1024) {
-    //  MessageBox( NULL, "TRONCO!!!", "Warning", MB_OK);
-    sizeinKb = (TUINT32)(1.8 * 1024 * 1024);
-  }
-
-  m_availableMemory = sizeinKb * 1024;
-
-  m_theMemory       = allocate(m_availableMemory);
-  m_allocatedMemory = m_availableMemory;
-
-  if (!m_theMemory) {
-    //  MessageBox( NULL, "Ouch!can't allocate Big Chunk!", "Warning", MB_OK);
-    m_theMemory       = 0;
-    m_availableMemory = 0;
-    return false;
-  }
-  // char str[1024];
-  // sprintf_s(str, "chiesto %d MB, allocato un big chunk di %d MB",
-  // sizeinKb/1024, m_availableMemory/(1024*1024));
-  // MessageBox( NULL, str, "Warning", MB_OK);
+//------------------------------------------------------------------------------
 
-  m_chunks[m_theMemory + m_availableMemory] = Chunkinfo(0, 0);
+//! Activates the manager, keeping the rasters within the specified amount
+//! of memory.
+bool TBigMemoryManager::init(TUINT32 sizeinKb) {
+  m_budget = (TINT64)sizeinKb << 10;
   return true;
 }
 
 //------------------------------------------------------------------------------
-/*
-void TBigMemoryManager::lock(UCHAR *buffer)
-{
-QMutexLocker sl(m_mutex);
-if (m_theMemory==0) return;
-assert(buffer);
-map<UCHAR*, Chunkinfo>::iterator it = m_chunks.find(buffer);
-
-if (it==m_chunks.end()) return;
-
-++it->second.m_locks;
-}
-*/
-//------------------------------------------------------------------------------
-
-/*
-void TBigMemoryManager::unlock(UCHAR *buffer)
-{
-QMutexLocker sl(m_mutex);
-if (m_theMemory==0) return;
-assert(buffer);
-map<UCHAR*, Chunkinfo>::iterator it = m_chunks.find(buffer);
-
-if (it==m_chunks.end()) return;
-int locks = it->second.m_locks;
-
-assert(locks>0);
 
---it->second.m_locks;
+TUINT32 TBigMemoryManager::getAvailableMemoryinKb() const {
+  assert(isActive());
+  TINT64 availableMemory = m_budget - m_arena->getUsedSize();
+  return (availableMemory > 0) ? (TUINT32)(availableMemory >> 10) : 0;
 }
-*/
 
 //------------------------------------------------------------------------------
 
+//! Returns a zeroed buffer for a raster, or 0 if there is no memory for it.
+//! The buffer must be given to a raster with putRaster().
 UCHAR *TBigMemoryManager::getBuffer(UINT size) {
-  if (m_theMemory == 0) return (UCHAR *)calloc(size, 1);
-
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-  UCHAR *buffer     = m_theMemory;
-  TUINT32 chunkSize = 0;
-  UCHAR *address    = 0;
-  while (it != m_chunks.end()) {
-    /*if (it->second.m_putInNormalMemory)
-{it++; continue;}*/
-
-    if ((TUINT32)((it->first) - (buffer + chunkSize)) >= size) {
-      address = buffer + chunkSize;
-      break;
-    }
-
-    buffer    = it->first;
-    chunkSize = it->second.m_size;
-    it++;
-  }
-  if (address) memset(address, 0x00, size);
-  return address;
+  return m_arena->allocate(size, m_budget);
 }
 
 //---------------------------------------------------------------------------------
@@ -245,6 +399,8 @@ void TBigMemoryManager::getRasterInfo(int &rasterCount,
 
 #endif
 
+//------------------------------------------------------------------------------
+
 bool TBigMemoryManager::putRaster(TRaster *ras, bool canPutOnDisk) {
   if (!ras->m_parent && ras->m_buffer) {
 #ifdef _DEBUG
@@ -253,9 +409,8 @@ bool TBigMemoryManager::putRaster(TRaster *ras, bool canPutOnDisk) {
     return true;
   }
 
-#ifdef _DEBUG
-  checkConsistency();
-#endif
+  // i sotto-raster usano il buffer del padre
+  if (ras->m_parent) return true;
 
   TUINT32 size = ras->getLx() * ras->getLy() * ras->getPixelSize();
 
@@ -264,417 +419,49 @@ bool TBigMemoryManager::putRaster(TRaster *ras, bool canPutOnDisk) {
     return true;
   }
 
-  if (m_theMemory == 0)  // il bigmemorymanager e' inattivo
-  {
-    if (!ras->m_parent) {
-      int sizeKB       = size >> 10;
-      allocationPeakKB = std::max(allocationPeakKB, sizeKB);
-      allocationSumKB += sizeKB;
-      allocationCount++;
-    }
-
-    if (!ras->m_parent && !(ras->m_buffer = (UCHAR *)calloc(size, 1))) {
-      // MessageBox( NULL, "Ouch!can't allocate!", "Warning", MB_OK);
-      // non c'e' memoria; provo a comprimere
-      /*TImageCache::instance()->doCompress(); 
-    if (!(ras->m_buffer = (UCHAR *)malloc(size)))*/  // andata male pure cosi';
-                                                     // metto tutto su disco
-      // TImageCache::instance()->outputMap(size, "C:\\logCacheFailure");
-      TINT64 availMemInKb = TSystem::getFreeMemorySize(true);
-      if (availMemInKb > (size >> 10)) {
-        // char str[1024];
-        // sprintf_s(str, "Non alloco, ma : memoria (KB) richiesta : %d -
-        // memoria disponibile : %d", size>>10, availMemInKb);
-        // MessageBox( NULL, (LPCSTR)str, (LPCSTR)"Segmentation!", MB_OK);
-      }
-      ras->m_buffer = TImageCache::instance()->compressAndMalloc(size);
-
-      if (!ras->m_buffer) {
-        // char str[1024];
-        // sprintf_s(str, "E' andata male: faccio il log della cache.");
-        // MessageBox( NULL, (LPCSTR)str, (LPCSTR)"Segmentation!", MB_OK);
-        TImageCache::instance()->outputMap(size, "C:\\logCacheTotalFailure");
-      } else {
-#ifdef _DEBUG
-        m_totRasterMemInKb += size >> 10;
-        Rasters.insert(ras);
-#endif
-      }
-      return ras->m_buffer != 0;
-    } else {
-      if (!ras->m_parent) {
-#ifdef _DEBUG
-        m_totRasterMemInKb += size >> 10;
-        Rasters.insert(ras);
-#endif
-      }
-      return true;
-    }
-  }
-
-  // il bigmemorymanager e' attivo
-  TThread::MutexLocker sl(&m_mutex);
-
-  /*
-if (m_availableMemory<size && !ras->m_parent)
-{
-TImageCache::instance()->compressAndMalloc(size);
-if (m_availableMemory>=size)
-return TBigMemoryManager::instance()->putRaster(ras);
-else
-return (ras->m_buffer = (UCHAR *)malloc(size))!=0;
-
-
-}*/
+  m_arena->recordAllocation(size);
 
-  if (ras->m_parent) {
-    std::map<UCHAR *, Chunkinfo>::iterator it =
-        m_chunks.find(ras->m_parent->m_buffer);
+  ras->m_buffer = m_arena->allocate(size, m_budget);
 
-    if (it != m_chunks.end()) {
-#ifdef _DEBUG
-// assert(!it->second.m_rasters.empty());
-// for (UINT i=0; i<it->second.m_rasters.size(); i++)
-//  assert (it->second.m_rasters[i]!=ras);
-#endif
-
-      it->second.m_rasters.push_back(ras);
-    }
-#ifdef _DEBUG
-    checkConsistency();
-#endif
-    return true;
-  }
+  // non c'e' memoria; provo a liberarne comprimendo la cache
+  if (!ras->m_buffer && canPutOnDisk)
+    ras->m_buffer = TImageCache::instance()->compressAndMalloc(size);
 
-  UCHAR *address = 0;
-  bool remapped  = false;
+  if (ras->m_buffer)
+    ras->m_arenaBuffer = true;
+  else if (isActive())
+    // Out of budget: the system may have some more memory
+    ras->m_buffer = (UCHAR *)calloc(size, 1);
 
-  assert(m_chunks.size() > 0);
-
-  /*if (m_chunks.size()==1) //c'e' solo l'elemento che marca la fine del
-bufferone
-{
-if ((TUINT32)(m_chunks.begin()->first-m_theMemory)>=size)
-address = m_theMemory;
-}
-else
-{*/
-
-  address = getBuffer(size);
-
-#ifdef _DEBUG
-  checkConsistency();
-#endif
-
-  if (address == 0 && m_availableMemory >= size) {
-    address  = remap(size);
-    remapped = true;
-#ifdef _DEBUG
-    checkConsistency();
-#endif
-  } else if (address == 0) {
-    printLog(size);
-    // assert(!"la bigmemory e' piena...scritto log");
-  }
-  //}
-  if (address == 0) {
-    if (canPutOnDisk)
-      address = TImageCache::instance()->compressAndMalloc(size);
-    if (address == 0) return (ras->m_buffer = (UCHAR *)calloc(size, 1)) != 0;
+  if (!ras->m_buffer) {
+    TImageCache::instance()->outputMap(size, "C:\\logCacheTotalFailure");
+    return false;
   }
 
-  // assert(address);
-
-  ras->m_buffer     = address;
-  m_chunks[address] = Chunkinfo(size, ras);
-  assert(m_availableMemory >= size);
-  m_availableMemory -= size;
 #ifdef _DEBUG
-  checkConsistency();
+  m_totRasterMemInKb += size >> 10;
+  Rasters.insert(ras);
 #endif
   return true;
 }
 
 //------------------------------------------------------------------------------
 
-TRaster *TBigMemoryManager::findRaster(TRaster *ras) {
-  // return 0;
-
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-  while (it != m_chunks.end()) {
-    for (UINT i = 0; i < it->second.m_rasters.size(); i++)
-      if (it->second.m_rasters[i] == ras) return ras;
-    it++;
-  }
-  return 0;
-}
-
-//------------------------------------------------------------------------------
-#ifdef _DEBUG
-
-void TBigMemoryManager::printMap() {
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-  TSystem::outputDebug("BIGMEMORY chunks totali: " +
-                       std::to_string((int)m_chunks.size()) + "\n");
-
-  int count = 0;
-
-  while (it != m_chunks.end()) {
-    TSystem::outputDebug(
-        "chunk #" + std::to_string((int)count++) + "dimensione(kb):" +
-        std::to_string((int)(it->second.m_size >> 10)) + "num raster:" +
-        std::to_string((int)(it->second.m_rasters.size())) + "\n");
-
-    it++;
-  }
-}
-
-#endif
-
 bool TBigMemoryManager::releaseRaster(TRaster *ras) {
-  TThread::MutexLocker sl(&m_mutex);
-  UCHAR *buffer = (ras->m_parent) ? (ras->m_parent->m_buffer) : (ras->m_buffer);
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.find(buffer);
+  if (ras->m_parent || !ras->m_bufferOwner) return false;
 
-  if (m_theMemory == 0 || it == m_chunks.end()) {
-    assert(buffer);
-    if (!ras->m_parent && ras->m_bufferOwner) {
-      free(buffer);
-#ifdef _DEBUG
-      m_totRasterMemInKb -=
-          (ras->getPixelSize() * ras->getLx() * ras->getLy()) >> 10;
-      Rasters.erase(ras);
-#endif
-    }
-
-    // assert(findRaster(ras)==0);
-
-    return false;
-  }
-
-  assert(ras->m_lockCount == 0);
-
-  if (it->second.m_rasters.size() >
-      1)  // non e' il solo raster ad usare il buffer; non libero
-  {
-    std::vector<TRaster *>::iterator it2 = it->second.m_rasters.begin();
-    for (; it2 != it->second.m_rasters.end(); ++it2) {
-      if (ras == *it2) {
-        it->second.m_rasters.erase(it2);
-
-#ifdef _DEBUG
-// assert(!it->second.m_rasters.empty());
-// assert(findRaster(ras)==0);
-#endif
-
-        return true;
-      }
-    }
-    assert(false);
-    return false;
-  } else if (ras->m_bufferOwner)  // libero!
-  {
-#ifdef _DEBUG
-    checkConsistency();
-#endif
-    /*if (it->second.m_putInNormalMemory && ras->m_bufferOwner)
-    free(it->first);
-else */
-    m_availableMemory += it->second.m_size;
-    m_chunks.erase(it);
-  }
-
-#ifdef _DEBUG
-  // assert(findRaster(ras)==0);
-  checkConsistency();
-#endif
-
-  return true;
-}
-//------------------------------------------------------------------------------
-
-void TBigMemoryManager::checkConsistency() {
-  return;
-
-  // QMutexLocker sl(m_mutex);
-
-  int count = 0;
-  // int size = m_chunks.size();
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-  UCHAR *endAddress = m_theMemory;
-  TUINT32 freeMem = 0, allocMem = 0;
-
-  while (it != m_chunks.end()) {
-    count++;
-    // assert(it->second.m_rasters.size()==0 || it->second.m_rasters.size()>0);
-
-    if (endAddress != 0 /*&& !it->second.m_putInNormalMemory*/) {
-      freeMem += (TUINT32)(it->first - endAddress);
-      allocMem += it->second.m_size;
-    }
-    assert(endAddress <= it->first);
-    endAddress = it->first + it->second.m_size;
-    for (UINT i = 0; i < it->second.m_rasters.size(); i++) {
-      TRaster *ras            = it->second.m_rasters[i];
-      it->second.m_rasters[i] = 0;  // ogni raster deve apparire una sola volta
-      assert(findRaster(ras) == 0);
-      it->second.m_rasters[i] = ras;
-
-      UCHAR *buf1 = (ras->m_parent) ? ras->m_parent->m_buffer : ras->m_buffer;
-      UCHAR *buf2 = it->first;
-      assert(buf1 == buf2);
-      UINT size;
-      if (ras->m_parent)
-        size = ras->m_parent->getLx() * ras->m_parent->getLy() *
-               ras->m_parent->getPixelSize();
-      else
-        size = ras->getLx() * ras->getLy() * ras->getPixelSize();
-      assert(size == it->second.m_size);
-    }
-    it++;
-  }
-
-  if (m_theMemory) {
-    assert(allocMem + m_availableMemory == m_allocatedMemory);
-
-    assert(freeMem == m_availableMemory);
-  }
-}
-
-//------------------------------------------------------------------------------
-
-std::map<UCHAR *, Chunkinfo>::iterator TBigMemoryManager::shiftBlock(
-    const std::map<UCHAR *, Chunkinfo>::iterator &it, TUINT32 offset) {
-  UCHAR *newAddress = it->first - offset;
+  assert(ras->m_buffer);
+  TUINT32 size = ras->getLx() * ras->getLy() * ras->getPixelSize();
 
-  if (offset > it->second.m_size)
-    memcpy(newAddress, it->first, it->second.m_size);  // se NON overlappano.
+  if (ras->m_arenaBuffer)
+    m_arena->release(ras->m_buffer, size, m_budget);
   else
-    memmove(newAddress, it->first, it->second.m_size);  // se overlappano.
-
-  m_chunks[newAddress] = Chunkinfo(it->second.m_size, it->second.m_rasters[0]);
-  std::map<UCHAR *, Chunkinfo>::iterator it1 = m_chunks.find(newAddress);
-
-  assert(it1->first < it1->second.m_rasters[0]->m_buffer);
-  UINT i = 0;
-  for (i = 0; i < it->second.m_rasters.size();
-       i++)  // prima rimappo i subraster, senza toccare il buffer del parent...
-  {
-    TRaster *ras = it->second.m_rasters[i];
-    assert(i > 0 || !ras->m_parent);
-    if (!ras->m_parent) continue;
-    assert(ras->m_parent->m_buffer == it->first);
-    ras->remap(newAddress);
-    if (i > 0) it1->second.m_rasters.push_back(ras);
-  }
-
-  it->second.m_rasters[0]->remap(newAddress);  // ORA rimappo il parent
+    free(ras->m_buffer);
 
 #ifdef _DEBUG
-  for (i = 1; i < it->second.m_rasters.size(); i++)  //..poi i raster padri
-  {
-    // TRaster*ras = it->second.m_rasters[i];
-
-    assert(it->second.m_rasters[i]->m_parent);
-    // ras->remap(newAddress);
-    // if (i>0)
-    //  it1->second.m_rasters.push_back(ras);
-  }
-  assert(it1->second.m_rasters.size() == it->second.m_rasters.size());
+  m_totRasterMemInKb -= size >> 10;
+  Rasters.erase(ras);
 #endif
 
-  m_chunks.erase(it);
-  it1 = m_chunks.find(newAddress);  // non dovrebbe servire, ma per prudenza...
-  assert(it1->first == it1->second.m_rasters[0]->m_buffer);
-  return it1;
-}
-
-//------------------------------------------------------------------------------
-
-UCHAR *TBigMemoryManager::remap(TUINT32 size)  // size==0 -> remappo tutto
-{
-  bool locked = false;
-// QMutexLocker sl(m_mutex); //gia' scopata
-
-#ifdef _DEBUG
-  checkConsistency();
-#endif
-  UINT i;
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-
-  try {
-    UCHAR *buffer     = m_theMemory;
-    TUINT32 chunkSize = 0;
-    while (it != m_chunks.end()) {
-      /*if (it->second.m_putInNormalMemory)
-{it++; continue;}*/
-
-      TUINT32 gap = (TUINT32)((it->first) - (buffer + chunkSize));
-      if (size > 0 && gap >= size)  // trovato chunk sufficiente
-        return buffer + chunkSize;
-      else if (gap > 0 && it->second.m_size > 0)  // c'e' un frammento di
-                                                  // memoria, accorpo; ma solo
-                                                  // se non sto in fondo
-      {
-        std::vector<TRaster *> &rasters = it->second.m_rasters;
-        assert(rasters[0]->m_parent == 0);
-
-        // devo controllare il lockCount solo sul parent, la funzione lock()
-        // locka solo il parent;
-        for (i = 0; i < rasters.size(); i++) rasters[i]->beginRemapping();
-
-        if (rasters[0]->m_lockCount == 0)
-          it = shiftBlock(it, gap);
-        else
-          locked = true;
-
-        for (i = 0; i < rasters.size(); i++) rasters[i]->endRemapping();
-
-        // rasters.clear();
-      }
-
-      buffer    = it->first;
-      chunkSize = it->second.m_size;
-      it++;
-    }
-
-  } catch (...) {
-    for (i = 0; i < it->second.m_rasters.size(); i++)
-      it->second.m_rasters[i]->endRemapping();
-  }
-
-  if (size >
-      0)  // e' andata male...non liberato un blocco di grandezza sufficiente
-  {
-    printLog(size);
-    assert(!"Niente memoria! scritto log");
-    if (!locked)
-      assert(false);  // se entro nella remap, di sicuro c'e' 'size'  memoria
-                      // disponibile; basta deframmentarla
-  }
-  return 0;
-}
-
-//------------------------------------------------------------------------------
-
-void TBigMemoryManager::printLog(TUINT32 size) {
-  TFilePath fp("C:\\memorymaplog.txt");
-  Tofstream os(fp);
-
-  os << "memoria totale: " << m_allocatedMemory / 1024 << " KB\n";
-  os << "memoria richiesta: " << size / 1024 << " KB\n";
-  os << "memoria libera: " << m_availableMemory / 1024 << " KB\n\n\n";
-
-  std::map<UCHAR *, Chunkinfo>::iterator it = m_chunks.begin();
-  UCHAR *buffer  = m_theMemory;
-  UINT chunkSize = 0;
-  for (; it != m_chunks.end(); it++) {
-    TUINT32 gap = (TUINT32)((it->first) - (buffer + chunkSize));
-    if (gap > 0) os << "- gap di " << gap / 1024 << " KB\n";
-    if (it->second.m_size > 0)
-      os << "- raster di " << it->second.m_size / 1024 << " KB"
-         << ((it->second.m_rasters[0]->m_lockCount > 0) ? " LOCCATO!\n" : "\n");
-    buffer    = it->first;
-    chunkSize = it->second.m_size;
-  }
+  return true;
 }
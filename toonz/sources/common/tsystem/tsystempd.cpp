@@ -103,6 +103,9 @@
 #include <pwd.h>
 #include <dlfcn.h>
 
+#include <sys/sysctl.h>
+#include <mach/mach.h>
+
 #include "Carbon/Carbon.h"
 
 #endif
@@ -516,6 +519,66 @@ TINT64 TSystem::getMemorySize(bool onlyPhysicalMemory) {
 
 //------------------------------------------------------------
 
+bool TSystem::getPhysicalMemoryStatus(TINT64 &totalKb, TINT64 &availableKb) {
+#ifdef _WIN32
+
+  MEMORYSTATUSEX memStatus;
+  memStatus.dwLength = sizeof(MEMORYSTATUSEX);
+  if (!GlobalMemoryStatusEx(&memStatus)) return false;
+
+  totalKb     = memStatus.ullTotalPhys >> 10;
+  availableKb = memStatus.ullAvailPhys >> 10;
+  return true;
+
+#elif defined(LINUX)
+
+  // MemAvailable accounts for the reclaimable page cache, unlike sysinfo()
+  FILE *meminfo = fopen("/proc/meminfo", "r");
+  if (!meminfo) return false;
+
+  bool hasTotal = false, hasAvailable = false;
+  char line[256];
+  long long value;
+  while (fgets(line, sizeof(line), meminfo)) {
+    if (sscanf(line, "MemTotal: %lld kB", &value) == 1)
+      totalKb = value, hasTotal = true;
+    else if (sscanf(line, "MemAvailable: %lld kB", &value) == 1)
+      availableKb = value, hasAvailable = true;
+  }
+  fclose(meminfo);
+
+  return hasTotal && hasAvailable;
+
+#elif defined(MACOSX)
+
+  int mib[] = {CTL_HW, HW_MEMSIZE};
+  uint64_t memSize = 0;
+  size_t size      = sizeof(memSize);
+  if (sysctl(mib, 2, &memSize, &size, NULL, 0) < 0) return false;
+
+  vm_statistics64_data_t vmStats;
+  mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+  if (host_statistics64(mach_host_self(), HOST_VM_INFO64,
+                        (host_info64_t)&vmStats, &count) != KERN_SUCCESS)
+    return false;
+
+  // Inactive pages are reclaimed before swapping
+  totalKb     = memSize >> 10;
+  availableKb = ((TINT64)(vmStats.free_count + vmStats.inactive_count) *
+                 vm_page_size) >>
+                10;
+  return true;
+
+#else
+
+  // to be done...
+  return false;
+
+#endif
+}
+
+//------------------------------------------------------------
+
 void TSystem::moveFileToRecycleBin(const TFilePath &fp) {
 #if defined(_WIN32)
   //
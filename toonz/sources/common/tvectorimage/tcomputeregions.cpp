@@ -2222,6 +2222,116 @@ void addIntersection(IntersectionData &intData, const vector<VIStroke *> &s,
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+//! Uniform grid over a set of bounding boxes, used to find the strokes whose
+//! boxes overlap a given one without testing every stroke pair.
+class BBoxGrid {
+  std::vector<TRectD> m_bboxes;
+  std::vector<std::vector<int>> m_cells;
+  std::vector<int> m_marks;
+  TPointD m_origin;
+  double m_cellSize;
+  int m_cols, m_rows, m_mark;
+
+public:
+  //! Boxes are referred to by their index in \b bboxes. Invalid boxes (see
+  //! noBBox()) are not stored, and never returned by queries.
+  BBoxGrid(const std::vector<TRectD> &bboxes)
+      : m_bboxes(bboxes)
+      , m_marks(bboxes.size(), 0)
+      , m_cellSize(1)
+      , m_cols(0)
+      , m_rows(0)
+      , m_mark(0) {
+    TRectD box;
+    double extent = 0;
+    int count     = 0;
+    for (int i = 0; i < (int)m_bboxes.size(); ++i) {
+      const TRectD &r = m_bboxes[i];
+      if (!isValid(r)) continue;
+      if (count == 0)
+        box = r;
+      else
+        box = TRectD(std::min(box.x0, r.x0), std::min(box.y0, r.y0),
+                     std::max(box.x1, r.x1), std::max(box.y1, r.y1));
+      extent += r.getLx() + r.getLy();
+      ++count;
+    }
+    if (count == 0) return;
+
+    // Cells about as large as the average box, and about as many as the
+    // boxes
+    extent /= 2 * count;
+    m_cellSize = std::max(
+        {extent, sqrt(box.getLx() * box.getLy() / count), TConsts::epsilon});
+    m_origin = box.getP00();
+    m_cols   = std::min(1024, (int)(box.getLx() / m_cellSize) + 1);
+    m_rows   = std::min(1024, (int)(box.getLy() / m_cellSize) + 1);
+    m_cells.resize(m_cols * m_rows);
+
+    for (int i = 0; i < (int)m_bboxes.size(); ++i) {
+      if (!isValid(m_bboxes[i])) continue;
+      int c0, r0, c1, r1;
+      getCells(m_bboxes[i], c0, r0, c1, r1);
+      for (int r = r0; r <= r1; ++r)
+        for (int c = c0; c <= c1; ++c) m_cells[r * m_cols + c].push_back(i);
+    }
+  }
+
+  //! Returns, in increasing order, the indices of the boxes overlapping
+  //! \b rect.
+  void query(const TRectD &rect, std::vector<int> &result) {
+    result.clear();
+    if (m_cells.empty() || !isValid(rect)) return;
+
+    ++m_mark;
+    int c0, r0, c1, r1;
+    getCells(rect, c0, r0, c1, r1);
+    for (int r = r0; r <= r1; ++r)
+      for (int c = c0; c <= c1; ++c) {
+        const std::vector<int> &cell = m_cells[r * m_cols + c];
+        for (int k = 0; k < (int)cell.size(); ++k) {
+          int i = cell[k];
+          if (m_marks[i] == m_mark) continue;
+          m_marks[i] = m_mark;
+          if (m_bboxes[i].overlaps(rect)) result.push_back(i);
+        }
+      }
+    std::sort(result.begin(), result.end());
+  }
+
+  static TRectD noBBox() { return TRectD(0, 0, -1, -1); }
+
+private:
+  // Unlike TRectD::isEmpty(), degenerate boxes are valid: they still
+  // overlap others.
+  static bool isValid(const TRectD &r) { return r.x0 <= r.x1 && r.y0 <= r.y1; }
+
+  void getCells(const TRectD &r, int &c0, int &r0, int &c1, int &r1) const {
+    c0 = getCell(r.x0 - m_origin.x, m_cols);
+    c1 = getCell(r.x1 - m_origin.x, m_cols);
+    r0 = getCell(r.y0 - m_origin.y, m_rows);
+    r1 = getCell(r.y1 - m_origin.y, m_rows);
+  }
+
+  int getCell(double d, int count) const {
+    double c = floor(d / m_cellSize);
+    return c < 0 ? 0 : c >= count ? count - 1 : (int)c;
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+inline double getAutocloseEnlarge(double autocloseTolerance, TStroke *s) {
+  return (autocloseTolerance + 0.7) *
+         (s->getMaxThickness() > 0 ? s->getMaxThickness() : 2.5);
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
 void TVectorImage::Imp::findIntersections() {
   vector<VIStroke *> &strokeArray = m_strokes;
   IntersectionData &intData       = *m_intersectionData;
@@ -2230,6 +2340,11 @@ void TVectorImage::Imp::findIntersections() {
   bool isVectorized = (m_autocloseTolerance < 0);
 
   assert(intData.m_intersectedStrokeArray.empty());
+
+  // Candidate pairs are looked up in grids of stroke bboxes; the candidates
+  // are visited in the same order as a full scan would.
+  vector<int> candidates;
+
 #define AUTOCLOSE_ATTIVO
 #ifdef AUTOCLOSE_ATTIVO
   intData.maxAutocloseId++;
@@ -2237,6 +2352,15 @@ void TVectorImage::Imp::findIntersections() {
   map<int, VIStroke *>::iterator it, it_b = intData.m_autocloseMap.begin();
   map<int, VIStroke *>::iterator it_e = intData.m_autocloseMap.end();
 
+  vector<map<int, VIStroke *>::iterator> autocloses;
+  vector<TRectD> bboxes;
+  for (it = it_b; it != it_e; ++it) {
+    autocloses.push_back(it);
+    bboxes.push_back(it->second ? it->second->m_s->getBBox()
+                                : BBoxGrid::noBBox());
+  }
+  BBoxGrid autocloseGrid(bboxes);
+
   // prima cerco le intersezioni tra nuove strokes e vecchi autoclose
   for (i = 0; i < strokeSize; i++) {
     TStroke *s1 = strokeArray[i]->m_s;
@@ -2252,7 +2376,9 @@ void TVectorImage::Imp::findIntersections() {
 
     roundStroke(s1);
 
-    for (it = it_b; it != it_e; ++it) {
+    autocloseGrid.query(s1->getBBox(), candidates);
+    for (int k = 0; k < (int)candidates.size(); ++k) {
+      it = autocloses[candidates[k]];
       if (!it->second || it->second->m_groupId != strokeArray[i]->m_groupId)
         continue;
 
@@ -2269,13 +2395,24 @@ void TVectorImage::Imp::findIntersections() {
 
   map<pair<int, int>, vector<DoublePair>> intersectionMap;
 
+  vector<TRectD> strokeBBoxes(strokeSize, BBoxGrid::noBBox()),
+      enlargedBBoxes(strokeSize, BBoxGrid::noBBox());
+  for (i = 0; i < strokeSize; i++) {
+    if (strokeArray[i]->m_isPoint) continue;
+    TStroke *s        = strokeArray[i]->m_s;
+    strokeBBoxes[i]   = s->getBBox();
+    enlargedBBoxes[i] = strokeBBoxes[i].enlarge(
+        getAutocloseEnlarge(m_autocloseTolerance, s));
+  }
+  BBoxGrid strokeGrid(strokeBBoxes);
+
   for (i = 0; i < strokeSize; i++) {
     TStroke *s1 = strokeArray[i]->m_s;
     if (strokeArray[i]->m_isPoint) continue;
-    for (j = i; j < strokeSize /*&& (strokeArray[i]->getBBox().x1>=
-                                  strokeArray[j]->getBBox().x0)*/
-         ;
-         j++) {
+    strokeGrid.query(strokeBBoxes[i], candidates);
+    for (int k = 0; k < (int)candidates.size(); ++k) {
+      j = candidates[k];
+      if (j < i) continue;
       TStroke *s2 = strokeArray[j]->m_s;
 
       if (strokeArray[j]->m_isPoint ||
@@ -2313,36 +2450,26 @@ void TVectorImage::Imp::findIntersections() {
 
 #ifdef AUTOCLOSE_ATTIVO
   TL2LAutocloser l2lautocloser;
+  BBoxGrid enlargedGrid(enlargedBBoxes);
 
   for (i = 0; i < strokeSize; i++) {
-    TStroke *s1 = strokeArray[i]->m_s;
     if (strokeArray[i]->m_isPoint) continue;
-    for (j = i; j < strokeSize; j++) {
+    enlargedGrid.query(enlargedBBoxes[i], candidates);
+    for (int k = 0; k < (int)candidates.size(); ++k) {
+      j = candidates[k];
+      if (j < i) continue;
       if (strokeArray[i]->m_groupId != strokeArray[j]->m_groupId) continue;
-
-      TStroke *s2 = strokeArray[j]->m_s;
-      if (strokeArray[j]->m_isPoint) continue;
       if (!(strokeArray[i]->m_isNewForFill || strokeArray[j]->m_isNewForFill))
         continue;
 
-      double enlarge1 =
-          (m_autocloseTolerance + 0.7) *
-          (s1->getMaxThickness() > 0 ? s1->getMaxThickness() : 2.5);
-      double enlarge2 =
-          (m_autocloseTolerance + 0.7) *
-          (s2->getMaxThickness() > 0 ? s2->getMaxThickness() : 2.5);
-
-      if (s1->getBBox().enlarge(enlarge1).overlaps(
-              s2->getBBox().enlarge(enlarge2))) {
-        map<pair<int, int>, vector<DoublePair>>::iterator it =
-            intersectionMap.find(pair<int, int>(i, j));
-        if (it == intersectionMap.end())
-          autoclose(m_autocloseTolerance, strokeArray, i, j, intData,
-                    strokeSize, l2lautocloser, 0, isVectorized);
-        else
-          autoclose(m_autocloseTolerance, strokeArray, i, j, intData,
-                    strokeSize, l2lautocloser, &(it->second), isVectorized);
-      }
+      map<pair<int, int>, vector<DoublePair>>::iterator it =
+          intersectionMap.find(pair<int, int>(i, j));
+      if (it == intersectionMap.end())
+        autoclose(m_autocloseTolerance, strokeArray, i, j, intData, strokeSize,
+                  l2lautocloser, 0, isVectorized);
+      else
+        autoclose(m_autocloseTolerance, strokeArray, i, j, intData, strokeSize,
+                  l2lautocloser, &(it->second), isVectorized);
     }
     strokeArray[i]->m_isNewForFill = false;
   }
@@ -2373,9 +2500,10 @@ void TVectorImage::Imp::findIntersections() {
         addIntersections(intData, strokeArray, i, j, parIntersections,
                          strokeSize, isVectorized);
     }
-    for (j = 0; j < strokeSize; ++j)  // intersezione segmento-curva
+    strokeGrid.query(s1->getBBox(), candidates);
+    for (int k = 0; k < (int)candidates.size(); ++k)  // segmento-curva
     {
-      if (strokeArray[j]->m_isPoint) continue;
+      j = candidates[k];
       if (strokeArray[i]->m_groupId != strokeArray[j]->m_groupId) continue;
 
       TStroke *s2 = strokeArray[j]->m_s;
@@ -0,0 +1,455 @@
+#include "tvectorrasterizer.h"
+
+// TnzCore includes
+#include "tvectorimage.h"
+#include "tvectorrenderdata.h"
+#include "tpalette.h"
+#include "tcolorfunctions.h"
+#include "tsimplecolorstyles.h"
+#include "tstroke.h"
+#include "tregion.h"
+#include "tstrokeoutline.h"
+#include "tpixelutils.h"
+#include "tmathutil.h"
+#include "tthreadmessage.h"
+#include "drawutil.h"
+
+// STD includes
+#include <algorithm>
+
+//=============================================================================
+
+namespace {
+
+//! Sub-scanlines sampled per pixel row by the antialiased rasterization.
+//! Coverage along the scanlines is computed exactly.
+const int SubScanlines = 16;
+
+//-----------------------------------------------------------------------------
+
+/*!
+  Scanline polygon rasterizer. Edges are accumulated with addEdge() and
+  friends, then render() fills the resulting shape with a color, blending
+  it over the raster according to the coverage of each pixel.
+*/
+class Rasterizer {
+  struct Edge {
+    double m_x0, m_y0, m_y1, m_dxdy;
+    int m_dir;
+
+    bool operator<(const Edge &e) const { return m_y0 < e.m_y0; }
+  };
+
+  std::vector<Edge> m_edges;
+  std::vector<int> m_active;
+  std::vector<std::pair<double, int>> m_crossings;
+  std::vector<float> m_cover, m_run;
+  int m_lx, m_xMin, m_xMax;
+
+public:
+  void clear() { m_edges.clear(); }
+
+  void addEdge(const TPointD &a, const TPointD &b) {
+    if (a.y == b.y) return;
+
+    Edge e;
+    if (a.y < b.y)
+      e.m_x0 = a.x, e.m_y0 = a.y, e.m_y1 = b.y, e.m_dir = 1;
+    else
+      e.m_x0 = b.x, e.m_y0 = b.y, e.m_y1 = a.y, e.m_dir = -1;
+    e.m_dxdy = (b.x - a.x) / (b.y - a.y);
+    m_edges.push_back(e);
+  }
+
+  void addPolygon(const std::vector<TPointD> &pts) {
+    int i, count = pts.size();
+    if (count < 3) return;
+    for (i = 1; i < count; ++i) addEdge(pts[i - 1], pts[i]);
+    addEdge(pts[count - 1], pts[0]);
+  }
+
+  //! Adds a counterclockwise triangle, so that a nonzero fill of many
+  //! triangles is their union.
+  void addTriangle(const TPointD &a, const TPointD &b, const TPointD &c) {
+    double area = cross(b - a, c - a);
+    if (area > 0)
+      addEdge(a, b), addEdge(b, c), addEdge(c, a);
+    else if (area < 0)
+      addEdge(a, c), addEdge(c, b), addEdge(b, a);
+  }
+
+  void render(const TRaster32P &ras, const TPixel32 &color, bool antialias,
+              bool evenOdd);
+
+private:
+  void addSpan(double x0, double x1, float weight, bool antialias);
+  void blendRow(TPixel32 *pix, const TPixel32 &color);
+};
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::addSpan(double x0, double x1, float weight, bool antialias) {
+  if (!antialias) {
+    // Pixels whose center lies in the span
+    int i0 = (int)std::max(std::ceil(x0 - 0.5), 0.0);
+    int i1 = (int)std::min(std::ceil(x1 - 0.5), (double)m_lx);
+    if (i0 >= i1) return;
+
+    m_run[i0] += weight, m_run[i1] -= weight;
+    m_xMin = std::min(m_xMin, i0), m_xMax = std::max(m_xMax, i1 - 1);
+    return;
+  }
+
+  x0 = std::max(x0, 0.0), x1 = std::min(x1, (double)m_lx);
+  if (x0 >= x1) return;
+
+  int i0 = (int)x0, i1 = (int)x1;
+  if (i0 == i1)
+    m_cover[i0] += (x1 - x0) * weight;
+  else {
+    m_cover[i0] += (i0 + 1 - x0) * weight;
+    m_run[i0 + 1] += weight, m_run[i1] -= weight;
+    m_cover[i1] += (x1 - i1) * weight;
+  }
+  m_xMin = std::min(m_xMin, i0);
+  m_xMax = std::max(m_xMax, std::min(i1, m_lx - 1));
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::blendRow(TPixel32 *pix, const TPixel32 &color) {
+  float run = 0.0f;
+  for (int x = m_xMin; x <= m_xMax; ++x) {
+    run += m_run[x];
+    float c    = m_cover[x] + run;
+    m_cover[x] = 0.0f, m_run[x] = 0.0f;
+    if (c < 1.0f / 512) continue;
+
+    if (c >= 1.0f - 1.0f / 512)
+      pix[x] = (color.m == 255) ? color : overPix(pix[x], color);
+    else {
+      TPixel32 top((int)(color.r * c + 0.5f), (int)(color.g * c + 0.5f),
+                   (int)(color.b * c + 0.5f), (int)(color.m * c + 0.5f));
+      pix[x] = overPix(pix[x], top);
+    }
+  }
+  m_run[m_xMax + 1] = 0.0f;
+}
+
+//-----------------------------------------------------------------------------
+
+void Rasterizer::render(const TRaster32P &ras, const TPixel32 &color,
+                        bool antialias, bool evenOdd) {
+  if (m_edges.empty()) return;
+
+  m_lx   = ras->getLx();
+  int ly = ras->getLy();
+
+  std::sort(m_edges.begin(), m_edges.end());
+
+  double yMax = m_edges[0].m_y1;
+  for (const Edge &e : m_edges) yMax = std::max(yMax, e.m_y1);
+
+  int y0 = std::max((int)std::floor(m_edges[0].m_y0), 0);
+  int y1 = std::min((int)std::ceil(yMax), ly - 1);
+  if (y0 > y1) return;
+
+  // blendRow() leaves the coverage buffers cleared, so they are reused by
+  // the next shapes as long as the raster width is the same
+  if ((int)m_cover.size() != m_lx + 1) {
+    m_cover.assign(m_lx + 1, 0.0f);
+    m_run.assign(m_lx + 1, 0.0f);
+  }
+  m_active.clear();
+
+  TPixel32 premultColor = premultiply(color);
+
+  int subCount = antialias ? SubScanlines : 1;
+  float weight = 1.0f / subCount;
+
+  ras->lock();
+
+  int y, s, next = 0, edgesCount = m_edges.size();
+  for (y = y0; y <= y1; ++y) {
+    m_xMin = m_lx, m_xMax = -1;
+
+    for (s = 0; s < subCount; ++s) {
+      double ys = y + (s + 0.5) / subCount;
+
+      // Update the active edges
+      int a, activeCount = m_active.size(), keptCount = 0;
+      for (a = 0; a < activeCount; ++a)
+        if (m_edges[m_active[a]].m_y1 > ys) m_active[keptCount++] = m_active[a];
+      m_active.resize(keptCount);
+
+      for (; next < edgesCount && m_edges[next].m_y0 <= ys; ++next)
+        if (m_edges[next].m_y1 > ys) m_active.push_back(next);
+
+      if (m_active.empty()) continue;
+
+      // Find the spans inside the shape
+      m_crossings.clear();
+      for (int idx : m_active) {
+        const Edge &e = m_edges[idx];
+        m_crossings.push_back(
+            std::make_pair(e.m_x0 + (ys - e.m_y0) * e.m_dxdy, e.m_dir));
+      }
+      std::sort(m_crossings.begin(), m_crossings.end());
+
+      int c, crossingsCount = m_crossings.size(), winding = 0;
+      double spanStart = 0.0;
+      for (c = 0; c < crossingsCount; ++c) {
+        bool wasInside = evenOdd ? (winding & 1) : (winding != 0);
+        winding += m_crossings[c].second;
+        bool isInside = evenOdd ? (winding & 1) : (winding != 0);
+
+        if (!wasInside && isInside)
+          spanStart = m_crossings[c].first;
+        else if (wasInside && !isInside)
+          addSpan(spanStart, m_crossings[c].first, weight, antialias);
+      }
+    }
+
+    if (m_xMin <= m_xMax) blendRow(ras->pixels(y), premultColor);
+
+    if (next == edgesCount && m_active.empty()) break;
+  }
+
+  ras->unlock();
+}
+
+//=============================================================================
+
+inline bool isOThick(const TStroke *s) {
+  int i;
+  for (i = 0; i < s->getControlPointCount(); i++)
+    if (s->getControlPoint(i).thick != 0) return false;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Same visibility test of tglDoDraw(): at least a color parameter must not
+//! be fully transparent.
+bool isVisible(const TColorStyle *style, const TVectorRenderData &rd) {
+  int j, colorCount = style->getColorParamCount();
+  if (colorCount == 0) return true;
+
+  for (j = 0; j < colorCount; j++) {
+    TPixel32 color = style->getColorParamValue(j);
+    if (rd.m_cf) color = (*(rd.m_cf))(color);
+    if (color.m != 0) return true;
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the style of the stroke if tglDraw() would draw it, or 0.
+const TColorStyle *strokeStyle(const TStroke *s, const TVectorRenderData &rd) {
+  const TColorStyle *style = rd.m_palette->getStyle(s->getStyle());
+  if (!isVisible(style, rd) || !style->isStrokeStyle() || !style->isEnabled())
+    return 0;
+  if (!rd.m_show0ThickStrokes && isOThick(s) &&
+      dynamic_cast<const TSolidColorStyle *>(style))
+    return 0;
+  return style;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the style of the region if tglDraw() would fill it, or 0.
+const TColorStyle *regionStyle(const TRegion *r, const TVectorRenderData &rd) {
+  if (!r->getStyle()) return 0;
+  const TColorStyle *style = rd.m_palette->getStyle(r->getStyle());
+  if (!isVisible(style, rd) || !style->isRegionStyle() || !style->isEnabled())
+    return 0;
+  return style;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Plain TSolidColorStyle instances are the only ones handled here, derived
+//! styles have tag ids of their own.
+inline const TSolidColorStyle *solidStyle(const TColorStyle *style) {
+  return (style->getTagId() == 3) ? static_cast<const TSolidColorStyle *>(style)
+                                  : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+bool isRegionSupported(const TRegion *r, const TVectorRenderData &rd) {
+  if (const TColorStyle *style = regionStyle(r, rd)) {
+    const TSolidColorStyle *solid = solidStyle(style);
+    if (!solid || solid->getRegionOutlineModifier()) return false;
+  }
+  for (UINT i = 0; i < r->getSubregionCount(); i++)
+    if (!isRegionSupported(r->getSubregion(i), rd)) return false;
+  return true;
+}
+
+//=============================================================================
+
+class ImageRasterizer {
+  const TRaster32P &m_ras;
+  const TVectorRenderData &m_rd;
+  TRectD m_rasRect;
+  double m_pixelSize;
+
+  Rasterizer m_rasterizer;
+  std::vector<TPointD> m_points;
+  TStrokeOutline m_outline;
+
+public:
+  ImageRasterizer(const TRaster32P &ras, const TVectorRenderData &rd)
+      : m_ras(ras)
+      , m_rd(rd)
+      , m_rasRect(0, 0, ras->getLx(), ras->getLy())
+      , m_pixelSize(1.0 / sqrt(fabs(rd.m_aff.det()))) {}
+
+  void drawRegion(const TRegion *r);
+  void drawStroke(const TStroke *s);
+
+private:
+  void addRegionBoundary(const TRegion *r);
+  TPixel32 getColor(const TSolidColorStyle *style) const {
+    TPixel32 color = style->getMainColor();
+    return m_rd.m_cf ? (*(m_rd.m_cf))(color) : color;
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+void ImageRasterizer::addRegionBoundary(const TRegion *r) {
+  m_points.clear();
+  for (UINT i = 0; i < r->getEdgeCount(); i++) {
+    const TEdge *e = r->getEdge(i);
+    if (e->m_index >= 0 && e->m_s)
+      stroke2polyline(m_points, *e->m_s, m_pixelSize, e->m_w0, e->m_w1);
+  }
+  for (TPointD &p : m_points) p = m_rd.m_aff * p;
+  m_rasterizer.addPolygon(m_points);
+}
+
+//-----------------------------------------------------------------------------
+
+void ImageRasterizer::drawRegion(const TRegion *r) {
+  const TColorStyle *style = regionStyle(r, m_rd);
+  if (style && (m_rd.m_aff * r->getBBox()).overlaps(m_rasRect)) {
+    TPixel32 color = getColor(solidStyle(style));
+    if (color.m != 0) {
+      // Subregions are holes in the area, then drawn on their own
+      m_rasterizer.clear();
+      addRegionBoundary(r);
+      for (UINT i = 0; i < r->getSubregionCount(); i++)
+        addRegionBoundary(r->getSubregion(i));
+
+      m_rasterizer.render(m_ras, color,
+                          m_rd.m_antiAliasing && m_rd.m_regionAntialias, true);
+    }
+  }
+
+  for (UINT i = 0; i < r->getSubregionCount(); i++)
+    drawRegion(r->getSubregion(i));
+}
+
+//-----------------------------------------------------------------------------
+
+void ImageRasterizer::drawStroke(const TStroke *s) {
+  const TColorStyle *style = strokeStyle(s, m_rd);
+  if (!style || !(m_rd.m_aff * s->getBBox()).overlaps(m_rasRect)) return;
+
+  TPixel32 color = getColor(solidStyle(style));
+  if (color.m == 0) return;
+
+  m_outline.getArray().clear();
+  TOutlineUtil::makeOutline(*s, m_outline, TOutlineUtil::OutlineParameter());
+
+  // The outline is a strip of quads, as drawn by TSolidColorStyle; each one
+  // is split in two triangles to get their union
+  const std::vector<TOutlinePoint> &v = m_outline.getArray();
+  int i, count = v.size() / 2 - 1;
+  if (count < 1) return;
+
+  m_rasterizer.clear();
+  for (i = 0; i < count; ++i) {
+    TPointD a = m_rd.m_aff * convert(v[2 * i]);
+    TPointD b = m_rd.m_aff * convert(v[2 * i + 1]);
+    TPointD c = m_rd.m_aff * convert(v[2 * i + 3]);
+    TPointD d = m_rd.m_aff * convert(v[2 * i + 2]);
+    m_rasterizer.addTriangle(a, b, c);
+    m_rasterizer.addTriangle(a, c, d);
+  }
+
+  m_rasterizer.render(m_ras, color, m_rd.m_antiAliasing, false);
+}
+
+}  // namespace
+
+//=============================================================================
+
+bool TVectorRasterizer::isSupported(const TVectorImage *vim,
+                                    const TVectorRenderData &_rd) {
+  if (_rd.m_tcheckEnabled || _rd.m_inkCheckEnabled || _rd.m_ink1CheckEnabled ||
+      _rd.m_paintCheckEnabled || _rd.m_showGuidedDrawing)
+    return false;
+
+  // Entered groups are drawn faded by tglDraw()
+  if (!_rd.m_isIcon && vim->isInsideGroup() > 0) return false;
+
+  TVectorRenderData rd(_rd);
+  if (!rd.m_palette) {
+    rd.m_palette = vim->getPalette();
+    if (!rd.m_palette) return false;
+  }
+
+  QMutexLocker sl(vim->getMutex());
+
+  UINT i;
+  for (i = 0; i < vim->getStrokeCount(); i++) {
+    const TStroke *s = vim->getStroke(i);
+    if (const TColorStyle *style = strokeStyle(s, rd))
+      if (!solidStyle(style) || s->isCenterLine()) return false;
+  }
+
+  if (rd.m_drawRegions)
+    for (i = 0; i < vim->getRegionCount(); i++)
+      if (!isRegionSupported(vim->getRegion(i), rd)) return false;
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void TVectorRasterizer::rasterize(const TRaster32P &ras,
+                                  const TVectorImage *vim,
+                                  const TVectorRenderData &_rd) {
+  assert(isSupported(vim, _rd));
+
+  TVectorRenderData rd(_rd);
+  if (!rd.m_palette) {
+    rd.m_palette = vim->getPalette();
+    if (!rd.m_palette) return;
+  }
+  if (isAlmostZero(rd.m_aff.det())) return;
+
+  QMutexLocker sl(vim->getMutex());
+
+  ImageRasterizer rasterizer(ras, rd);
+
+  // Same order as tglDraw(): each group draws its areas, then its strokes
+  UINT strokeIndex = 0, strokeCount = vim->getStrokeCount();
+  while (strokeIndex < strokeCount) {
+    UINT currStrokeIndex = strokeIndex;
+
+    if (rd.m_drawRegions)
+      for (UINT regionIndex = 0; regionIndex < vim->getRegionCount();
+           regionIndex++)
+        if (vim->sameGroupStrokeAndRegion(currStrokeIndex, regionIndex))
+          rasterizer.drawRegion(vim->getRegion(regionIndex));
+
+    while (strokeIndex < strokeCount &&
+           vim->sameGroup(strokeIndex, currStrokeIndex))
+      rasterizer.drawStroke(vim->getStroke(strokeIndex++));
+  }
+}
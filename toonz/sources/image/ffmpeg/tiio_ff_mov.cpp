@@ -62,6 +62,13 @@ TLevelWriterFFMov::TLevelWriterFFMov(const TFilePath &path,
 //-----------------------------------------------------------
 
 TLevelWriterFFMov::~TLevelWriterFFMov() {
+  ffmpegWriter->stopStreaming();
+  ffmpegWriter->cleanUpFiles();
+}
+
+//-----------------------------------------------------------
+
+void TLevelWriterFFMov::startStreaming() {
   QStringList preIArgs;
   QStringList postIArgs;
 
@@ -118,8 +125,7 @@ TLevelWriterFFMov::~TLevelWriterFFMov() {
   postIArgs << "-b:v";
   postIArgs << QString::number(finalBitrate) + "k";
 
-  ffmpegWriter->runFfmpeg(preIArgs, postIArgs, false, false, true);
-  ffmpegWriter->cleanUpFiles();
+  ffmpegWriter->startStreaming(preIArgs, postIArgs, m_lx, m_ly);
 }
 
 //-----------------------------------------------------------
@@ -144,10 +150,14 @@ void TLevelWriterFFMov::saveSoundTrack(TSoundTrack *st) {
 //-----------------------------------------------------------
 
 void TLevelWriterFFMov::save(const TImageP &img, int frameIndex) {
-  TRasterImageP image(img);
-  m_lx = image->getRaster()->getLx();
-  m_ly = image->getRaster()->getLy();
-  ffmpegWriter->createIntermediateImage(img, frameIndex);
+  // ffmpeg is launched on the first frame, once the size is known
+  if (!ffmpegWriter->isStreaming()) {
+    TRasterImageP image(img);
+    m_lx = image->getRaster()->getLx();
+    m_ly = image->getRaster()->getLy();
+    startStreaming();
+  }
+  ffmpegWriter->writeFrame(img, frameIndex);
 }
 
 //===========================================================
@@ -211,7 +221,7 @@ TLevelReaderFFMov::TLevelReaderFFMov(const TFilePath &path)
 }
 //-----------------------------------------------------------
 
-TLevelReaderFFMov::~TLevelReaderFFMov() {}
+TLevelReaderFFMov::~TLevelReaderFFMov() { delete ffmpegReader; }
 
 //-----------------------------------------------------------
 
@@ -239,11 +249,7 @@ TDimension TLevelReaderFFMov::getSize() { return m_size; }
 //------------------------------------------------
 
 TImageP TLevelReaderFFMov::load(int frameIndex) {
-  if (!ffmpegFramesCreated) {
-    ffmpegReader->getFramesFromMovie();
-    ffmpegFramesCreated = true;
-  }
-  return ffmpegReader->getImage(frameIndex);
+  return ffmpegReader->readFrame(frameIndex);
 }
 
 Tiio::FFMovWriterProperties::FFMovWriterProperties()
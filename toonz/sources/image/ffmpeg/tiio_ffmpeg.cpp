@@ -4,6 +4,7 @@
 #include "tsound.h"
 #include "tenv.h"
 #include "timageinfo.h"
+#include "trop.h"
 #include "toonz/stage.h"
 
 #include <QProcess>
@@ -12,11 +13,391 @@
 #include <QDir>
 #include <QtGui/QImage>
 #include <QRegExp>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include "toonz/preferences.h"
 #include "toonz/toonzfolders.h"
 #include "tmsgcore.h"
 #include "thirdparty.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <set>
+
+namespace {
+
+// ffmpeg name of the raw pixel format matching TPixel32 in memory
+QString rawPixelFormat() {
+#if defined(TNZ_MACHINE_CHANNEL_ORDER_BGRM)
+  return "bgra";
+#elif defined(TNZ_MACHINE_CHANNEL_ORDER_MBGR)
+  return "abgr";
+#elif defined(TNZ_MACHINE_CHANNEL_ORDER_RGBM)
+  return "rgba";
+#else
+  return "argb";
+#endif
+}
+
+}  // namespace
+
+//===========================================================
+//
+//  FfmpegStreamWriter
+//
+//===========================================================
+
+/*!
+  Owns the ffmpeg process of a streaming writer and feeds it on its own
+  thread, so encoding overlaps rendering. Queued frames are piped in order of
+  frame index, lowest first; indices need not be contiguous, since render
+  steps and time-stretched scenes skip some. The number of frames waiting in
+  the queue is bounded; callers block in addFrame() when it is full.
+*/
+
+class FfmpegStreamWriter final : public QThread {
+  QStringList m_args;
+  int m_timeout;
+
+  QMutex m_mutex;
+  QWaitCondition m_frameAdded, m_frameTaken;
+  std::map<int, QByteArray> m_pending;
+  int m_maxPending;
+  bool m_closing, m_failed;
+
+public:
+  FfmpegStreamWriter(const QStringList &args, int timeout)
+      : m_args(args)
+      , m_timeout(timeout)
+      , m_maxPending(std::max(2, QThread::idealThreadCount()))
+      , m_closing(false)
+      , m_failed(false) {}
+
+  void addFrame(int frameIndex, const QByteArray &data) {
+    QMutexLocker locker(&m_mutex);
+    // The writer thread takes any queued frame, so a full queue always
+    // drains
+    while ((int)m_pending.size() >= m_maxPending && !m_failed)
+      m_frameTaken.wait(&m_mutex);
+    if (m_failed) return;
+
+    m_pending[frameIndex] = data;
+    m_frameAdded.wakeAll();
+  }
+
+  void close() {
+    QMutexLocker locker(&m_mutex);
+    m_closing = true;
+    m_frameAdded.wakeAll();
+  }
+
+  bool hasFailed() {
+    QMutexLocker locker(&m_mutex);
+    return m_failed;
+  }
+
+protected:
+  void run() override {
+    // The process must be created in this thread, as QProcess is not meant
+    // to be driven from a thread other than its own.
+    QProcess ffmpeg;
+    ffmpeg.setStandardOutputFile(QProcess::nullDevice());
+    ffmpeg.setStandardErrorFile(QProcess::nullDevice());
+    ThirdParty::runFFmpeg(ffmpeg, m_args);
+    bool ok = ffmpeg.waitForStarted();
+
+    while (ok) {
+      QByteArray data;
+      {
+        QMutexLocker locker(&m_mutex);
+        // Movie writers receive frames in order (see isSequencialRequired()),
+        // so the lowest queued frame is the next one in the stream
+        while (!m_closing && m_pending.empty()) m_frameAdded.wait(&m_mutex);
+        if (m_pending.empty()) break;
+
+        std::map<int, QByteArray>::iterator it = m_pending.begin();
+        data = it->second;
+        m_pending.erase(it);
+        m_frameTaken.wakeAll();
+      }
+
+      ffmpeg.write(data);
+      while (ok && ffmpeg.bytesToWrite() > 0)
+        ok = ffmpeg.waitForBytesWritten(-1);
+    }
+
+    if (ok) {
+      ffmpeg.closeWriteChannel();
+      ok = ffmpeg.waitForFinished(m_timeout) &&
+           ffmpeg.exitStatus() == QProcess::NormalExit &&
+           ffmpeg.exitCode() == 0;
+    }
+    if (!ok) {
+      ffmpeg.kill();
+      ffmpeg.waitForFinished();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_failed = !ok;
+    m_pending.clear();
+    m_frameTaken.wakeAll();
+  }
+};
+
+//===========================================================
+//
+//  FfmpegStreamReader
+//
+//===========================================================
+
+/*!
+  Decodes a movie through a persistent ffmpeg process emitting raw frames on
+  its stdout. Decoded frames are kept in a small buffer around the last
+  requested one, and the process reads a few frames ahead of it. Requests far
+  from the current decoding position restart the process with an input seek.
+  Frame indices are 0-based.
+
+  Only a normal exit of ffmpeg with no frame left marks the end of the
+  movie. Other failures (pipe timeouts, failed seeks, crashes) restart the
+  decode a few times; past that the waiting requests return an empty raster,
+  and later requests of the same frame try again.
+*/
+
+class FfmpegStreamReader final : public QThread {
+  QString m_path;
+  QStringList m_inputArgs;
+  int m_lx, m_ly, m_timeout;
+  double m_frameRate;
+
+  QMutex m_mutex;
+  QWaitCondition m_frameWanted, m_frameDecoded;
+  std::map<int, TRaster32P> m_frames;
+  std::map<int, int> m_wanted;  // frame -> number of waiting callers
+  std::set<int> m_failed;       // wanted frames that could not be decoded
+  int m_lastRequested, m_endFrame;
+  bool m_closing;
+
+  enum { BufferSize = 16, ReadAhead = 8, SeekThreshold = 48, MaxRetries = 2 };
+
+  enum ReadResult { FrameRead, EndOfStream, ReadFailed };
+
+public:
+  FfmpegStreamReader(const QString &path, const QStringList &inputArgs,
+                     int lx, int ly, double frameRate, int timeout)
+      : m_path(path)
+      , m_inputArgs(inputArgs)
+      , m_lx(lx)
+      , m_ly(ly)
+      , m_timeout(timeout)
+      , m_frameRate(frameRate > 0 ? frameRate : 24.0)
+      , m_lastRequested(0)
+      , m_endFrame(INT_MAX)
+      , m_closing(false) {}
+
+  TRaster32P getFrame(int frame) {
+    QMutexLocker locker(&m_mutex);
+    m_lastRequested = frame;
+
+    std::map<int, TRaster32P>::iterator it = m_frames.find(frame);
+    if (it == m_frames.end()) {
+      ++m_wanted[frame];
+      m_frameWanted.wakeAll();
+      for (;;) {
+        it = m_frames.find(frame);
+        if (it != m_frames.end() || m_closing || frame >= m_endFrame ||
+            m_failed.count(frame))
+          break;
+        m_frameDecoded.wait(&m_mutex);
+      }
+      if (--m_wanted[frame] == 0) {
+        // Later requests of a failed frame will try to decode it again
+        m_wanted.erase(frame);
+        m_failed.erase(frame);
+      }
+      if (it == m_frames.end()) return TRaster32P();
+    }
+    m_frameWanted.wakeAll();  // may read ahead of the new position
+
+    // The buffered raster is shared with later requests - hand out a copy
+    return it->second->clone();
+  }
+
+  void close() {
+    QMutexLocker locker(&m_mutex);
+    m_closing = true;
+    m_frameWanted.wakeAll();
+    m_frameDecoded.wakeAll();
+  }
+
+protected:
+  void run() override {
+    QProcess *ffmpeg = 0;
+    int pos          = 0;  // next frame emitted by ffmpeg
+    int failures     = 0;  // consecutive failed reads
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+      int target = -1;
+      while (!m_closing && (target = nextTarget(ffmpeg != 0, pos)) < 0)
+        m_frameWanted.wait(&m_mutex);
+      if (m_closing) break;
+
+      bool seek = !ffmpeg || target < pos || target >= pos + SeekThreshold;
+      locker.unlock();
+
+      if (seek) {
+        stopDecoding(ffmpeg);
+        ffmpeg = startDecoding(target);
+        pos    = target;
+      }
+      TRaster32P ras;
+      ReadResult result = ffmpeg ? readFrame(*ffmpeg, ras) : ReadFailed;
+
+      locker.relock();
+      if (result == FrameRead) {
+        m_frames[pos++] = ras;
+        trimBuffer();
+        failures = 0;
+      } else {
+        locker.unlock();
+        stopDecoding(ffmpeg);
+        locker.relock();
+
+        if (result == EndOfStream) {
+          // Confirmed by ffmpeg: nothing at or past pos
+          m_endFrame = std::min(m_endFrame, pos);
+          failures   = 0;
+        } else if (++failures > MaxRetries) {
+          // Give up on the current request. Below the limit, the stopped
+          // process is restarted with a seek to the wanted frame.
+          if (m_wanted.count(target)) m_failed.insert(target);
+          failures = 0;
+        }
+      }
+      m_frameDecoded.wakeAll();
+    }
+    locker.unlock();
+
+    stopDecoding(ffmpeg);
+  }
+
+private:
+  //! Returns the frame decoding should proceed to, or -1 if none is needed.
+  int nextTarget(bool decoding, int pos) const {
+    // Requested frames reachable by decoding forward come first
+    int behind = -1;
+    std::map<int, int>::const_iterator wt;
+    for (wt = m_wanted.begin(); wt != m_wanted.end(); ++wt) {
+      int frame = wt->first;
+      if (frame >= m_endFrame || m_frames.count(frame) || m_failed.count(frame))
+        continue;
+      if (decoding && frame >= pos) return frame;
+      if (behind < 0) behind = frame;
+    }
+    if (behind >= 0) return behind;
+
+    // Then read ahead of the last request
+    if (decoding && pos >= m_lastRequested &&
+        pos <= m_lastRequested + ReadAhead && pos < m_endFrame)
+      return pos;
+
+    return -1;
+  }
+
+  //! Drops the frames farthest from the last request past the buffer size.
+  //! Frames with waiting callers are kept, as dropping them would have them
+  //! decoded again forever.
+  void trimBuffer() {
+    while (m_frames.size() > BufferSize) {
+      std::map<int, TRaster32P>::iterator it, farthest = m_frames.end();
+      int maxDistance = -1;
+      for (it = m_frames.begin(); it != m_frames.end(); ++it) {
+        if (m_wanted.count(it->first)) continue;
+        int distance = std::abs(it->first - m_lastRequested);
+        if (distance > maxDistance) maxDistance = distance, farthest = it;
+      }
+      if (farthest == m_frames.end()) break;
+      m_frames.erase(farthest);
+    }
+  }
+
+  QProcess *startDecoding(int frame) {
+    QStringList args;
+    if (frame > 0) {
+      // Seek half a frame early: accurate seeking drops frames before the
+      // seek point, so the first emitted frame is the requested one.
+      args << "-ss";
+      args << QString::number((frame - 0.5) / m_frameRate, 'f', 6);
+    }
+    args = args + m_inputArgs;
+    args << "-i";
+    args << m_path;
+    args << "-an";
+    args << "-sn";
+    args << "-s";
+    args << QString::number(m_lx) + "x" + QString::number(m_ly);
+    args << "-f";
+    args << "rawvideo";
+    args << "-pix_fmt";
+    args << rawPixelFormat();
+    args << "-";
+
+    QProcess *ffmpeg = new QProcess;
+    ffmpeg->setStandardErrorFile(QProcess::nullDevice());
+    ThirdParty::runFFmpeg(*ffmpeg, args);
+    if (!ffmpeg->waitForStarted()) {
+      delete ffmpeg;
+      return 0;
+    }
+    return ffmpeg;
+  }
+
+  void stopDecoding(QProcess *&ffmpeg) {
+    if (!ffmpeg) return;
+    ffmpeg->kill();
+    ffmpeg->waitForFinished();
+    delete ffmpeg;
+    ffmpeg = 0;
+  }
+
+  ReadResult readFrame(QProcess &ffmpeg, TRaster32P &ras) {
+    int rowSize = m_lx * 4, frameSize = rowSize * m_ly;
+
+    QByteArray data;
+    data.reserve(frameSize);
+    while (data.size() < frameSize) {
+      if (ffmpeg.bytesAvailable() == 0 && !ffmpeg.waitForReadyRead(m_timeout)) {
+        if (ffmpeg.state() != QProcess::NotRunning) return ReadFailed;
+        if (ffmpeg.bytesAvailable() > 0) continue;
+
+        // The stream ends where a successful decode stops emitting frames
+        bool ended = ffmpeg.exitStatus() == QProcess::NormalExit &&
+                     ffmpeg.exitCode() == 0;
+        return ended ? EndOfStream : ReadFailed;
+      }
+      data += ffmpeg.read(frameSize - data.size());
+    }
+
+    // ffmpeg rows are top-down
+    ras = TRaster32P(m_lx, m_ly);
+    ras->lock();
+    for (int y = 0; y < m_ly; ++y)
+      memcpy(ras->pixels(y), data.constData() + (m_ly - 1 - y) * rowSize,
+             rowSize);
+    ras->unlock();
+    return FrameRead;
+  }
+};
+
+//===========================================================
+//
+//  Ffmpeg
+//
+//===========================================================
+
 Ffmpeg::Ffmpeg() {
   m_ffmpegTimeout      = ThirdParty::getFFmpegTimeout() * 1000;
   if (m_ffmpegTimeout <= 0)
@@ -24,7 +405,14 @@ Ffmpeg::Ffmpeg() {
   m_intermediateFormat = "png";
   m_startNumber        = 2147483647;  // Lowest frame determines starting frame
 }
-Ffmpeg::~Ffmpeg() {}
+Ffmpeg::~Ffmpeg() {
+  if (m_streamWriter) stopStreaming();
+  if (m_streamReader) {
+    m_streamReader->close();
+    m_streamReader->wait();
+    delete m_streamReader;
+  }
+}
 
 bool Ffmpeg::checkFormat(std::string format) {
   static std::string strResults = "";
@@ -118,6 +506,93 @@ void Ffmpeg::createIntermediateImage(const TImageP &img, int frameIndex) {
   delete image;
 }
 
+//-----------------------------------------------------------
+
+void Ffmpeg::startStreaming(QStringList preIArgs, QStringList postIArgs,
+                            int lx, int ly) {
+  assert(!m_streamWriter);
+  m_lx = lx;
+  m_ly = ly;
+
+  QStringList args;
+  args = args + preIArgs;
+  args << "-f";
+  args << "rawvideo";
+  args << "-pix_fmt";
+  args << rawPixelFormat();
+  args << "-video_size";
+  args << QString::number(m_lx) + "x" + QString::number(m_ly);
+  args << "-i";
+  args << "-";
+  if (m_hasSoundTrack) args = args + m_audioArgs;
+  args = args + postIArgs;
+  args << "-y";
+  args << m_path.getQString();
+
+  m_streamWriter = new FfmpegStreamWriter(args, m_ffmpegTimeout);
+  m_streamWriter->start(QThread::LowPriority);
+}
+
+//-----------------------------------------------------------
+
+void Ffmpeg::writeFrame(const TImageP &img, int frameIndex) {
+  assert(m_streamWriter);
+  TRasterImageP image(img);
+  TRasterP raster = image ? image->getRaster() : TRasterP();
+  if (!raster) throw TImageException(m_path, "unsupported image type");
+  if (raster->getLx() != m_lx || raster->getLy() != m_ly)
+    throw TImageException(m_path, "frame size mismatch");
+
+  // 64-bit renders and other pixel types are converted to 32-bit, the raw
+  // format fed to ffmpeg
+  TRaster32P ras = raster;
+  if (!ras) {
+    ras = TRaster32P(m_lx, m_ly);
+    try {
+      TRop::convert(ras, raster);
+    } catch (TRopException &) {
+      throw TImageException(m_path, "unsupported pixel format");
+    }
+  }
+  m_frameCount++;
+
+  // Copy the frame top-down, the way ffmpeg expects it. The copy also
+  // decouples the queued frame from the raster, which the caller may reuse.
+  int rowSize = m_lx * 4;
+  QByteArray data(rowSize * m_ly, Qt::Uninitialized);
+  ras->lock();
+  for (int y = 0; y < m_ly; ++y)
+    memcpy(data.data() + (m_ly - 1 - y) * rowSize, ras->pixels(y), rowSize);
+  ras->unlock();
+
+  m_streamWriter->addFrame(frameIndex, data);
+}
+
+//-----------------------------------------------------------
+
+void Ffmpeg::stopStreaming() {
+  if (!m_streamWriter) return;
+
+  // Keep the event loop alive while ffmpeg flushes the last frames, as
+  // runFfmpeg() does for asynchronous processes.
+  QEventLoop eloop;
+  QObject::connect(m_streamWriter, &QThread::finished, &eloop,
+                   &QEventLoop::quit);
+  m_streamWriter->close();
+  if (!m_streamWriter->isFinished()) eloop.exec();
+  m_streamWriter->wait();
+
+  if (m_streamWriter->hasFailed())
+    DVGui::warning(
+        QObject::tr("FFmpeg failed to write the file.\n"
+                    "Please check the file for errors.\n"
+                    "If the file doesn't play or is incomplete, \n"
+                    "Please try raising the FFmpeg timeout in Preferences."));
+
+  delete m_streamWriter;
+  m_streamWriter = 0;
+}
+
 void Ffmpeg::runFfmpeg(QStringList preIArgs, QStringList postIArgs,
                        bool includesInPath, bool includesOutPath,
                        bool overWriteFiles, bool asyncProcess) {
@@ -318,6 +793,30 @@ TRasterImageP Ffmpeg::getImage(int frameIndex) {
   return TRasterImageP();
 }
 
+TRasterImageP Ffmpeg::readFrame(int frameIndex) {
+  if (frameIndex < 1 || m_lx <= 0 || m_ly <= 0) return TRasterImageP();
+  {
+    QMutexLocker locker(&m_streamReaderMutex);
+    if (!m_streamReader) {
+      QStringList inputArgs;
+      if (m_path.getType() == "webm") {
+        // To load in webm transparency
+        inputArgs << "-vcodec";
+        inputArgs << "libvpx";
+      }
+      m_streamReader =
+          new FfmpegStreamReader(m_path.getQString(), inputArgs, m_lx, m_ly,
+                                 m_frameRate, m_ffmpegTimeout);
+      m_streamReader->start();
+    }
+  }
+
+  TRaster32P ras = m_streamReader->getFrame(frameIndex - 1);
+  return ras ? TRasterImageP(ras) : TRasterImageP();
+}
+
+//-----------------------------------------------------------
+
 double Ffmpeg::getFrameRate() {
   QStringList fpsArgs;
   int fpsNum = 0, fpsDen = 0;
@@ -576,7 +1075,7 @@ TLevelReaderFFmpeg::TLevelReaderFFmpeg(const TFilePath &path)
 }
 //-----------------------------------------------------------
 
-TLevelReaderFFmpeg::~TLevelReaderFFmpeg() {}
+TLevelReaderFFmpeg::~TLevelReaderFFmpeg() { delete ffmpegReader; }
 
 //-----------------------------------------------------------
 
@@ -604,9 +1103,5 @@ TDimension TLevelReaderFFmpeg::getSize() { return m_size; }
 //------------------------------------------------
 
 TImageP TLevelReaderFFmpeg::load(int frameIndex) {
-  if (!ffmpegFramesCreated) {
-    ffmpegReader->getFramesFromMovie();
-    ffmpegFramesCreated = true;
-  }
-  return ffmpegReader->getImage(frameIndex);
+  return ffmpegReader->readFrame(frameIndex);
 }
\ No newline at end of file
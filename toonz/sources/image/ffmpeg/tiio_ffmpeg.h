@@ -9,6 +9,10 @@
 #include <QVector>
 #include <QStringList>
 #include <QProcess>
+#include <QMutex>
+
+class FfmpegStreamWriter;
+class FfmpegStreamReader;
 
 struct ffmpegFileInfo {
   int m_lx, m_ly, m_frameCount;
@@ -20,6 +24,13 @@ public:
   Ffmpeg();
   ~Ffmpeg();
   void createIntermediateImage(const TImageP &image, int frameIndex);
+  // Streaming mode: frames are piped to a single ffmpeg process as raw video
+  // instead of being saved as intermediate images in the cache folder.
+  void startStreaming(QStringList preIArgs, QStringList postIArgs, int lx,
+                      int ly);
+  void writeFrame(const TImageP &image, int frameIndex);
+  void stopStreaming();
+  bool isStreaming() const { return m_streamWriter != 0; }
   void runFfmpeg(QStringList preIArgs, QStringList postIArgs,
                  bool includesInPath, bool includesOutPath, bool overWriteFiles,
                  bool asyncProcess = true);
@@ -38,6 +49,9 @@ public:
   int getFrameCount();
   void getFramesFromMovie(int frame = -1);
   TRasterImageP getImage(int frameIndex);
+  // Streaming decode: frames are read from a persistent ffmpeg process as raw
+  // video. getInfo() must have been called first.
+  TRasterImageP readFrame(int frameIndex);
   TFilePath getFfmpegCache();
   ffmpegFileInfo getInfo();
   void disablePrecompute();
@@ -53,6 +67,9 @@ private:
   QVector<QString> m_cleanUpList;
   QStringList m_audioArgs;
   TUINT32 m_sampleRate;
+  FfmpegStreamWriter *m_streamWriter = 0;
+  FfmpegStreamReader *m_streamReader = 0;
+  QMutex m_streamReaderMutex;
   QString cleanPathSymbols();
   bool waitFfmpeg(QProcess &ffmpeg, bool asyncProcess);
 };
@@ -79,7 +96,6 @@ public:
 
 private:
   Ffmpeg *ffmpegReader;
-  bool ffmpegFramesCreated = false;
   TDimension m_size;
   int m_frameCount, m_lx, m_ly;
 };
@@ -57,7 +57,13 @@ TLevelWriterMp4::TLevelWriterMp4(const TFilePath &path, TPropertyGroup *winfo)
 //-----------------------------------------------------------
 
 TLevelWriterMp4::~TLevelWriterMp4() {
-  // QProcess createMp4;
+  ffmpegWriter->stopStreaming();
+  ffmpegWriter->cleanUpFiles();
+}
+
+//-----------------------------------------------------------
+
+void TLevelWriterMp4::startStreaming() {
   QStringList preIArgs;
   QStringList postIArgs;
 
@@ -117,8 +123,7 @@ TLevelWriterMp4::~TLevelWriterMp4() {
     postIArgs << "libxh264";
   }
 
-  ffmpegWriter->runFfmpeg(preIArgs, postIArgs, false, false, true);
-  ffmpegWriter->cleanUpFiles();
+  ffmpegWriter->startStreaming(preIArgs, postIArgs, m_lx, m_ly);
 }
 
 //-----------------------------------------------------------
@@ -145,10 +150,14 @@ void TLevelWriterMp4::saveSoundTrack(TSoundTrack *st) {
 //-----------------------------------------------------------
 
 void TLevelWriterMp4::save(const TImageP &img, int frameIndex) {
-  TRasterImageP image(img);
-  m_lx = image->getRaster()->getLx();
-  m_ly = image->getRaster()->getLy();
-  ffmpegWriter->createIntermediateImage(img, frameIndex);
+  // ffmpeg is launched on the first frame, once the size is known
+  if (!ffmpegWriter->isStreaming()) {
+    TRasterImageP image(img);
+    m_lx = image->getRaster()->getLx();
+    m_ly = image->getRaster()->getLy();
+    startStreaming();
+  }
+  ffmpegWriter->writeFrame(img, frameIndex);
 }
 
 //===========================================================
@@ -211,9 +220,7 @@ TLevelReaderMp4::TLevelReaderMp4(const TFilePath &path) : TLevelReader(path) {
 }
 //-----------------------------------------------------------
 
-TLevelReaderMp4::~TLevelReaderMp4() {
-  // ffmpegReader->cleanUpFiles();
-}
+TLevelReaderMp4::~TLevelReaderMp4() { delete ffmpegReader; }
 
 //-----------------------------------------------------------
 
@@ -243,11 +250,7 @@ TDimension TLevelReaderMp4::getSize() { return m_size; }
 //------------------------------------------------
 
 TImageP TLevelReaderMp4::load(int frameIndex) {
-  if (!ffmpegFramesCreated) {
-    ffmpegReader->getFramesFromMovie();
-    ffmpegFramesCreated = true;
-  }
-  return ffmpegReader->getImage(frameIndex);
+  return ffmpegReader->readFrame(frameIndex);
 }
 
 Tiio::Mp4WriterProperties::Mp4WriterProperties()
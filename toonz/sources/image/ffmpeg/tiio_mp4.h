@@ -31,6 +31,8 @@ public:
   }
 
 private:
+  void startStreaming();
+
   Ffmpeg *ffmpegWriter;
   int m_lx, m_ly;
   int m_scale;
@@ -61,7 +63,6 @@ public:
   // void *m_decompressedBuffer;
 private:
   Ffmpeg *ffmpegReader;
-  bool ffmpegFramesCreated = false;
   TDimension m_size;
   int m_frameCount, m_lx, m_ly;
 };
@@ -52,7 +52,13 @@ TLevelWriterWebm::TLevelWriterWebm(const TFilePath &path, TPropertyGroup *winfo)
 //-----------------------------------------------------------
 
 TLevelWriterWebm::~TLevelWriterWebm() {
-  // QProcess createWebm;
+  ffmpegWriter->stopStreaming();
+  ffmpegWriter->cleanUpFiles();
+}
+
+//-----------------------------------------------------------
+
+void TLevelWriterWebm::startStreaming() {
   QStringList preIArgs;
   QStringList postIArgs;
 
@@ -92,8 +98,7 @@ TLevelWriterWebm::~TLevelWriterWebm() {
   postIArgs << "-quality";
   postIArgs << "good";
 
-  ffmpegWriter->runFfmpeg(preIArgs, postIArgs, false, false, true);
-  ffmpegWriter->cleanUpFiles();
+  ffmpegWriter->startStreaming(preIArgs, postIArgs, m_lx, m_ly);
 }
 
 //-----------------------------------------------------------
@@ -120,10 +125,14 @@ void TLevelWriterWebm::saveSoundTrack(TSoundTrack *st) {
 //-----------------------------------------------------------
 
 void TLevelWriterWebm::save(const TImageP &img, int frameIndex) {
-  TRasterImageP image(img);
-  m_lx = image->getRaster()->getLx();
-  m_ly = image->getRaster()->getLy();
-  ffmpegWriter->createIntermediateImage(img, frameIndex);
+  // ffmpeg is launched on the first frame, once the size is known
+  if (!ffmpegWriter->isStreaming()) {
+    TRasterImageP image(img);
+    m_lx = image->getRaster()->getLx();
+    m_ly = image->getRaster()->getLy();
+    startStreaming();
+  }
+  ffmpegWriter->writeFrame(img, frameIndex);
 }
 
 //===========================================================
@@ -186,9 +195,7 @@ TLevelReaderWebm::TLevelReaderWebm(const TFilePath &path) : TLevelReader(path) {
 }
 //-----------------------------------------------------------
 
-TLevelReaderWebm::~TLevelReaderWebm() {
-  // ffmpegReader->cleanUpFiles();
-}
+TLevelReaderWebm::~TLevelReaderWebm() { delete ffmpegReader; }
 
 //-----------------------------------------------------------
 
@@ -218,11 +225,7 @@ TDimension TLevelReaderWebm::getSize() { return m_size; }
 //------------------------------------------------
 
 TImageP TLevelReaderWebm::load(int frameIndex) {
-  if (!ffmpegFramesCreated) {
-    ffmpegReader->getFramesFromMovie();
-    ffmpegFramesCreated = true;
-  }
-  return ffmpegReader->getImage(frameIndex);
+  return ffmpegReader->readFrame(frameIndex);
 }
 
 Tiio::WebmWriterProperties::WebmWriterProperties()
@@ -132,10 +132,8 @@ UINT findColor(const TPixel32 &color, const std::vector<TPixel> &colorArray) {
 
 //---------------------------------------------------------------------------
 
-void buildPalette(ParsedPli *pli, const TImageP img) {
+void buildPalette(ParsedPli *pli, TPalette *vPalette) {
   if (!pli->m_palette_tags.empty()) return;
-  TVectorImageP tempVecImg = img;
-  TPalette *vPalette       = tempVecImg->getPalette();
   unsigned int i;
   // if (pli->m_idWrittenColorsArray.empty())
   //  {
@@ -542,7 +540,9 @@ void TImageWriterPli::save(const TImageP &img) {
     m_lwp->m_pli->setCreator(m_lwp->m_creator);
   }
 
-  buildPalette(m_lwp->m_pli.get(), img);
+  // The palette is written with the level, so that styles added while the
+  // frames are being saved are not lost
+  m_lwp->m_palette = tempVecImg->getPalette();
 
   ParsedPli *pli = m_lwp->m_pli.get();
 
@@ -622,6 +622,7 @@ TLevelWriterPli::~TLevelWriterPli() {
   try {
     // aggiungo il tag della palette
     CurrStyle = NULL;
+    buildPalette(m_pli.get(), m_palette.getPointer());
     assert(!m_pli->m_palette_tags.empty());
     std::unique_ptr<GroupTag> groupTag(
         new GroupTag(GroupTag::PALETTE, m_pli->m_palette_tags.size(),
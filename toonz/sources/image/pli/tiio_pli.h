@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "tlevel_io.h"
+#include "tpalette.h"
 
 class GroupTag;
 class ParsedPli;
@@ -44,6 +45,9 @@ class TLevelWriterPli final : public TLevelWriter {
   //  vettore da utilizzare per il calcolo della palette
   std::vector<TPixel> m_colorArray;
 
+  //! palette of the last saved frame, written at destruction
+  TPaletteP m_palette;
+
 public:
   TLevelWriterPli(const TFilePath &path, TPropertyGroup *winfo);
   ~TLevelWriterPli();
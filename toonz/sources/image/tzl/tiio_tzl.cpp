@@ -21,6 +21,8 @@
 #include "toonz/preferences.h"
 
 #include <QByteArray>
+#include <QFile>
+#include <QMutexLocker>
 
 #if !defined(TNZ_LITTLE_ENDIAN)
 TNZ_LITTLE_ENDIAN undefined !!
@@ -1475,6 +1477,9 @@ void TLevelReaderTzl::readPalette() {
 TLevelReaderTzl::TLevelReaderTzl(const TFilePath &path)
     : TLevelReader(path)
     , m_chan(0)
+    , m_file(0)
+    , m_mappedData(0)
+    , m_mappedSize(0)
     , m_res(0, 0)
     , m_xDpi(0)
     , m_yDpi(0)
@@ -1491,6 +1496,14 @@ TLevelReaderTzl::TLevelReaderTzl(const TFilePath &path)
                             m_version, m_creator, 0, 0, 0, m_level))
     return;
 
+  // Map the level file, so that frames can be read without seeking m_chan
+  m_file = new QFile(path.getQString());
+  if (m_file->open(QIODevice::ReadOnly)) {
+    m_mappedSize = m_file->size();
+    m_mappedData = m_file->map(0, m_mappedSize);
+  }
+  if (!m_mappedData) m_mappedSize = 0;
+
   TFilePath historyFp = path.withNoFrame().withType("hst");
   FILE *historyChan   = fopen(historyFp, "r");
   if (historyChan) {
@@ -1527,6 +1540,31 @@ void TLevelReaderTzl::doReadPalette(bool doReadIt) { m_readPalette = doReadIt; }
 TLevelReaderTzl::~TLevelReaderTzl() {
   if (m_chan) fclose(m_chan);
   m_chan = 0;
+
+  delete m_file;  // Unmaps the file, too
+}
+
+//-------------------------------------------------------------------
+
+const UCHAR *TLevelReaderTzl::mappedData(TINT32 offs, TINT32 size) const {
+  if (!m_mappedData || offs < 0 || size < 0 ||
+      (qint64)offs + size > m_mappedSize)
+    return 0;
+
+  return m_mappedData + offs;
+}
+
+//-------------------------------------------------------------------
+
+bool TLevelReaderTzl::readData(TINT32 offs, void *dst, TINT32 size) {
+  if (const UCHAR *src = mappedData(offs, size)) {
+    memcpy(dst, src, size);
+    return true;
+  }
+
+  QMutexLocker sl(&m_chanMutex);
+  if (!m_chan || fseek(m_chan, offs, SEEK_SET)) return false;
+  return fread(dst, 1, size, m_chan) == (size_t)size;
 }
 
 //-------------------------------------------------------------------
@@ -1555,6 +1593,7 @@ bool TLevelReaderTzl::getIconSize(TDimension &iconSize) {
   if (m_iconOffsTable.empty()) return false;
   if (m_version < 13) return false;
   assert(m_chan);
+  QMutexLocker sl(&m_chanMutex);
   TINT32 currentPos         = ftell(m_chan);
   TzlOffsetMap::iterator it = m_iconOffsTable.begin();
   TINT32 offs               = it->second.m_offs;
@@ -1592,6 +1631,7 @@ TImageP TImageReaderTzl::load10() {
   FILE *chan = m_lrp->m_chan;
 
   if (!chan) return TImageP();
+  QMutexLocker sl(&m_lrp->m_chanMutex);
 
   // SAVEBOX_X0 SAVEBOX_Y0 SAVEBOX_LX SAVEBOX_LY BUFFER_SIZE
   TINT32 sbx0, sby0, sblx, sbly;
@@ -1723,6 +1763,7 @@ TImageP TImageReaderTzl::load11() {
   FILE *chan = m_lrp->m_chan;
 
   if (!chan) return TImageP();
+  QMutexLocker sl(&m_lrp->m_chanMutex);
 
   // SAVEBOX_X0 SAVEBOX_Y0 SAVEBOX_LX SAVEBOX_LY BUFFER_SIZE
   TINT32 sbx0, sby0, sblx, sbly;
@@ -1845,6 +1886,7 @@ TImageP TImageReaderTzl::load13() {
   FILE *chan = m_lrp->m_chan;
 
   if (!chan) return TImageP();
+  QMutexLocker sl(&m_lrp->m_chanMutex);
   // SAVEBOX_X0 SAVEBOX_Y0 SAVEBOX_LX SAVEBOX_LY BUFFER_SIZE
   TINT32 sbx0, sby0, sblx, sbly;
   TINT32 actualBuffSize;
@@ -2071,15 +2113,17 @@ static TRect applyShrinkAndRegion(TRasterP &ras, int shrink, TRect region,
 //-------------------------------------------------------------------
 
 TImageP TImageReaderTzl::load14() {
-  FILE *chan = m_lrp->m_chan;
+  // NOTE: This function does not modify the level reader, and reads data
+  // through TLevelReaderTzl::readData() - so multiple threads may load
+  // different frames of the same level concurrently.
 
-  if (!chan) return TImageP();
+  if (!m_lrp->m_chan) return TImageP();
   // SAVEBOX_X0 SAVEBOX_Y0 SAVEBOX_LX SAVEBOX_LY BUFFER_SIZE
   TINT32 sbx0 = 0, sby0 = 0, sblx, sbly;
   TINT32 actualBuffSize;
   double xdpi = 1, ydpi = 1;
   // TINT32 imgBuffSize = 0;
-  UCHAR *imgBuff = 0;
+  const UCHAR *imgBuff = 0;
   TINT32 iconLx = 0, iconLy = 0;
   assert(!m_lrp->m_frameOffsTable.empty());
   assert(!m_lrp->m_iconOffsTable.empty());
@@ -2094,14 +2138,21 @@ TImageP TImageReaderTzl::load14() {
       iconIt == m_lrp->m_iconOffsTable.end())
     throw TException("Loading tlv: frame ID not found.");
 
-  fseek(chan, it->second.m_offs, SEEK_SET);
-  fread(&sbx0, sizeof(TINT32), 1, chan);
-  fread(&sby0, sizeof(TINT32), 1, chan);
-  fread(&sblx, sizeof(TINT32), 1, chan);
-  fread(&sbly, sizeof(TINT32), 1, chan);
-  fread(&actualBuffSize, sizeof(TINT32), 1, chan);
-  fread(&xdpi, sizeof(double), 1, chan);
-  fread(&ydpi, sizeof(double), 1, chan);
+  const int frameHeaderSize = 5 * sizeof(TINT32) + 2 * sizeof(double);
+  TINT32 buffOffs           = it->second.m_offs + frameHeaderSize;
+  {
+    UCHAR frameHeader[frameHeaderSize];
+    if (!m_lrp->readData(it->second.m_offs, frameHeader, frameHeaderSize))
+      throw TException("Loading tlv: unexpected end of file.");
+
+    memcpy(&sbx0, frameHeader, sizeof(TINT32));
+    memcpy(&sby0, frameHeader + 4, sizeof(TINT32));
+    memcpy(&sblx, frameHeader + 8, sizeof(TINT32));
+    memcpy(&sbly, frameHeader + 12, sizeof(TINT32));
+    memcpy(&actualBuffSize, frameHeader + 16, sizeof(TINT32));
+    memcpy(&xdpi, frameHeader + 20, sizeof(double));
+    memcpy(&ydpi, frameHeader + 28, sizeof(double));
+  }
 
   if (sbx0 < 0 || sby0 < 0 || sblx < 0 || sbly < 0 || sblx > m_lx ||
       sbly > m_ly)
@@ -2119,37 +2170,53 @@ TImageP TImageReaderTzl::load14() {
 
   // Carico l'icona dal file
   if (m_isIcon) {
-    fseek(chan, iconIt->second.m_offs, SEEK_SET);
-    fread(&iconLx, sizeof(TINT32), 1, chan);
-    fread(&iconLy, sizeof(TINT32), 1, chan);
-    assert(iconLx > 0 && iconLy > 0);
-    if (iconLx < 0 || iconLy < 0 || iconLx > m_lx || iconLy > m_ly)
-      throw TException("Loading tlv: bad icon size.");
-    fread(&actualBuffSize, sizeof(TINT32), 1, chan);
+    {
+      TINT32 iconHeader[3] = {0, 0, 0};
+      if (!m_lrp->readData(iconIt->second.m_offs, iconHeader,
+                           sizeof(iconHeader)))
+        throw TException("Loading tlv: unexpected end of file.");
+
+      iconLx = iconHeader[0], iconLy = iconHeader[1];
+      assert(iconLx > 0 && iconLy > 0);
+      if (iconLx < 0 || iconLy < 0 || iconLx > m_lx || iconLy > m_ly)
+        throw TException("Loading tlv: bad icon size.");
+      actualBuffSize = iconHeader[2];
+    }
 
     if (actualBuffSize <= 0 ||
         actualBuffSize > (int)(iconLx * iconLx * sizeof(TPixelCM32)))
       throw TException("Loading tlv: icon buffer size error.");
 
-    TRasterCM32P raux = TRasterCM32P(iconLx, iconLy);
-    if (!raux) return TImageP();
-    raux->lock();
-    imgBuff = (UCHAR *)raux->getRawData();  // new UCHAR[imgBuffSize];
-    fread(imgBuff, actualBuffSize, 1, chan);
+    TINT32 iconBuffOffs = iconIt->second.m_offs + 3 * sizeof(TINT32);
+
+    TRasterCM32P raux;
+#if TNZ_LITTLE_ENDIAN
+    // Decompress straight from the mapped file, if possible
+    imgBuff = m_lrp->mappedData(iconBuffOffs, actualBuffSize);
+#endif
+    if (!imgBuff) {
+      raux = TRasterCM32P(iconLx, iconLy);
+      if (!raux) return TImageP();
+      raux->lock();
+      UCHAR *buff = (UCHAR *)raux->getRawData();  // new UCHAR[imgBuffSize];
+      if (!m_lrp->readData(iconBuffOffs, buff, actualBuffSize))
+        throw TException("Loading tlv: unexpected end of file.");
 
 #if !TNZ_LITTLE_ENDIAN
-    Header *header    = (Header *)imgBuff;
-    header->m_lx      = swapTINT32(header->m_lx);
-    header->m_ly      = swapTINT32(header->m_ly);
-    header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
+      Header *header    = (Header *)buff;
+      header->m_lx      = swapTINT32(header->m_lx);
+      header->m_ly      = swapTINT32(header->m_ly);
+      header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
+      imgBuff = buff;
+    }
 
     TRasterCodecLZO codec("LZO", false);
     TRasterP ras;
     if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
       return TImageP();
     assert((TRasterCM32P)ras);
-    raux->unlock();
+    if (raux) raux->unlock();
     raux = TRasterCM32P();
 
 #if !TNZ_LITTLE_ENDIAN
@@ -2231,24 +2298,31 @@ TImageP TImageReaderTzl::load14() {
       actualBuffSize > (int)(m_lx * m_ly * sizeof(TPixelCM32)))
     throw TException("Loading tlv: buffer size error");
 
-  TRasterCM32P raux = TRasterCM32P(m_lx, m_ly);
-
-  // imgBuffSize = m_lx*m_ly*sizeof(TPixelCM32);
-
-  raux->lock();
-  imgBuff = (UCHAR *)raux->getRawData();  // new UCHAR[imgBuffSize];
-  // int ret =
+  TRasterCM32P raux;
+#if TNZ_LITTLE_ENDIAN
+  // Decompress straight from the mapped file, if possible
+  imgBuff = m_lrp->mappedData(buffOffs, actualBuffSize);
+#endif
+  if (!imgBuff) {
+    raux = TRasterCM32P(m_lx, m_ly);
 
-  fread(imgBuff, actualBuffSize, 1, chan);
-  // assert(ret==1);
+    // imgBuffSize = m_lx*m_ly*sizeof(TPixelCM32);
 
-  Header *header = (Header *)imgBuff;
+    raux->lock();
+    UCHAR *buff = (UCHAR *)raux->getRawData();  // new UCHAR[imgBuffSize];
+    if (!m_lrp->readData(buffOffs, buff, actualBuffSize))
+      throw TException("Loading tlv: unexpected end of file.");
 
 #if !TNZ_LITTLE_ENDIAN
-  header->m_lx      = swapTINT32(header->m_lx);
-  header->m_ly      = swapTINT32(header->m_ly);
-  header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
+    Header *header    = (Header *)buff;
+    header->m_lx      = swapTINT32(header->m_lx);
+    header->m_ly      = swapTINT32(header->m_ly);
+    header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
+    imgBuff = buff;
+  }
+
+  const Header *header = (const Header *)imgBuff;
 
   TRasterCodecLZO codec("LZO", false);
   TRasterP ras;
@@ -2261,7 +2335,7 @@ TImageP TImageReaderTzl::load14() {
     throw TException("Loading tlv: lx dimension error.");
   if (ras->getLy() != header->m_ly)
     throw TException("Loading tlv: ly dimension error.");
-  raux->unlock();
+  if (raux) raux->unlock();
   raux = TRasterCM32P();
 
 #if !TNZ_LITTLE_ENDIAN
@@ -2374,6 +2448,8 @@ const TImageInfo *TImageReaderTzl::getImageInfo11() const {
   FILE *chan = m_lrp->m_chan;
   if (!chan) return 0;
 
+  QMutexLocker sl(&m_lrp->m_chanMutex);
+
   TzlOffsetMap::iterator it = m_lrp->m_frameOffsTable.find(m_fid);
 
   if (it == m_lrp->m_frameOffsTable.end()) return 0;
@@ -2426,6 +2502,7 @@ const TImageInfo *TImageReaderTzl::getImageInfo11() const {
 const TImageInfo *TImageReaderTzl::getImageInfo10() const {
   FILE *chan = m_lrp->m_chan;
   if (!chan) return 0;
+  QMutexLocker sl(&m_lrp->m_chanMutex);
 
   // SAVEBOX_X0 SAVEBOX_Y0 SAVEBOX_LX SAVEBOX_LY BUFFER_SIZE
   TINT32 sbx0, sby0, sblx, sbly;
@@ -6,8 +6,11 @@
 #include "tlevel_io.h"
 #include <set>
 
+#include <QMutex>
+
 class TImageWriterTzl;
 class TImageReaderTzl;
+class QFile;
 
 //===========================================================================
 
@@ -133,6 +136,11 @@ private:
 
 /*!
   TLevelReaderTzl:
+
+  The level file is memory-mapped when possible, so that frame readers
+  obtained from the same level reader can load different frames concurrently
+  (see TImageReaderTzl::load14()). Accesses to the shared FILE handle are
+  serialized.
  */
 class TLevelReaderTzl final : public TLevelReader {
 public:
@@ -164,6 +172,10 @@ Return an image with Reader information
 
 private:
   FILE *m_chan;
+  QFile *m_file;              //!< Read-only view of the level file
+  const UCHAR *m_mappedData;  //!< The mapped file contents, or 0
+  qint64 m_mappedSize;        //!< Size of m_mappedData in bytes
+  QMutex m_chanMutex;         //!< Serializes accesses to m_chan
   TLevelP m_level;
   TDimension m_res;
   double m_xDpi, m_yDpi;
@@ -182,6 +194,13 @@ public:
 
 private:
   void readPalette();
+
+  //! Returns the mapped file data in [offs, offs + size), or 0 if
+  //! unavailable.
+  const UCHAR *mappedData(TINT32 offs, TINT32 size) const;
+  //! Copies size bytes starting at offs into dst. Returns false on failure.
+  bool readData(TINT32 offs, void *dst, TINT32 size);
+
   // not implemented
   TLevelReaderTzl(const TLevelReaderTzl &);
   TLevelReaderTzl &operator=(const TLevelReaderTzl &);
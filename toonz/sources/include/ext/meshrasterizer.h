@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef MESHRASTERIZER_H
+#define MESHRASTERIZER_H
+
+// TnzCore includes
+#include "traster.h"
+#include "tgeometry.h"
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TNZEXT_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//=======================================================================
+
+//    Forward Declarations
+
+class TMeshImage;
+
+struct PlasticDeformerDataGroup;
+
+//=======================================================================
+
+//********************************************************************************************
+//    Mesh Rasterizer  functions
+//********************************************************************************************
+
+/*!
+  \brief    Software rendering of texturized mesh images.
+
+  \details  The rasterizer draws deformed mesh images straight into a raster,
+            without any OpenGL context, so it can be used on machines with no
+            display, and by several render threads at once. Rows of the output
+            raster are split into bands, drawn on the shared helper threads.
+*/
+
+namespace MeshRasterizer {
+
+enum Filter {
+  BILINEAR,  //!< Same sampling as the OpenGL textures.
+  BICUBIC    //!< Catmull-Rom sampling, sharper on magnified textures.
+};
+
+/*!
+  \brief    Draws a texturized mesh image over the specified raster, the same
+            way tglDraw() does on an OpenGL context of the raster size.
+
+  \remark   Unlike tglDraw(), the input texture is assumed to be
+            \a premultiplied - and so is the drawn image.
+*/
+
+DVAPI void rasterize(
+    const TRaster32P &ras,     //!< Output raster, drawn over.
+    const TMeshImage &image,   //!< Mesh image to be drawn.
+    const TRaster32P &tex,     //!< Premultiplied texture.
+    const TRectD &texGeom,     //!< Texture geometry, in texture coordinates.
+    const TAffine &meshToTexAff,  //!< Transform from mesh to texture
+                                  //!  coordinates.
+    const PlasticDeformerDataGroup
+        &deformerDatas,  //!< Data structure of a deformation of the input image.
+    const TAffine &deformedToRasAff,  //!< Transform from the deformed mesh to
+                                      //!  output raster coordinates.
+    Filter filter = BILINEAR,
+    bool isMask = false  //!< Whether the image is drawn as a mask, the
+                         //!  same way tglDraw() does.
+    );
+
+}  // namespace MeshRasterizer
+
+#endif  // MESHRASTERIZER_H
@@ -0,0 +1,151 @@
+#pragma once
+
+#ifndef TALIASHASH_H
+#define TALIASHASH_H
+
+#include "tnztypes.h"
+
+#include <string>
+#include <string.h>
+
+//==============================================================================
+
+/*!
+  \brief    128-bit hash of a render resource alias.
+
+  \details  Fx aliases identify render results, and may grow up to several KBs
+            on deep fx trees. The render cache uses their hash as key, so that
+            lookups compare 16 bytes rather than the whole strings.
+            The hash is MurmurHash3 (x64, 128-bit variant); it is meant for
+            in-memory keys only, and must not be saved to disk.
+
+  \sa       TFxCacheManager and TCacheResourcePool classes.
+*/
+
+class TAliasHash {
+  TUINT64 m_h1, m_h2;
+
+public:
+  TAliasHash() : m_h1(0), m_h2(0) {}
+  explicit TAliasHash(const std::string &alias) {
+    build(alias.data(), alias.size());
+  }
+  TAliasHash(const char *data, size_t size) { build(data, size); }
+
+  bool operator==(const TAliasHash &other) const {
+    return m_h1 == other.m_h1 && m_h2 == other.m_h2;
+  }
+  bool operator!=(const TAliasHash &other) const { return !operator==(other); }
+  bool operator<(const TAliasHash &other) const {
+    return m_h1 < other.m_h1 || (m_h1 == other.m_h1 && m_h2 < other.m_h2);
+  }
+
+  //! Returns the first 64 bits of the hash, eg for bucket or shard selection.
+  TUINT64 toUInt64() const { return m_h1; }
+
+  //! Returns the hash as a string of 32 hexadecimal digits.
+  std::string toString() const {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result(32, '0');
+    for (int i = 0; i < 16; ++i) {
+      result[15 - i] = digits[(m_h1 >> (4 * i)) & 0xf];
+      result[31 - i] = digits[(m_h2 >> (4 * i)) & 0xf];
+    }
+    return result;
+  }
+
+private:
+  static TUINT64 rotl(TUINT64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static TUINT64 fmix(TUINT64 k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  void build(const char *data, size_t size) {
+    const TUINT64 c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+    const unsigned char *bytes = (const unsigned char *)data;
+
+    TUINT64 h1 = 0, h2 = 0, k1, k2;
+
+    size_t i, blocksCount = size / 16;
+    for (i = 0; i < blocksCount; ++i) {
+      memcpy(&k1, bytes + 16 * i, 8);
+      memcpy(&k2, bytes + 16 * i + 8, 8);
+
+      k1 *= c1, k1 = rotl(k1, 31), k1 *= c2, h1 ^= k1;
+      h1 = rotl(h1, 27), h1 += h2, h1 = h1 * 5 + 0x52dce729;
+
+      k2 *= c2, k2 = rotl(k2, 33), k2 *= c1, h2 ^= k2;
+      h2 = rotl(h2, 31), h2 += h1, h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    // Tail bytes. Each case falls through to hash the lower bytes too.
+    const unsigned char *tail = bytes + 16 * blocksCount;
+    k1 = k2 = 0;
+
+    switch (size & 15) {
+    case 15:
+      k2 ^= (TUINT64)tail[14] << 48;
+      // fallthrough
+    case 14:
+      k2 ^= (TUINT64)tail[13] << 40;
+      // fallthrough
+    case 13:
+      k2 ^= (TUINT64)tail[12] << 32;
+      // fallthrough
+    case 12:
+      k2 ^= (TUINT64)tail[11] << 24;
+      // fallthrough
+    case 11:
+      k2 ^= (TUINT64)tail[10] << 16;
+      // fallthrough
+    case 10:
+      k2 ^= (TUINT64)tail[9] << 8;
+      // fallthrough
+    case 9:
+      k2 ^= (TUINT64)tail[8];
+      k2 *= c2, k2 = rotl(k2, 33), k2 *= c1, h2 ^= k2;
+      // fallthrough
+    case 8:
+      k1 ^= (TUINT64)tail[7] << 56;
+      // fallthrough
+    case 7:
+      k1 ^= (TUINT64)tail[6] << 48;
+      // fallthrough
+    case 6:
+      k1 ^= (TUINT64)tail[5] << 40;
+      // fallthrough
+    case 5:
+      k1 ^= (TUINT64)tail[4] << 32;
+      // fallthrough
+    case 4:
+      k1 ^= (TUINT64)tail[3] << 24;
+      // fallthrough
+    case 3:
+      k1 ^= (TUINT64)tail[2] << 16;
+      // fallthrough
+    case 2:
+      k1 ^= (TUINT64)tail[1] << 8;
+      // fallthrough
+    case 1:
+      k1 ^= (TUINT64)tail[0];
+      k1 *= c1, k1 = rotl(k1, 31), k1 *= c2, h1 ^= k1;
+    }
+
+    // Finalization
+    h1 ^= (TUINT64)size, h2 ^= (TUINT64)size;
+    h1 += h2, h2 += h1;
+    h1 = fmix(h1), h2 = fmix(h2);
+    h1 += h2, h2 += h1;
+
+    m_h1 = h1, m_h2 = h2;
+  }
+};
+
+#endif  // TALIASHASH_H
@@ -3,7 +3,7 @@
 #ifndef _TBIGMEMORYMANAGER_
 #define _TBIGMEMORYMANAGER_
 
-class Chunkinfo;
+#include <memory>
 
 #undef DVAPI
 #undef DVVAR
@@ -19,19 +19,31 @@ class Chunkinfo;
 #include "tthreadmessage.h"
 class TRaster;
 
+//! Allocates the buffers of the rasters.
+/*!
+  Buffers are recycled by an arena of size classes: released buffers are
+  kept by the thread releasing them, and then in a shared cache, to be given
+  to the next rasters of the same class. Cached buffers are returned to the
+  system under memory pressure.
+
+  When initialized with init(), the manager is \a active: rasters are kept
+  within the specified amount of memory, and TImageCache makes room for new
+  rasters by compressing images or moving them to disk.
+*/
 class DVAPI TBigMemoryManager {
-  TThread::Mutex m_mutex;
-  UCHAR *m_theMemory;
-  std::map<UCHAR *, Chunkinfo> m_chunks;
-  UCHAR *allocate(UINT &size);
+  class Arena;
+  std::unique_ptr<Arena> m_arena;
+  TINT64 m_budget;  // in bytes, 0 when inactive
 
-  TUINT32 m_availableMemory, m_allocatedMemory;
-  std::map<UCHAR *, Chunkinfo>::iterator shiftBlock(
-      const std::map<UCHAR *, Chunkinfo>::iterator &it, TUINT32 offset);
-  TRaster *findRaster(TRaster *ras);
-  void checkConsistency();
-  UCHAR *remap(TUINT32 RequestedSize);
-  void printLog(TUINT32 size);
+public:
+  //! Raster allocation statistics of the current session.
+  struct Statistics {
+    TINT64 m_allocationsCount;  //!< Allocated rasters
+    TINT64 m_recycledCount;  //!< Allocated rasters with a recycled buffer
+    TINT64 m_usedKb;         //!< Memory used by the rasters
+    TINT64 m_peakUsedKb;     //!< Peak of the memory used by the rasters
+    TINT64 m_cachedKb;       //!< Memory of the buffers kept for reuse
+  };
 
 public:
   TBigMemoryManager();
@@ -39,25 +51,22 @@ public:
   bool init(TUINT32 sizeinKb);
   bool putRaster(TRaster *ras, bool canPutOnDisk = true);
   bool releaseRaster(TRaster *ras);
-  void lock(UCHAR *buffer);
-  void unlock(UCHAR *buffer);
   UCHAR *getBuffer(UINT size);
   static TBigMemoryManager *instance();
-  bool isActive() const { return m_theMemory != 0; }
-  // void releaseSubraster(UCHAR *chunk, TRaster*subRas);
-  TUINT32 getAvailableMemoryinKb() const {
-    assert(m_theMemory != 0);
-    return m_availableMemory >> 10;
-  }
+  bool isActive() const { return m_budget != 0; }
+  TUINT32 getAvailableMemoryinKb() const;
   void getRasterInfo(int &rasterCount, TUINT32 &totRasterMemInKb,
                      int &notCachedRasterCount,
                      TUINT32 &notCachedRasterMemInKb);
 #ifdef _DEBUG
   TUINT32 m_totRasterMemInKb;
-  void printMap();
 #endif
   int getAllocationPeak();
   int getAllocationMean();
+  Statistics getStatistics() const;
+
+  //! Returns the cached buffers to the system.
+  void releaseCachedMemory();
 
   void setRunOutOfContiguousMemoryHandler(void (*callback)(unsigned long size));
 
@@ -9,6 +9,7 @@
 
 #include "traster.h"
 #include "tpalette.h"
+#include "taliashash.h"
 
 #include <QMutex>
 #include <QString>
@@ -103,7 +104,8 @@ class DVAPI TCacheResource {
   };
 
 private:
-  std::map<std::string, TCacheResource *>::iterator m_pos;
+  std::map<TAliasHash, TCacheResource *>::iterator m_pos;
+  std::string m_name;
   TFilePath m_path;
   unsigned long m_id;
 
@@ -134,7 +136,7 @@ private:
   void release();
 
 public:
-  const std::string &getName() const { return m_pos->first; }
+  const std::string &getName() const { return m_name; }
 
   QMutex *getMutex() { return &m_mutex; }
 
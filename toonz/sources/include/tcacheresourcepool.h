@@ -36,7 +36,7 @@ class DVAPI TCacheResourcePool final : public QObject {
   THDCacheResourcePool *m_hdPool;
   TFilePath m_path;
 
-  typedef std::map<std::string, TCacheResource *> MemResources;
+  typedef std::map<TAliasHash, TCacheResource *> MemResources;
   MemResources m_memResources;
   QMutex m_memMutex;
 
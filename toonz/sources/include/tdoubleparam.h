@@ -82,6 +82,11 @@ public:
   // (e.g. expression and linear) then getValue(frame,true) can be !=
   // getValue(frame,false)
 
+  //! Evaluates the curve at count frames at once, faster than calling
+  //! getValue() for each of them.
+  void getValues(const double *frames, int count, double *values,
+                 bool leftmost = false) const;
+
   bool setValue(double frame, double value);
 
   // returns the incoming speed vector for keyframe kIndex. kIndex-1 must be
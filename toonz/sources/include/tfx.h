@@ -461,6 +461,10 @@ public:
   // TParamObserver-related methods
   void onChange(const TParamChange &c) override;
 
+  //! Returns a counter increased on every parameter change of any fx. Used to
+  //! invalidate data derived from fx parameters, like memoized aliases.
+  static long getParamChangesCount();
+
   void addObserver(TFxObserver *);
   void removeObserver(TFxObserver *);
   void notify(const TFxChange &change);
@@ -67,6 +67,15 @@ class DVAPI TImageCache {
   class Imp;
   std::unique_ptr<Imp> m_imp;
 
+public:
+  //! Cache activity counters, accumulated since the application start.
+  struct Statistics {
+    TUINT64 m_hits;          //!< get() calls that found the image
+    TUINT64 m_misses;        //!< get() calls that did not find the image
+    TUINT64 m_compressions;  //!< Images evicted from the uncompressed pool
+    TUINT64 m_diskSpills;    //!< Images shipped to swap files
+  };
+
 public:
   static TImageCache *instance();
 
@@ -155,6 +164,9 @@ public:
   // compress id (in memory)
   void compress(const std::string &id);
 
+  //! Returns the cache activity counters.
+  Statistics getStatistics() const;
+
 private:
   TImageCache();
   ~TImageCache();
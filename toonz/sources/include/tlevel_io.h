@@ -263,8 +263,11 @@ inline bool isMovieTypeOpaque(const TFilePath &fp) {
 
 //-----------------------------------------------------------
 
+// Formats streamed to a single ffmpeg process (mov, mp4, webm) must receive
+// frames in order.
 inline bool isSequencialRequired(std::string type) {
-  return (type == "mov" || type == "avi" || type == "3gp");
+  return (type == "mov" || type == "avi" || type == "3gp" || type == "mp4" ||
+          type == "webm");
 }
 
 //-----------------------------------------------------------
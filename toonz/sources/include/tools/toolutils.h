@@ -522,6 +522,12 @@ bool DVAPI doUpdateXSheet(TXshSimpleLevel *sl, std::vector<TFrameId> oldFids,
 bool DVAPI renumberForInsertFId(TXshSimpleLevel *sl, const TFrameId &fid,
                                 const TFrameId &maxFid, TXsheet *xsh);
 
+//! Connects the notifications of the scene changes which may affect the
+//! reference renders of the "Refer Visible" fills (see FillReferenceCache)
+//! to the specified slot of the receiver, or disconnects them.
+void DVAPI connectFillReferenceChanges(QObject *receiver, const char *slot,
+                                       bool connected);
+
 }  // namespace ToolUtils
 
 #endif  // TOOLSUTILS_H
@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef CLEANUPPIPELINE_H
+#define CLEANUPPIPELINE_H
+
+// TnzCore includes
+#include "timage.h"
+#include "trasterimage.h"
+#include "tfilepath.h"
+#include "tthread.h"
+
+// Qt includes
+#include <QMutex>
+#include <QWaitCondition>
+
+// STD includes
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TOONZLIB_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//*****************************************************************************
+//    CleanupPipeline  declaration
+//*****************************************************************************
+
+/*!
+  \brief    Cleans up the frames of a level on a pool of threads.
+
+  \details  The pipeline has three stages. The calling thread reads the
+            source frames and writes the results, while a pool of threads
+            runs the \p TCleanupper process and finalize steps of the frames
+            in between. Results are written in the same order the frames
+            were read.
+
+            Memory is bounded: no more than twice as many frames as threads
+            are read and not written yet at any time.
+
+            The first frame is processed on the calling thread before the
+            others are queued, since the auto-adjust reference and the target
+            colors are taken from it. The \p TCleanupper parameters must not
+            change while the pipeline runs.
+
+  \sa       The \p TCleanupper class.
+*/
+
+class DVAPI CleanupPipeline {
+public:
+  //! Returns the source image of a frame, or \p 0 to skip it.
+  typedef std::function<TRasterImageP(const TFrameId &fid)> Reader;
+
+  /*! Receives a cleaned up frame: a toonz raster image when lines are
+      processed, a resampled raster image otherwise - or \p 0 if the frame
+      could not be cleaned up.                                             */
+  typedef std::function<void(const TFrameId &fid, const TImageP &img,
+                             bool autocentered)>
+      Writer;
+
+  //! Receives the number of written frames, out of the frames to clean up.
+  typedef std::function<void(int done, int total)> ProgressCallback;
+
+  //! Time spent in each stage, in milliseconds. Process and finalize times
+  //! are summed over all the threads.
+  struct Timings {
+    qint64 m_read, m_process, m_finalize, m_write;
+    qint64 m_wait;   //!< Writer time spent waiting for the workers
+    qint64 m_total;  //!< Elapsed time of the whole run
+    int m_framesCount;
+
+    Timings()
+        : m_read(0)
+        , m_process(0)
+        , m_finalize(0)
+        , m_write(0)
+        , m_wait(0)
+        , m_total(0)
+        , m_framesCount(0) {}
+  };
+
+private:
+  struct Frame;
+  class FrameTask;
+
+  ProgressCallback m_progressCallback;
+
+  TThread::Executor m_executor;
+  int m_threadsCount;
+
+  mutable QMutex m_mutex;  //!< Guards the frames' states and the timings
+  QWaitCondition m_frameDone;
+  std::deque<std::shared_ptr<Frame>> m_frames;  //!< Queued frames, in order
+  Timings m_timings;
+  bool m_isCanceled;
+
+public:
+  /*! \param    threadsCount  Maximum number of frames cleaned up at the same
+                              time; \p 0 stands for the number of cores.     */
+  CleanupPipeline(int threadsCount = 0);
+  ~CleanupPipeline();  //!< Cancels the queued frames, and waits for the
+                       //!  running ones.
+
+  int getThreadsCount() const { return m_threadsCount; }
+
+  void setProgressCallback(const ProgressCallback &callback) {
+    m_progressCallback = callback;
+  }
+
+  /*! \brief    Cleans up the specified frames with the current \p TCleanupper
+                parameters, and returns once all of them were written.
+
+      \note     The source dpi must be set in the \p TCleanupper before the
+                first frame is processed - at the latest, by the reader when
+                it is invoked for the first time.                           */
+  void run(const std::vector<TFrameId> &fids, const Reader &reader,
+           const Writer &writer);
+
+  //! Stops reading frames, and skips the ones not started yet. May be called
+  //! from any thread - typically, from the reader or the writer.
+  void cancel();
+  bool isCanceled() const;
+
+  Timings getTimings() const;
+
+  //! Returns the timings of the last run as readable text.
+  std::string getTimingsReport() const;
+
+private:
+  void process(Frame &frame, bool firstImage);
+  void writeFrame(const Writer &writer, int &doneCount, int totalCount);
+  void waitFrames();
+  void addTime(qint64 &stageTime, qint64 time);
+
+  // Not copyable
+  CleanupPipeline(const CleanupPipeline &);
+  CleanupPipeline &operator=(const CleanupPipeline &);
+};
+
+#endif  // CLEANUPPIPELINE_H
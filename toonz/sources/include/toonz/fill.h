@@ -169,4 +169,42 @@ else fill ink and paint in rect.
                 bool onlyUnfilled);
 };
 
+//=============================================================================
+//! Keeps the camera stand renders used as reference by the "Refer Visible"
+//! fills, one per xsheet frame, so that only the first fill on a frame has
+//! to render it.
+/*!
+  The cache is not notified of the scene changes: tools filling with
+  references must invalidate() it when the xsheet, its levels or their
+  palettes change. Fills with references update() the renders
+  themselves in the area they changed, as the next fills flood by color
+  similarity on the render.
+*/
+//=============================================================================
+
+class DVAPI FillReferenceCache {
+  struct Entry {
+    const TXsheet *m_xsheet;
+    int m_frameIndex;
+    TRaster32P m_render;
+  };
+  std::vector<Entry> m_entries;  // Most recently used first
+
+  FillReferenceCache() {}
+
+public:
+  static FillReferenceCache *instance();
+
+  //! Returns the reference render of the specified xsheet frame, at camera
+  //! resolution. The raster is shared with the cache, and must not be
+  //! modified.
+  TRaster32P getRender(const TXsheet *xsheet, int frameIndex);
+
+  //! Renders again the specified rect, in render coordinates, of the cached
+  //! frames of the xsheet. Renders of other xsheets are dropped.
+  void update(const TXsheet *xsheet, const TRect &rect);
+
+  void invalidate() { m_entries.clear(); }
+};
+
 #endif
@@ -155,6 +155,29 @@ Binding an id to 0 is equivalent to unbinding it.
   void loadAllTlvIconsAndPutInCache(TXshSimpleLevel *, std::vector<TFrameId>,
                                     std::vector<std::string>, bool);
 
+  /*!
+Builds the images of the specified level frames in advance, using multiple
+threads, and stores them in the cache. Frames whose image is already cached
+are skipped. Returns once all images have been built.
+\n
+Frames of a tlv level are loaded through a single level reader, which maps the
+level file in memory and supports concurrent frame loads.
+*/
+  void prefetch(TXshSimpleLevel *level, const std::vector<TFrameId> &fids,
+                int imFlags = none);
+
+  /*!
+Queues a prefetch() of the specified level frames, which is served on a
+background thread. The level is retained until then. Requests are served one at
+a time, in the order they were made.
+*/
+  void prefetchInBackground(TXshSimpleLevel *level,
+                            const std::vector<TFrameId> &fids,
+                            int imFlags = none);
+
+  //! Drops the background prefetches which have not started yet.
+  void cancelPrefetches();
+
   /*!
 Returns the image built by the object associated with the specified identifier,
 using the
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef LEVELVECTORIZER_H
+#define LEVELVECTORIZER_H
+
+// TnzLib includes
+#include "toonz/vectorizerparameters.h"
+
+// TnzCore includes
+#include "timage.h"
+#include "tvectorimage.h"
+#include "tpalette.h"
+#include "tfilepath.h"
+#include "tthread.h"
+
+// Qt includes
+#include <QMutex>
+#include <QWaitCondition>
+
+// STD includes
+#include <deque>
+#include <functional>
+#include <memory>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TOONZLIB_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//*****************************************************************************
+//    LevelVectorizer  declaration
+//*****************************************************************************
+
+/*!
+  \brief    Vectorizes the frames of a level on a pool of threads.
+
+  \details  Frames are queued with addFrame() and vectorized concurrently, each
+            by its own \p VectorizerCore. Results are retrieved with
+            takeFrame() in the same order the frames were queued, so they can
+            be stored or written as soon as they are ready.
+
+            Vectorization may add styles to the palette. Each frame works on a
+            copy of the level palette, and the styles it added are merged into
+            the level palette when the frame is taken - styles with the same
+            color added by different frames are merged together.
+
+            All the methods must be called from the same thread, which is the
+            only one accessing the level palette.
+
+  \sa       The \p VectorizerCore and \p VectorizerParameters classes.
+*/
+
+class DVAPI LevelVectorizer {
+public:
+  //! Receives the partial progress of the oldest queued frame. It is
+  //! invoked from the vectorization threads.
+  typedef std::function<void(int partial, int total)> ProgressCallback;
+
+private:
+  struct Frame;
+  class FrameTask;
+
+  VectorizerParameters m_params;
+  TPaletteP m_palette;  //!< The level palette, receiving the new styles
+  ProgressCallback m_progressCallback;
+
+  TThread::Executor m_executor;
+  int m_threadsCount;
+
+  mutable QMutex m_mutex;  //!< Guards the frames' states
+  QWaitCondition m_frameDone;
+  std::deque<std::shared_ptr<Frame>> m_frames;  //!< Queued frames, in order
+  bool m_isCanceled;
+
+public:
+  /*! \param    threadsCount  Maximum number of frames vectorized at the same
+                              time; \p 0 stands for the number of cores.     */
+  LevelVectorizer(const VectorizerParameters &params, const TPaletteP &palette,
+                  int threadsCount = 0);
+  ~LevelVectorizer();  //!< Cancels the queued frames, and waits for the
+                       //!  running ones.
+
+  int getThreadsCount() const { return m_threadsCount; }
+
+  void setProgressCallback(const ProgressCallback &callback) {
+    m_progressCallback = callback;
+  }
+
+  //! Returns the number of queued frames not taken yet.
+  int getQueuedCount() const { return (int)m_frames.size(); }
+
+  //! Returns whether enough frames are queued to keep all the threads busy.
+  //! Frames should be taken before queueing more, to limit memory usage.
+  bool isFull() const { return getQueuedCount() >= 2 * m_threadsCount; }
+
+  /*! \brief    Queues a frame for vectorization.
+
+      \param    dpiAff  Image to level transform, applied to the results.
+      \param    weight  Position of the frame in the vectorized range,
+                        normalized to <TT>[0, 1]</TT>, used to interpolate
+                        the parameters.                                     */
+  void addFrame(const TFrameId &fid, const TImageP &img, const TAffine &dpiAff,
+                double weight);
+
+  /*! \brief    Waits for the oldest queued frame and returns its vector
+                image, bound to the level palette.
+
+      \return   The vectorized image, or \p 0 if the frame could not be
+                vectorized or was canceled.                                 */
+  TVectorImageP takeFrame(TFrameId &fid);
+
+  //! Stops the running frames as soon as possible, and skips the others.
+  void cancel();
+  bool isCanceled() const;
+
+private:
+  void mergeStyles(Frame &frame, TVectorImage *vi);
+
+  // Not copyable
+  LevelVectorizer(const LevelVectorizer &);
+  LevelVectorizer &operator=(const LevelVectorizer &);
+};
+
+#endif  // LEVELVECTORIZER_H
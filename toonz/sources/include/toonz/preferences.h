@@ -259,6 +259,12 @@ public:
   // Visualization  tab
   bool getShow0ThickLines() const { return getBoolValue(show0ThickLines); }
   bool getRegionAntialias() const { return getBoolValue(regionAntialias); }
+  bool isCpuVectorRenderingEnabled() const {
+    return getBoolValue(cpuVectorRendering);
+  }
+  bool isCpuMeshRenderingEnabled() const {
+    return getBoolValue(cpuMeshRendering);
+  }
 
   // Loading  tab
   int getDefaultImportPolicy() { return getIntValue(importPolicy); }
@@ -56,6 +56,8 @@ enum PreferencesItemId {
   // Visualization
   show0ThickLines,
   regionAntialias,
+  cpuVectorRendering,
+  cpuMeshRendering,
 
   //----------
   // Loading
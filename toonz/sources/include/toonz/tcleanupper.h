@@ -58,10 +58,11 @@ public:
 class DVAPI TCleanupper {
   CleanupParameters *m_parameters;
   TPointD m_sourceDpi;
+  bool m_targetColorsFrozen;
 
 private:
   TCleanupper()
-      : m_parameters(0) {
+      : m_parameters(0), m_targetColorsFrozen(false) {
   }  // singleton class - will not be externally constructed
 
 public:
@@ -105,7 +106,17 @@ time, to unlock a possibly useful memory block.
   TPointD getSourceDpi() const { return m_sourceDpi; }
   void setSourceDpi(const TPointD &dpi) { m_sourceDpi = dpi; }
 
+  /*!
+Prevents process() from refreshing the parameters' target colors from the
+cleanup palette - they are refreshed one last time when frozen. Frames may be
+processed and finalized concurrently only while the target colors are frozen.
+*/
+  void freezeTargetColors(bool frozen);
+  bool areTargetColorsFrozen() const { return m_targetColorsFrozen; }
+
 private:
+  void updateTargetColors();
+
   // process phase
   bool doAutocenter(double &angle, double &skew, double &cxin, double &cyin,
                     double &cqout, double &cpout, const double xdpi,
@@ -156,6 +156,15 @@ the specified
                    bool checkFlags = true, bool forSceneIcon = true,
                    bool forReference = false) const;
 
+  /*!
+Performs a camera-stand render of the specified rect of a frame of size
+frameSize, into the specified 32-bit raster of the rect's size.
+*/
+  void renderFrame(const TRaster32P &ras, const TRect &rect,
+                   const TDimension &frameSize, int row, const TXsheet *xsh,
+                   bool checkFlags, bool forSceneIcon,
+                   bool forReference) const;
+
   /*!
 Performs a camera-stand render of the specified xsheet in the specified
 placedRect,
@@ -35,6 +35,7 @@
 //    Forward declarations
 
 class TXshLevel;
+class TXshSimpleLevel;
 class TXshCell;
 class TAffine;
 class TStageObjectId;
@@ -214,6 +215,21 @@ public:
 */
   void getCells(int row, int col, int rowCount, TXshCell cells[],
                 bool implicitLookup = false) const;
+  /*! Loads in background the images of the tlv levels exposed at the
+     specified \b \e rows, sub-xsheets included, so that they are cached by
+     the time they are needed.
+          \sa ImageManager::prefetchInBackground()
+*/
+  void prefetchRows(const std::vector<int> &rows) const;
+  /*! Sets to \b \e levelFrames the frames of the tlv levels exposed at the
+     specified \b \e rows, sub-xsheets included, grouped by level in request
+     order.
+          \sa prefetchRows()
+*/
+  void getTlvFrames(
+      const std::vector<int> &rows,
+      std::vector<std::pair<TXshSimpleLevel *, std::vector<TFrameId>>>
+          &levelFrames) const;
   /*! If column identified by index \b \e col is a \b TXshCellColumn or is empty
     and is not
     locked, this method sets to \b \e cells[] the given \b \e rowCount cells of
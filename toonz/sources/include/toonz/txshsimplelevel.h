@@ -204,6 +204,11 @@ table) it returns the proper insertion index
   TImageP getFullsampledFrame(const TFrameId &fid,
                               UCHAR imgManagerParamsMask) const;
 
+  //! Returns the image of the specified frame like getFrame(), given its
+  //! getImageId(). The frames table is not looked up, so that it can be
+  //! called outside the main thread; the image can't be modified.
+  TImageP getFrameById(const std::string &imageId, const TFrameId &fid) const;
+
   TImageInfo *getFrameInfo(const TFrameId &fid, bool toBeModified);
   TImageP getFrameIcon(const TFrameId &fid) const;
 
@@ -17,6 +17,7 @@
 #include "tpixel.h"
 #include "toonzqt/intfield.h"
 #include "toonz/imagepainter.h"
+#include "toonzqt/playbackprefetcher.h"
 #include "tstopwatch.h"
 #include <QThread>
 #include <QElapsedTimer>
@@ -350,6 +351,15 @@ public:
 
   void triggerInbetweenFlip();
 
+  //! Returns the image of the specified frame if it was built in advance
+  //! while playing.
+  TImageP takePrefetchedImage(int frame) {
+    return m_prefetcher.takeImage(frame);
+  }
+  //! Drops the images built in advance, to be invoked when the frames
+  //! change while playing.
+  void clearPrefetchedImages() { m_prefetcher.clear(); }
+
 signals:
 
   void buttonPressed(FlipConsole::EGadget button);
@@ -363,6 +373,7 @@ private:
   QString m_customizeId;
   QAction *m_customAction;
   PlaybackExecutor m_playbackExecutor;
+  PlaybackPrefetcher m_prefetcher;
 
   QAction *m_customSep, *m_rateSep, *m_histoSep, *m_bgSep, *m_vcrSep,
       *m_compareSep, *m_saveSep, *m_colorFilterSep, *m_soundSep, *m_subcamSep,
@@ -447,6 +458,7 @@ private:
   TFrameHandle *m_frameHandle;
 
   void adjustGain(bool increase);
+  void prefetchFrames(int from, int to);
 
 protected slots:
 
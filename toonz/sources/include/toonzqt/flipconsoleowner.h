@@ -22,5 +22,12 @@ public:
 
   virtual void swapBuffers(){};
   virtual void changeSwapBehavior(bool enable){};
+
+  // Returns a function building the image of the specified frame on a
+  // background thread while playing, or an empty one if the frame can't be
+  // built in advance. See PlaybackPrefetcher.
+  virtual PlaybackPrefetcher::FrameBuilder getFrameBuilder(int frame) {
+    return PlaybackPrefetcher::FrameBuilder();
+  }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef PLAYBACKPREFETCHER_H
+#define PLAYBACKPREFETCHER_H
+
+// TnzCore includes
+#include "timage.h"
+#include "tthread.h"
+
+// STD includes
+#include <functional>
+#include <memory>
+#include <vector>
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TOONZQT_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//=============================================================================
+
+//! Builds the frames about to be played on background threads, and keeps
+//! them in a bounded ring of ready images.
+/*!
+  Each time a frame is shown, the playing console passes the following
+  frames, in play order, to schedule(). Frames missing from the ring are
+  built by the functions supplied with them; frames no longer expected -
+  after a seek, or a change of direction or play range - leave the ring, and
+  their pending builds are skipped.
+
+  Builders run on other threads while the owner keeps working: they must
+  hold copies of all the data they need, and must not refer to widgets.
+*/
+class DVAPI PlaybackPrefetcher {
+public:
+  typedef std::function<TImageP()> FrameBuilder;
+
+private:
+  struct Ring;
+  class BuildTask;
+
+  std::shared_ptr<Ring> m_ring;  // Shared with the running builds
+  TThread::Executor m_executor;
+  int m_capacity;
+  int m_hitsCount, m_missesCount;
+
+public:
+  PlaybackPrefetcher();
+  ~PlaybackPrefetcher();
+
+  int getCapacity() const { return m_capacity; }
+  void setCapacity(int framesCount);
+
+  //! Sets the frames expected next, in play order. Frames which are not
+  //! in the ring yet are built by the functions returned by getBuilder,
+  //! which may return an empty function for frames that can't be built in
+  //! advance.
+  void schedule(const std::vector<int> &frames,
+                const std::function<FrameBuilder(int frame)> &getBuilder);
+
+  //! Returns the ready image of the specified frame, if any. Builders may
+  //! just load data in some cache, and return no image: the frame still
+  //! counts as ready in the statistics, once built.
+  TImageP takeImage(int frame);
+
+  //! Drops all the ready images and pending builds.
+  void clear();
+
+  //! Returns the share of the scheduled frames that were ready when taken,
+  //! in percent.
+  int getReadyPercentage() const;
+  void resetStatistics() { m_hitsCount = m_missesCount = 0; }
+
+private:
+  // Not copyable
+  PlaybackPrefetcher(const PlaybackPrefetcher &);
+  PlaybackPrefetcher &operator=(const PlaybackPrefetcher &);
+};
+
+#endif  // PLAYBACKPREFETCHER_H
@@ -85,6 +85,7 @@ protected:
   TRaster *m_parent;  // nel caso di sotto-raster
   UCHAR *m_buffer;
   bool m_bufferOwner;
+  bool m_arenaBuffer;  // il buffer e' del TBigMemoryManager
   // i costruttori sono qui per centralizzare la gestione della memoria
   // e' comunque impossibile fare new TRaster perche' e' una classe astratta
   // (clone, extract)
@@ -129,8 +130,8 @@ public:
   int getRowSize() const { return m_pixelSize * m_lx; };
   // in bytes
 
-  // when the bigMemoryManager is active, remapping can change buffers...need to
-  // to lock/unlock them o use them.
+  // lock/unlock bracket the use of the buffer; the count is kept only when
+  // the bigMemoryManager is active. Buffers are never moved.
 
   void lock() {
     if (!TBigMemoryManager::instance()->isActive()) return;
@@ -216,9 +217,6 @@ public:
 protected:
   void fillRawData(const UCHAR *pixel);
   void fillRawDataOutside(const TRect &rect, const UCHAR *pixel);
-
-private:
-  void remap(UCHAR *newLocation);
 };
 
 //------------------------------------------------------------
@@ -5,6 +5,7 @@
 
 // TnzCore includes
 #include "tnotanimatableparam.h"
+#include "taliashash.h"
 
 // TnzBase includes
 #include "tfx.h"
@@ -299,6 +300,18 @@ public:
   std::string getAlias(double frame,
                        const TRenderSettings &info) const override;
 
+  //! Returns getAlias(), memoized per frame during a render instance until any
+  //! fx parameter changes. Input aliases should be retrieved this way, so that
+  //! deep fx trees do not rebuild them recursively on every tile computation.
+  //! While getAliasHash() builds a hash, the input's hash is returned instead.
+  std::string getCachedAlias(double frame, const TRenderSettings &info) const;
+
+  //! Returns the hash of getAlias(), memoized like getCachedAlias(). It is
+  //! built incrementally: input fxs contribute their own memoized hash, so
+  //! only the fx type and parameters are described anew. Render caches are
+  //! keyed this way - whole aliases are meant for debugging and persistence.
+  TAliasHash getAliasHash(double frame, const TRenderSettings &info) const;
+
   virtual void dryCompute(TRectD &rect, double frame,
                           const TRenderSettings &info);
 
@@ -199,6 +199,11 @@ DVAPI TINT64 getFreeMemorySize(bool onlyPhysicalMemory);
 /*! return total physical (+ virtual mem if boolean=true) memory in kbytes */
 DVAPI TINT64 getMemorySize(bool onlyPhysicalMemory);
 
+/*! retrieves the total physical memory and the physical memory available to
+   new allocations without swapping (page cache included), in kbytes. Returns
+   false if the platform doesn't report them */
+DVAPI bool getPhysicalMemoryStatus(TINT64 &totalKb, TINT64 &availableKb);
+
 /*! return true if not enough memory. It can happen for 2 reasons:
       1) free physical memory is close to 0;
       2) the calling process has allocated the maximum amount of memory  allowed
@@ -221,6 +226,8 @@ enum CPUExtensions {
   CpuSupportsSse2 = 0x00000020L,
   // CpuSupports3DNow      = 0x00000040L,
   // CpuSupports3DNowExt   = 0x00000080L
+  CpuSupportsNeon = 0x00000100L,
+  CpuSupportsAvx2 = 0x00000200L
 };
 
 /*! returns a bit mask containing the CPU extensions supported */
@@ -7,6 +7,8 @@
 
 #include <QThread>
 
+#include <functional>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TNZCORE_EXPORTS
@@ -124,6 +126,7 @@ class DVAPI Runnable : public QObject, public TSmartObject {
 
   int m_load;
   int m_schedulingPriority;
+  TUINT64 m_serial;  // Insertion order among tasks of equal priority
 
   friend class Executor;     // Needed to confront Executor's and Runnable's ids
   friend class ExecutorImp;  // The internal task manager needs full control
@@ -238,6 +241,22 @@ private:
   Executor(const Executor &);
 };
 
+//------------------------------------------------------------------------------
+
+/*!
+  Calls \b work on the calling thread and on up to \b helpersCount threads of
+  a process-wide pool, and returns once every call has returned.
+\n \n
+  The calls are expected to share some work among themselves - typically
+  taking its parts in turn until none is left - as only the pool threads idle
+  at the time of the call take part. This bounds the threads used by nested
+  and concurrent parallel computations to the processor count, and never
+  waits for the pool. Exceptions thrown by the helpers' calls are dropped:
+  \b work must report its failures otherwise.
+*/
+void DVAPI runConcurrently(const std::function<void()> &work,
+                           int helpersCount);
+
 }  // namespace TThread
 
 #endif  // TTHREAD_H
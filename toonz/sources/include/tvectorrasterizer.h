@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef TVECTORRASTERIZER_H
+#define TVECTORRASTERIZER_H
+
+#include "traster.h"
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TVRENDER_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//=============================================================================
+// forward declarations
+class TVectorImage;
+class TVectorRenderData;
+
+//=============================================================================
+
+/*!
+  Software rendering of vector images.
+
+  The rasterizer renders straight into a raster, without any GL context, so
+  it can be called from several render threads at once. It covers the
+  images made only of solid color strokes and areas; the others must be
+  drawn through tglDraw().
+*/
+namespace TVectorRasterizer {
+
+//! Returns whether rasterize() can render \b vim with the specified settings.
+DVAPI bool isSupported(const TVectorImage *vim, const TVectorRenderData &rd);
+
+/*!
+  Draws \b vim over \b ras, the same way tglDraw() does on a GL context of
+  the raster size. \b rd.m_aff maps the image to raster pixel coordinates.
+*/
+DVAPI void rasterize(const TRaster32P &ras, const TVectorImage *vim,
+                     const TVectorRenderData &rd);
+
+}  // namespace TVectorRasterizer
+
+#endif
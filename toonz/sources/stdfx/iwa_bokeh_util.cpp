@@ -49,11 +49,9 @@ TRasterGR8P allocateRasterAndLock(T** buf, TDimensionI dim) {
   return ras;
 }
 
-// release all registered raster memories and free all fft plans
-void releaseAllRastersAndPlans(QList<TRasterGR8P>& rasterList,
-                               QList<kiss_fftnd_cfg>& planList) {
+// release all registered raster memories
+void releaseAllRasters(QList<TRasterGR8P>& rasterList) {
   for (int r = 0; r < rasterList.size(); r++) rasterList.at(r)->unlock();
-  for (int p = 0; p < planList.size(); p++) kiss_fft_free(planList.at(p));
 }
 }  // namespace
 
@@ -73,7 +71,7 @@ BokehUtils::MyThread::MyThread(Channel channel, TRasterP layerTileRas,
     , m_layerGamma(layerGamma)
     , m_masterGamma(masterGamma)
     , m_finished(false)
-    , m_kissfft_comp_in(0)
+    , m_kissfft_real_in(0)
     , m_kissfft_comp_out(0)
     , m_isTerminated(false) {
   if (m_masterGamma == 0.0) m_masterGamma = m_layerGamma;
@@ -86,78 +84,54 @@ bool BokehUtils::MyThread::init() {
   ly = m_layerTileRas->getSize().ly;
 
   // memory allocation for input
-  m_kissfft_comp_in_ras = TRasterGR8P(lx * sizeof(kiss_fft_cpx), ly);
-  m_kissfft_comp_in_ras->lock();
-  m_kissfft_comp_in = (kiss_fft_cpx*)m_kissfft_comp_in_ras->getRawData();
+  m_kissfft_real_in_ras = TRasterGR8P(lx * sizeof(kiss_fft_scalar), ly);
+  m_kissfft_real_in_ras->lock();
+  m_kissfft_real_in = (kiss_fft_scalar*)m_kissfft_real_in_ras->getRawData();
 
   // allocation check
-  if (m_kissfft_comp_in == 0) return false;
+  if (m_kissfft_real_in == 0) return false;
 
   // cancel check
   if (m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
+    m_kissfft_real_in_ras->unlock();
     return false;
   }
 
-  // memory allocation for output
-  m_kissfft_comp_out_ras = TRasterGR8P(lx * sizeof(kiss_fft_cpx), ly);
+  // memory allocation for output (half spectrum of the real input)
+  m_kissfft_comp_out_ras =
+      TRasterGR8P(FftUtils::spectrumLx(lx) * sizeof(kiss_fft_cpx), ly);
   m_kissfft_comp_out_ras->lock();
   m_kissfft_comp_out = (kiss_fft_cpx*)m_kissfft_comp_out_ras->getRawData();
 
   // allocation check
   if (m_kissfft_comp_out == 0) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
+    m_kissfft_real_in_ras->unlock();
+    m_kissfft_real_in = 0;
     return false;
   }
 
   // cancel check
   if (m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
+    m_kissfft_real_in_ras->unlock();
+    m_kissfft_real_in = 0;
     m_kissfft_comp_out_ras->unlock();
     m_kissfft_comp_out = 0;
     return false;
   }
 
-  // create the forward FFT plan
-  int dims[2]        = {ly, lx};
-  int ndims          = 2;
-  m_kissfft_plan_fwd = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  // allocation and cancel check
-  if (m_kissfft_plan_fwd == NULL || m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
-    m_kissfft_comp_out_ras->unlock();
-    m_kissfft_comp_out = 0;
-    return false;
-  }
-
-  // create the backward FFT plan
-  m_kissfft_plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
-  // allocation and cancel check
-  if (m_kissfft_plan_bkwd == NULL || m_isTerminated) {
-    m_kissfft_comp_in_ras->unlock();
-    m_kissfft_comp_in = 0;
-    m_kissfft_comp_out_ras->unlock();
-    m_kissfft_comp_out = 0;
-    kiss_fft_free(m_kissfft_plan_fwd);
-    m_kissfft_plan_fwd = NULL;
-    return false;
-  }
-
-  // return true if all the initializations are done
+  // return true if all the initializations are done.
+  // FFT plans are shared, see FftUtils.
   return true;
 }
 
 //------------------------------------------------------------
 // convert layer RGB to exposure
 // multiply alpha
-// set to kiss_fft_cpx
+// set to the real FFT input
 
 template <typename RASTER, typename PIXEL>
 void BokehUtils::MyThread::setLayerRaster(const RASTER srcRas,
-                                          kiss_fft_cpx* dstMem,
+                                          kiss_fft_scalar* dstMem,
                                           TDimensionI dim) {
   for (int j = 0; j < dim.ly; j++) {
     PIXEL* pix = srcRas->pixels(j);
@@ -167,7 +141,7 @@ void BokehUtils::MyThread::setLayerRaster(const RASTER srcRas,
                      : (m_channel == Green) ? (double)pix->g
                                             : (double)pix->b;
         // multiply the exposure by alpha channel value
-        dstMem[j * dim.lx + i].r =
+        dstMem[j * dim.lx + i] =
             m_conv->valueToExposure(val / (double)PIXEL::maxChannelValue) *
             ((double)pix->m / (double)PIXEL::maxChannelValue);
       }
@@ -185,10 +159,7 @@ void BokehUtils::MyThread::run() {
   int ly = m_layerTileRas->getSize().ly;
 
   // initialize
-  for (int i = 0; i < dim.lx * dim.ly; i++) {
-    m_kissfft_comp_in[i].r = 0.0;  // real part
-    m_kissfft_comp_in[i].i = 0.0;  // imaginary part
-  }
+  std::fill_n(m_kissfft_real_in, dim.lx * dim.ly, kiss_fft_scalar(0));
 
   TRaster32P ras32 = (TRaster32P)m_layerTileRas;
   TRaster64P ras64 = (TRaster64P)m_layerTileRas;
@@ -199,11 +170,11 @@ void BokehUtils::MyThread::run() {
   {
     lock.lockForRead();
     if (ras32)
-      setLayerRaster<TRaster32P, TPixel32>(ras32, m_kissfft_comp_in, dim);
+      setLayerRaster<TRaster32P, TPixel32>(ras32, m_kissfft_real_in, dim);
     else if (ras64)
-      setLayerRaster<TRaster64P, TPixel64>(ras64, m_kissfft_comp_in, dim);
+      setLayerRaster<TRaster64P, TPixel64>(ras64, m_kissfft_real_in, dim);
     else if (rasF)
-      setLayerRaster<TRasterFP, TPixelF>(rasF, m_kissfft_comp_in, dim);
+      setLayerRaster<TRasterFP, TPixelF>(rasF, m_kissfft_real_in, dim);
     else {
       lock.unlock();
       return;
@@ -214,34 +185,23 @@ void BokehUtils::MyThread::run() {
 
   if (checkTerminationAndCleanupThread()) return;
 
-  kiss_fftnd(m_kissfft_plan_fwd, m_kissfft_comp_in, m_kissfft_comp_out);
-  kiss_fft_free(m_kissfft_plan_fwd);  // we don't need this plan anymore
-  m_kissfft_plan_fwd = NULL;
+  // the three channel threads run concurrently, so each transform is
+  // computed in its own thread only
+  FftUtils::fft2dReal(m_kissfft_real_in, m_kissfft_comp_out, lx, ly);
 
   if (checkTerminationAndCleanupThread()) return;
 
   // Filtering. Multiply by the iris FFT data
-  {
-    for (int i = 0; i < lx * ly; i++) {
-      kiss_fft_scalar re, im;
-      re = m_kissfft_comp_out[i].r * m_kissfft_comp_iris[i].r -
-           m_kissfft_comp_out[i].i * m_kissfft_comp_iris[i].i;
-      im = m_kissfft_comp_out[i].r * m_kissfft_comp_iris[i].i +
-           m_kissfft_comp_iris[i].r * m_kissfft_comp_out[i].i;
-      m_kissfft_comp_out[i].r = re;
-      m_kissfft_comp_out[i].i = im;
-    }
-  }
+  FftUtils::multiplySpectrum(m_kissfft_comp_out, m_kissfft_comp_iris,
+                             FftUtils::spectrumLx(lx) * ly);
 
   if (checkTerminationAndCleanupThread()) return;
 
-  kiss_fftnd(m_kissfft_plan_bkwd, m_kissfft_comp_out,
-             m_kissfft_comp_in);       // Backward FFT
-  kiss_fft_free(m_kissfft_plan_bkwd);  // we don't need this plan anymore
-  m_kissfft_plan_bkwd = NULL;
+  FftUtils::ifft2dReal(m_kissfft_comp_out, m_kissfft_real_in, lx,
+                       ly);  // Backward FFT
 
   // In the backward FFT above, "m_kissfft_comp_out" is used as input and
-  // "m_kissfft_comp_in" as output.
+  // "m_kissfft_real_in" as output.
   // So we don't need "m_kissfft_comp_out" anymore.
   m_kissfft_comp_out_ras->unlock();
   m_kissfft_comp_out = 0;
@@ -258,7 +218,7 @@ void BokehUtils::MyThread::run() {
       if ((*alp_p) < 0.00001) continue;
 
       double exposure =
-          (double)m_kissfft_comp_in[getCoord(i, dim.lx, dim.ly)].r /
+          (double)m_kissfft_real_in[getCoord(i, dim.lx, dim.ly)] /
           (double)(dim.lx * dim.ly);
 
       // convert to layer hardness
@@ -298,8 +258,8 @@ void BokehUtils::MyThread::run() {
     }
   }
 
-  m_kissfft_comp_in_ras->unlock();
-  m_kissfft_comp_in = 0;
+  m_kissfft_real_in_ras->unlock();
+  m_kissfft_real_in = 0;
 
   m_finished = true;
 }
@@ -307,31 +267,24 @@ void BokehUtils::MyThread::run() {
 bool BokehUtils::MyThread::checkTerminationAndCleanupThread() {
   if (!m_isTerminated) return false;
 
-  if (m_kissfft_comp_in) m_kissfft_comp_in_ras->unlock();
+  if (m_kissfft_real_in) m_kissfft_real_in_ras->unlock();
   if (m_kissfft_comp_out) m_kissfft_comp_out_ras->unlock();
 
-  if (m_kissfft_plan_fwd) kiss_fft_free(m_kissfft_plan_fwd);
-  if (m_kissfft_plan_bkwd) kiss_fft_free(m_kissfft_plan_bkwd);
-
   m_finished = true;
   return true;
 }
 
 //------------------------------------
 BokehUtils::BokehRefThread::BokehRefThread(
-    int channel, kiss_fft_cpx* fftcpx_channel_before,
-    kiss_fft_cpx* fftcpx_channel, kiss_fft_cpx* fftcpx_alpha,
-    kiss_fft_cpx* fftcpx_iris, double4* result_buff,
-    kiss_fftnd_cfg kissfft_plan_fwd, kiss_fftnd_cfg kissfft_plan_bkwd,
-    TDimensionI& dim)
+    int channel, kiss_fft_scalar* fftcpx_channel_before,
+    kiss_fft_cpx* fftcpx_channel, kiss_fft_scalar* fftcpx_alpha,
+    kiss_fft_cpx* fftcpx_iris, double4* result_buff, TDimensionI& dim)
     : m_channel(channel)
     , m_fftcpx_channel_before(fftcpx_channel_before)
     , m_fftcpx_channel(fftcpx_channel)
     , m_fftcpx_alpha(fftcpx_alpha)
     , m_fftcpx_iris(fftcpx_iris)
     , m_result_buff(result_buff)
-    , m_kissfft_plan_fwd(kissfft_plan_fwd)
-    , m_kissfft_plan_bkwd(kissfft_plan_bkwd)
     , m_dim(dim)
     , m_finished(false)
     , m_isTerminated(false) {}
@@ -340,7 +293,8 @@ BokehUtils::BokehRefThread::BokehRefThread(
 
 void BokehUtils::BokehRefThread::run() {
   // execute channel fft
-  kiss_fftnd(m_kissfft_plan_fwd, m_fftcpx_channel_before, m_fftcpx_channel);
+  FftUtils::fft2dReal(m_fftcpx_channel_before, m_fftcpx_channel, m_dim.lx,
+                      m_dim.ly);
 
   // cancel check
   if (m_isTerminated) {
@@ -351,17 +305,11 @@ void BokehUtils::BokehRefThread::run() {
   int size = m_dim.lx * m_dim.ly;
 
   // multiply filter
-  for (int i = 0; i < size; i++) {
-    kiss_fft_scalar re, im;
-    re = m_fftcpx_channel[i].r * m_fftcpx_iris[i].r -
-         m_fftcpx_channel[i].i * m_fftcpx_iris[i].i;
-    im = m_fftcpx_channel[i].r * m_fftcpx_iris[i].i +
-         m_fftcpx_iris[i].r * m_fftcpx_channel[i].i;
-    m_fftcpx_channel[i].r = re;
-    m_fftcpx_channel[i].i = im;
-  }
+  FftUtils::multiplySpectrum(m_fftcpx_channel, m_fftcpx_iris,
+                             FftUtils::spectrumLx(m_dim.lx) * m_dim.ly);
   // execute invert fft
-  kiss_fftnd(m_kissfft_plan_bkwd, m_fftcpx_channel, m_fftcpx_channel_before);
+  FftUtils::ifft2dReal(m_fftcpx_channel, m_fftcpx_channel_before, m_dim.lx,
+                       m_dim.ly);
 
   // cancel check
   if (m_isTerminated) {
@@ -376,11 +324,11 @@ void BokehUtils::BokehRefThread::run() {
     // modify fft coordinate to normal
     int coord = getCoord(i, m_dim.lx, m_dim.ly);
 
-    double alpha = (double)m_fftcpx_alpha[coord].r / (double)size;
+    double alpha = (double)m_fftcpx_alpha[coord] / (double)size;
     // ignore transpalent pixels
     if (alpha < 0.00001) continue;
 
-    double exposure = (double)m_fftcpx_channel_before[coord].r / (double)size;
+    double exposure = (double)m_fftcpx_channel_before[coord] / (double)size;
 
     // in case of using upper layer at all
     if (alpha >= 1.0 || (m_channel == 0 && (*result_p).x == 0.0) ||
@@ -951,7 +899,7 @@ void BokehUtils::compositeAsIs(const double4* segment_layer_buff,
 // Normalize the brightness of the iris image.
 // Enlarge the iris to the output size.
 void BokehUtils::convertIris(const double irisSize,
-                             kiss_fft_cpx* kissfft_comp_iris_before,
+                             kiss_fft_scalar* kissfft_comp_iris_before,
                              const TDimensionI& dimOut, const TRectD& irisBBox,
                              const TTile& irisTile) {
   // the original size of iris image
@@ -1004,10 +952,8 @@ void BokehUtils::convertIris(const double irisSize,
 
   int iris_j = 0;
   // Initialize
-  for (int i = 0; i < dimOut.lx * dimOut.ly; i++) {
-    kissfft_comp_iris_before[i].r = 0.0f;
-    kissfft_comp_iris_before[i].i = 0.0f;
-  }
+  std::fill_n(kissfft_comp_iris_before, dimOut.lx * dimOut.ly,
+              kiss_fft_scalar(0));
   for (int j = (dimOut.ly - filterSize.y) / 2; iris_j < filterSize.y;
        j++, iris_j++) {
     TPixel64* pix = resizedIris->pixels(iris_j);
@@ -1015,18 +961,18 @@ void BokehUtils::convertIris(const double irisSize,
     for (int i = (dimOut.lx - filterSize.x) / 2; iris_i < filterSize.x;
          i++, iris_i++) {
       // Value = 0.3R 0.59G 0.11B
-      kissfft_comp_iris_before[j * dimOut.lx + i].r =
+      kissfft_comp_iris_before[j * dimOut.lx + i] =
           ((float)pix->r * 0.3f + (float)pix->g * 0.59f +
            (float)pix->b * 0.11f) /
           (float)USHRT_MAX;
-      irisValAmount += kissfft_comp_iris_before[j * dimOut.lx + i].r;
+      irisValAmount += kissfft_comp_iris_before[j * dimOut.lx + i];
       pix++;
     }
   }
 
   // Normalize value
   for (int i = 0; i < dimOut.lx * dimOut.ly; i++) {
-    kissfft_comp_iris_before[i].r /= irisValAmount;
+    kissfft_comp_iris_before[i] /= irisValAmount;
   }
 }
 
@@ -1034,49 +980,31 @@ void BokehUtils::convertIris(const double irisSize,
 // retrieve segment layer image for each channel
 //--------------------------------------------
 void BokehUtils::retrieveChannel(const double4* segment_layer_buff,  // src
-                                 kiss_fft_cpx* fftcpx_r_before,      // dst
-                                 kiss_fft_cpx* fftcpx_g_before,      // dst
-                                 kiss_fft_cpx* fftcpx_b_before,      // dst
-                                 kiss_fft_cpx* fftcpx_a_before,      // dst
+                                 kiss_fft_scalar* fftcpx_r_before,   // dst
+                                 kiss_fft_scalar* fftcpx_g_before,   // dst
+                                 kiss_fft_scalar* fftcpx_b_before,   // dst
+                                 kiss_fft_scalar* fftcpx_a_before,   // dst
                                  int size) {
   double4* layer_p = (double4*)segment_layer_buff;
   for (int i = 0; i < size; i++, layer_p++) {
-    fftcpx_r_before[i].r = (*layer_p).x;
-    fftcpx_g_before[i].r = (*layer_p).y;
-    fftcpx_b_before[i].r = (*layer_p).z;
-    fftcpx_a_before[i].r = (*layer_p).w;
-  }
-}
-
-//--------------------------------------------
-// multiply filter on channel
-//--------------------------------------------
-void BokehUtils::multiplyFilter(kiss_fft_cpx* fftcpx_channel,  // dst
-                                kiss_fft_cpx* fftcpx_iris,     // filter
-                                int size) {
-  for (int i = 0; i < size; i++) {
-    kiss_fft_scalar re, im;
-    re = fftcpx_channel[i].r * fftcpx_iris[i].r -
-         fftcpx_channel[i].i * fftcpx_iris[i].i;
-    im = fftcpx_channel[i].r * fftcpx_iris[i].i +
-         fftcpx_channel[i].i * fftcpx_iris[i].r;
-
-    fftcpx_channel[i].r = re;
-    fftcpx_channel[i].i = im;
+    fftcpx_r_before[i] = (*layer_p).x;
+    fftcpx_g_before[i] = (*layer_p).y;
+    fftcpx_b_before[i] = (*layer_p).z;
+    fftcpx_a_before[i] = (*layer_p).w;
   }
 }
 
 //--------------------------------------------
 // normal comosite the alpha channel
 //--------------------------------------------
-void BokehUtils::compositeAlpha(const double4* result_buff,        // dst
-                                const kiss_fft_cpx* fftcpx_alpha,  // alpha
+void BokehUtils::compositeAlpha(const double4* result_buff,           // dst
+                                const kiss_fft_scalar* fftcpx_alpha,  // alpha
                                 int lx, int ly) {
   int size          = lx * ly;
   double4* result_p = (double4*)result_buff;
   for (int i = 0; i < size; i++, result_p++) {
     // modify fft coordinate to normal
-    double alpha  = (double)fftcpx_alpha[getCoord(i, lx, ly)].r / (double)size;
+    double alpha  = (double)fftcpx_alpha[getCoord(i, lx, ly)] / (double)size;
     alpha         = clamp01(alpha);
     (*result_p).w = alpha + ((*result_p).w * (1.0 - alpha));
   }
@@ -1202,21 +1130,17 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
   ly = layerTile.getRaster()->getSize().ly;
 
   // Allocate the FFT data
-  kiss_fft_cpx *kissfft_comp_in, *kissfft_comp_out;
-
-  TRasterGR8P kissfft_comp_in_ras(lx * sizeof(kiss_fft_cpx), ly);
-  kissfft_comp_in_ras->lock();
-  kissfft_comp_in = (kiss_fft_cpx*)kissfft_comp_in_ras->getRawData();
-  TRasterGR8P kissfft_comp_out_ras(lx * sizeof(kiss_fft_cpx), ly);
+  kiss_fft_scalar* kissfft_real_in;
+  kiss_fft_cpx* kissfft_comp_out;
+
+  TRasterGR8P kissfft_real_in_ras(lx * sizeof(kiss_fft_scalar), ly);
+  kissfft_real_in_ras->lock();
+  kissfft_real_in = (kiss_fft_scalar*)kissfft_real_in_ras->getRawData();
+  TRasterGR8P kissfft_comp_out_ras(
+      FftUtils::spectrumLx(lx) * sizeof(kiss_fft_cpx), ly);
   kissfft_comp_out_ras->lock();
   kissfft_comp_out = (kiss_fft_cpx*)kissfft_comp_out_ras->getRawData();
 
-  // Initialize the FFT data
-  for (int i = 0; i < lx * ly; i++) {
-    kissfft_comp_in[i].r = 0.0;  // real part
-    kissfft_comp_in[i].i = 0.0;  // imaginary part
-  }
-
   TRaster32P ras32 = (TRaster32P)layerTile.getRaster();
   TRaster64P ras64 = (TRaster64P)layerTile.getRaster();
   TRasterFP rasF   = (TRasterFP)layerTile.getRaster();
@@ -1224,7 +1148,7 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
     for (int j = 0; j < ly; j++) {
       TPixel32* pix = ras32->pixels(j);
       for (int i = 0; i < lx; i++) {
-        kissfft_comp_in[j * lx + i].r = (double)pix->m / (double)UCHAR_MAX;
+        kissfft_real_in[j * lx + i] = (double)pix->m / (double)UCHAR_MAX;
         pix++;
       }
     }
@@ -1232,7 +1156,7 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
     for (int j = 0; j < ly; j++) {
       TPixel64* pix = ras64->pixels(j);
       for (int i = 0; i < lx; i++) {
-        kissfft_comp_in[j * lx + i].r = (double)pix->m / (double)USHRT_MAX;
+        kissfft_real_in[j * lx + i] = (double)pix->m / (double)USHRT_MAX;
         pix++;
       }
     }
@@ -1240,36 +1164,29 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
     for (int j = 0; j < ly; j++) {
       TPixelF* pix = rasF->pixels(j);
       for (int i = 0; i < lx; i++) {
-        kissfft_comp_in[j * lx + i].r = (double)pix->m;
+        kissfft_real_in[j * lx + i] = (double)pix->m;
         pix++;
       }
     }
-  } else
+  } else {
+    kissfft_real_in_ras->unlock();
+    kissfft_comp_out_ras->unlock();
     return;
+  }
 
-  int dims[2]             = {ly, lx};
-  int ndims               = 2;
-  kiss_fftnd_cfg plan_fwd = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  kiss_fftnd(plan_fwd, kissfft_comp_in, kissfft_comp_out);
-  kiss_fft_free(plan_fwd);  // we don't need this plan anymore
+  int threadsCount = FftUtils::getThreadsCount();
+  FftUtils::fft2dReal(kissfft_real_in, kissfft_comp_out, lx, ly,
+                      threadsCount);
 
   // Filtering. Multiply by the iris FFT data
-  for (int i = 0; i < lx * ly; i++) {
-    kiss_fft_scalar re, im;
-    re = kissfft_comp_out[i].r * kissfft_comp_iris[i].r -
-         kissfft_comp_out[i].i * kissfft_comp_iris[i].i;
-    im = kissfft_comp_out[i].r * kissfft_comp_iris[i].i +
-         kissfft_comp_iris[i].r * kissfft_comp_out[i].i;
-    kissfft_comp_out[i].r = re;
-    kissfft_comp_out[i].i = im;
-  }
+  FftUtils::multiplySpectrum(kissfft_comp_out, kissfft_comp_iris,
+                             FftUtils::spectrumLx(lx) * ly);
 
-  kiss_fftnd_cfg plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
-  kiss_fftnd(plan_bkwd, kissfft_comp_out, kissfft_comp_in);  // Backward FFT
-  kiss_fft_free(plan_bkwd);  // we don't need this plan anymore
+  FftUtils::ifft2dReal(kissfft_comp_out, kissfft_real_in, lx, ly,
+                       threadsCount);  // Backward FFT
 
   // In the backward FFT above, "kissfft_comp_out" is used as input and
-  // "kissfft_comp_in" as output.
+  // "kissfft_real_in" as output.
   // So we don't need "kissfft_comp_out" anymore.
   kissfft_comp_out_ras->unlock();
 
@@ -1277,13 +1194,13 @@ void BokehUtils::calcAlfaChannelBokeh(kiss_fft_cpx* kissfft_comp_iris,
   double* alp_p = alpha_bokeh;
   for (int j = 0; j < ly; j++) {
     for (int i = 0; i < lx; i++, alp_p++) {
-      (*alp_p) = (double)kissfft_comp_in[getCoord(j * lx + i, lx, ly)].r /
+      (*alp_p) = (double)kissfft_real_in[getCoord(j * lx + i, lx, ly)] /
                  (double)(lx * ly);
       (*alp_p) = clamp01(*alp_p);
     }
   }
 
-  kissfft_comp_in_ras->unlock();
+  kissfft_real_in_ras->unlock();
 }
 
 //-----------------------------------------------------
@@ -1421,13 +1338,15 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
   // QMutexLocker fx_locker(&fx_mutex);
 
   QList<TRasterGR8P> rasterList;
-  QList<kiss_fftnd_cfg> planList;
+
+  // half spectrum of the iris, see FftUtils
+  TDimensionI dimSpectrum(FftUtils::spectrumLx(dimOut.lx), dimOut.ly);
 
   kiss_fft_cpx* kissfft_comp_iris;
   double* alpha_bokeh = nullptr;
   double4* result     = nullptr;
   rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&kissfft_comp_iris, dimOut));
+      allocateRasterAndLock<kiss_fft_cpx>(&kissfft_comp_iris, dimSpectrum));
   rasterList.append(allocateRasterAndLock<double>(&alpha_bokeh, dimOut));
   rasterList.append(allocateRasterAndLock<double4>(&result, dimOut));
 
@@ -1445,7 +1364,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
@@ -1453,7 +1372,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
   for (int i = 0; i < layerValues.size(); i++) {
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1500,8 +1419,8 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
     {
       // prepare for iris FFT
-      kiss_fft_cpx* kissfft_comp_iris_before;
-      rasterList.append(allocateRasterAndLock<kiss_fft_cpx>(
+      kiss_fft_scalar* kissfft_comp_iris_before;
+      rasterList.append(allocateRasterAndLock<kiss_fft_scalar>(
           &kissfft_comp_iris_before, dimOut));
       // Resize / flip the iris image according to the size ratio.
       // Normalize the brightness of the iris image.
@@ -1511,22 +1430,13 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
 
-      // Create the FFT plan for the iris image.
-      kiss_fftnd_cfg iris_kissfft_plan;
-      while (1) {
-        int dims[2]       = {dimOut.ly, dimOut.lx};
-        int ndims         = 2;
-        iris_kissfft_plan = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-        if (iris_kissfft_plan != NULL) break;
-      }
       // Do FFT the iris image.
-      kiss_fftnd(iris_kissfft_plan, kissfft_comp_iris_before,
-                 kissfft_comp_iris);
-      kiss_fft_free(iris_kissfft_plan);
+      FftUtils::fft2dReal(kissfft_comp_iris_before, kissfft_comp_iris,
+                          dimOut.lx, dimOut.ly, FftUtils::getThreadsCount());
       // release the iris buffer
       rasterList.takeLast()->unlock();
     }
@@ -1535,7 +1445,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1553,7 +1463,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
 
     // cancel check
     if (settings.m_isCanceled && *settings.m_isCanceled) {
-      releaseAllRastersAndPlans(rasterList, planList);
+      releaseAllRasters(rasterList);
       return;
     }
 
@@ -1593,7 +1503,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
       // cancel check
       if ((settings.m_isCanceled && *settings.m_isCanceled) ||
           waitCount >= 20) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       if (threadR.init()) {
@@ -1615,7 +1525,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
         if (!threadR.isFinished()) threadR.terminateThread();
         while (!threadR.isFinished()) {
         }
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       if (threadG.init()) {
@@ -1638,7 +1548,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
         if (!threadG.isFinished()) threadG.terminateThread();
         while (!threadR.isFinished() || !threadG.isFinished()) {
         }
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       if (threadB.init()) {
@@ -1673,7 +1583,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
         while (!threadR.isFinished() || !threadG.isFinished() ||
                !threadB.isFinished()) {
         }
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       if (threadR.isFinished() && threadG.isFinished() && threadB.isFinished())
@@ -1714,7 +1624,7 @@ void Iwa_BokehCommonFx::doFx(TTile& tile, double frame,
                                                     outMargin);
   lock.unlock();
 
-  releaseAllRastersAndPlans(rasterList, planList);
+  releaseAllRasters(rasterList);
 }
 
 void Iwa_BokehCommonFx::doBokehRef(
@@ -1723,7 +1633,6 @@ void Iwa_BokehCommonFx::doBokehRef(
     TTile& irisTile, kiss_fft_cpx* kissfft_comp_iris, LayerValue layer,
     unsigned char* ctrl, const bool isLinear) {
   QList<TRasterGR8P> rasterList;
-  QList<kiss_fftnd_cfg> planList;
   // source image
   double4* source_buff;
   rasterList.append(allocateRasterAndLock<double4>(&source_buff, dimOut));
@@ -1775,33 +1684,40 @@ void Iwa_BokehCommonFx::doBokehRef(
   double4* layer_buff;
   rasterList.append(allocateRasterAndLock<double4>(&layer_buff, dimOut));
 
-  kiss_fft_cpx* kissfft_comp_iris_before;
-  rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&kissfft_comp_iris_before, dimOut));
+  // the channels are real, so their spectra are stored in half size
+  TDimensionI dimSpectrum(FftUtils::spectrumLx(dimOut.lx), dimOut.ly);
+
+  kiss_fft_scalar* kissfft_comp_iris_before;
+  rasterList.append(allocateRasterAndLock<kiss_fft_scalar>(
+      &kissfft_comp_iris_before, dimOut));
 
   // alpha channel
-  kiss_fft_cpx* fftcpx_alpha_before;
+  kiss_fft_scalar* fftcpx_alpha_before;
   kiss_fft_cpx* fftcpx_alpha;
   rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_alpha_before, dimOut));
-  rasterList.append(allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_alpha, dimOut));
+      allocateRasterAndLock<kiss_fft_scalar>(&fftcpx_alpha_before, dimOut));
+  rasterList.append(
+      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_alpha, dimSpectrum));
 
   // RGB channels
-  kiss_fft_cpx* fftcpx_r_before;
-  kiss_fft_cpx* fftcpx_g_before;
-  kiss_fft_cpx* fftcpx_b_before;
+  kiss_fft_scalar* fftcpx_r_before;
+  kiss_fft_scalar* fftcpx_g_before;
+  kiss_fft_scalar* fftcpx_b_before;
   kiss_fft_cpx* fftcpx_r;
   kiss_fft_cpx* fftcpx_g;
   kiss_fft_cpx* fftcpx_b;
   rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_r_before, dimOut));
+      allocateRasterAndLock<kiss_fft_scalar>(&fftcpx_r_before, dimOut));
+  rasterList.append(
+      allocateRasterAndLock<kiss_fft_scalar>(&fftcpx_g_before, dimOut));
   rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_g_before, dimOut));
+      allocateRasterAndLock<kiss_fft_scalar>(&fftcpx_b_before, dimOut));
   rasterList.append(
-      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_b_before, dimOut));
-  rasterList.append(allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_r, dimOut));
-  rasterList.append(allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_g, dimOut));
-  rasterList.append(allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_b, dimOut));
+      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_r, dimSpectrum));
+  rasterList.append(
+      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_g, dimSpectrum));
+  rasterList.append(
+      allocateRasterAndLock<kiss_fft_cpx>(&fftcpx_b, dimSpectrum));
 
   // for accumulating result image
   double4* result_main_buff;
@@ -1811,30 +1727,10 @@ void Iwa_BokehCommonFx::doBokehRef(
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
-  // fft plans
-  int dims[2]                      = {dimOut.ly, dimOut.lx};
-  kiss_fftnd_cfg kissfft_plan_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  planList.append(kissfft_plan_fwd);
-  planList.append(kissfft_plan_bkwd);
-
-  kiss_fftnd_cfg kissfft_plan_r_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_r_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_g_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_g_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_b_fwd  = kiss_fftnd_alloc(dims, 2, false, 0, 0);
-  kiss_fftnd_cfg kissfft_plan_b_bkwd = kiss_fftnd_alloc(dims, 2, true, 0, 0);
-  planList.append(kissfft_plan_r_fwd);
-  planList.append(kissfft_plan_r_bkwd);
-  planList.append(kissfft_plan_g_fwd);
-  planList.append(kissfft_plan_g_bkwd);
-  planList.append(kissfft_plan_b_fwd);
-  planList.append(kissfft_plan_b_bkwd);
-
   // initialize result memory
   memset(result_main_buff, 0, sizeof(double4) * size);
   memset(result_sub_buff, 0, sizeof(double4) * size);
@@ -1881,7 +1777,7 @@ void Iwa_BokehCommonFx::doBokehRef(
     for (int index = 0; index < segmentDepth_mainSub.size(); index++) {
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
 
@@ -1910,18 +1806,13 @@ void Iwa_BokehCommonFx::doBokehRef(
 
       // cancel check
       if (settings.m_isCanceled && *settings.m_isCanceled) {
-        releaseAllRastersAndPlans(rasterList, planList);
+        releaseAllRasters(rasterList);
         return;
       }
       // Do FFT the iris image.
-      kiss_fftnd(kissfft_plan_fwd, kissfft_comp_iris_before, kissfft_comp_iris);
-
-      // initialize alpha
-      memset(fftcpx_alpha_before, 0, sizeof(kiss_fft_cpx) * size);
-      // initialize channels
-      memset(fftcpx_r_before, 0, sizeof(kiss_fft_cpx) * size);
-      memset(fftcpx_g_before, 0, sizeof(kiss_fft_cpx) * size);
-      memset(fftcpx_b_before, 0, sizeof(kiss_fft_cpx) * size);
+      int threadsCount = FftUtils::getThreadsCount();
+      FftUtils::fft2dReal(kissfft_comp_iris_before, kissfft_comp_iris,
+                          dimOut.lx, dimOut.ly, threadsCount);
 
       // retrieve segment layer image for each channel
       BokehUtils::retrieveChannel(layer_buff,           // src
@@ -1932,16 +1823,18 @@ void Iwa_BokehCommonFx::doBokehRef(
                                   size);
 
       // forward fft of alpha channel
-      kiss_fftnd(kissfft_plan_fwd, fftcpx_alpha_before, fftcpx_alpha);
+      FftUtils::fft2dReal(fftcpx_alpha_before, fftcpx_alpha, dimOut.lx,
+                          dimOut.ly, threadsCount);
 
       // multiply filter on alpha
-      BokehUtils::multiplyFilter(fftcpx_alpha,       // dst
+      FftUtils::multiplySpectrum(fftcpx_alpha,       // dst
                                  kissfft_comp_iris,  // filter
-                                 size);
+                                 dimSpectrum.lx * dimSpectrum.ly);
 
       // inverse fft the alpha channel
       // note that the result is multiplied by the image size
-      kiss_fftnd(kissfft_plan_bkwd, fftcpx_alpha, fftcpx_alpha_before);
+      FftUtils::ifft2dReal(fftcpx_alpha, fftcpx_alpha_before, dimOut.lx,
+                           dimOut.ly, threadsCount);
 
       // over composite the alpha channel
       BokehUtils::compositeAlpha(result_buff_mainSub,  // dst
@@ -1949,15 +1842,15 @@ void Iwa_BokehCommonFx::doBokehRef(
                                  dimOut.lx, dimOut.ly);
 
       // create worker threads
-      BokehUtils::BokehRefThread threadR(
-          0, fftcpx_r_before, fftcpx_r, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_r_fwd, kissfft_plan_r_bkwd, dimOut);
-      BokehUtils::BokehRefThread threadG(
-          1, fftcpx_g_before, fftcpx_g, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_g_fwd, kissfft_plan_g_bkwd, dimOut);
-      BokehUtils::BokehRefThread threadB(
-          2, fftcpx_b_before, fftcpx_b, fftcpx_alpha_before, kissfft_comp_iris,
-          result_buff_mainSub, kissfft_plan_b_fwd, kissfft_plan_b_bkwd, dimOut);
+      BokehUtils::BokehRefThread threadR(0, fftcpx_r_before, fftcpx_r,
+                                         fftcpx_alpha_before, kissfft_comp_iris,
+                                         result_buff_mainSub, dimOut);
+      BokehUtils::BokehRefThread threadG(1, fftcpx_g_before, fftcpx_g,
+                                         fftcpx_alpha_before, kissfft_comp_iris,
+                                         result_buff_mainSub, dimOut);
+      BokehUtils::BokehRefThread threadB(2, fftcpx_b_before, fftcpx_b,
+                                         fftcpx_alpha_before, kissfft_comp_iris,
+                                         result_buff_mainSub, dimOut);
 
       // If you set this flag to true, the fx will be forced to compute in
       // single thread.
@@ -1986,7 +1879,7 @@ void Iwa_BokehCommonFx::doBokehRef(
             while (!threadR.isFinished() || !threadG.isFinished() ||
                    !threadB.isFinished()) {
             }
-            releaseAllRastersAndPlans(rasterList, planList);
+            releaseAllRasters(rasterList);
             return;
           }
           if (threadR.isFinished() && threadG.isFinished() &&
@@ -2002,7 +1895,7 @@ void Iwa_BokehCommonFx::doBokehRef(
 
   // cancel check
   if (settings.m_isCanceled && *settings.m_isCanceled) {
-    releaseAllRastersAndPlans(rasterList, planList);
+    releaseAllRasters(rasterList);
     return;
   }
 
@@ -2016,6 +1909,6 @@ void Iwa_BokehCommonFx::doBokehRef(
                                                  result,              // dst
                                                  size, adjustFactor);
 
-  // release rasters and plans
-  releaseAllRastersAndPlans(rasterList, planList);
+  // release rasters
+  releaseAllRasters(rasterList);
 }
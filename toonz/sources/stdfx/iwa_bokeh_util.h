@@ -5,8 +5,7 @@
 
 #include "tgeometry.h"
 #include "traster.h"
-#include "kiss_fft.h"
-#include "tools/kiss_fftnd.h"
+#include "iwa_fft_util.h"
 #include "ttile.h"
 #include "stdfx.h"
 #include "tfxparam.h"
@@ -98,9 +97,9 @@ private:
   double m_layerGamma;
   double m_masterGamma;
 
-  TRasterGR8P m_kissfft_comp_in_ras, m_kissfft_comp_out_ras;
-  kiss_fft_cpx *m_kissfft_comp_in, *m_kissfft_comp_out;
-  kiss_fftnd_cfg m_kissfft_plan_fwd, m_kissfft_plan_bkwd;
+  TRasterGR8P m_kissfft_real_in_ras, m_kissfft_comp_out_ras;
+  kiss_fft_scalar* m_kissfft_real_in;
+  kiss_fft_cpx* m_kissfft_comp_out;
 
   bool m_isTerminated;
 
@@ -113,9 +112,9 @@ public:
 
   // Convert the pixels from RGB values to exposures and multiply it by alpha
   // channel value.
-  // Store the results in the real part of kiss_fft_cpx.
+  // Store the results in the real FFT input.
   template <typename RASTER, typename PIXEL>
-  void setLayerRaster(const RASTER srcRas, kiss_fft_cpx* dstMem,
+  void setLayerRaster(const RASTER srcRas, kiss_fft_scalar* dstMem,
                       TDimensionI dim);
 
   void run();
@@ -139,23 +138,20 @@ class BokehRefThread : public QThread {
   int m_channel;
   volatile bool m_finished;
 
-  kiss_fft_cpx* m_fftcpx_channel_before;
+  kiss_fft_scalar* m_fftcpx_channel_before;
   kiss_fft_cpx* m_fftcpx_channel;
-  kiss_fft_cpx* m_fftcpx_alpha;
+  kiss_fft_scalar* m_fftcpx_alpha;
   kiss_fft_cpx* m_fftcpx_iris;
   double4* m_result_buff;
 
-  kiss_fftnd_cfg m_kissfft_plan_fwd, m_kissfft_plan_bkwd;
-
   TDimensionI m_dim;
   bool m_isTerminated;
 
 public:
-  BokehRefThread(int channel, kiss_fft_cpx* fftcpx_channel_before,
-                 kiss_fft_cpx* fftcpx_channel, kiss_fft_cpx* fftcpx_alpha,
+  BokehRefThread(int channel, kiss_fft_scalar* fftcpx_channel_before,
+                 kiss_fft_cpx* fftcpx_channel, kiss_fft_scalar* fftcpx_alpha,
                  kiss_fft_cpx* fftcpx_iris, double4* result_buff,
-                 kiss_fftnd_cfg kissfft_plan_fwd,
-                 kiss_fftnd_cfg kissfft_plan_bkwd, TDimensionI& dim);
+                 TDimensionI& dim);
 
   void run() override;
 
@@ -213,26 +209,22 @@ void compositeAsIs(const double4* segment_layer_buff,
 // Resize / flip the iris image according to the size ratio.
 // Normalize the brightness of the iris image.
 // Enlarge the iris to the output size.
-void convertIris(const double irisSize, kiss_fft_cpx* kissfft_comp_iris_before,
+void convertIris(const double irisSize,
+                 kiss_fft_scalar* kissfft_comp_iris_before,
                  const TDimensionI& dimOut, const TRectD& irisBBox,
                  const TTile& irisTile);
 
 // retrieve segment layer image for each channel
 void retrieveChannel(const double4* segment_layer_buff,  // src
-                     kiss_fft_cpx* fftcpx_r_before,      // dst
-                     kiss_fft_cpx* fftcpx_g_before,      // dst
-                     kiss_fft_cpx* fftcpx_b_before,      // dst
-                     kiss_fft_cpx* fftcpx_a_before,      // dst
+                     kiss_fft_scalar* fftcpx_r_before,   // dst
+                     kiss_fft_scalar* fftcpx_g_before,   // dst
+                     kiss_fft_scalar* fftcpx_b_before,   // dst
+                     kiss_fft_scalar* fftcpx_a_before,   // dst
                      int size);
 
-// multiply filter on channel
-void multiplyFilter(kiss_fft_cpx* fftcpx_channel,  // dst
-                    kiss_fft_cpx* fftcpx_iris,     // filter
-                    int size);
-
 // normal comosite the alpha channel
-void compositeAlpha(const double4* result_buff,        // dst
-                    const kiss_fft_cpx* fftcpx_alpha,  // alpha
+void compositeAlpha(const double4* result_buff,           // dst
+                    const kiss_fft_scalar* fftcpx_alpha,  // alpha
                     int lx, int ly);
 
 // interpolate main and sub exposures
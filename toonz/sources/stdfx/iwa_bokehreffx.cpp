@@ -23,13 +23,6 @@ TRasterGR8P allocateRasterAndLock(T** buf, TDimensionI dim) {
 void releaseAllRasters(QList<TRasterGR8P>& rasterList) {
   for (int r = 0; r < rasterList.size(); r++) rasterList.at(r)->unlock();
 }
-
-// release all registered raster memories and free all fft plans
-void releaseAllRastersAndPlans(QList<TRasterGR8P>& rasterList,
-                               QList<kiss_fftnd_cfg>& planList) {
-  releaseAllRasters(rasterList);
-  for (int p = 0; p < planList.size(); p++) kiss_fft_free(planList.at(p));
-}
 };  // namespace
 
 //------------------------------------------------------------
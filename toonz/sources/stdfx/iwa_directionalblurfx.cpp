@@ -6,9 +6,171 @@
 #include "iwa_directionalblurfx.h"
 
 #include "tparamuiconcept.h"
+#include "iwa_fft_util.h"
+
+#include <QThread>
+#include <QAtomicInt>
+
+#include <memory>
+#include <vector>
 
 enum FILTER_TYPE { Linear = 0, Gaussian, Flat };
 
+namespace {
+
+/*- この数より多くの非０タップを持つフィルタは、周波数空間で畳み込む -*/
+const int c_fftTapsThreshold = 64;
+
+/*- フィルタの非０の要素 -*/
+struct FilterTap {
+  int x, y;  // filter coordinates
+  float value;
+};
+
+inline float &channel(float4 &pix, int c) {
+  return (c == 0) ? pix.x : (c == 1) ? pix.y : (c == 2) ? pix.z : pix.w;
+}
+inline float channel(const float4 &pix, int c) {
+  return (c == 0) ? pix.x : (c == 1) ? pix.y : (c == 2) ? pix.z : pix.w;
+}
+
+//------------------------------------
+
+/*- スキャンラインごとのフィルタリングの設定。ワーカースレッドで共有する -*/
+struct BlurRows {
+  const float4 *m_in;
+  float4 *m_out;
+  const float *m_reference;  // 0 if not connected
+  const std::vector<FilterTap> *m_taps;
+  int m_lx;                  // width of the enlarged buffers
+  int m_x0, m_x1, m_y1;      // computed range
+  bool m_fullFilterDone;     // pixels using the whole filter are computed
+  QAtomicInt m_nextRow;
+
+  void run() {
+    int y;
+    while ((y = m_nextRow.fetchAndAddOrdered(1)) < m_y1) blurRow(y);
+  }
+
+  void blurRow(int y) {
+    for (int x = m_x0; x < m_x1; x++) {
+      int index = y * m_lx + x;
+      float ref = (m_reference) ? m_reference[index] : 1.0f;
+
+      /*- 参照画像が黒ならソースをそのまま返す -*/
+      if (ref == 0.0f) {
+        m_out[index] = m_in[index];
+        continue;
+      }
+      if (ref == 1.0f && m_fullFilterDone) continue;
+
+      /*- 値を積算する入れ物を用意 -*/
+      float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
+
+      /*- フィルタはサンプル点の画像を収集するように
+         用いるため、上下左右反転してサンプルする -*/
+      for (const FilterTap &tap : *m_taps) {
+        int sampleIndex;
+        if (ref == 1.0f)
+          sampleIndex = index - tap.y * m_lx - tap.x;
+        else {
+          int2 samplePos = {tround((float)x - (float)tap.x * ref),
+                            tround((float)y - (float)tap.y * ref)};
+          sampleIndex    = samplePos.y * m_lx + samplePos.x;
+        }
+
+        /*- サンプルピクセルが透明ならcontinue -*/
+        const float4 &sample = m_in[sampleIndex];
+        if (sample.w == 0.0f) continue;
+
+        /*- サンプル点の値にフィルタ値を掛けて積算する -*/
+        value.x += sample.x * tap.value;
+        value.y += sample.y * tap.value;
+        value.z += sample.z * tap.value;
+        value.w += sample.w * tap.value;
+      }
+
+      /*- 値を格納 -*/
+      m_out[index] = value;
+    }
+  }
+};
+
+class BlurRowsThread final : public QThread {
+  BlurRows *m_rows;
+
+public:
+  BlurRowsThread(BlurRows *rows) : m_rows(rows) {}
+  void run() override { m_rows->run(); }
+};
+
+//------------------------------------
+/*- フィルタ全体を FFT で畳み込み、out の計算範囲に格納する。
+    透明なサンプルは寄与しないので、０にしてから変換する -*/
+
+void convolveFFT(const float4 *in, float4 *out, const float *filter,
+                 const TDimensionI &dim, const TDimensionI &filterDim,
+                 int marginLeft, int marginBottom, int x0, int x1, int y0,
+                 int y1) {
+  /*- kissfft の得意なサイズに広げる。広げた部分は０なので結果は変わらない -*/
+  int lx = kiss_fft_next_fast_size(dim.lx);
+  int ly = kiss_fft_next_fast_size(dim.ly);
+
+  int spectrumLx   = FftUtils::spectrumLx(lx);
+  int threadsCount = FftUtils::getThreadsCount();
+  float scale      = 1.0f / ((float)lx * (float)ly);
+
+  TRasterGR8P real_ras(lx * sizeof(kiss_fft_scalar), ly);
+  TRasterGR8P filterSpectrum_ras(spectrumLx * sizeof(kiss_fft_cpx), ly);
+  TRasterGR8P spectrum_ras(spectrumLx * sizeof(kiss_fft_cpx), ly);
+  real_ras->lock();
+  filterSpectrum_ras->lock();
+  spectrum_ras->lock();
+  kiss_fft_scalar *real = (kiss_fft_scalar *)real_ras->getRawData();
+  kiss_fft_cpx *filterSpectrum =
+      (kiss_fft_cpx *)filterSpectrum_ras->getRawData();
+  kiss_fft_cpx *spectrum = (kiss_fft_cpx *)spectrum_ras->getRawData();
+
+  /*- フィルタの原点を (0,0) に置き、負の座標は反対側に回り込ませる -*/
+  real_ras->clear();
+  for (int fy = 0; fy < filterDim.ly; fy++) {
+    int v = (fy - marginBottom + ly) % ly;
+    for (int fx = 0; fx < filterDim.lx; fx++) {
+      int u = (fx - marginLeft + lx) % lx;
+      real[v * lx + u] = filter[fy * filterDim.lx + fx];
+    }
+  }
+  FftUtils::fft2dReal(real, filterSpectrum, lx, ly, threadsCount);
+
+  for (int c = 0; c < 4; c++) {
+    real_ras->clear();
+    for (int j = 0; j < dim.ly; j++) {
+      const float4 *in_p    = in + j * dim.lx;
+      kiss_fft_scalar *re_p = real + j * lx;
+      for (int i = 0; i < dim.lx; i++, in_p++, re_p++)
+        if ((*in_p).w != 0.0f) (*re_p) = channel(*in_p, c);
+    }
+
+    FftUtils::fft2dReal(real, spectrum, lx, ly, threadsCount);
+    FftUtils::multiplySpectrum(spectrum, filterSpectrum, spectrumLx * ly);
+    FftUtils::ifft2dReal(spectrum, real, lx, ly, threadsCount);
+
+    /*- 計算範囲の端から端までのサンプルは回り込まない -*/
+    for (int y = y0; y < y1; y++) {
+      float4 *out_p         = out + y * dim.lx + x0;
+      kiss_fft_scalar *re_p = real + y * lx + x0;
+      for (int x = x0; x < x1; x++, out_p++, re_p++)
+        channel(*out_p, c) = (*re_p) * scale;
+    }
+  }
+
+  real_ras->unlock();
+  filterSpectrum_ras->unlock();
+  spectrum_ras->unlock();
+}
+
+}  // namespace
+
 /*------------------------------------------------------------
  参照画像の輝度を０〜１に正規化してホストメモリに読み込む
 ------------------------------------------------------------*/
@@ -259,116 +421,47 @@ void Iwa_DirectionalBlurFx::doCompute_CPU(
                                 marginRight, marginTop, marginBottom,
                                 filterDim);
 
-  if (reference_host) /*- 参照画像がある場合 -*/
+  /*- フィルタの非０の要素を、サンプルする順に集める -*/
+  std::vector<FilterTap> taps;
   {
-    float4 *out_p = out + marginTop * enlargedDimIn.lx;
-    float *ref_p  = reference_host + marginTop * enlargedDimIn.lx;
-    /*- フィルタリング -*/
-    for (int y = marginTop; y < dimOut.ly + marginTop; y++) {
-      out_p += marginRight;
-      ref_p += marginRight;
-      for (int x = marginRight; x < dimOut.lx + marginRight;
-           x++, out_p++, ref_p++) {
-        /*- 参照画像が黒ならソースをそのまま返す -*/
-        if ((*ref_p) == 0.0f) {
-          (*out_p) = in[y * enlargedDimIn.lx + x];
-          continue;
-        }
-
-        /*- 値を積算する入れ物を用意 -*/
-        float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
-
-        float *filter_p = filter;
-
-        if ((*ref_p) == 1.0f) {
-          /*- フィルタのサイズでループ
-             ただし、フィルタはサンプル点の画像を収集するように
-                  用いるため、上下左右反転してサンプルする -*/
-          for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-               fily++) {
-            /*- サンプル座標 と インデックス の このスキャンラインのうしろ -*/
-            int2 samplePos  = {x + marginLeft, y - fily};
-            int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
-
-            for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-                 filx++, filter_p++, sampleIndex--) {
-              /*- フィルター値が０またはサンプルピクセルが透明ならcontinue -*/
-              if ((*filter_p) == 0.0f || in[sampleIndex].w == 0.0f) continue;
-              /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-              value.x += in[sampleIndex].x * (*filter_p);
-              value.y += in[sampleIndex].y * (*filter_p);
-              value.z += in[sampleIndex].z * (*filter_p);
-              value.w += in[sampleIndex].w * (*filter_p);
-            }
-          }
-        } else {
-          for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-               fily++) {
-            for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-                 filx++, filter_p++) {
-              /*- フィルター値が０ならcontinue -*/
-              if ((*filter_p) == 0.0f) continue;
-              /*- サンプル座標 -*/
-              int2 samplePos  = {tround((float)x - (float)filx * (*ref_p)),
-                                 tround((float)y - (float)fily * (*ref_p))};
-              int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
-
-              /*- サンプルピクセルが透明ならcontinue -*/
-              if (in[sampleIndex].w == 0.0f) continue;
-
-              /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-              value.x += in[sampleIndex].x * (*filter_p);
-              value.y += in[sampleIndex].y * (*filter_p);
-              value.z += in[sampleIndex].z * (*filter_p);
-              value.w += in[sampleIndex].w * (*filter_p);
-            }
-          }
-        }
+    float *filter_p = filter;
+    for (int fily = -marginBottom; fily < filterDim.ly - marginBottom; fily++)
+      for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
+           filx++, filter_p++)
+        if ((*filter_p) != 0.0f) taps.push_back({filx, fily, *filter_p});
+  }
 
-        /*- 値を格納 -*/
-        (*out_p) = value;
-      }
-      out_p += marginLeft;
-      ref_p += marginLeft;
-    }
+  BlurRows rows;
+  rows.m_in             = in;
+  rows.m_out            = out;
+  rows.m_reference      = reference_host;
+  rows.m_taps           = &taps;
+  rows.m_lx             = enlargedDimIn.lx;
+  rows.m_x0             = marginRight;
+  rows.m_x1             = dimOut.lx + marginRight;
+  rows.m_y1             = dimOut.ly + marginTop;
+  rows.m_fullFilterDone = false;
+  rows.m_nextRow.storeRelease(marginTop);
+
+  /*- 長いフィルタは FFT で畳み込む。参照画像がある場合は、
+      参照値が１のピクセルにだけその結果を使う -*/
+  if ((int)taps.size() > c_fftTapsThreshold) {
+    convolveFFT(in, out, filter, enlargedDimIn, filterDim, marginLeft,
+                marginBottom, rows.m_x0, rows.m_x1, marginTop, rows.m_y1);
+    rows.m_fullFilterDone = true;
+  }
 
-  } else /*- 参照画像が無い場合 -*/
-  {
-    float4 *out_p = out + marginTop * enlargedDimIn.lx;
-    /*- フィルタリング -*/
-    for (int y = marginTop; y < dimOut.ly + marginTop; y++) {
-      out_p += marginRight;
-      for (int x = marginRight; x < dimOut.lx + marginRight; x++, out_p++) {
-        /*- 値を積算する入れ物を用意 -*/
-        float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
-        /*- フィルタのサイズでループ
-           ただし、フィルタはサンプル点の画像を収集するように
-                用いるため、上下左右反転してサンプルする -*/
-        int filterIndex = 0;
-        for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-             fily++) {
-          /*- サンプル座標 と インデックス の このスキャンラインのうしろ -*/
-          int2 samplePos  = {x + marginLeft, y - fily};
-          int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
-
-          for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-               filx++, filterIndex++, sampleIndex--) {
-            /*- フィルター値が０またはサンプルピクセルが透明ならcontinue -*/
-            if (filter[filterIndex] == 0.0f || in[sampleIndex].w == 0.0f)
-              continue;
-            /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-            value.x += in[sampleIndex].x * filter[filterIndex];
-            value.y += in[sampleIndex].y * filter[filterIndex];
-            value.z += in[sampleIndex].z * filter[filterIndex];
-            value.w += in[sampleIndex].w * filter[filterIndex];
-          }
-        }
+  /*- フィルタリング。スキャンラインごとにスレッドに分配する -*/
+  if (reference_host || !rows.m_fullFilterDone) {
+    int threadsCount = std::min(QThread::idealThreadCount(), dimOut.ly);
 
-        /*- 値を格納 -*/
-        (*out_p) = value;
-      }
-      out_p += marginLeft;
+    std::vector<std::unique_ptr<BlurRowsThread>> threads;
+    for (int t = 1; t < threadsCount; t++) {
+      threads.emplace_back(new BlurRowsThread(&rows));
+      threads.back()->start();
     }
+    rows.run();
+    for (auto &thread : threads) thread->wait();
   }
 
   in_ras->unlock();
@@ -0,0 +1,291 @@
+#include "iwa_fft_util.h"
+
+#include "tthread.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInt>
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <string.h>
+
+namespace {
+
+// Below this amount of values a pass is run in the calling thread only.
+const int c_minParallelSize = 1 << 16;
+
+//------------------------------------
+// Plan cache
+//------------------------------------
+
+class PlanCache {
+  QMutex m_mutex;
+  std::map<std::pair<int, bool>, kiss_fft_cfg> m_plans;
+
+public:
+  ~PlanCache() {
+    for (auto& plan : m_plans) kiss_fft_free(plan.second);
+  }
+
+  kiss_fft_cfg getPlan(int nfft, bool inverse) {
+    QMutexLocker locker(&m_mutex);
+
+    kiss_fft_cfg& plan = m_plans[std::make_pair(nfft, inverse)];
+    if (!plan) plan = kiss_fft_alloc(nfft, inverse, 0, 0);
+    return plan;
+  }
+};
+
+PlanCache planCache;
+
+//------------------------------------
+// Passes
+//------------------------------------
+
+// A set of independent 1D transforms (rows or columns), consumed by the
+// calling thread and by the idle threads of the shared helper pool. Each
+// thread owns a work buffer of m_workSize values.
+class FftPass {
+  QAtomicInt m_next;
+  int m_count, m_workSize;
+
+public:
+  FftPass(int count, int workSize)
+      : m_next(0), m_count(count), m_workSize(workSize) {}
+  virtual ~FftPass() {}
+
+  virtual void process(int index, kiss_fft_cpx* work) = 0;
+
+  void run(int threadsCount) {
+    if (threadsCount > m_count) threadsCount = m_count;
+    if (m_count * m_workSize < c_minParallelSize) threadsCount = 1;
+
+    TThread::runConcurrently([this]() { loop(); }, threadsCount - 1);
+  }
+
+private:
+  void loop() {
+    std::vector<kiss_fft_cpx> work(m_workSize);
+
+    int index;
+    while ((index = m_next.fetchAndAddOrdered(1)) < m_count)
+      process(index, work.data());
+  }
+};
+
+//------------------------------------
+
+// Complex transforms of the rows of a full complex image.
+class ComplexRowsPass final : public FftPass {
+  const kiss_fft_cpx* m_in;
+  kiss_fft_cpx* m_out;
+  int m_lx;
+  kiss_fft_cfg m_plan;
+
+public:
+  ComplexRowsPass(const kiss_fft_cpx* in, kiss_fft_cpx* out, int lx, int ly,
+                  bool inverse)
+      : FftPass(ly, lx)
+      , m_in(in)
+      , m_out(out)
+      , m_lx(lx)
+      , m_plan(FftUtils::getPlan(lx, inverse)) {}
+
+  void process(int j, kiss_fft_cpx* work) override {
+    const kiss_fft_cpx* src = m_in + j * m_lx;
+    kiss_fft_cpx* dst       = m_out + j * m_lx;
+    if (src == dst) {
+      memcpy(work, src, m_lx * sizeof(kiss_fft_cpx));
+      src = work;
+    }
+    kiss_fft(m_plan, src, dst);
+  }
+};
+
+//------------------------------------
+
+// In-place complex transforms of the columns of an image, whose rows are
+// lx values long.
+class ColumnsPass final : public FftPass {
+  kiss_fft_cpx* m_data;
+  int m_lx, m_ly;
+  kiss_fft_cfg m_plan;
+
+public:
+  ColumnsPass(kiss_fft_cpx* data, int lx, int ly, bool inverse)
+      : FftPass(lx, ly)
+      , m_data(data)
+      , m_lx(lx)
+      , m_ly(ly)
+      , m_plan(FftUtils::getPlan(ly, inverse)) {}
+
+  void process(int i, kiss_fft_cpx* work) override {
+    kiss_fft_stride(m_plan, m_data + i, work, m_lx);
+
+    kiss_fft_cpx* dst = m_data + i;
+    for (int j = 0; j < m_ly; ++j, dst += m_lx) *dst = work[j];
+  }
+};
+
+//------------------------------------
+
+// Forward transforms of the rows of a real image to half spectra.
+// Pairs of real rows are packed into a single complex transform, as the
+// real and imaginary part, and separated by the spectra symmetries.
+class RealRowsPass final : public FftPass {
+  const kiss_fft_scalar* m_in;
+  kiss_fft_cpx* m_out;
+  int m_lx, m_ly, m_sx;
+  kiss_fft_cfg m_plan;
+
+public:
+  RealRowsPass(const kiss_fft_scalar* in, kiss_fft_cpx* out, int lx, int ly)
+      : FftPass((ly + 1) / 2, 2 * lx)
+      , m_in(in)
+      , m_out(out)
+      , m_lx(lx)
+      , m_ly(ly)
+      , m_sx(FftUtils::spectrumLx(lx))
+      , m_plan(FftUtils::getPlan(lx, false)) {}
+
+  void process(int p, kiss_fft_cpx* work) override {
+    int j0 = 2 * p, j1 = j0 + 1;
+    bool hasPair = (j1 < m_ly);
+
+    kiss_fft_cpx *z = work, *zz = work + m_lx;
+
+    const kiss_fft_scalar* x = m_in + j0 * m_lx;
+    const kiss_fft_scalar* y = m_in + j1 * m_lx;
+    for (int i = 0; i < m_lx; ++i) {
+      z[i].r = x[i];
+      z[i].i = hasPair ? y[i] : 0;
+    }
+
+    kiss_fft(m_plan, z, zz);
+
+    // X[k] = (Z[k] + conj(Z[-k])) / 2, Y[k] = (Z[k] - conj(Z[-k])) / 2i
+    kiss_fft_cpx* xOut = m_out + j0 * m_sx;
+    kiss_fft_cpx* yOut = m_out + j1 * m_sx;
+    for (int k = 0; k < m_sx; ++k) {
+      const kiss_fft_cpx &zk = zz[k], &zn = zz[(m_lx - k) % m_lx];
+
+      xOut[k].r = (zk.r + zn.r) * 0.5f;
+      xOut[k].i = (zk.i - zn.i) * 0.5f;
+      if (hasPair) {
+        yOut[k].r = (zk.i + zn.i) * 0.5f;
+        yOut[k].i = (zn.r - zk.r) * 0.5f;
+      }
+    }
+  }
+};
+
+//------------------------------------
+
+// Backward transforms of half spectra rows to the rows of a real image.
+// Pairs of rows are rebuilt as X + iY, whose transform holds the two real
+// rows in the real and imaginary part.
+class RealInverseRowsPass final : public FftPass {
+  const kiss_fft_cpx* m_in;
+  kiss_fft_scalar* m_out;
+  int m_lx, m_ly, m_sx;
+  kiss_fft_cfg m_plan;
+
+public:
+  RealInverseRowsPass(const kiss_fft_cpx* in, kiss_fft_scalar* out, int lx,
+                      int ly)
+      : FftPass((ly + 1) / 2, 2 * lx)
+      , m_in(in)
+      , m_out(out)
+      , m_lx(lx)
+      , m_ly(ly)
+      , m_sx(FftUtils::spectrumLx(lx))
+      , m_plan(FftUtils::getPlan(lx, true)) {}
+
+  void process(int p, kiss_fft_cpx* work) override {
+    int j0 = 2 * p, j1 = j0 + 1;
+    bool hasPair = (j1 < m_ly);
+
+    kiss_fft_cpx *z = work, *zz = work + m_lx;
+
+    const kiss_fft_cpx* xIn = m_in + j0 * m_sx;
+    const kiss_fft_cpx* yIn = m_in + j1 * m_sx;
+    for (int k = 0; k < m_lx; ++k) {
+      // the upper half of the spectra is the conjugate of the lower one
+      kiss_fft_cpx x, y = {0, 0};
+      if (k < m_sx) {
+        x = xIn[k];
+        if (hasPair) y = yIn[k];
+      } else {
+        x   = xIn[m_lx - k];
+        x.i = -x.i;
+        if (hasPair) y = yIn[m_lx - k], y.i = -y.i;
+      }
+
+      z[k].r = x.r - y.i;
+      z[k].i = x.i + y.r;
+    }
+
+    kiss_fft(m_plan, z, zz);
+
+    kiss_fft_scalar* x = m_out + j0 * m_lx;
+    kiss_fft_scalar* y = m_out + j1 * m_lx;
+    for (int i = 0; i < m_lx; ++i) {
+      x[i] = zz[i].r;
+      if (hasPair) y[i] = zz[i].i;
+    }
+  }
+};
+
+}  // namespace
+
+//------------------------------------
+
+kiss_fft_cfg FftUtils::getPlan(int nfft, bool inverse) {
+  return planCache.getPlan(nfft, inverse);
+}
+
+//------------------------------------
+
+int FftUtils::getThreadsCount() {
+  int count = QThread::idealThreadCount();
+  return (count > 1) ? count : 1;
+}
+
+//------------------------------------
+
+void FftUtils::fft2d(const kiss_fft_cpx* in, kiss_fft_cpx* out, int lx,
+                     int ly, bool inverse, int threadsCount) {
+  ComplexRowsPass(in, out, lx, ly, inverse).run(threadsCount);
+  ColumnsPass(out, lx, ly, inverse).run(threadsCount);
+}
+
+//------------------------------------
+
+void FftUtils::fft2dReal(const kiss_fft_scalar* in, kiss_fft_cpx* out, int lx,
+                         int ly, int threadsCount) {
+  RealRowsPass(in, out, lx, ly).run(threadsCount);
+  ColumnsPass(out, spectrumLx(lx), ly, false).run(threadsCount);
+}
+
+//------------------------------------
+
+void FftUtils::ifft2dReal(kiss_fft_cpx* in, kiss_fft_scalar* out, int lx,
+                          int ly, int threadsCount) {
+  ColumnsPass(in, spectrumLx(lx), ly, true).run(threadsCount);
+  RealInverseRowsPass(in, out, lx, ly).run(threadsCount);
+}
+
+//------------------------------------
+
+void FftUtils::multiplySpectrum(kiss_fft_cpx* spectrum,
+                                const kiss_fft_cpx* filter, int count) {
+  for (int i = 0; i < count; i++, spectrum++, filter++) {
+    kiss_fft_scalar re = spectrum->r * filter->r - spectrum->i * filter->i;
+    kiss_fft_scalar im = spectrum->r * filter->i + spectrum->i * filter->r;
+    spectrum->r        = re;
+    spectrum->i        = im;
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef IWA_FFT_UTIL_H
+#define IWA_FFT_UTIL_H
+
+#include "kiss_fft.h"
+
+//------------------------------------
+// 2D FFT services shared by the fxs convolving with kissfft.
+//
+// The transforms are built on 1D kissfft plans, which are cached by length
+// and direction for the whole session: they only hold the twiddle factors,
+// so they are small and can be used by many threads at the same time.
+// Row and column passes can be distributed among several threads.
+//
+// As with kiss_fftnd, the transforms are not normalized: a forward transform
+// followed by the backward one multiplies the data by lx * ly.
+//------------------------------------
+
+namespace FftUtils {
+
+// Returns the shared 1D plan of the specified length and direction.
+// The plan is owned by the cache and must not be freed.
+kiss_fft_cfg getPlan(int nfft, bool inverse);
+
+// Returns the number of threads used for the passes by default.
+int getThreadsCount();
+
+// Returns the width of the half spectrum of real data with the specified
+// width. The spectrum of a lx x ly real image is stored row by row in
+// spectrumLx(lx) x ly complex values.
+inline int spectrumLx(int lx) { return lx / 2 + 1; }
+
+// Complex 2D FFT of ly rows of lx values, equivalent to kiss_fftnd with
+// dims = {ly, lx}. in and out may coincide.
+void fft2d(const kiss_fft_cpx* in, kiss_fft_cpx* out, int lx, int ly,
+           bool inverse, int threadsCount = 1);
+
+// Forward 2D FFT of real data. out receives the half spectrum.
+void fft2dReal(const kiss_fft_scalar* in, kiss_fft_cpx* out, int lx, int ly,
+               int threadsCount = 1);
+
+// Backward 2D FFT of a half spectrum to real data.
+// The spectrum is used as work memory, and is overwritten.
+void ifft2dReal(kiss_fft_cpx* in, kiss_fft_scalar* out, int lx, int ly,
+                int threadsCount = 1);
+
+// Multiplies the spectrum by the filter, element by element.
+void multiplySpectrum(kiss_fft_cpx* spectrum, const kiss_fft_cpx* filter,
+                      int count);
+
+}  // namespace FftUtils
+
+#endif
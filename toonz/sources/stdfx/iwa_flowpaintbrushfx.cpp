@@ -1066,7 +1066,7 @@ std::string Iwa_FlowPaintBrushFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
       // add alias of flow, area and color map in the reference frame
       if (getInputPortName(i) != "Brush") {
         alias += ",";
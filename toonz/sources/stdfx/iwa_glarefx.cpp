@@ -347,17 +347,10 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
 
     convertIris(kissfft_comp_iris_before, dimIris, irisBBox, irisRas);
 
-    // Create the FFT plan for the iris image.
-    kiss_fftnd_cfg iris_kissfft_plan;
-    while (1) {
-      int dims[2]       = {dimIris, dimIris};
-      int ndims         = 2;
-      iris_kissfft_plan = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-      if (iris_kissfft_plan != NULL) break;
-    }
-    // Do FFT the iris image.
-    kiss_fftnd(iris_kissfft_plan, kissfft_comp_iris_before, kissfft_comp_iris);
-    kiss_fft_free(iris_kissfft_plan);
+    // Do FFT the iris image. The whole power spectrum is needed here, so the
+    // complex transform is used.
+    FftUtils::fft2d(kissfft_comp_iris_before, kissfft_comp_iris, dimIris,
+                    dimIris, false, FftUtils::getThreadsCount());
     kissfft_comp_iris_before_ras->unlock();
   }
 
@@ -436,25 +429,27 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
     dimOut.ly = new_y;
   }
 
-  kiss_fft_cpx* kissfft_comp_tmp;
+  // the source and the glare pattern are real, so only the half spectra
+  // are computed
+  int spectrumLx = FftUtils::spectrumLx(dimOut.lx);
+
+  kiss_fft_scalar* kissfft_comp_tmp;
   kiss_fft_cpx* kissfft_comp_glare;
   kiss_fft_cpx* kissfft_comp_source;
-  TRasterGR8P kissfft_comp_tmp_ras(dimOut.lx * sizeof(kiss_fft_cpx), dimOut.ly);
-  TRasterGR8P kissfft_comp_glare_ras(dimOut.lx * sizeof(kiss_fft_cpx),
+  TRasterGR8P kissfft_comp_tmp_ras(dimOut.lx * sizeof(kiss_fft_scalar),
+                                   dimOut.ly);
+  TRasterGR8P kissfft_comp_glare_ras(spectrumLx * sizeof(kiss_fft_cpx),
                                      dimOut.ly);
-  TRasterGR8P kissfft_comp_source_ras(dimOut.lx * sizeof(kiss_fft_cpx),
+  TRasterGR8P kissfft_comp_source_ras(spectrumLx * sizeof(kiss_fft_cpx),
                                       dimOut.ly);
-  kissfft_comp_tmp    = (kiss_fft_cpx*)kissfft_comp_tmp_ras->getRawData();
+  kissfft_comp_tmp    = (kiss_fft_scalar*)kissfft_comp_tmp_ras->getRawData();
   kissfft_comp_glare  = (kiss_fft_cpx*)kissfft_comp_glare_ras->getRawData();
   kissfft_comp_source = (kiss_fft_cpx*)kissfft_comp_source_ras->getRawData();
   kissfft_comp_tmp_ras->lock();
   kissfft_comp_glare_ras->lock();
   kissfft_comp_source_ras->lock();
 
-  int dims[2]              = {dimOut.ly, dimOut.lx};
-  int ndims                = 2;
-  kiss_fftnd_cfg plan_fwd  = kiss_fftnd_alloc(dims, ndims, false, 0, 0);
-  kiss_fftnd_cfg plan_bkwd = kiss_fftnd_alloc(dims, ndims, true, 0, 0);
+  int threadsCount = FftUtils::getThreadsCount();
 
   // obtain the source tile
   TTile sourceTile;
@@ -476,7 +471,8 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
       setSourceTileToBuffer<TRasterFP, TPixelF>(sourceTile.getRaster(),
                                                 kissfft_comp_tmp);
     // FFT the source
-    kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_source);
+    FftUtils::fft2dReal(kissfft_comp_tmp, kissfft_comp_source, dimOut.lx,
+                        dimOut.ly, threadsCount);
   }
 
   // compute for each rgb channels
@@ -493,7 +489,8 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
         setSourceTileToBuffer<TRasterFP, TPixelF>(sourceTile.getRaster(),
                                                   kissfft_comp_tmp, ch);
       // FFT the source
-      kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_source);
+      FftUtils::fft2dReal(kissfft_comp_tmp, kissfft_comp_source, dimOut.lx,
+                          dimOut.ly, threadsCount);
     }
 
     kissfft_comp_tmp_ras->clear();
@@ -502,15 +499,16 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
                             dimOut);
 
     // FFT the glare pattern
-    kiss_fftnd(plan_fwd, kissfft_comp_tmp, kissfft_comp_glare);
+    FftUtils::fft2dReal(kissfft_comp_tmp, kissfft_comp_glare, dimOut.lx,
+                        dimOut.ly, threadsCount);
 
     // multiply the glare and the source
-    multiplyFilter(kissfft_comp_glare, kissfft_comp_source,
-                   dimOut.lx * dimOut.ly);
+    FftUtils::multiplySpectrum(kissfft_comp_glare, kissfft_comp_source,
+                               spectrumLx * dimOut.ly);
 
     // Backward-FFT the glare pattern to tmp
-    kiss_fftnd(plan_bkwd, kissfft_comp_glare,
-               kissfft_comp_tmp);  // Backward FFT
+    FftUtils::ifft2dReal(kissfft_comp_glare, kissfft_comp_tmp, dimOut.lx,
+                         dimOut.ly, threadsCount);  // Backward FFT
 
     // convert tmp to channel values, store it into the tile
     if (ras32)
@@ -529,9 +527,6 @@ void Iwa_GlareFx::doCompute(TTile& tile, double frame,
     TRop::tosRGB(tile.getRaster(), settings.m_colorSpaceGamma);
   }
 
-  kiss_fft_free(plan_fwd);
-  kiss_fft_free(plan_bkwd);
-
   kissfft_comp_source_ras->unlock();
   kissfft_comp_glare_ras->unlock();
 }
@@ -820,35 +815,35 @@ void Iwa_GlareFx::setFilterPreviewToResult(const RASTER ras, double3* glare,
 
 // put the source tile's brightness to fft buffer
 template <typename RASTER, typename PIXEL>
-void Iwa_GlareFx::setSourceTileToBuffer(const RASTER ras, kiss_fft_cpx* buf) {
-  kiss_fft_cpx* buf_p = buf;
+void Iwa_GlareFx::setSourceTileToBuffer(const RASTER ras,
+                                        kiss_fft_scalar* buf) {
+  kiss_fft_scalar* buf_p = buf;
   for (int j = 0; j < ras->getLy(); j++) {
     PIXEL* pix = ras->pixels(j);
     for (int i = 0; i < ras->getLx(); i++, pix++, buf_p++) {
       // Value = 0.3R 0.59G 0.11B
-      (*buf_p).r = (double(pix->r) * 0.3 + double(pix->g) * 0.59 +
-                    double(pix->b) * 0.11) /
-                   double(PIXEL::maxChannelValue);
+      (*buf_p) = (double(pix->r) * 0.3 + double(pix->g) * 0.59 +
+                  double(pix->b) * 0.11) /
+                 double(PIXEL::maxChannelValue);
     }
   }
 }
 
 // put the source tile's brightness to fft buffer
 template <typename RASTER, typename PIXEL>
-void Iwa_GlareFx::setSourceTileToBuffer(const RASTER ras, kiss_fft_cpx* buf,
-                                        int channel) {
-  kiss_fft_cpx* buf_p = buf;
+void Iwa_GlareFx::setSourceTileToBuffer(const RASTER ras,
+                                        kiss_fft_scalar* buf, int channel) {
+  kiss_fft_scalar* buf_p = buf;
   for (int j = 0; j < ras->getLy(); j++) {
     PIXEL* pix = ras->pixels(j);
     for (int i = 0; i < ras->getLx(); i++, pix++, buf_p++) {
       if (channel == 0)
-        (*buf_p).r = float(pix->r) / float(PIXEL::maxChannelValue);
+        (*buf_p) = float(pix->r) / float(PIXEL::maxChannelValue);
       else if (channel == 1)
-        (*buf_p).r = float(pix->g) / float(PIXEL::maxChannelValue);
+        (*buf_p) = float(pix->g) / float(PIXEL::maxChannelValue);
       else {  // if (channel == 2)
-        (*buf_p).r = float(pix->b) / float(PIXEL::maxChannelValue);
+        (*buf_p) = float(pix->b) / float(PIXEL::maxChannelValue);
       }
-      (*buf_p).i = 0.f;
     }
   }
 }
@@ -856,39 +851,26 @@ void Iwa_GlareFx::setSourceTileToBuffer(const RASTER ras, kiss_fft_cpx* buf,
 //------------------------------------------------
 
 void Iwa_GlareFx::setGlarePatternToBuffer(const double3* glare,
-                                          kiss_fft_cpx* buf, const int channel,
-                                          const int dimIris,
+                                          kiss_fft_scalar* buf,
+                                          const int channel, const int dimIris,
                                           const TDimensionI& dimOut) {
   int margin_x = (dimOut.lx - dimIris) / 2;
   int margin_y = (dimOut.ly - dimIris) / 2;
   for (int j = margin_y; j < margin_y + dimIris; j++) {
     const double3* glare_p = &glare[(j - margin_y) * dimIris];
-    kiss_fft_cpx* buf_p    = &buf[j * dimOut.lx + margin_x];
+    kiss_fft_scalar* buf_p = &buf[j * dimOut.lx + margin_x];
     for (int i = margin_x; i < margin_x + dimIris; i++, buf_p++, glare_p++) {
-      (*buf_p).r = (channel == 0)   ? (*glare_p).x
-                   : (channel == 1) ? (*glare_p).y
-                                    : (*glare_p).z;
+      (*buf_p) = (channel == 0)   ? (*glare_p).x
+                 : (channel == 1) ? (*glare_p).y
+                                  : (*glare_p).z;
     }
   }
 }
 
 //------------------------------------------------
 
-void Iwa_GlareFx::multiplyFilter(kiss_fft_cpx* glare,
-                                 const kiss_fft_cpx* source, const int count) {
-  kiss_fft_cpx* g_p       = glare;
-  const kiss_fft_cpx* s_p = source;
-  for (int i = 0; i < count; i++, g_p++, s_p++) {
-    double re = (*g_p).r * (*s_p).r - (*g_p).i * (*s_p).i;
-    double im = (*g_p).r * (*s_p).i + (*s_p).r * (*g_p).i;
-    (*g_p).r  = re;
-    (*g_p).i  = im;
-  }
-}
-
-//------------------------------------------------
 template <typename RASTER, typename PIXEL>
-void Iwa_GlareFx::setChannelToResult(const RASTER ras, kiss_fft_cpx* buf,
+void Iwa_GlareFx::setChannelToResult(const RASTER ras, kiss_fft_scalar* buf,
                                      int channel, const TDimensionI& dimOut) {
   auto clamp01 = [](double chan) {
     if (chan < 0.0) return 0.0;
@@ -902,12 +884,12 @@ void Iwa_GlareFx::setChannelToResult(const RASTER ras, kiss_fft_cpx* buf,
   bool doClamp = (ras->getPixelSize() != 16);
 
   for (int j = 0; j < ras->getLy(); j++) {
-    // kiss_fft_cpx* buf_p = &buf[(j + margin_y)*dimOut.lx + margin_x];
+    // kiss_fft_scalar* buf_p = &buf[(j + margin_y)*dimOut.lx + margin_x];
     PIXEL* pix = ras->pixels(j);
     for (int i = 0; i < ras->getLx(); i++, pix++) {
-      kiss_fft_cpx fft_val =
+      kiss_fft_scalar fft_val =
           buf[getCoord(i + margin_x, j + margin_y, dimOut.lx, dimOut.ly)];
-      double val = fft_val.r / (dimOut.lx * dimOut.ly);
+      double val = fft_val / (dimOut.lx * dimOut.ly);
       if (doClamp) {
         if (channel == 0)
           pix->r = (typename PIXEL::Channel)(clamp01(val) *
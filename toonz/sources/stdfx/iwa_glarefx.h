@@ -15,7 +15,7 @@ Iwa_GlareFx
 #include <QList>
 #include <QThread>
 
-#include "tools/kiss_fftnd.h"
+#include "iwa_fft_util.h"
 
 const int LAYER_NUM = 5;
 
@@ -99,19 +99,17 @@ protected:
 
   // put the source tile's brightness to fft buffer
   template <typename RASTER, typename PIXEL>
-  void setSourceTileToBuffer(const RASTER ras, kiss_fft_cpx *buf);
+  void setSourceTileToBuffer(const RASTER ras, kiss_fft_scalar *buf);
   template <typename RASTER, typename PIXEL>
-  void setSourceTileToBuffer(const RASTER ras, kiss_fft_cpx *buf, int channel);
+  void setSourceTileToBuffer(const RASTER ras, kiss_fft_scalar *buf,
+                             int channel);
 
-  void setGlarePatternToBuffer(const double3 *glare, kiss_fft_cpx *buf,
+  void setGlarePatternToBuffer(const double3 *glare, kiss_fft_scalar *buf,
                                const int channel, const int dimIris,
                                const TDimensionI &dimOut);
 
-  void multiplyFilter(kiss_fft_cpx *glare, const kiss_fft_cpx *source,
-                      const int count);
-
   template <typename RASTER, typename PIXEL>
-  void setChannelToResult(const RASTER ras, kiss_fft_cpx *buf, int channel,
+  void setChannelToResult(const RASTER ras, kiss_fft_scalar *buf, int channel,
                           const TDimensionI &dimOut);
 
 public:
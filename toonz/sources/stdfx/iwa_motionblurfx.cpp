@@ -1032,7 +1032,7 @@ std::string Iwa_MotionBlurCompFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
     }
     alias += ",";
   }
@@ -22,9 +22,12 @@
 #include "iwa_particlesengine.h"
 
 #include "trenderer.h"
+#include "tthread.h"
 
 #include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
+#include <QAtomicInt>
 
 #include <sstream>
 
@@ -38,6 +41,91 @@ void printTime(TStopWatch &sw, std::string name) {
   ss << '\n' << '\0';
   TSystem::outputDebug(ss.str());
 }
+
+//----
+
+/*- 寿命の尽きた粒子（scaleが0以下のものは残す）-*/
+bool isDeadParticle(const Iwa_Particle &part) {
+  return part.scale > 0.0 && part.lifetime <= 0;
+}
+
+//----
+
+/*- 粒子の移動を分担して行う。各スレッドが粒子のブロックを順に取っていく -*/
+class ParticlesMoveJob {
+  Iwa_Particle *m_particles;
+  int m_count;
+  const std::map<int, TTile *> &m_porttiles;
+  const particles_values &m_values;
+  const particles_ranges &m_ranges;
+  float m_windx, m_windy, m_xgravity, m_ygravity, m_dpi;
+  const std::vector<int> &m_lastframe;
+
+  QAtomicInt m_nextBlock;
+
+public:
+  enum { BlockSize = 1024 };
+
+  ParticlesMoveJob(Iwa_Particle *particles, int count,
+                   const std::map<int, TTile *> &porttiles,
+                   const particles_values &values,
+                   const particles_ranges &ranges, float windx, float windy,
+                   float xgravity, float ygravity, float dpi,
+                   const std::vector<int> &lastframe)
+      : m_particles(particles)
+      , m_count(count)
+      , m_porttiles(porttiles)
+      , m_values(values)
+      , m_ranges(ranges)
+      , m_windx(windx)
+      , m_windy(windy)
+      , m_xgravity(xgravity)
+      , m_ygravity(ygravity)
+      , m_dpi(dpi)
+      , m_lastframe(lastframe)
+      , m_nextBlock(0) {}
+
+  void run() {
+    int block;
+    while ((block = m_nextBlock.fetchAndAddOrdered(1)) * BlockSize < m_count) {
+      Iwa_Particle *part = m_particles + block * BlockSize,
+                   *end  = m_particles + std::min((block + 1) * BlockSize,
+                                                  m_count);
+      for (; part != end; ++part) {
+        if (part->scale <= 0.0) continue;
+        part->move(m_porttiles, m_values, m_ranges, m_windx, m_windy,
+                   m_xgravity, m_ygravity, m_dpi, m_lastframe[part->level]);
+      }
+    }
+  }
+};
+
+//----
+
+/*-
+ * 粒子を1フレーム分動かす。各粒子は自身の乱数を持ち、参照画像は読むだけなので、
+ * 粒子が多い場合は共有のヘルパースレッドの空いている分で処理する
+ * -*/
+void move_particles(std::vector<Iwa_Particle> &particles,
+                    const std::map<int, TTile *> &porttiles,
+                    const particles_values &values,
+                    const particles_ranges &ranges, float windx, float windy,
+                    float xgravity, float ygravity, float dpi,
+                    const std::vector<int> &lastframe) {
+  const int minParticlesPerThread = 2048;
+
+  int count        = (int)particles.size();
+  int threadAmount = std::min(QThread::idealThreadCount(),
+                              count / minParticlesPerThread);
+
+  ParticlesMoveJob job(particles.data(), count, porttiles, values, ranges,
+                       windx, windy, xgravity, ygravity, dpi, lastframe);
+
+  if (threadAmount <= 1)
+    job.run();
+  else
+    TThread::runConcurrently([&job]() { job.run(); }, threadAmount - 1);
+}
 };  // namespace
 //----
 
@@ -196,7 +284,7 @@ void Iwa_Particles_Engine::roll_particles(
     TTile *tile,                      /*-結果を格納するTile-*/
     std::map<int, TTile *> porttiles, /*-コントロール画像のポート番号／タイル-*/
     const TRenderSettings &ri, /*-現在のフレームの計算用RenderSettings-*/
-    std::list<Iwa_Particle> &myParticles, /*-パーティクルのリスト-*/
+    std::vector<Iwa_Particle> &myParticles, /*-パーティクルのリスト-*/
     struct particles_values &values, /*-現在のフレームでのパラメータ-*/
     float cx,                        /*- 0 で入ってくる-*/
     float cy,                        /*- 0 で入ってくる-*/
@@ -335,24 +423,19 @@ void Iwa_Particles_Engine::roll_particles(
   }
   /*- 既存粒子を動かし、かつ新規粒子を作る -*/
   else {
-    std::list<Iwa_Particle>::iterator it;
-    for (it = myParticles.begin(); it != myParticles.end();) {
-      std::list<Iwa_Particle>::iterator current = it;
-      ++it;
-
-      Iwa_Particle &part = (*current);
-      if (part.scale <= 0.0) continue;
-      if (part.lifetime <= 0)        // Note: This is in line with the above
-                                     // "lifetime>curr_frame-frame"
-        myParticles.erase(current);  // insertion counterpart
-      else {
-        part.move(porttiles, values, ranges, windx, windy, xgravity, ygravity,
-                  dpi, lastframe[part.level]);
-      }
-    }
+    // Note: This is in line with the above "lifetime>curr_frame-frame"
+    // insertion counterpart
+    myParticles.erase(
+        std::remove_if(myParticles.begin(), myParticles.end(), isDeadParticle),
+        myParticles.end());
+
+    move_particles(myParticles, porttiles, values, ranges, windx, windy,
+                   xgravity, ygravity, dpi, lastframe);
 
     switch (values.toplayer_val) {
-    case Iwa_TiledParticlesFx::TOP_YOUNGER:
+    case Iwa_TiledParticlesFx::TOP_YOUNGER: {
+      /*- 新しい粒子ほど前に来るよう、逆順に先頭へ挿入する -*/
+      std::vector<Iwa_Particle> newParticles;
       for (i = 0; i < actualBirthParticles; i++) {
         /*- 出発する粒子 -*/
         ParticleOrigin po = particleOrigins.at(leavingPartIndex.at(i));
@@ -369,7 +452,7 @@ void Iwa_Particles_Engine::roll_particles(
                     ranges.lifetime_range * values.random_val->getFloat());
         }
         if (lifetime > curr_frame - frame) {
-          myParticles.push_front(Iwa_Particle(
+          newParticles.push_back(Iwa_Particle(
               lifetime, seed, porttiles, values, ranges, totalparticles, 0,
               (int)po.level, lastframe[po.level], po.pos[0], po.pos[1],
               po.isUpward,
@@ -378,14 +461,15 @@ void Iwa_Particles_Engine::roll_particles(
         }
         totalparticles++;
       }
+      myParticles.insert(myParticles.begin(), newParticles.rbegin(),
+                         newParticles.rend());
       break;
+    }
 
     case Iwa_TiledParticlesFx::TOP_RANDOM:
       for (i = 0; i < actualBirthParticles; i++) {
         double tmp = values.random_val->getFloat() * myParticles.size();
-        std::list<Iwa_Particle>::iterator it = myParticles.begin();
-        for (int j = 0; j < tmp; j++, it++)
-          ;
+        int pos    = (int)std::ceil(tmp);
         {
           /*- 出発する粒子 -*/
           ParticleOrigin po = particleOrigins.at(leavingPartIndex.at(i));
@@ -403,7 +487,7 @@ void Iwa_Particles_Engine::roll_particles(
           }
           if (lifetime > curr_frame - frame) {
             myParticles.insert(
-                it,
+                myParticles.begin() + pos,
                 Iwa_Particle(
                     lifetime, seed, porttiles, values, ranges, totalparticles,
                     0, (int)po.level, lastframe[po.level], po.pos[0], po.pos[1],
@@ -568,7 +652,7 @@ void Iwa_Particles_Engine::render_particles(
   // Retrieve the last rolled frame
   Iwa_ParticlesManager::FrameData *particlesData = pc->data(fxId);
 
-  std::list<Iwa_Particle> myParticles;
+  std::vector<Iwa_Particle> myParticles;
   TRandom myRandom  = m_parent->randseed_val->getValue();
   values.random_val = &myRandom;
 
@@ -595,9 +679,42 @@ void Iwa_Particles_Engine::render_particles(
   /*- 外側にマージンを取って粒子を生成 -*/
   TRectD resourceTileBBox = outTileBBox.enlarge(pixelMargin);
 
+  /*- シミュレーションの識別子。チェックポイントのキーに用いる -*/
+  Iwa_ParticlesManager::SimulationId simId;
+  simId.m_fxId              = fxId;
+  simId.m_paramChangesCount = TFx::getParamChangesCount();
+  {
+    std::ostringstream os;
+    os.precision(17);
+    os << ri.m_affine.a11 << "," << ri.m_affine.a12 << "," << ri.m_affine.a13
+       << "," << ri.m_affine.a21 << "," << ri.m_affine.a22 << ","
+       << ri.m_affine.a23 << ";" << resourceTileBBox.x0 << ","
+       << resourceTileBBox.y0 << "," << resourceTileBBox.x1 << ","
+       << resourceTileBBox.y1;
+    simId.m_placementHash = TAliasHash(os.str());
+  }
+
   /*- 初期粒子量。これが変わっていなければ、BGはそのまま描く -*/
   int initialOriginsSize;
-  if (pcFrame > curr_frame) {
+
+  // Resume from the nearest shared checkpoint, if it is nearer to the current
+  // frame than the configuration stored by this thread
+  Iwa_ParticlesManager::Checkpoint checkpoint;
+  if (pc->getCheckpoint(simId, curr_frame, checkpoint) &&
+      checkpoint.m_frame >= startframe - 1 &&
+      (pcFrame > curr_frame || checkpoint.m_frame > pcFrame)) {
+    particlesData->clear();
+
+    myParticles        = checkpoint.m_particles;
+    myRandom           = checkpoint.m_random;
+    totalparticles     = checkpoint.m_totalParticles;
+    fractpart          = checkpoint.m_fractPart;
+    particleOrigins    = checkpoint.m_particleOrigins;
+    pcFrame            = checkpoint.m_frame;
+    initialOriginsSize = -1;
+  }
+
+  else if (pcFrame > curr_frame) {
     /*- データを初期化 -*/
     // Clear stored particlesData
     particlesData->clear();
@@ -614,6 +731,7 @@ void Iwa_Particles_Engine::render_particles(
     myParticles        = particlesData->m_particles;
     myRandom           = particlesData->m_random;
     totalparticles     = particlesData->m_totalParticles;
+    fractpart          = particlesData->m_fractPart;
     particleOrigins    = particlesData->m_particleOrigins;
     initialOriginsSize = -1;
   } else {
@@ -748,9 +866,23 @@ void Iwa_Particles_Engine::render_particles(
       particlesData->buildMaxTrail();
       particlesData->m_calculated      = true;
       particlesData->m_totalParticles  = totalparticles;
+      particlesData->m_fractPart       = fractpart;
       particlesData->m_particleOrigins = particleOrigins;
     }
 
+    // Share a checkpoint of the simulation with the other threads
+    if ((frame - (startframe - 1)) % Iwa_ParticlesManager::CheckpointInterval ==
+        0) {
+      checkpoint.m_frame           = frame;
+      checkpoint.m_targetFrame     = curr_frame;
+      checkpoint.m_random          = myRandom;
+      checkpoint.m_particles       = myParticles;
+      checkpoint.m_totalParticles  = totalparticles;
+      checkpoint.m_fractPart       = fractpart;
+      checkpoint.m_particleOrigins = particleOrigins;
+      pc->storeCheckpoint(simId, checkpoint);
+    }
+
     // Render the particles if the distance from current frame is a trail
     // multiple
     /*- さしあたり、trailは無視する -*/
@@ -762,7 +894,7 @@ void Iwa_Particles_Engine::render_particles(
          -*/
       /*-	①飛んでいる粒子 -*/
       if (values.iw_rendermode_val != Iwa_TiledParticlesFx::REND_BG) {
-        std::list<Iwa_Particle>::iterator pt;
+        std::vector<Iwa_Particle>::iterator pt;
         for (pt = myParticles.begin(); pt != myParticles.end(); ++pt) {
           Iwa_Particle &part = *pt;
           int ndx            = part.frame % last_frame[part.level];
@@ -809,12 +941,13 @@ void Iwa_Particles_Engine::render_particles(
       if (values.iw_rendermode_val != Iwa_TiledParticlesFx::REND_BG) {
         if (values.toplayer_val == Iwa_TiledParticlesFx::TOP_SMALLER ||
             values.toplayer_val == Iwa_TiledParticlesFx::TOP_BIGGER)
-          myParticles.sort(Iwa_ComparebySize());
+          std::stable_sort(myParticles.begin(), myParticles.end(),
+                           Iwa_ComparebySize());
 
         if (values.toplayer_val == Iwa_TiledParticlesFx::TOP_SMALLER) {
           int unit  = 1 + (int)myParticles.size() / 100;
           int count = 0;
-          std::list<Iwa_Particle>::iterator pt;
+          std::vector<Iwa_Particle>::iterator pt;
           for (pt = myParticles.begin(); pt != myParticles.end(); ++pt) {
             count++;
 
@@ -833,7 +966,7 @@ void Iwa_Particles_Engine::render_particles(
         } else {
           int unit  = 1 + (int)myParticles.size() / 100;
           int count = 0;
-          std::list<Iwa_Particle>::reverse_iterator pt;
+          std::vector<Iwa_Particle>::reverse_iterator pt;
           for (pt = myParticles.rbegin(); pt != myParticles.rend(); ++pt) {
             count++;
 
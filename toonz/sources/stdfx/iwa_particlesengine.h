@@ -68,7 +68,7 @@ public:
 
   void roll_particles(TTile *tile, std::map<int, TTile *> porttiles,
                       const TRenderSettings &ri,
-                      std::list<Iwa_Particle> &myParticles,
+                      std::vector<Iwa_Particle> &myParticles,
                       struct particles_values &values, float cx, float cy,
                       int frame, int curr_frame, int level_n,
                       bool *random_level, float dpi, std::vector<int> lastframe,
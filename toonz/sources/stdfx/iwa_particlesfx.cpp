@@ -330,7 +330,9 @@ Iwa_TiledParticlesFx::Iwa_TiledParticlesFx()
 
 //------------------------------------------------------------------
 
-Iwa_TiledParticlesFx::~Iwa_TiledParticlesFx() {}
+Iwa_TiledParticlesFx::~Iwa_TiledParticlesFx() {
+  Iwa_ParticlesManager::releaseCheckpoints(getIdentifier());
+}
 
 //------------------------------------------------------------------
 
@@ -374,7 +376,7 @@ std::string Iwa_TiledParticlesFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
     }
     alias += ",";
   }
@@ -7,6 +7,8 @@
 
 #include <QMutexLocker>
 
+#include <set>
+
 #include "iwa_particlesmanager.h"
 
 /*
@@ -20,6 +22,15 @@ configuration that rendered
 last. In case a trail was set, such frame is that beyond the trail.
 This managemer works well on the assumption that each thread builds particle in
 an incremental timeline.
+
+In addition, every CheckpointInterval rolled frames a copy of the simulation
+state is stored in a map shared by all threads. A thread whose own
+configuration is behind (or beyond) the frame to be rendered resumes from the
+nearest checkpoint instead of rolling the whole timeline again.
+Checkpoints are bounded in number, per simulation and per fx, the least
+recently used ones being dropped first. Since particles dying before the
+frame to be rendered are not born at all, a checkpoint is only reused to
+render its own target frame or a later one.
 */
 
 //--------------------------------------------------------------------------------------------------
@@ -31,6 +42,22 @@ DEFINE_CLASS_CODE(Iwa_ParticlesManager::FxData,
 
 typedef std::map<double, Iwa_ParticlesManager::FrameData> FramesMap;
 
+namespace {
+
+template <class Map>
+typename Map::iterator leastRecentlyUsed(Map &map) {
+  typename Map::iterator it, lru = map.begin();
+  for (it = map.begin(); it != map.end(); ++it)
+    if (it->second.m_lastUse < lru->second.m_lastUse) lru = it;
+  return lru;
+}
+
+// Living managers, whose checkpoints are dropped when an fx is deleted
+QMutex managersMutex;
+std::set<Iwa_ParticlesManager *> managers;
+
+}  // namespace
+
 //************************************************************************************************
 //    Preliminaries
 //************************************************************************************************
@@ -57,7 +84,8 @@ Iwa_ParticlesManager::FrameData::FrameData(FxData *fxData)
     , m_frame((std::numeric_limits<int>::min)())
     , m_calculated(false)
     , m_maxTrail(-1)
-    , m_totalParticles(0) {
+    , m_totalParticles(0)
+    , m_fractPart(0) {
   m_fxData->addRef();
 }
 
@@ -69,7 +97,7 @@ Iwa_ParticlesManager::FrameData::~FrameData() { m_fxData->release(); }
 
 void Iwa_ParticlesManager::FrameData::buildMaxTrail() {
   // Store the maximum trail of each particle
-  std::list<Iwa_Particle>::iterator it;
+  std::vector<Iwa_Particle>::iterator it;
   for (it = m_particles.begin(); it != m_particles.end(); ++it)
     m_maxTrail = std::max(m_maxTrail, it->trail);
 }
@@ -83,6 +111,7 @@ void Iwa_ParticlesManager::FrameData::clear() {
   m_calculated     = false;
   m_maxTrail       = -1;
   m_totalParticles = 0;
+  m_fractPart      = 0;
 }
 
 //************************************************************************************************
@@ -102,11 +131,20 @@ Iwa_ParticlesManager *Iwa_ParticlesManager::instance() {
 
 //-------------------------------------------------------------------------
 
-Iwa_ParticlesManager::Iwa_ParticlesManager() : m_renderStatus(-1) {}
+Iwa_ParticlesManager::Iwa_ParticlesManager()
+    : m_checkpointsClock(0), m_renderStatus(-1) {
+  QMutexLocker locker(&managersMutex);
+  managers.insert(this);
+}
 
 //-------------------------------------------------------------------------
 
 Iwa_ParticlesManager::~Iwa_ParticlesManager() {
+  {
+    QMutexLocker locker(&managersMutex);
+    managers.erase(this);
+  }
+
   // Release all fxDatas
   std::map<unsigned long, FxData *>::iterator it, end = m_fxs.end();
   for (it = m_fxs.begin(); it != end; ++it) it->second->release();
@@ -144,3 +182,102 @@ bool Iwa_ParticlesManager::isCached(unsigned long fxId) {
   std::map<unsigned long, FxData *>::iterator it = m_fxs.find(fxId);
   return (it != m_fxs.end());
 }
+
+//-------------------------------------------------------------------------
+
+Iwa_ParticlesManager::FxCheckpoints *Iwa_ParticlesManager::fxCheckpoints(
+    const SimulationId &simId, bool create) {
+  std::map<unsigned long, FxCheckpoints>::iterator it =
+      m_checkpoints.find(simId.m_fxId);
+  if (it == m_checkpoints.end()) {
+    if (!create) return 0;
+
+    it = m_checkpoints.insert(std::make_pair(simId.m_fxId, FxCheckpoints()))
+             .first;
+    it->second.m_paramChangesCount = simId.m_paramChangesCount;
+  }
+
+  FxCheckpoints &fxCheckpoints = it->second;
+  if (fxCheckpoints.m_paramChangesCount < simId.m_paramChangesCount) {
+    // The fx parameters changed - stored simulations are outdated
+    fxCheckpoints.m_simulations.clear();
+    fxCheckpoints.m_paramChangesCount = simId.m_paramChangesCount;
+  } else if (fxCheckpoints.m_paramChangesCount > simId.m_paramChangesCount)
+    return 0;  // The request is outdated
+
+  return &fxCheckpoints;
+}
+
+//-------------------------------------------------------------------------
+
+bool Iwa_ParticlesManager::getCheckpoint(const SimulationId &simId,
+                                         int targetFrame, Checkpoint &cp) {
+  QMutexLocker locker(&m_checkpointsMutex);
+
+  FxCheckpoints *fxCheckpoints = this->fxCheckpoints(simId, false);
+  if (!fxCheckpoints) return false;
+
+  std::map<TAliasHash, Simulation>::iterator st =
+      fxCheckpoints->m_simulations.find(simId.m_placementHash);
+  if (st == fxCheckpoints->m_simulations.end()) return false;
+
+  // Nearest checkpoint whose frame and target are not beyond the passed one
+  Simulation &sim = st->second;
+  std::map<int, StoredCheckpoint>::iterator ct =
+      sim.m_checkpoints.upper_bound(targetFrame);
+  while (ct != sim.m_checkpoints.begin()) {
+    --ct;
+    if (ct->second.m_checkpoint.m_targetFrame > targetFrame) continue;
+
+    sim.m_lastUse = ct->second.m_lastUse = ++m_checkpointsClock;
+    cp            = ct->second.m_checkpoint;
+    return true;
+  }
+
+  return false;
+}
+
+//-------------------------------------------------------------------------
+
+void Iwa_ParticlesManager::storeCheckpoint(const SimulationId &simId,
+                                           const Checkpoint &cp) {
+  QMutexLocker locker(&m_checkpointsMutex);
+
+  FxCheckpoints *fxCheckpoints = this->fxCheckpoints(simId, true);
+  if (!fxCheckpoints) return;
+
+  std::map<TAliasHash, Simulation> &sims = fxCheckpoints->m_simulations;
+  std::map<TAliasHash, Simulation>::iterator st =
+      sims.find(simId.m_placementHash);
+  if (st == sims.end()) {
+    if ((int)sims.size() >= MaxSimulations) sims.erase(leastRecentlyUsed(sims));
+    st = sims.insert(std::make_pair(simId.m_placementHash, Simulation())).first;
+  }
+
+  Simulation &sim = st->second;
+  sim.m_lastUse   = ++m_checkpointsClock;
+
+  // An earlier target serves more requests
+  std::map<int, StoredCheckpoint>::iterator ct =
+      sim.m_checkpoints.find(cp.m_frame);
+  if (ct != sim.m_checkpoints.end()) {
+    if (ct->second.m_checkpoint.m_targetFrame <= cp.m_targetFrame) return;
+  } else if ((int)sim.m_checkpoints.size() >= MaxCheckpoints)
+    sim.m_checkpoints.erase(leastRecentlyUsed(sim.m_checkpoints));
+
+  StoredCheckpoint &stored = sim.m_checkpoints[cp.m_frame];
+  stored.m_checkpoint      = cp;
+  stored.m_lastUse         = m_checkpointsClock;
+}
+
+//-------------------------------------------------------------------------
+
+void Iwa_ParticlesManager::releaseCheckpoints(unsigned long fxId) {
+  QMutexLocker locker(&managersMutex);
+
+  std::set<Iwa_ParticlesManager *>::iterator it;
+  for (it = managers.begin(); it != managers.end(); ++it) {
+    QMutexLocker checkpointsLocker(&(*it)->m_checkpointsMutex);
+    (*it)->m_checkpoints.erase(fxId);
+  }
+}
@@ -11,6 +11,7 @@
 #include "tsmartpointer.h"
 #include "trenderresourcemanager.h"
 #include "trandom.h"
+#include "taliashash.h"
 #include "iwa_particles.h"
 
 #include <QThreadStorage>
@@ -36,10 +37,11 @@ public:
     FxData *m_fxData;
     double m_frame;
     TRandom m_random;
-    std::list<Iwa_Particle> m_particles;
+    std::vector<Iwa_Particle> m_particles;
     bool m_calculated;
     int m_maxTrail;
     int m_totalParticles;
+    float m_fractPart;
 
     /*- しきつめ情報 -*/
     QList<ParticleOrigin> m_particleOrigins;
@@ -59,6 +61,40 @@ public:
     FxData();
   };
 
+  //! Snapshot of the simulation state at the end of a rolled frame, shared
+  //! by all the render threads.
+  /*!
+    Particles are only born if they live until the frame being rendered, so
+    the state depends on that target frame too. A checkpoint holds every
+    particle needed to render its target frame or any later one.
+  */
+  struct Checkpoint {
+    int m_frame;
+    int m_targetFrame;
+    TRandom m_random;
+    std::vector<Iwa_Particle> m_particles;
+    int m_totalParticles;
+    float m_fractPart;
+    QList<ParticleOrigin> m_particleOrigins;
+  };
+
+  //! Identifies a simulation: its fx, the revision of the fx parameters and
+  //! the placement of the simulated area.
+  struct SimulationId {
+    unsigned long m_fxId;
+    long m_paramChangesCount;
+    TAliasHash m_placementHash;
+  };
+
+  //! Frames between two consecutive checkpoints of the same simulation.
+  static const int CheckpointInterval = 10;
+  //! Checkpoints kept for each simulation. Beyond it, the least recently used
+  //! one is dropped.
+  static const int MaxCheckpoints = 8;
+  //! Simulations kept for each fx, eg for different resolutions. Beyond it,
+  //! the least recently used one is dropped.
+  static const int MaxSimulations = 4;
+
 public:
   Iwa_ParticlesManager();
   ~Iwa_ParticlesManager();
@@ -69,13 +105,53 @@ public:
 
   bool isCached(unsigned long fxId);
 
+  /*!
+    Retrieves the checkpoint of the specified simulation which is nearest to,
+    but not beyond, the passed target frame, among those stored for a target
+    not beyond it. Returns false if none is available.
+  */
+  bool getCheckpoint(const SimulationId &simId, int targetFrame,
+                     Checkpoint &cp);
+  /*!
+    Stores a checkpoint, unless one at the same frame and for an earlier
+    target was already stored.
+    The checkpoints of previous parameter revisions of the fx are dropped.
+  */
+  void storeCheckpoint(const SimulationId &simId, const Checkpoint &cp);
+
+  //! Drops the checkpoints of the specified fx from all managers. Invoked
+  //! when the fx is deleted.
+  static void releaseCheckpoints(unsigned long fxId);
+
+private:
+  struct StoredCheckpoint {
+    Checkpoint m_checkpoint;
+    unsigned long m_lastUse;
+  };
+
+  struct Simulation {
+    std::map<int, StoredCheckpoint> m_checkpoints;
+    unsigned long m_lastUse;
+  };
+
+  struct FxCheckpoints {
+    long m_paramChangesCount;
+    std::map<TAliasHash, Simulation> m_simulations;
+  };
+
 private:
   std::map<unsigned long, FxData *> m_fxs;
   QMutex m_mutex;
 
+  std::map<unsigned long, FxCheckpoints> m_checkpoints;
+  unsigned long m_checkpointsClock;  //!< Use counter, for the LRU policy
+  QMutex m_checkpointsMutex;
+
   int m_renderStatus;
 
   void onRenderStatusStart(int renderStatus) override;
+
+  FxCheckpoints *fxCheckpoints(const SimulationId &simId, bool create);
 };
 
 #endif
@@ -629,7 +629,7 @@ public:
       if (port->isConnected()) {
         TRasterFxP ifx = port->getFx();
         assert(ifx);
-        alias += ifx->getAlias(frame, info);
+        alias += ifx->getCachedAlias(frame, info);
       }
       alias += ",";
     }
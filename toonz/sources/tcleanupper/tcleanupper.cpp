@@ -17,6 +17,7 @@
 #include "toonz/txshchildlevel.h"
 #include "toonz/tproject.h"
 #include "toonz/tcleanupper.h"
+#include "toonz/cleanuppipeline.h"
 #include "toonz/txsheet.h"
 #include "toonz/txshcell.h"
 #include "toonz/txshcolumn.h"
@@ -384,7 +385,7 @@ static void addCleanupDefaultPalette(TXshSimpleLevel *sl) {
 
 static void cleanupLevel(TXshSimpleLevel *xl, std::set<TFrameId> fidsInXsheet,
                          ToonzScene *scene, bool overwrite,
-                         TUserLogAppend &m_userLog) {
+                         TUserLogAppend &m_userLog, int threadsCount) {
   prepareToCleanup(xl, scene->getProperties()
                            ->getCleanupParameters()
                            ->m_cleanupPalette.getPointer());
@@ -398,48 +399,43 @@ static void cleanupLevel(TXshSimpleLevel *xl, std::set<TFrameId> fidsInXsheet,
   LevelUpdater updater(xl);
   m_userLog.info(info);
   DVGui::info(QString::fromStdString(info));
-  bool firstImage = true;
+
+  std::vector<TFrameId> fids;
   for (auto const &fid : fidsInXsheet) {
-    cout << "  " << fid << endl;
-    info = "  " + fid.expand();
-    m_userLog.info(info);
     int status = xl->getFrameStatus(fid);
 
     if (0 != (status & TXshSimpleLevel::Cleanupped) && !overwrite) {
+      cout << "  " << fid << endl;
       cout << "  skipped" << endl;
+      m_userLog.info("  " + fid.expand());
       m_userLog.info("  skipped");
       DVGui::info(QString("--skipped frame ") +
                   QString::fromStdString(fid.expand()));
       continue;
     }
-    CleanupParameters *params = scene->getProperties()->getCleanupParameters();
-    // if lines are not processed, obtain the original sampled image
-    bool toBeLineProcessed = params->m_lineProcessingMode != lpNone;
+    fids.push_back(fid);
+  }
+  if (fids.empty()) return;
+
+  CleanupParameters *params = scene->getProperties()->getCleanupParameters();
+  // if lines are not processed, obtain the original sampled image
+  bool toBeLineProcessed = params->m_lineProcessingMode != lpNone;
+
+  bool firstImage = true, firstWrittenImage = true;
+
+  // Frames are read and written here, and cleaned up on other threads
+  auto reader = [&](const TFrameId &fid) -> TRasterImageP {
+    cout << "  " << fid << endl;
+    m_userLog.info("  " + fid.expand());
+
     TRasterImageP original = xl->getFrameToCleanup(fid, toBeLineProcessed);
     if (!original) {
       string err = "    *error* missed frame";
       m_userLog.error(err);
       cout << err << endl;
-      continue;
+      return original;
     }
 
-    if (params->m_lineProcessingMode == lpNone) {
-      TRasterImageP ri(original);
-      /*if (params->m_autocenterType == CleanupTypes::AUTOCENTER_NONE)
-        ri = original;
-      else {
-        bool autocentered;
-        ri = cl->autocenterOnly(original, false, autocentered);
-        if (!autocentered) {
-          m_userLog.error("The autocentering failed on the current drawing.");
-          cout << "The autocentering failed on the current drawing." << endl;
-        }
-      }*/
-      cl->process(original, false, ri, false, true, true, nullptr,
-                  ri->getRaster());
-      updater.update(fid, ri);
-      continue;
-    }
     // Obtain the source dpi. Changed it to be done once at the first frame of
     // each level in order to avoid the following problem:
     // If the original raster level has no dpi (such as TGA images), obtaining
@@ -447,45 +443,74 @@ static void cleanupLevel(TXshSimpleLevel *xl, std::set<TFrameId> fidsInXsheet,
     // following frames, since the value
     // TXshSimpleLevel::m_properties->getDpi() will be changed to the
     // dpi of cleanup camera (= TLV's dpi) after finishing the first frame.
-    if (firstImage) {
+    if (firstImage && toBeLineProcessed) {
       TPointD dpi;
       original->getDpi(dpi.x, dpi.y);
       if (dpi.x == 0 && dpi.y == 0) dpi = xl->getProperties()->getDpi();
       cl->setSourceDpi(dpi);
     }
+    firstImage = false;
 
-    CleanupPreprocessedImage *cpi;
-    {
-      TRasterImageP resampledImage;
-      cpi = cl->process(original, firstImage, resampledImage);
+    return original;
+  };
+
+  auto writer = [&](const TFrameId &fid, const TImageP &img,
+                    bool autocentered) {
+    if (!img) {
+      string err = "    *error* cleanup failed on frame " + fid.expand();
+      m_userLog.error(err);
+      cout << err << endl;
+      return;
+    }
+
+    if (params->m_autocenterType == CleanupTypes::AUTOCENTER_FDG &&
+        !autocentered) {
+      string err = "    The autocentering failed on frame " + fid.expand();
+      m_userLog.error(err);
+      cout << err << endl;
     }
 
-    TToonzImageP timage = cl->finalize(cpi, true);
+    if (!toBeLineProcessed) {
+      updater.update(fid, img);
+      return;
+    }
+
+    TToonzImageP timage = img;
     TPointD dpi(0, 0);
     timage->getDpi(dpi.x, dpi.y);
     if (dpi.x != 0 && dpi.y != 0) xl->getProperties()->setDpi(dpi);
 
-    if (firstImage) addCleanupDefaultPalette(xl);
-    firstImage = false;
+    if (firstWrittenImage) addCleanupDefaultPalette(xl);
+    firstWrittenImage = false;
 
     timage->setPalette(xl->getPalette());
-    xl->setFrameStatus(fid, status | TXshSimpleLevel::Cleanupped);
+    xl->setFrameStatus(fid,
+                       xl->getFrameStatus(fid) | TXshSimpleLevel::Cleanupped);
     xl->setFrame(fid, timage);
 
     updater.update(fid, timage);
 
     /*- 1フレーム終わったら、そのフレームのキャッシュは消す -*/
     xl->invalidateFrame(fid);
+  };
 
-    delete cpi;
-  }
+  CleanupPipeline pipeline(threadsCount);
+  pipeline.setProgressCallback([](int done, int total) {
+    cout << "  " << done << "/" << total << " frames done" << endl;
+  });
+
+  pipeline.run(fids, reader, writer);
+
+  string report = pipeline.getTimingsReport();
+  m_userLog.info(report);
+  cout << report << endl;
 }
 
 //========================================================================
 //
 // main
 //
-// usage: tcleanup filename.tnz [-selected][-overwrite]
+// usage: tcleanup filename.tnz [-selected][-overwrite][-t threads]
 //
 //------------------------------------------------------------------------
 
@@ -503,6 +528,8 @@ int main(int argc, char *argv[]) {
       QString::fromStdString(TEnv::getApplicationName()));
 
   TSystem::hasMainLoop(false);
+  TThread::init();
+
   int i;
   for (i = 0; i < argc; i++)  // tmsg must be set as soon as it's possible
   {
@@ -551,12 +578,14 @@ int main(int argc, char *argv[]) {
       "-overwriteNoPaint",
       "Overwrite only no-paint levels of already cleanupped frames");
 
+  IntQualifier threads("-t threads", "Number of frames cleaned up at once");
+
   StringQualifier farmData("-farm data", "TFarm Controller");
   StringQualifier idq("-id n", "id");
   StringQualifier tmsg("-tmsg n", "Internal use only");
   Usage usage(argv[0]);
   usage.add(srcName + selectedOnlyOption + overwriteAllOption +
-            overwriteNoPaintOption + farmData + idq + tmsg);
+            overwriteNoPaintOption + threads + farmData + idq + tmsg);
   if (!usage.parse(argc, argv)) exit(1);
 
   TaskId       = idq.getValue();
@@ -771,7 +800,8 @@ int main(int argc, char *argv[]) {
     assert(fidsInXsheet.size() > 0);
 
     xl->load();
-    cleanupLevel(xl, fidsInXsheet, scene, overwrite, m_userLog);
+    cleanupLevel(xl, fidsInXsheet, scene, overwrite, m_userLog,
+                 threads.isSelected() ? threads.getValue() : 0);
 
     /*- Cleanup完了後、Nopaintをnopaintフォルダに保存する -*/
     if (Preferences::instance()->isSaveUnpaintedInCleanupEnable() &&
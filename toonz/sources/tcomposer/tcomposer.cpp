@@ -1029,6 +1029,13 @@ int main(int argc, char *argv[]) {
         "Raster Allocation Mean: " +
         std::to_string(TBigMemoryManager::instance()->getAllocationMean()) +
         " KB");
+    TBigMemoryManager::Statistics stats =
+        TBigMemoryManager::instance()->getStatistics();
+    m_userLog->info("Raster Buffers Recycled: " +
+                    std::to_string(stats.m_recycledCount) + " of " +
+                    std::to_string(stats.m_allocationsCount) +
+                    " - Peak Usage: " + std::to_string(stats.m_peakUsedKb) +
+                    " KB");
 
     msg = "Compositing completed in " +
           ::to_string(Sw1.getTotalTime() / 1000.0, 2) + " seconds";
@@ -183,6 +183,28 @@ inline std::string traduce(const TAffine &aff) {
       (areAlmostEqual(aff.a23, 0.0) ? "0" : ::to_string(aff.a23, 5));
 }
 
+//--------------------------------------------------
+
+//! Whether the aliases being built on this thread include the hashes of their
+//! input fxs, rather than their whole aliases.
+thread_local bool hashingInputAliases = false;
+
+//--------------------------------------------------
+
+//! Returns the hash of the fx alias, where input fxs appear by their own alias
+//! hash. The hashed alias is so bounded by the fx parameters, and does not
+//! grow with the depth of the fx tree.
+TAliasHash buildAliasHash(const TRasterFx *fx, double frame,
+                          const TRenderSettings &info) {
+  bool wasHashingInputAliases = hashingInputAliases;
+  hashingInputAliases         = true;
+
+  TAliasHash hash(fx->getAlias(frame, info));
+
+  hashingInputAliases = wasHashingInputAliases;
+  return hash;
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -191,6 +213,200 @@ inline std::string traduce(const TAffine &aff) {
 // directly
 // to an appropriate resource manager...
 
+//==============================================================================
+//
+// AliasCache  (per render instance aliases memoization)
+//
+//------------------------------------------------------------------------------
+
+/*!
+  Stores the aliases and alias hashes built during a render instance. Fx
+  aliases include those of all their input fxs, so without memoization every
+  tile computation of a deep fx tree rebuilds the whole tree description.
+  Aliases are released when no frame is being rendered, and whenever an fx
+  parameter changes.
+*/
+class AliasCache final : public TRenderResourceManager {
+  T_RENDER_RESOURCE_MANAGER
+
+  struct Key {
+    const TRasterFx *m_fx;
+    double m_frame;
+    std::string m_data;  //!< Description of the fx-specific render data.
+
+    bool operator<(const Key &other) const {
+      return m_fx < other.m_fx ||
+             (m_fx == other.m_fx &&
+              (m_frame < other.m_frame ||
+               (m_frame == other.m_frame && m_data < other.m_data)));
+    }
+  };
+
+  struct Entry {
+    TRasterFxP m_fx;  //!< Keeps the fx alive, so that its address is not
+                      //!< reused while the entry exists.
+    std::string m_alias;
+    TAliasHash m_hash;
+    bool m_hasAlias, m_hasHash;
+
+    Entry() : m_hasAlias(false), m_hasHash(false) {}
+  };
+
+  std::map<Key, Entry> m_aliases;
+  long m_paramChangesCount;
+  int m_activeFramesCount;
+
+  QMutex m_mutex;
+
+  // Upper bound to the stored aliases, as long renders may never
+  // have all frames ended at once
+  static const int c_maxAliasesCount = 4096;
+
+public:
+  AliasCache()
+      : m_paramChangesCount(TFx::getParamChangesCount())
+      , m_activeFramesCount(0) {}
+
+  static AliasCache *instance() {
+    return static_cast<AliasCache *>(
+        AliasCache::gen()->getManager(TRenderer::renderId()));
+  }
+
+  std::string getAlias(const TRasterFx *fx, double frame,
+                       const TRenderSettings &info);
+  TAliasHash getHash(const TRasterFx *fx, double frame,
+                     const TRenderSettings &info);
+
+  void onRenderFrameStart(double frame) override {
+    QMutexLocker locker(&m_mutex);
+    ++m_activeFramesCount;
+  }
+
+  void onRenderFrameEnd(double frame) override {
+    QMutexLocker locker(&m_mutex);
+    if (--m_activeFramesCount <= 0) {
+      m_activeFramesCount = 0;
+      m_aliases.clear();
+    }
+  }
+
+private:
+  static Key buildKey(const TRasterFx *fx, double frame,
+                      const TRenderSettings &info);
+
+  //! Returns the entry of the passed key, if any. The mutex must be locked.
+  Entry *find(const Key &key);
+
+  //! Returns the entry where a value built for the passed key can be stored,
+  //! or 0 if parameters changed in the meantime. The mutex must be locked.
+  Entry *store(const TRasterFx *fx, const Key &key);
+};
+
+//------------------------------------------------------------------------------
+
+class AliasCacheGenerator final : public TRenderResourceManagerGenerator {
+public:
+  AliasCacheGenerator() : TRenderResourceManagerGenerator(true) {}
+
+  TRenderResourceManager *operator()() override { return new AliasCache; }
+};
+
+MANAGER_FILESCOPE_DECLARATION(AliasCache, AliasCacheGenerator)
+
+//------------------------------------------------------------------------------
+
+AliasCache::Key AliasCache::buildKey(const TRasterFx *fx, double frame,
+                                     const TRenderSettings &info) {
+  Key key = {fx, frame, std::string()};
+
+  std::vector<TRasterFxRenderDataP>::const_iterator dt;
+  for (dt = info.m_data.begin(); dt != info.m_data.end(); ++dt)
+    if (*dt) key.m_data += (*dt)->toString() + ";";
+
+  return key;
+}
+
+//------------------------------------------------------------------------------
+
+AliasCache::Entry *AliasCache::find(const Key &key) {
+  long paramChangesCount = TFx::getParamChangesCount();
+  if (paramChangesCount != m_paramChangesCount) {
+    m_aliases.clear();
+    m_paramChangesCount = paramChangesCount;
+  }
+
+  std::map<Key, Entry>::iterator it = m_aliases.find(key);
+  return (it == m_aliases.end()) ? 0 : &it->second;
+}
+
+//------------------------------------------------------------------------------
+
+AliasCache::Entry *AliasCache::store(const TRasterFx *fx, const Key &key) {
+  if (m_paramChangesCount != TFx::getParamChangesCount()) return 0;
+
+  if ((int)m_aliases.size() >= c_maxAliasesCount &&
+      m_aliases.find(key) == m_aliases.end())
+    m_aliases.clear();
+
+  Entry &entry = m_aliases[key];
+  entry.m_fx   = const_cast<TRasterFx *>(fx);
+
+  return &entry;
+}
+
+//------------------------------------------------------------------------------
+
+std::string AliasCache::getAlias(const TRasterFx *fx, double frame,
+                                 const TRenderSettings &info) {
+  Key key = buildKey(fx, frame, info);
+
+  {
+    QMutexLocker locker(&m_mutex);
+
+    Entry *entry = find(key);
+    if (entry && entry->m_hasAlias) return entry->m_alias;
+  }
+
+  // Build the alias outside the lock - it recursively accesses the cache
+  std::string alias = fx->getAlias(frame, info);
+
+  QMutexLocker locker(&m_mutex);
+
+  if (Entry *entry = store(fx, key)) {
+    entry->m_alias    = alias;
+    entry->m_hasAlias = true;
+  }
+
+  return alias;
+}
+
+//------------------------------------------------------------------------------
+
+TAliasHash AliasCache::getHash(const TRasterFx *fx, double frame,
+                               const TRenderSettings &info) {
+  Key key = buildKey(fx, frame, info);
+
+  {
+    QMutexLocker locker(&m_mutex);
+
+    Entry *entry = find(key);
+    if (entry && entry->m_hasHash) return entry->m_hash;
+  }
+
+  TAliasHash hash = buildAliasHash(fx, frame, info);
+
+  QMutexLocker locker(&m_mutex);
+
+  if (Entry *entry = store(fx, key)) {
+    entry->m_hash    = hash;
+    entry->m_hasHash = true;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+
 //! Declares an image to be kept in cache until the render ends or is canceled.
 void addRenderCache(const std::string &alias, TImageP image) {
   TFxCacheManager::instance()->add(alias, image);
@@ -245,7 +461,7 @@ public:
     // currently handled by inserting the
     // rendering affine AFTER a getAlias call. Ever.
     std::string alias = getFxType();
-    return alias + "[" + m_fx->getAlias(frame, info) + "]";
+    return alias + "[" + m_fx->getCachedAlias(frame, info) + "]";
   }
 
   //-----------------------------------------------------------
@@ -629,7 +845,7 @@ std::string TRasterFx::getAlias(double frame,
     if (port->isConnected()) {
       TRasterFxP ifx = port->getFx();
       assert(ifx);
-      alias += ifx->getAlias(frame, info);
+      alias += ifx->getCachedAlias(frame, info);
     }
     alias += ",";
   }
@@ -646,6 +862,32 @@ std::string TRasterFx::getAlias(double frame,
 
 //--------------------------------------------------
 
+std::string TRasterFx::getCachedAlias(double frame,
+                                      const TRenderSettings &info) const {
+  if (hashingInputAliases) return getAliasHash(frame, info).toString();
+
+  // Transformer fxs are allocated for each computation, there is no point
+  // storing them. Their alias retrieves the cached one of their input.
+  AliasCache *aliasCache = AliasCache::instance();
+  if (!aliasCache || dynamic_cast<const TrFx *>(this))
+    return getAlias(frame, info);
+
+  return aliasCache->getAlias(this, frame, info);
+}
+
+//--------------------------------------------------
+
+TAliasHash TRasterFx::getAliasHash(double frame,
+                                   const TRenderSettings &info) const {
+  AliasCache *aliasCache = AliasCache::instance();
+  if (!aliasCache || dynamic_cast<const TrFx *>(this))
+    return buildAliasHash(this, frame, info);
+
+  return aliasCache->getHash(this, frame, info);
+}
+
+//--------------------------------------------------
+
 void TRasterFx::dryCompute(TRectD &rect, double frame,
                            const TRenderSettings &info) {
   if (checkActiveTimeRegion() && !getActiveTimeRegion().contains(frame)) return;
@@ -698,8 +940,9 @@ void TRasterFx::dryCompute(TRectD &rect, double frame,
     return;
   }
 
-  std::string alias = getAlias(frame, info) + "[" + ::traduce(info.m_affine) +
-                      "][" + std::to_string(info.m_bpp) + "][" +
+  std::string alias = getAliasHash(frame, info).toString() + "[" +
+                      ::traduce(info.m_affine) + "][" +
+                      std::to_string(info.m_bpp) + "][" +
                       std::to_string(info.m_linearColorSpace) + "][" +
                       std::to_string(info.m_colorSpaceGamma) + "]";
 
@@ -929,9 +1172,12 @@ void TRasterFx::compute(TTile &tile, double frame,
       TRop::toLinearRGB(tile.getRaster(), info.m_colorSpaceGamma);
   }
 
-  // Build the fx result alias (in other words, its name)
-  std::string alias = getAlias(frame, info) + "[" + ::traduce(info.m_affine) +
-                      "][" + std::to_string(info.m_bpp) + "][" +
+  // Build the fx result alias (in other words, its name). The fx alias enters
+  // by its hash - whole aliases are only needed for debugging and by the
+  // passive cache.
+  std::string alias = getAliasHash(frame, info).toString() + "[" +
+                      ::traduce(info.m_affine) + "][" +
+                      std::to_string(info.m_bpp) + "][" +
                       std::to_string(computeInLinear) + "][" +
                       std::to_string(info.m_colorSpaceGamma) + "]";
 
@@ -0,0 +1,454 @@
+// TnzCore includes
+#include "tmeshimage.h"
+#include "tthread.h"
+
+// TnzExt includes
+#include "ext/plasticdeformerstorage.h"
+
+// Qt includes
+#include <QAtomicInt>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+#include "ext/meshrasterizer.h"
+
+//********************************************************************************************
+//    Local namespace
+//********************************************************************************************
+
+namespace {
+
+const int c_minRowsPerThread = 32;
+
+//-------------------------------------------------------------------------------
+
+//! A mesh face ready to be drawn. Output coordinates are in raster pixels,
+//! texture coordinates in texture pixels - both with pixel centers at
+//! integer + 0.5 and integer coordinates respectively.
+struct RasterFace {
+  TPointD m_d[3];  //!< Output vertex coordinates, counter-clockwise
+  TPointD m_s[3];  //!< Texture vertex coordinates
+  bool m_border[3];  //!< Whether the edge (i, i + 1) is on the mesh border
+  double m_y0, m_y1;  //!< Vertical extent, including antialiased borders
+};
+
+//-------------------------------------------------------------------------------
+
+struct Premult {
+  double r, g, b, m;
+};
+
+//-------------------------------------------------------------------------------
+
+inline Premult fetch(const TRaster32P &tex, int x, int y) {
+  // The texture is surrounded by transparent pixels, like the OpenGL
+  // texture tiles with their transparent border
+  if (x < 0 || y < 0 || x >= tex->getLx() || y >= tex->getLy()) {
+    Premult p = {0.0, 0.0, 0.0, 0.0};
+    return p;
+  }
+
+  const TPixel32 &pix = tex->pixels(y)[x];
+
+  Premult p = {(double)pix.r, (double)pix.g, (double)pix.b, (double)pix.m};
+  return p;
+}
+
+//-------------------------------------------------------------------------------
+
+inline Premult sampleBilinear(const TRaster32P &tex, const TPointD &s) {
+  int x = tfloor(s.x), y = tfloor(s.y);
+  double fx = s.x - x, fy = s.y - y;
+
+  Premult p00 = fetch(tex, x, y), p10 = fetch(tex, x + 1, y),
+          p01 = fetch(tex, x, y + 1), p11 = fetch(tex, x + 1, y + 1);
+
+  double w00 = (1.0 - fx) * (1.0 - fy), w10 = fx * (1.0 - fy),
+         w01 = (1.0 - fx) * fy, w11 = fx * fy;
+
+  Premult p = {w00 * p00.r + w10 * p10.r + w01 * p01.r + w11 * p11.r,
+               w00 * p00.g + w10 * p10.g + w01 * p01.g + w11 * p11.g,
+               w00 * p00.b + w10 * p10.b + w01 * p01.b + w11 * p11.b,
+               w00 * p00.m + w10 * p10.m + w01 * p01.m + w11 * p11.m};
+  return p;
+}
+
+//-------------------------------------------------------------------------------
+
+inline void catmullRomWeights(double f, double w[4]) {
+  double f2 = f * f, f3 = f2 * f;
+
+  w[0] = 0.5 * (-f3 + 2.0 * f2 - f);
+  w[1] = 0.5 * (3.0 * f3 - 5.0 * f2 + 2.0);
+  w[2] = 0.5 * (-3.0 * f3 + 4.0 * f2 + f);
+  w[3] = 0.5 * (f3 - f2);
+}
+
+//-------------------------------------------------------------------------------
+
+inline Premult sampleBicubic(const TRaster32P &tex, const TPointD &s) {
+  int x = tfloor(s.x), y = tfloor(s.y);
+
+  double wx[4], wy[4];
+  catmullRomWeights(s.x - x, wx);
+  catmullRomWeights(s.y - y, wy);
+
+  Premult p = {0.0, 0.0, 0.0, 0.0};
+  for (int j = 0; j < 4; ++j)
+    for (int i = 0; i < 4; ++i) {
+      Premult q = fetch(tex, x - 1 + i, y - 1 + j);
+      double w  = wx[i] * wy[j];
+
+      p.r += w * q.r, p.g += w * q.g, p.b += w * q.b, p.m += w * q.m;
+    }
+
+  // Catmull-Rom overshoots - keep the result a valid premultiplied pixel
+  p.m = tcrop(p.m, 0.0, 255.0);
+  p.r = tcrop(p.r, 0.0, p.m);
+  p.g = tcrop(p.g, 0.0, p.m);
+  p.b = tcrop(p.b, 0.0, p.m);
+
+  return p;
+}
+
+//-------------------------------------------------------------------------------
+
+//! Blends a premultiplied sample over a pixel, with the specified coverage.
+inline void over(TPixel32 &pix, const Premult &src, double coverage) {
+  double k = 1.0 - src.m * coverage / 255.0;
+
+  pix.r = (int)(src.r * coverage + pix.r * k + 0.5);
+  pix.g = (int)(src.g * coverage + pix.g * k + 0.5);
+  pix.b = (int)(src.b * coverage + pix.b * k + 0.5);
+  pix.m = (int)(src.m * coverage + pix.m * k + 0.5);
+}
+
+//-------------------------------------------------------------------------------
+
+//! Blends a channel the way tglDraw() does on masks, where both its passes
+//! write all channels: first with GL_SRC_ALPHA, then with GL_ONE.
+inline int maskChannel(double c, double d, double a) {
+  double d1 = c * a + d * (1.0 - a);
+  return std::min((int)(c + d1 * (1.0 - a) + 0.5), 255);
+}
+
+//-------------------------------------------------------------------------------
+
+//! Blends a premultiplied sample over a pixel like tglDraw() does on masks.
+//! The sample is depremultiplied first, as tglDraw() textures are.
+inline void overMask(TPixel32 &pix, const Premult &src, double coverage) {
+  double a = src.m * coverage / 255.0;
+  if (a <= 0.0) return;
+
+  double k = 255.0 / src.m;
+
+  pix.r = maskChannel(std::min(src.r * k, 255.0), pix.r, a);
+  pix.g = maskChannel(std::min(src.g * k, 255.0), pix.g, a);
+  pix.b = maskChannel(std::min(src.b * k, 255.0), pix.b, a);
+  pix.m = maskChannel(255.0 * a, pix.m, a);
+}
+
+//-------------------------------------------------------------------------------
+
+//! Whether a pixel center lying exactly on the specified edge of a
+//! counter-clockwise triangle belongs to the triangle. Adjacent faces must
+//! not draw their shared edges twice.
+inline bool isTopLeft(const TPointD &a, const TPointD &b) {
+  return (a.y == b.y && b.x < a.x) || (b.y > a.y);
+}
+
+//*******************************************************************************
+//    BandRasterizer  definition
+//*******************************************************************************
+
+//! Draws all the faces, in order, on a band of raster rows.
+class BandRasterizer {
+  const TRaster32P &m_ras;
+  const TRaster32P &m_tex;
+  const std::vector<RasterFace> &m_faces;
+  MeshRasterizer::Filter m_filter;
+  bool m_isMask;
+  int m_y0, m_y1;  //!< Band rows, the last excluded
+
+public:
+  BandRasterizer(const TRaster32P &ras, const TRaster32P &tex,
+                 const std::vector<RasterFace> &faces,
+                 MeshRasterizer::Filter filter, bool isMask, int y0, int y1)
+      : m_ras(ras)
+      , m_tex(tex)
+      , m_faces(faces)
+      , m_filter(filter)
+      , m_isMask(isMask)
+      , m_y0(y0)
+      , m_y1(y1) {}
+
+  void run() {
+    for (const RasterFace &face : m_faces) {
+      if (face.m_y1 < m_y0 || face.m_y0 >= m_y1) continue;
+
+      // Like tglDraw(), draw antialiased mesh borders first, then the face
+      for (int i = 0; i < 3; ++i)
+        if (face.m_border[i]) drawBorder(face, i);
+
+      drawFace(face);
+    }
+  }
+
+private:
+  Premult sample(const TPointD &s) const {
+    return (m_filter == MeshRasterizer::BICUBIC) ? sampleBicubic(m_tex, s)
+                                                 : sampleBilinear(m_tex, s);
+  }
+
+  void blend(TPixel32 &pix, const TPointD &s, double coverage) const {
+    if (m_isMask)
+      overMask(pix, sample(s), coverage);
+    else
+      over(pix, sample(s), coverage);
+  }
+
+  void drawFace(const RasterFace &face);
+  void drawBorder(const RasterFace &face, int e);
+};
+
+//-------------------------------------------------------------------------------
+
+void BandRasterizer::drawFace(const RasterFace &face) {
+  const TPointD *d = face.m_d;
+
+  double area = cross(d[1] - d[0], d[2] - d[0]);
+  if (area <= 0.0) return;
+
+  double yMin = std::min({d[0].y, d[1].y, d[2].y}),
+         yMax = std::max({d[0].y, d[1].y, d[2].y});
+
+  // Clamp before converting - faces may extend far beyond the raster
+  int y0 = (int)std::max((double)m_y0, std::ceil(yMin - 0.5)),
+      y1 = (int)std::min(m_y1 - 1.0, std::floor(yMax - 0.5));
+
+  int lx = m_ras->getLx();
+
+  bool topLeft[3];
+  for (int i = 0; i < 3; ++i) topLeft[i] = isTopLeft(d[i], d[(i + 1) % 3]);
+
+  for (int y = y0; y <= y1; ++y) {
+    double yc = y + 0.5;
+
+    // Edge functions are linear in x along the row: w_i = a_i * x + b_i,
+    // with w_i the doubled area of the subtriangle opposed to vertex i + 2
+    double a[3], b[3];
+    double xMin = 0.0, xMax = lx - 1.0;
+
+    for (int i = 0; i < 3; ++i) {
+      const TPointD &p = d[i], &q = d[(i + 1) % 3];
+
+      a[i] = p.y - q.y;
+      b[i] = (q.x - p.x) * (yc - p.y) - (p.y - q.y) * p.x;
+
+      // Restrict the span to the pixel centers where w_i >= 0
+      if (a[i] > 0.0)
+        xMin = std::max(xMin, std::ceil(-b[i] / a[i] - 0.5));
+      else if (a[i] < 0.0)
+        xMax = std::min(xMax, std::floor(-b[i] / a[i] - 0.5));
+      else if (b[i] < 0.0 || (b[i] == 0.0 && !topLeft[i]))
+        xMax = -1.0;
+    }
+
+    if (xMin > xMax) continue;
+
+    TPixel32 *pix = m_ras->pixels(y);
+    for (int x = (int)xMin; x <= (int)xMax; ++x) {
+      double xc = x + 0.5;
+
+      double w[3];
+      bool inside = true;
+      for (int i = 0; i < 3; ++i) {
+        w[i] = a[i] * xc + b[i];
+        if (w[i] < 0.0 || (w[i] == 0.0 && !topLeft[i])) inside = false;
+      }
+      if (!inside) continue;
+
+      // Barycentric coordinates - the weight of vertex i is the area
+      // opposed to it, that is the one of edge (i + 1, i + 2)
+      double l0 = w[1] / area, l1 = w[2] / area, l2 = w[0] / area;
+
+      TPointD s = l0 * face.m_s[0] + l1 * face.m_s[1] + l2 * face.m_s[2];
+      blend(pix[x], s, 1.0);
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------
+
+void BandRasterizer::drawBorder(const RasterFace &face, int e) {
+  // Emulates a 1 pixel wide GL_LINE_SMOOTH line: pixels are covered
+  // proportionally to their distance from the segment
+  const TPointD &p = face.m_d[e], &q = face.m_d[(e + 1) % 3];
+  const TPointD &sp = face.m_s[e], &sq = face.m_s[(e + 1) % 3];
+
+  TPointD dir = q - p;
+  double len2 = dir * dir;
+  if (len2 <= 0.0) return;
+
+  int x0 = (int)std::max(0.0, std::floor(std::min(p.x, q.x) - 1.0)),
+      x1 = (int)std::min(m_ras->getLx() - 1.0,
+                         std::ceil(std::max(p.x, q.x) + 1.0));
+  int y0 = (int)std::max((double)m_y0, std::floor(std::min(p.y, q.y) - 1.0)),
+      y1 = (int)std::min(m_y1 - 1.0, std::ceil(std::max(p.y, q.y) + 1.0));
+
+  for (int y = y0; y <= y1; ++y) {
+    TPixel32 *pix = m_ras->pixels(y);
+
+    for (int x = x0; x <= x1; ++x) {
+      TPointD c(x + 0.5, y + 0.5);
+
+      double t     = tcrop(((c - p) * dir) / len2, 0.0, 1.0);
+      double dist  = norm(c - (p + t * dir));
+      double cover = 1.0 - dist;
+      if (cover <= 0.0) continue;
+
+      blend(pix[x], sp + t * (sq - sp), cover);
+    }
+  }
+}
+
+//*******************************************************************************
+//    RasterizeJob  definition
+//*******************************************************************************
+
+//! Shares the bands of a raster among the threads calling run().
+class RasterizeJob {
+  const TRaster32P &m_ras;
+  const TRaster32P &m_tex;
+  const std::vector<RasterFace> &m_faces;
+  MeshRasterizer::Filter m_filter;
+  bool m_isMask;
+  int m_bandsCount;
+
+  QAtomicInt m_nextBand;
+
+public:
+  RasterizeJob(const TRaster32P &ras, const TRaster32P &tex,
+               const std::vector<RasterFace> &faces,
+               MeshRasterizer::Filter filter, bool isMask, int bandsCount)
+      : m_ras(ras)
+      , m_tex(tex)
+      , m_faces(faces)
+      , m_filter(filter)
+      , m_isMask(isMask)
+      , m_bandsCount(bandsCount)
+      , m_nextBand(0) {}
+
+  void run() {
+    int ly = m_ras->getLy(), band;
+    while ((band = m_nextBand.fetchAndAddOrdered(1)) < m_bandsCount)
+      BandRasterizer(m_ras, m_tex, m_faces, m_filter, m_isMask,
+                     ly * band / m_bandsCount, ly * (band + 1) / m_bandsCount)
+          .run();
+  }
+};
+
+}  // namespace
+
+//********************************************************************************************
+//    MeshRasterizer  implementation
+//********************************************************************************************
+
+void MeshRasterizer::rasterize(const TRaster32P &ras, const TMeshImage &image,
+                               const TRaster32P &tex, const TRectD &texGeom,
+                               const TAffine &meshToTexAff,
+                               const PlasticDeformerDataGroup &group,
+                               const TAffine &deformedToRasAff, Filter filter,
+                               bool isMask) {
+  if (!ras || !tex || texGeom.isEmpty()) return;
+
+  // Map texture coordinates to texture pixels, centers on integers
+  const TAffine &meshToTexRasAff =
+      TTranslation(-0.5, -0.5) *
+      TScale(tex->getLx() / texGeom.getLx(), tex->getLy() / texGeom.getLy()) *
+      TTranslation(-texGeom.x0, -texGeom.y0) * meshToTexAff;
+
+  // Prepare the faces, in the group's stacking order
+  const std::vector<TTextureMeshP> &meshes = image.meshes();
+
+  typedef std::vector<std::pair<int, int>> SortedFacesVector;
+  const SortedFacesVector &sortedFaces = group.m_sortedFaces;
+
+  std::vector<RasterFace> faces;
+  faces.reserve(sortedFaces.size());
+
+  SortedFacesVector::const_iterator sft, sfEnd(sortedFaces.end());
+  for (sft = sortedFaces.begin(); sft != sfEnd; ++sft) {
+    int f = sft->first, m = sft->second;
+
+    const TTextureMesh *mesh = meshes[m].getPointer();
+    const double *dstCoords  = group.m_datas[m].m_output.get();
+
+    const TTextureMesh::face_type &fc = mesh->face(f);
+
+    const TTextureMesh::edge_type &ed0 = mesh->edge(fc.edge(0)),
+                                  &ed1 = mesh->edge(fc.edge(1)),
+                                  &ed2 = mesh->edge(fc.edge(2));
+
+    // Same vertices extraction as tglDraw()
+    int v[3];
+    v[0] = ed0.vertex(0);
+    v[1] = ed0.vertex(1);
+    v[2] = ed1.vertex((ed1.vertex(0) == v[0]) | (ed1.vertex(0) == v[1]));
+
+    // ed1 joins v[2] to one of the others
+    bool ed1JoinsV1 = (ed1.vertex(0) == v[1]) | (ed1.vertex(1) == v[1]);
+
+    RasterFace face;
+    for (int i = 0; i < 3; ++i) {
+      face.m_d[i] = deformedToRasAff *
+                    TPointD(dstCoords[v[i] << 1], dstCoords[(v[i] << 1) + 1]);
+      face.m_s[i] = meshToTexRasAff * mesh->vertex(v[i]).P();
+    }
+
+    face.m_border[0] = (ed0.facesCount() < 2);                     // (0, 1)
+    face.m_border[1] = ((ed1JoinsV1 ? ed1 : ed2).facesCount() < 2);  // (1, 2)
+    face.m_border[2] = ((ed1JoinsV1 ? ed2 : ed1).facesCount() < 2);  // (2, 0)
+
+    // Make the face counter-clockwise
+    if (cross(face.m_d[1] - face.m_d[0], face.m_d[2] - face.m_d[0]) < 0.0) {
+      std::swap(face.m_d[1], face.m_d[2]);
+      std::swap(face.m_s[1], face.m_s[2]);
+      std::swap(face.m_border[0], face.m_border[2]);
+    }
+
+    face.m_y0 =
+        std::min({face.m_d[0].y, face.m_d[1].y, face.m_d[2].y}) - 1.0;
+    face.m_y1 =
+        std::max({face.m_d[0].y, face.m_d[1].y, face.m_d[2].y}) + 1.0;
+
+    if (face.m_y1 < 0.0 || face.m_y0 >= ras->getLy()) continue;
+
+    faces.push_back(face);
+  }
+
+  if (faces.empty()) return;
+
+  // Split the raster rows in bands. Each band draws all the faces in order,
+  // so bands don't need to synchronize. Idle threads of the shared helper
+  // pool take part.
+  int ly           = ras->getLy();
+  int threadAmount = std::min(QThread::idealThreadCount(),
+                              ly / c_minRowsPerThread);
+
+  ras->lock();
+  tex->lock();
+
+  if (threadAmount <= 1)
+    BandRasterizer(ras, tex, faces, filter, isMask, 0, ly).run();
+  else {
+    RasterizeJob job(ras, tex, faces, filter, isMask, threadAmount);
+    TThread::runConcurrently([&job]() { job.run(); }, threadAmount - 1);
+  }
+
+  tex->unlock();
+  ras->unlock();
+}
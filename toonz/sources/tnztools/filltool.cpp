@@ -3136,6 +3136,13 @@ void FillTool::onActivate() {
     }
   }
 
+  if (m_targetType == TTool::ToonzImage) {
+    // The scene may have changed while the tool was inactive
+    FillReferenceCache::instance()->invalidate();
+    ToolUtils::connectFillReferenceChanges(this, SLOT(onReferenceChanged()),
+                                           true);
+  }
+
   if (m_fillType.getValue() != NORMALFILL) {
     m_rectFill->onActivate();
     return;
@@ -3184,6 +3191,14 @@ void FillTool::onDeactivate() {
              this, SLOT(onFrameSwitched()));
   disconnect(TTool::m_application->getCurrentColumn(),
              SIGNAL(columnIndexSwitched()), this, SLOT(onFrameSwitched()));
+  ToolUtils::connectFillReferenceChanges(this, SLOT(onReferenceChanged()),
+                                         false);
+}
+
+//-----------------------------------------------------------------------------
+
+void FillTool::onReferenceChanged() {
+  FillReferenceCache::instance()->invalidate();
 }
 
 //-----------------------------------------------------------------------------
@@ -172,6 +172,7 @@ private:
 
 public slots:
   void onFrameSwitched() override;
+  void onReferenceChanged();
 };
 
 #endif  // FILLTOOL_H
@@ -413,6 +413,20 @@ void FullColorFillTool::onActivate() {
   m_frameRange.setIndex(FullColorFillRange);
 
   resetMulti();
+
+  // The scene may have changed while the tool was inactive
+  FillReferenceCache::instance()->invalidate();
+  ToolUtils::connectFillReferenceChanges(this, SLOT(onReferenceChanged()),
+                                         true);
+}
+
+void FullColorFillTool::onDeactivate() {
+  ToolUtils::connectFillReferenceChanges(this, SLOT(onReferenceChanged()),
+                                         false);
+}
+
+void FullColorFillTool::onReferenceChanged() {
+  FillReferenceCache::instance()->invalidate();
 }
 
 int FullColorFillTool::getCursorId() const {
@@ -24,7 +24,7 @@
 #define EASE_IN_OUT_INTERPOLATION L"Ease In/Out"
 
 class FullColorFillTool final : public QObject, public TTool {
-  Q_DECLARE_TR_FUNCTIONS(FullColorFillTool)
+  Q_OBJECT
 
   TXshSimpleLevelP m_level;
   TDoublePairProperty m_fillDepth;
@@ -63,6 +63,7 @@ public:
   bool onPropertyChanged(std::string propertyName) override;
 
   void onActivate() override;
+  void onDeactivate() override;
   int getCursorId() const override;
 
   void draw() override;
@@ -79,6 +80,9 @@ private:
   void processSequence(const TPointD &pos, FillParameters &params,
                        int closeStyleIndex, TXsheet *xsheet, int firstFidx,
                        int lastFidx, int multi);
+
+public slots:
+  void onReferenceChanged();
 };
 
 #endif  // FULLCOLORFILLTOOL_H
\ No newline at end of file
@@ -1897,3 +1897,31 @@ bool ToolUtils::renumberForInsertFId(TXshSimpleLevel *sl, const TFrameId &fid,
 
   return true;
 }
+
+//-----------------------------------------------------------------------------
+
+void ToolUtils::connectFillReferenceChanges(QObject *receiver, const char *slot,
+                                            bool connected) {
+  TTool::Application *app = TTool::getApplication();
+  if (!app) return;
+
+  // Edits of the levels, their palettes, the xsheet or the camera
+  const std::pair<QObject *, const char *> notifications[] = {
+      {app->getCurrentScene(), SIGNAL(sceneSwitched())},
+      {app->getCurrentScene(), SIGNAL(sceneChanged())},
+      {app->getCurrentXsheet(), SIGNAL(xsheetSwitched())},
+      {app->getCurrentXsheet(), SIGNAL(xsheetChanged())},
+      {app->getCurrentLevel(), SIGNAL(xshLevelChanged())},
+      {app->getCurrentObject(), SIGNAL(objectChanged(bool))},
+      {app->getCurrentPalette(), SIGNAL(paletteChanged())},
+      {app->getCurrentPalette(), SIGNAL(colorStyleChanged(bool))}};
+
+  for (const auto &notification : notifications) {
+    if (connected)
+      QObject::connect(notification.first, notification.second, receiver,
+                       slot, Qt::UniqueConnection);
+    else
+      QObject::disconnect(notification.first, notification.second, receiver,
+                          slot);
+  }
+}
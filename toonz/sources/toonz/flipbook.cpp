@@ -70,6 +70,7 @@
 
 // Qt includes
 #include <QApplication>
+#include <QMutex>
 #include <QScreen>
 #include <QSettings>
 #include <QPainter>
@@ -1033,7 +1034,8 @@ void FlipBook::setLevel(const TFilePath &fp, TPalette *palette, int from,
       clearCache();
       m_levelNames.clear();
       m_levels.clear();
-    }
+    } else
+      clearPrefetchedImages();
     m_snd = 0;
     m_xl  = 0;
 
@@ -1323,6 +1325,8 @@ void FlipBook::setLevel(TXshSimpleLevel *xl) {
 void FlipBook::setLevel(TFx *previewedFx, TXsheet *xsh, TLevel *level,
                         TPalette *palette, int from, int to, int step,
                         int currentFrame, TSoundTrack *snd) {
+  clearPrefetchedImages();
+
   m_xl          = 0;
   m_previewedFx = previewedFx;
   m_previewXsh  = xsh;
@@ -1524,6 +1528,114 @@ void FlipBook::playAudioFrame(int frame) {
 
 //-----------------------------------------------------------------------------
 
+namespace {
+
+//! Loads a frame of a level file the way the flipbook shows it. An empty
+//! loadbox loads the whole frame.
+TImageP loadViewedFrame(const TLevelReaderP &lr, const TFrameId &fid,
+                        int shrink, double colorSpaceGamma,
+                        const TRect &loadbox, bool premultiply,
+                        bool read16Bit, TPalette *flipPalette) {
+  TFilePath fp = lr->getFilePath();
+
+  int lx = 0, oriLx = 0;
+  // try to get image info only when loading tlv or pli as it is quite time
+  // consuming
+  if (fp.getType() == "tlv" || fp.getType() == "pli") {
+    if (lr->getImageInfo()) lx = oriLx = lr->getImageInfo()->m_lx;
+  }
+  TImageReaderP ir = lr->getFrameReader(fid);
+  ir->setShrink(shrink);
+  ir->setColorSpaceGamma(colorSpaceGamma);
+  if (loadbox != TRect()) {
+    ir->setRegion(loadbox);
+    lx = loadbox.getLx();
+  }
+
+  if (read16Bit) ir->enable16BitRead(true);
+
+  // always enable to load float-format images
+  ir->enableFloatRead(true);
+
+  TImageP img = ir->load();
+  if (!img) return img;
+
+  TRasterImageP ri = ((TRasterImageP)img);
+  TToonzImageP ti  = ((TToonzImageP)img);
+  if (premultiply) {
+    if (ri)
+      TRop::premultiply(ri->getRaster());
+    else if (ti)
+      TRop::premultiply(ti->getRaster());
+  }
+
+  // se e' stata caricata una sottoimmagine alcuni formati in realta'
+  // caricano tutto il raster e fanno extract, non si ha quindi alcun
+  // risparmio di occupazione di memoria; alloco un raster grande
+  // giusto copio la region e butto quello originale.
+  if (ri && loadbox != TRect() &&
+      ri->getRaster()->getLx() == oriLx)  // questo serve perche' per avi e
+                                          // mov la setRegion e'
+                                          // completamente ignorata...
+    ri->setRaster(ri->getRaster()->extract(loadbox)->clone());
+  else if (ri && ri->getRaster()->getWrap() > ri->getRaster()->getLx())
+    ri->setRaster(ri->getRaster()->clone());
+  else if (ti && ti->getCMapped()->getWrap() > ti->getCMapped()->getLx())
+    ti->setCMapped(ti->getCMapped()->clone());
+
+  if ((fp.getType() == "tlv" || fp.getType() == "pli") && shrink > 1 &&
+      (lx == 0 || (ri && ri->getRaster()->getLx() == lx) ||
+       (ti && ti->getRaster()->getLx() == lx))) {
+    if (ri)
+      ri->setRaster(TRop::shrink(ri->getRaster(), shrink));
+    else if (ti)
+      ti->setCMapped(TRop::shrink(ti->getRaster(), shrink));
+  }
+
+  TPalette *palette = img->getPalette();
+  if (flipPalette && (!palette || palette != flipPalette))
+    img->setPalette(flipPalette);
+
+  return img;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+//! Returns the index of the viewed level shown at the specified frame, or -1,
+//! and the level frame in fid.
+int FlipBook::findLevelFrame(int frame, TFrameId &fid) {
+  int from, to, step;
+  m_flipConsole->getFrameRange(from, to, step);
+
+  int frameIndex = m_previewedFx ? ((frame - from) / step) + 1 : frame;
+
+  int i = 0;
+  // Search all subsequent levels on the flipbook and retrieve the one
+  // containing the required frame
+  for (i = 0; i < m_levels.size(); i++) {
+    int frameIndexesCount = m_levels[i].getIndexesCount();
+    if (frameIndex > 0 && frameIndex <= frameIndexesCount) break;
+    frameIndex -= frameIndexesCount;
+  }
+
+  if (i == m_levels.size() || frame < 0) return -1;
+
+  fid = m_levels[i].flipbookIndexToLevelFrame(frameIndex);
+  return i;
+}
+
+//-----------------------------------------------------------------------------
+
+std::string FlipBook::getImageId(int levelIndex, const TFrameId &fid) const {
+  return m_levelNames[levelIndex].toStdString() +
+         fid.expand(TFrameId::NO_PAD) +
+         ((m_isPreviewFx) ? "" : ::to_string(this));
+}
+
+//-----------------------------------------------------------------------------
+
 TImageP FlipBook::getCurrentImage(int frame) {
   std::string id = "";
   TFrameId fid;
@@ -1538,28 +1650,16 @@ TImageP FlipBook::getCurrentImage(int frame) {
   if (m_xl)  // is an xsheet level
   {
     if (m_xl->getFrameCount() <= 0) return 0;
-    return m_xl->getFrame(m_xl->index2fid(frame - 1), false);
+    fid = m_xl->index2fid(frame - 1);
+    if (TImageP img =
+            takePrefetchedImage(frame, m_xl->getImageId(fid), TRect()))
+      return img;
+    return m_xl->getFrame(fid, false);
   } else if (!m_levels.empty())  // is a viewfile or a previewFx
   {
     TLevelP level;
-    QString levelName;
-    int from, to, step;
-    m_flipConsole->getFrameRange(from, to, step);
-
-    int frameIndex = m_previewedFx ? ((frame - from) / step) + 1 : frame;
-
-    int i = 0;
-    // Search all subsequent levels on the flipbook and retrieve the one
-    // containing the required frame
-    for (i = 0; i < m_levels.size(); i++) {
-      int frameIndexesCount = m_levels[i].getIndexesCount();
-      if (frameIndex > 0 && frameIndex <= frameIndexesCount) break;
-      frameIndex -= frameIndexesCount;
-    }
-
-    if (i == m_levels.size() || frame < 0) return 0;
-
-    frame--;
+    int i = findLevelFrame(frame, fid);
+    if (i < 0) return 0;
 
     // Now, get the right frame from the level
 
@@ -1567,14 +1667,11 @@ TImageP FlipBook::getCurrentImage(int frame) {
     fp                  = m_levels[i].m_fp;  // fp=empty when previewing fx
     randomAccessRead    = m_levels[i].m_randomAccessRead;
     incrementalIndexing = m_levels[i].m_incrementalIndexing;
-    levelName           = m_levelNames[i];
-    fid                 = m_levels[i].flipbookIndexToLevelFrame(frameIndex);
     premultiply         = m_levels[i].m_premultiply;
     colorSpaceGamma     = m_levels[i].m_colorSpaceGamma;
 
     if (fid == TFrameId()) return 0;
-    id = levelName.toStdString() + fid.expand(TFrameId::NO_PAD) +
-         ((m_isPreviewFx) ? "" : ::to_string(this));
+    id = getImageId(i, fid);
 
     if (!m_isPreviewFx) {
       m_title1 = m_viewerTitle + " :: " + fp.withoutParentDir().withFrame(fid);
@@ -1589,6 +1686,16 @@ TImageP FlipBook::getCurrentImage(int frame) {
 
   bool showSub = m_flipConsole->isChecked(FlipConsole::eUseLoadBox);
 
+  // The frame may have been loaded in advance while playing
+  if (fp != TFilePath() && !m_isPreviewFx) {
+    TRect loadbox = showSub ? m_loadbox : TRect();
+    if (TImageP img = takePrefetchedImage(frame, id, loadbox)) {
+      TImageCache::instance()->add(id, img);
+      m_loadboxes[id] = loadbox;
+      return img;
+    }
+  }
+
   if (TImageCache::instance()->isCached(id)) {
     TRect loadbox;
     std::map<std::string, TRect>::const_iterator it = m_loadboxes.find(id);
@@ -1604,70 +1711,19 @@ TImageP FlipBook::getCurrentImage(int frame) {
       TImageCache::instance()->remove(id);
   }
   if (fp != TFilePath() && !m_isPreviewFx) {
-    int lx = 0, oriLx = 0;
     // TLevelReaderP lr(fp);
     if (!m_lr || (fp != m_lr->getFilePath())) {
       m_lr = TLevelReaderP(fp);
       m_lr->enableRandomAccessRead(randomAccessRead);
     }
     if (!m_lr) return 0;
-    // try to get image info only when loading tlv or pli as it is quite time
-    // consuming
-    if (fp.getType() == "tlv" || fp.getType() == "pli") {
-      if (m_lr->getImageInfo()) lx = oriLx = m_lr->getImageInfo()->m_lx;
-    }
-    TImageReaderP ir = m_lr->getFrameReader(fid);
-    ir->setShrink(m_shrink);
-    ir->setColorSpaceGamma(colorSpaceGamma);
-    if (m_loadbox != TRect() && showSub) {
-      ir->setRegion(m_loadbox);
-      lx = m_loadbox.getLx();
-    }
 
-    if (Preferences::instance()->is30bitDisplayEnabled())
-      ir->enable16BitRead(true);
-
-    // always enable to load float-format images
-    ir->enableFloatRead(true);
-
-    TImageP img = ir->load();
+    TImageP img = loadViewedFrame(
+        m_lr, fid, m_shrink, colorSpaceGamma, showSub ? m_loadbox : TRect(),
+        premultiply, Preferences::instance()->is30bitDisplayEnabled(),
+        m_palette);
 
     if (img) {
-      TRasterImageP ri = ((TRasterImageP)img);
-      TToonzImageP ti  = ((TToonzImageP)img);
-      if (premultiply) {
-        if (ri)
-          TRop::premultiply(ri->getRaster());
-        else if (ti)
-          TRop::premultiply(ti->getRaster());
-      }
-
-      // se e' stata caricata una sottoimmagine alcuni formati in realta'
-      // caricano tutto il raster e fanno extract, non si ha quindi alcun
-      // risparmio di occupazione di memoria; alloco un raster grande
-      // giusto copio la region e butto quello originale.
-      if (ri && showSub && m_loadbox != TRect() &&
-          ri->getRaster()->getLx() == oriLx)  // questo serve perche' per avi e
-                                              // mov la setRegion e'
-                                              // completamente ignorata...
-        ri->setRaster(ri->getRaster()->extract(m_loadbox)->clone());
-      else if (ri && ri->getRaster()->getWrap() > ri->getRaster()->getLx())
-        ri->setRaster(ri->getRaster()->clone());
-      else if (ti && ti->getCMapped()->getWrap() > ti->getCMapped()->getLx())
-        ti->setCMapped(ti->getCMapped()->clone());
-
-      if ((fp.getType() == "tlv" || fp.getType() == "pli") && m_shrink > 1 &&
-          (lx == 0 || (ri && ri->getRaster()->getLx() == lx) ||
-           (ti && ti->getRaster()->getLx() == lx))) {
-        if (ri)
-          ri->setRaster(TRop::shrink(ri->getRaster(), m_shrink));
-        else if (ti)
-          ti->setCMapped(TRop::shrink(ti->getRaster(), m_shrink));
-      }
-
-      TPalette *palette = img->getPalette();
-      if (m_palette && (!palette || palette != m_palette))
-        img->setPalette(m_palette);
       TImageCache::instance()->add(id, img);
       m_loadboxes[id] = showSub ? m_loadbox : TRect();
     }
@@ -1727,6 +1783,136 @@ void FlipBook::onDrawFrame(int frame, const ImagePainter::VisualSettings &vs,
 
 //-----------------------------------------------------------------------------
 
+//! Returns the image of the specified frame loaded in advance, provided it
+//! was built for the specified image id, with the current shrink and the
+//! specified loadbox.
+TImageP FlipBook::takePrefetchedImage(int frame, const std::string &id,
+                                      const TRect &loadbox) {
+  TImageP img = m_flipConsole->takePrefetchedImage(frame);
+  if (!img) return img;
+
+  std::map<int, PrefetchedBuild>::const_iterator it =
+      m_prefetchedBuilds.find(frame);
+  if (it == m_prefetchedBuilds.end() || it->second.m_id != id ||
+      it->second.m_loadbox != loadbox || it->second.m_shrink != m_shrink)
+    return TImageP();
+
+  return img;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Drops the frames loaded in advance, which the level, shrink or loadbox
+//! changes make stale.
+void FlipBook::clearPrefetchedImages() {
+  m_flipConsole->clearPrefetchedImages();
+  m_prefetchedBuilds.clear();
+  m_prefetchReaders.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+//! The level readers of a file shared by the frames loaded in advance. Each
+//! build takes a reader no other build is using, so that a file is opened
+//! once per concurrent build rather than once per frame.
+class FlipBook::ReaderPool {
+  TFilePath m_fp;
+  bool m_randomAccessRead, m_keepOpened;
+
+  QMutex m_mutex;
+  std::vector<TLevelReaderP> m_readers;  // Not in use
+
+public:
+  ReaderPool(const TFilePath &fp, bool randomAccessRead, bool keepOpened)
+      : m_fp(fp)
+      , m_randomAccessRead(randomAccessRead)
+      , m_keepOpened(keepOpened) {}
+
+  TLevelReaderP acquire() {
+    {
+      QMutexLocker sl(&m_mutex);
+      if (!m_readers.empty()) {
+        TLevelReaderP lr = m_readers.back();
+        m_readers.pop_back();
+        return lr;
+      }
+    }
+
+    TLevelReaderP lr(m_fp);
+    if (lr) lr->enableRandomAccessRead(m_randomAccessRead);
+    return lr;
+  }
+
+  void release(const TLevelReaderP &lr) {
+    if (!m_keepOpened) return;
+
+    QMutexLocker sl(&m_mutex);
+    m_readers.push_back(lr);
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+//! Frames of level files are loaded in advance through pooled level readers,
+//! except for movies, whose frames are better decoded in sequence.
+PlaybackPrefetcher::FrameBuilder FlipBook::getFrameBuilder(int frame) {
+  if (m_xl) {
+    if (m_xl->getFrameCount() <= 0) return PlaybackPrefetcher::FrameBuilder();
+
+    // The level frames may be edited while building: look the frame up here
+    TXshSimpleLevelP xl = m_xl;
+    TFrameId fid        = m_xl->index2fid(frame - 1);
+    if (!m_xl->isFid(fid)) return PlaybackPrefetcher::FrameBuilder();
+
+    std::string id            = m_xl->getImageId(fid);
+    PrefetchedBuild build     = {id, TRect(), m_shrink};
+    m_prefetchedBuilds[frame] = build;
+    return [xl, fid, id]() { return xl->getFrameById(id, fid); };
+  }
+
+  if (m_levels.empty() || m_isPreviewFx)
+    return PlaybackPrefetcher::FrameBuilder();
+
+  TFrameId fid;
+  int i = findLevelFrame(frame, fid);
+  if (i < 0 || fid == TFrameId()) return PlaybackPrefetcher::FrameBuilder();
+
+  const Level &level = m_levels[i];
+  std::string id     = getImageId(i, fid);
+  if (level.m_fp == TFilePath() || isMovieType(level.m_fp) ||
+      TImageCache::instance()->isCached(id))
+    return PlaybackPrefetcher::FrameBuilder();
+
+  std::shared_ptr<ReaderPool> &readers = m_prefetchReaders[level.m_fp];
+  if (!readers)
+    readers.reset(new ReaderPool(level.m_fp, level.m_randomAccessRead,
+                                 !(m_flags & eDontKeepFilesOpened)));
+
+  bool premultiply  = level.m_premultiply;
+  double gamma      = level.m_colorSpaceGamma;
+  int shrink        = m_shrink;
+  TRect loadbox     = m_flipConsole->isChecked(FlipConsole::eUseLoadBox)
+                          ? m_loadbox
+                          : TRect();
+  bool read16Bit    = Preferences::instance()->is30bitDisplayEnabled();
+  TPaletteP palette = m_palette;
+
+  PrefetchedBuild build     = {id, loadbox, shrink};
+  m_prefetchedBuilds[frame] = build;
+
+  return [=]() {
+    TLevelReaderP lr = readers->acquire();
+    if (!lr) return TImageP();
+
+    TImageP img = loadViewedFrame(lr, fid, shrink, gamma, loadbox,
+                                  premultiply, read16Bit, palette.getPointer());
+    readers->release(lr);
+    return img;
+  };
+}
+
+//-----------------------------------------------------------------------------
+
 void FlipBook::swapBuffers() { m_imageViewer->doSwapBuffers(); }
 
 //-----------------------------------------------------------------------------
@@ -1740,6 +1926,7 @@ void FlipBook::changeSwapBehavior(bool enable) {
 void FlipBook::setLoadbox(const TRect &box) {
   m_loadbox =
       (m_dim.lx > 0) ? box * TRect(0, 0, m_dim.lx - 1, m_dim.ly - 1) : box;
+  clearPrefetchedImages();
 }
 
 //----------------------------------------------------------------
@@ -1747,6 +1934,8 @@ void FlipBook::setLoadbox(const TRect &box) {
 void FlipBook::clearCache() {
   TLevel::Iterator it;
 
+  clearPrefetchedImages();
+
   if (m_levelNames.empty()) return;
   int i;
 
@@ -1904,6 +2093,8 @@ void FlipBook::dropEvent(QDropEvent *e) {
 //-------------------------------------------------------------------
 
 void FlipBook::reset() {
+  clearPrefetchedImages();
+
   if (!m_isPreviewFx)  // The cache is owned by the PreviewFxManager otherwise
     clearCache();
   else
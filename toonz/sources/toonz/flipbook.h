@@ -16,6 +16,8 @@
 
 #include <QTimer>
 
+#include <memory>
+
 #include "toonzqt/flipconsoleowner.h"
 
 class QPoint;
@@ -124,6 +126,19 @@ protected:
   TDimension m_dim;
   std::map<std::string, TRect>
       m_loadboxes;  // id in the cash, rect loaded actually
+
+  // Frames loaded in advance while playing: the image id, loadbox and shrink
+  // of the last build scheduled for each one
+  struct PrefetchedBuild {
+    std::string m_id;
+    TRect m_loadbox;
+    int m_shrink;
+  };
+  std::map<int, PrefetchedBuild> m_prefetchedBuilds;
+
+  class ReaderPool;
+  std::map<TFilePath, std::shared_ptr<ReaderPool>> m_prefetchReaders;
+
   class Level {
   public:
     Level(const TLevelP &level, const TFilePath &fp, int fromIndex, int toIndex,
@@ -259,6 +274,7 @@ public:
 
   void swapBuffers() override;
   void changeSwapBehavior(bool enable) override;
+  PlaybackPrefetcher::FrameBuilder getFrameBuilder(int frame) override;
 
 private:
   // When viewing the tlv, try to cache all frames at the beginning.
@@ -276,6 +292,11 @@ protected:
   void dropEvent(QDropEvent *e) override;
 
   void playAudioFrame(int frame);
+  int findLevelFrame(int frame, TFrameId &fid);
+  std::string getImageId(int levelIndex, const TFrameId &fid) const;
+  TImageP takePrefetchedImage(int frame, const std::string &id,
+                              const TRect &loadbox);
+  void clearPrefetchedImages();
   TImageP getCurrentImage(int frame);
 
   void showEvent(QShowEvent *e) override;
@@ -1334,6 +1334,8 @@ QString PreferencesPopup::getUIString(PreferencesItemId id) {
       // Visualization
       {show0ThickLines, tr("Show Lines with Thickness 0")},
       {regionAntialias, tr("Antialiased Region Boundaries")},
+      {cpuVectorRendering, tr("Render Vector Levels without OpenGL")},
+      {cpuMeshRendering, tr("Render Plastic Deformations without OpenGL")},
 
       // Loading
       {importPolicy, tr("Default File Import Behavior:")},
@@ -1933,6 +1935,8 @@ QWidget* PreferencesPopup::createVisualizationPage() {
 
   insertUI(show0ThickLines, lay);
   insertUI(regionAntialias, lay);
+  insertUI(cpuVectorRendering, lay);
+  insertUI(cpuMeshRendering, lay);
 
   lay->setRowStretch(lay->rowCount(), 1);
   widget->setLayout(lay);
@@ -51,6 +51,8 @@
 #include "toonz/preferences.h"
 #include "toonz/fullcolorpalette.h"
 #include "toonz/txshsoundcolumn.h"
+#include "toonz/txsheet.h"
+#include "toonz/imagemanager.h"
 
 #include "toonzqt/tabbar.h"
 
@@ -541,6 +543,17 @@ void TApp::onFrameSwitched() {
       !Preferences::instance()->isUseArrowKeyToShiftCellSelectionEnabled()) {
     sel->selectNone();
   }
+
+  // Load ahead the frames following the current one, dropping the requests
+  // for the frames left behind
+  ImageManager::instance()->cancelPrefetches();
+  if (m_currentFrame->isEditingScene() && row >= 0) {
+    static const int PrefetchRows = 8;
+
+    std::vector<int> rows;
+    for (int r = row + 1; r <= row + PrefetchRows; ++r) rows.push_back(r);
+    m_currentXsheet->getXsheet()->prefetchRows(rows);
+  }
 }
 
 //-----------------------------------------------------------------------------
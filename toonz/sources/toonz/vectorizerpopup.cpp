@@ -27,6 +27,7 @@
 #include "toonz/txshcell.h"
 #include "toonz/toonzscene.h"
 #include "toonz/tcenterlinevectorizer.h"
+#include "toonz/levelvectorizer.h"
 #include "toonz/dpiscale.h"
 #include "toonz/txshchildlevel.h"
 #include "toonz/levelset.h"
@@ -65,6 +66,9 @@
 #include <QMainWindow>
 #include <QToolButton>
 
+// STD includes
+#include <deque>
+
 using namespace DVGui;
 
 //********************************************************************************
@@ -222,24 +226,6 @@ Vectorizer::~Vectorizer() {
 
 //-----------------------------------------------------------------------------
 
-TVectorImageP Vectorizer::doVectorize(TImageP img, TPalette *palette,
-                                      const VectorizerConfiguration &conf) {
-  TToonzImageP ti  = img;
-  TRasterImageP ri = img;
-
-  if (!ti && !ri) return TVectorImageP();
-
-  VectorizerCore vCore;
-  connect(&vCore, SIGNAL(partialDone(int, int)), this,
-          SIGNAL(partialDone(int, int)));
-  connect(this, SIGNAL(transmitCancel()), &vCore, SLOT(onCancel()),
-          Qt::DirectConnection);  // Direct connection *must* be
-                                  // established for child cancels
-  return vCore.vectorize(img, conf, palette);
-}
-
-//-----------------------------------------------------------------------------
-
 void Vectorizer::setLevel(const TXshSimpleLevelP &level) {
   m_level = level;
 
@@ -321,26 +307,6 @@ void Vectorizer::setLevel(const TXshSimpleLevelP &level) {
 //-----------------------------------------------------------------------------
 
 int Vectorizer::doVectorize() {
-  struct {
-    Vectorizer *m_this;
-
-    CenterlineConfiguration m_cConf;
-    NewOutlineConfiguration m_oConf;
-
-    void updateConfig(double weight) {
-      if (m_this->m_params.m_isOutline)
-        m_oConf = m_this->m_params.getOutlineConfiguration(weight);
-      else
-        m_cConf = m_this->m_params.getCenterlineConfiguration(weight);
-    }
-
-  } locals = {this};
-
-  VectorizerConfiguration &configuration =
-      m_params.m_isOutline
-          ? static_cast<VectorizerConfiguration &>(locals.m_oConf)
-          : static_cast<VectorizerConfiguration &>(locals.m_cConf);
-
   if (!m_vLevel) return 0;
 
   if (m_dialog->getChoice() == OverwriteDialog::KEEP_OLD && m_dialogShown)
@@ -355,8 +321,33 @@ int Vectorizer::doVectorize() {
   double frameRange[2] = {static_cast<double>(m_fids.front().getNumber()) - 1,
                           static_cast<double>(m_fids.back().getNumber()) - 1};
 
+  // Frames are vectorized in parallel, and stored in order as they are done
+  LevelVectorizer levelVectorizer(m_params, m_vLevel->getPalette());
+  levelVectorizer.setProgressCallback(
+      [this](int partial, int total) { emit partialDone(partial, total); });
+
+  // Cancels are transmitted directly, to stop the running frames
+  QMetaObject::Connection cancelConnection =
+      connect(this, &Vectorizer::transmitCancel,
+              [&levelVectorizer]() { levelVectorizer.cancel(); });
+
+  std::deque<QString> labelNames;  // Of the queued frames
   int count = 0;
 
+  auto takeFrame = [&]() {
+    emit frameName(labelNames.front());
+    labelNames.pop_front();
+
+    TFrameId fid;
+    if (TVectorImageP vi = levelVectorizer.takeFrame(fid)) {
+      if (fid.getNumber() < 0) fid = TFrameId(1, fid.getLetter());
+
+      m_vLevel->setFrame(fid, vi);
+
+      emit frameDone(++count);
+    }
+  };
+
   std::vector<TFrameId>::const_iterator ft, fEnd = m_fids.end();
   for (ft = m_fids.begin(); ft != fEnd; ++ft) {
     // Retrieve the image to be vectorized
@@ -367,50 +358,33 @@ int Vectorizer::doVectorize() {
 
     if (!img) continue;
 
-    // Build image-toonz coordinate transformation
-    TAffine dpiAff = getDpiAffine(sl, *ft, true);
-    double factor  = norm(dpiAff * TPointD(1, 0));
-
-    TPointD center;
-    if (TToonzImageP ti = img)
-      center = ti->getRaster()->getCenterD();
-    else if (TRasterImageP ri = img)
-      center = ri->getRaster()->getCenterD();
-
-    // Build vectorizer configuration
+    // Build the position of the frame in the vectorized range
     double weight = (ft->getNumber() - 1 - frameRange[0]) /
                     std::max(frameRange[1] - frameRange[0], 1.0);
     weight = tcrop(weight, 0.0, 1.0);
 
-    locals.updateConfig(weight);  // TEMPORARY
-
-    configuration.m_affine     = dpiAff * TTranslation(-center);
-    configuration.m_thickScale = factor;
-
     // Build vectorization label to be displayed
     QString labelName = QString::fromStdWString(sl->getShortName());
     labelName.push_back(' ');
     labelName.append(QString::fromStdString(ft->expand(TFrameId::NO_PAD)));
 
-    emit frameName(labelName);
+    labelNames.push_back(labelName);
 
     // Perform vectorization
-    if (TVectorImageP vi =
-            doVectorize(img, m_vLevel->getPalette(), configuration)) {
-      TFrameId fid = *ft;
-
-      if (fid.getNumber() < 0) fid = TFrameId(1, ft->getLetter());
-
-      m_vLevel->setFrame(fid, vi);
-      vi->setPalette(m_vLevel->getPalette());
+    levelVectorizer.addFrame(*ft, img, getDpiAffine(sl, *ft, true), weight);
 
-      emit frameDone(++count);
-    }
+    // Store the frames done before loading more
+    while (levelVectorizer.isFull()) takeFrame();
 
     // Stop if canceled
     if (m_isCanceled) break;
   }
 
+  // Frames done before a cancel are kept
+  while (levelVectorizer.getQueuedCount() > 0) takeFrame();
+
+  disconnect(cancelConnection);
+
   m_dialogShown = false;
 
   return count;
@@ -244,7 +244,7 @@ private slots:
   low-level
             vectorization methods: each frame of the input level is processed by
             \p VectorizerCore methods and the output is then stored on free
-  xsheet cells.
+  xsheet cells. Frames are vectorized in parallel by a \p LevelVectorizer.
 
             Signals are also excanghed through this class, ensuring basic
   communications
@@ -297,7 +297,7 @@ signals:
   void frameName(QString);
   void frameDone(int);
 
-  //! Forwards the VectorizerCore::partialDone(int,int) signal.
+  //! Forwards the partial progress of the frame being waited for.
   void partialDone(int, int);
 
   //! Transmits a user cancel downward to VectorizerCore.
@@ -332,12 +332,8 @@ private:
                       //! vectorization.
 
 private:
-  int doVectorize();  //!< Start vectorization of input frames.
-
-  //! Makes connections to low-level partial progress signals and cancel slots,
-  //! and invokes the low-level vectorization of \b img.
-  TVectorImageP doVectorize(TImageP img, TPalette *palette,
-                            const VectorizerConfiguration &conf);
+  int doVectorize();  //!< Vectorizes the input frames in parallel, storing
+                      //!  them in order as they are done.
 };
 
 #endif  // VECTORIZERPOPUP_H
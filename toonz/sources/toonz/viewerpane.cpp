@@ -19,6 +19,8 @@
 #include "toonz/stage2.h"
 #include "toonz/txshlevel.h"
 #include "toonz/txshcell.h"
+#include "toonz/txshcolumn.h"
+#include "toonz/txshsimplelevel.h"
 #include "toonz/tcamera.h"
 #include "toonz/tstageobjecttree.h"
 #include "toonz/tobjecthandle.h"
@@ -274,7 +276,10 @@ void BaseViewerPanel::onDrawFrame(int frame,
 
   TFrameHandle *frameHandle = app->getCurrentFrame();
 
-  if (m_sceneViewer->isPreviewEnabled()) {
+  if (!m_sceneViewer->isPreviewEnabled())
+    // Prefetched frames only loaded their images in the cache
+    m_flipConsole->takePrefetchedImage(frame);
+  else {
     class Previewer *pr = Previewer::instance(m_sceneViewer->getPreviewMode() ==
                                               SceneViewer::SUBCAMERA_PREVIEW);
     pr->getRaster(frame - 1, settings.m_recomputeIfNeeded);  // the 'getRaster'
@@ -312,6 +317,56 @@ void BaseViewerPanel::onDrawFrame(int frame,
 
 //-----------------------------------------------------------------------------
 
+//! Loads in advance the images of the level frames exposed at the specified
+//! frame, which the viewer then finds in the cache. The frames are looked up
+//! here, as the levels may be edited while the builder runs.
+PlaybackPrefetcher::FrameBuilder BaseViewerPanel::getFrameBuilder(int frame) {
+  if (m_sceneViewer->isPreviewEnabled())
+    return PlaybackPrefetcher::FrameBuilder();
+
+  TApp *app = TApp::instance();
+  std::vector<std::pair<TXshSimpleLevel *, TFrameId>> exposed;
+
+  if (app->getCurrentFrame()->isEditingLevel()) {
+    TXshSimpleLevel *sl = app->getCurrentLevel()->getSimpleLevel();
+    if (sl && frame > 0 && frame <= sl->getFrameCount())
+      exposed.push_back(std::make_pair(sl, sl->index2fid(frame - 1)));
+  } else {
+    TXsheet *xsh = app->getCurrentXsheet()->getXsheet();
+    for (int c = 0; c < xsh->getColumnCount(); ++c) {
+      TXshColumn *column = xsh->getColumn(c);
+      if (!column || !column->isCamstandVisible()) continue;
+
+      const TXshCell &cell = xsh->getCell(frame - 1, c);
+      if (TXshSimpleLevel *sl = cell.getSimpleLevel())
+        exposed.push_back(std::make_pair(sl, cell.getFrameId()));
+    }
+  }
+
+  struct LevelFrame {
+    TXshSimpleLevelP m_sl;
+    TFrameId m_fid;
+    std::string m_imageId;
+  };
+  std::vector<LevelFrame> levelFrames;
+  for (const auto &e : exposed)
+    if (e.first->isFid(e.second)) {
+      LevelFrame levelFrame = {e.first, e.second,
+                               e.first->getImageId(e.second)};
+      levelFrames.push_back(levelFrame);
+    }
+
+  if (levelFrames.empty()) return PlaybackPrefetcher::FrameBuilder();
+
+  return [levelFrames]() {
+    for (const LevelFrame &lf : levelFrames)
+      lf.m_sl->getFrameById(lf.m_imageId, lf.m_fid);
+    return TImageP();
+  };
+}
+
+//-----------------------------------------------------------------------------
+
 void BaseViewerPanel::showEvent(QShowEvent *event) {
   TApp *app                    = TApp::instance();
   TFrameHandle *frameHandle    = app->getCurrentFrame();
@@ -79,6 +79,7 @@ public:
 
   void onDrawFrame(int frame, const ImagePainter::VisualSettings &settings,
                    QElapsedTimer *timer, qint64 targetInstant) override;
+  PlaybackPrefetcher::FrameBuilder getFrameBuilder(int frame) override;
 
   void onEnterPanel() {
     m_sceneViewer->setFocus(Qt::OtherFocusReason);
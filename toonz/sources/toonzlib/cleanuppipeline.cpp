@@ -0,0 +1,303 @@
+#include "toonz/cleanuppipeline.h"
+
+// TnzLib includes
+#include "toonz/tcleanupper.h"
+#include "toonz/cleanupparameters.h"
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+// STD includes
+#include <iomanip>
+#include <sstream>
+
+//*****************************************************************************
+//    CleanupPipeline::Frame  definition
+//*****************************************************************************
+
+struct CleanupPipeline::Frame {
+  TFrameId m_fid;
+  TRasterImageP m_image;  //!< Released once processed
+
+  TImageP m_result;
+  bool m_autocentered;
+  bool m_skipped;  //!< The frame was canceled before being processed
+  bool m_done;
+
+  Frame() : m_autocentered(true), m_skipped(false), m_done(false) {}
+};
+
+//*****************************************************************************
+//    CleanupPipeline::FrameTask  definition
+//*****************************************************************************
+
+class CleanupPipeline::FrameTask final : public TThread::Runnable {
+  CleanupPipeline *m_owner;
+  std::shared_ptr<Frame> m_frame;
+
+public:
+  FrameTask(CleanupPipeline *owner, const std::shared_ptr<Frame> &frame)
+      : m_owner(owner), m_frame(frame) {}
+
+  void run() override {
+    if (m_owner->isCanceled()) {
+      QMutexLocker sl(&m_owner->m_mutex);
+
+      m_frame->m_image   = TRasterImageP();
+      m_frame->m_skipped = true;
+      m_frame->m_done    = true;
+
+      m_owner->m_frameDone.wakeAll();
+      return;
+    }
+
+    m_owner->process(*m_frame, false);
+  }
+};
+
+//*****************************************************************************
+//    CleanupPipeline  implementation
+//*****************************************************************************
+
+CleanupPipeline::CleanupPipeline(int threadsCount)
+    : m_threadsCount(threadsCount > 0 ? threadsCount
+                                      : QThread::idealThreadCount())
+    , m_isCanceled(false) {
+  if (m_threadsCount < 1) m_threadsCount = 1;
+  m_executor.setMaxActiveTasks(m_threadsCount);
+}
+
+//-----------------------------------------------------------------------------
+
+CleanupPipeline::~CleanupPipeline() {
+  cancel();
+  waitFrames();
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::waitFrames() {
+  // Tasks refer to this object, so all of them must end here. Canceled ones
+  // end immediately once started.
+  QMutexLocker sl(&m_mutex);
+  for (const std::shared_ptr<Frame> &frame : m_frames)
+    while (!frame->m_done) m_frameDone.wait(&m_mutex);
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::run(const std::vector<TFrameId> &fids,
+                          const Reader &reader, const Writer &writer) {
+  TCleanupper *cl       = TCleanupper::instance();
+  bool wereColorsFrozen = cl->areTargetColorsFrozen();
+
+  {
+    QMutexLocker sl(&m_mutex);
+    m_timings = Timings();
+  }
+
+  QElapsedTimer totalTimer;
+  totalTimer.start();
+
+  int doneCount = 0, totalCount = (int)fids.size();
+  bool firstImage = true;
+
+  try {
+    for (const TFrameId &fid : fids) {
+      if (isCanceled()) break;
+
+      // Write the frames done before reading more
+      while ((int)m_frames.size() >= 2 * m_threadsCount)
+        writeFrame(writer, doneCount, totalCount);
+
+      QElapsedTimer timer;
+      timer.start();
+
+      TRasterImageP img = reader(fid);
+      addTime(m_timings.m_read, timer.elapsed());
+
+      if (!img) {
+        if (m_progressCallback) m_progressCallback(++doneCount, totalCount);
+        continue;
+      }
+
+      std::shared_ptr<Frame> frame(new Frame);
+      frame->m_fid   = fid;
+      frame->m_image = img;
+      img            = TRasterImageP();  // process() releases the image
+
+      {
+        QMutexLocker sl(&m_mutex);
+        m_frames.push_back(frame);
+      }
+
+      if (firstImage) {
+        // The auto-adjust reference is taken from the first frame, which
+        // must then be processed before any other
+        cl->freezeTargetColors(true);
+        process(*frame, true);
+        firstImage = false;
+      } else
+        m_executor.addTask(new FrameTask(this, frame));
+    }
+
+    while (!m_frames.empty()) writeFrame(writer, doneCount, totalCount);
+  } catch (...) {
+    cancel();
+    waitFrames();
+    m_frames.clear();
+
+    cl->freezeTargetColors(wereColorsFrozen);
+    throw;
+  }
+
+  cl->freezeTargetColors(wereColorsFrozen);
+
+  QMutexLocker sl(&m_mutex);
+  m_timings.m_total = totalTimer.elapsed();
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::process(Frame &frame, bool firstImage) {
+  TCleanupper *cl = TCleanupper::instance();
+
+  TImageP result;
+  bool autocentered = true;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  qint64 processTime = 0, finalizeTime = 0;
+
+  try {
+    if (cl->getParameters()->m_lineProcessingMode == lpNone) {
+      // No line processing - the resampled image is the result
+      TRasterImageP ri(frame.m_image);
+      cl->process(frame.m_image, false, ri, false, true, true, nullptr,
+                  ri->getRaster());
+      result      = ri;
+      processTime = timer.elapsed();
+    } else {
+      std::unique_ptr<CleanupPreprocessedImage> cpi;
+      {
+        TRasterImageP resampledImage;
+        cpi.reset(cl->process(frame.m_image, firstImage, resampledImage));
+      }
+      processTime = timer.restart();
+
+      if (cpi) {
+        result       = cl->finalize(cpi.get(), true);
+        autocentered = cpi->m_autocentered;
+      }
+      finalizeTime = timer.elapsed();
+    }
+  } catch (...) {
+    result = TImageP();
+  }
+
+  QMutexLocker sl(&m_mutex);
+
+  frame.m_image        = TRasterImageP();
+  frame.m_result       = result;
+  frame.m_autocentered = autocentered;
+  frame.m_done         = true;
+
+  m_timings.m_process += processTime;
+  m_timings.m_finalize += finalizeTime;
+
+  m_frameDone.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::writeFrame(const Writer &writer, int &doneCount,
+                                 int totalCount) {
+  QElapsedTimer timer;
+  timer.start();
+
+  std::shared_ptr<Frame> frame;
+  {
+    QMutexLocker sl(&m_mutex);
+
+    frame = m_frames.front();
+    while (!frame->m_done) m_frameDone.wait(&m_mutex);
+
+    m_frames.pop_front();
+    m_timings.m_wait += timer.restart();
+  }
+
+  if (frame->m_skipped) return;
+
+  writer(frame->m_fid, frame->m_result, frame->m_autocentered);
+
+  {
+    QMutexLocker sl(&m_mutex);
+
+    m_timings.m_write += timer.elapsed();
+    if (frame->m_result) ++m_timings.m_framesCount;
+  }
+
+  if (m_progressCallback) m_progressCallback(++doneCount, totalCount);
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::addTime(qint64 &stageTime, qint64 time) {
+  QMutexLocker sl(&m_mutex);
+  stageTime += time;
+}
+
+//-----------------------------------------------------------------------------
+
+void CleanupPipeline::cancel() {
+  QMutexLocker sl(&m_mutex);
+  m_isCanceled = true;
+}
+
+//-----------------------------------------------------------------------------
+
+bool CleanupPipeline::isCanceled() const {
+  QMutexLocker sl(&m_mutex);
+  return m_isCanceled;
+}
+
+//-----------------------------------------------------------------------------
+
+CleanupPipeline::Timings CleanupPipeline::getTimings() const {
+  QMutexLocker sl(&m_mutex);
+  return m_timings;
+}
+
+//-----------------------------------------------------------------------------
+
+std::string CleanupPipeline::getTimingsReport() const {
+  Timings timings = getTimings();
+
+  struct locals {
+    static std::string seconds(qint64 msecs) {
+      std::ostringstream os;
+      os << std::fixed << std::setprecision(2) << msecs / 1000.0 << " s";
+      return os.str();
+    }
+  };
+
+  std::ostringstream os;
+  os << "Frames cleaned up: " << timings.m_framesCount << " on "
+     << m_threadsCount << " threads" << std::endl;
+  os << "  read:     " << locals::seconds(timings.m_read) << std::endl;
+  os << "  process:  " << locals::seconds(timings.m_process)
+     << " (all threads)" << std::endl;
+  os << "  finalize: " << locals::seconds(timings.m_finalize)
+     << " (all threads)" << std::endl;
+  os << "  write:    " << locals::seconds(timings.m_write) << std::endl;
+  os << "  waiting:  " << locals::seconds(timings.m_wait) << std::endl;
+  os << "  total:    " << locals::seconds(timings.m_total);
+  if (timings.m_framesCount > 0)
+    os << ", " << locals::seconds(timings.m_total / timings.m_framesCount)
+       << " per frame";
+
+  return os.str();
+}
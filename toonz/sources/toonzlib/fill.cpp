@@ -17,8 +17,11 @@
 #include "toonz/tcamera.h"
 
 #include <stack>
+#include <list>
 
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include "tsystem.h"
 
@@ -408,6 +411,21 @@ void insertSegment(std::vector<std::pair<int, int>> &segments,
 
 //-----------------------------------------------------------------------------
 
+//! Returns the box of the filled segments, grown by the pixels the gap
+//! closing lines may have changed around them and clipped to bounds.
+TRect getSegmentsBox(
+    const std::map<int, std::vector<std::pair<int, int>>> &segments,
+    const TRect &bounds) {
+  TRect box;
+  for (const auto &row : segments)
+    for (const auto &segment : row.second)
+      if (segment.second >= segment.first)
+        box += TRect(segment.first, row.first, segment.second, row.first);
+  return box.isEmpty() ? box : box.enlarge(1) * bounds;
+}
+
+//-----------------------------------------------------------------------------
+
 bool floodCheck(const TPixel32 &clickColor, const TPixel32 *targetPix,
                 const TPixel32 *oldPix, const int fillDepth) {
   auto fullColorThreshMatte = [](int matte, int fillDepth) -> int {
@@ -423,6 +441,178 @@ bool floodCheck(const TPixel32 &clickColor, const TPixel32 *targetPix,
   return !doesStemFill(clickColor, targetPix, fillDepth2);
 }
 
+//-----------------------------------------------------------------------------
+
+//! Keeps the gap closing segments found by TAutocloser on the last filled
+//! rasters, so that repeated fill clicks on the same frame don't analyze the
+//! whole image again.
+/*!
+  Segments only depend on the ink lines of the raster - the pixels whose
+  tone is not the maximum - and on the autoclose settings. Each entry keeps
+  a bit mask of the ink pixels: when the lines change, only the segments
+  near the changes are searched again.
+*/
+class GapClosingCache {
+  typedef TAutocloser::Segment Segment;
+
+  struct Entry {
+    const UCHAR *m_buffer;  // Identifies the frame
+    TDimension m_size;
+    int m_wrap;
+    int m_distance;
+    double m_angle;
+    std::vector<UCHAR> m_inkMask;  // One bit per pixel, rows padded to bytes
+    std::vector<Segment> m_segments;
+  };
+
+  // Rasters of different frames, of the same frame in savebox-only mode, or
+  // with different settings
+  static const int c_maxEntriesCount = 4;
+
+  QMutex m_mutex;
+  std::list<Entry> m_entries;  // Most recently used first
+
+public:
+  static GapClosingCache *instance() {
+    static GapClosingCache theInstance;
+    return &theInstance;
+  }
+
+  void getSegments(const TRasterCM32P &r, int distance, double angle,
+                   std::vector<Segment> &segments) {
+    QMutexLocker sl(&m_mutex);
+
+    std::vector<UCHAR> inkMask;
+    buildInkMask(r, inkMask);
+
+    std::list<Entry>::iterator it;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it)
+      if (it->m_buffer == r->getRawData() && it->m_size == r->getSize() &&
+          it->m_wrap == r->getWrap() && it->m_distance == distance &&
+          it->m_angle == angle)
+        break;
+
+    if (it != m_entries.end()) {
+      m_entries.splice(m_entries.begin(), m_entries, it);
+
+      Entry &entry     = m_entries.front();
+      TRect changedBox = getChangedBox(r, entry.m_inkMask, inkMask);
+      if (!changedBox.isEmpty()) {
+        // Large changes are better analyzed at once
+        if (4 * changedBox.getLx() * changedBox.getLy() >
+            r->getLx() * r->getLy())
+          entry.m_segments = computeSegments(r, distance, angle);
+        else
+          updateSegments(r, distance, angle, changedBox, entry.m_segments);
+        entry.m_inkMask.swap(inkMask);
+      }
+      segments = entry.m_segments;
+      return;
+    }
+
+    Entry entry = {r->getRawData(), r->getSize(), r->getWrap(), distance,
+                   angle};
+    entry.m_inkMask.swap(inkMask);
+    entry.m_segments = computeSegments(r, distance, angle);
+    segments         = entry.m_segments;
+
+    m_entries.push_front(entry);
+    if ((int)m_entries.size() > c_maxEntriesCount) m_entries.pop_back();
+  }
+
+private:
+  static void buildInkMask(const TRasterCM32P &r, std::vector<UCHAR> &mask) {
+    int lx = r->getLx(), ly = r->getLy(), rowBytes = (lx + 7) >> 3;
+    mask.assign(rowBytes * ly, 0);
+
+    UCHAR *maskRow = mask.data();
+    for (int y = 0; y < ly; ++y, maskRow += rowBytes) {
+      const TPixelCM32 *pix = r->pixels(y);
+      for (int x = 0; x < lx; ++x, ++pix)
+        if (pix->getTone() != TPixelCM32::getMaxTone())
+          maskRow[x >> 3] |= (1 << (x & 7));
+    }
+  }
+
+  // Returns the box of the pixels whose ink state differs, rounded to 8
+  // pixels horizontally.
+  static TRect getChangedBox(const TRasterCM32P &r,
+                             const std::vector<UCHAR> &oldMask,
+                             const std::vector<UCHAR> &newMask) {
+    int lx = r->getLx(), ly = r->getLy(), rowBytes = (lx + 7) >> 3;
+
+    TRect box;
+    for (int y = 0; y < ly; ++y) {
+      const UCHAR *oldRow = oldMask.data() + y * rowBytes;
+      const UCHAR *newRow = newMask.data() + y * rowBytes;
+      if (memcmp(oldRow, newRow, rowBytes) == 0) continue;
+
+      int b0 = 0, b1 = rowBytes - 1;
+      while (oldRow[b0] == newRow[b0]) ++b0;
+      while (oldRow[b1] == newRow[b1]) --b1;
+
+      TRect rowBox(b0 << 3, y, std::min((b1 << 3) + 7, lx - 1), y);
+      box += rowBox;
+    }
+    return box;
+  }
+
+  static std::vector<Segment> computeSegments(const TRasterCM32P &r,
+                                              int distance, double angle) {
+    std::vector<Segment> segments;
+    TAutocloser(r, distance, angle, GAP_CLOSE_TEMP, AutocloseOpacity)
+        .compute(segments);
+    return segments;
+  }
+
+  static TRect getSegmentBox(const Segment &s) {
+    return TRect(std::min(s.first.x, s.second.x),
+                 std::min(s.first.y, s.second.y),
+                 std::max(s.first.x, s.second.x),
+                 std::max(s.first.y, s.second.y));
+  }
+
+  //! Replaces the segments which may be affected by the ink changes in the
+  //! specified box with the ones found by analyzing its surroundings.
+  static void updateSegments(const TRasterCM32P &r, int distance,
+                             double angle, const TRect &changedBox,
+                             std::vector<Segment> &segments) {
+    TRect bounds = r->getBounds();
+
+    // Segments reach the lines within the closing distance, and the
+    // skeleton of the lines may change a few pixels away from the changes
+    TRect affectedBox = changedBox.enlarge(distance + 4) * bounds;
+
+    // Lines cut by the analyzed region have false endpoints on its border:
+    // segments found near it are discarded, unless it's the raster border
+    int border       = distance + 4;
+    TRect regionBox  = affectedBox.enlarge(2 * border) * bounds;
+    TRect trustedBox = regionBox;
+    if (trustedBox.x0 > 0) trustedBox.x0 += border;
+    if (trustedBox.y0 > 0) trustedBox.y0 += border;
+    if (trustedBox.x1 < bounds.x1) trustedBox.x1 -= border;
+    if (trustedBox.y1 < bounds.y1) trustedBox.y1 -= border;
+
+    segments.erase(
+        std::remove_if(segments.begin(), segments.end(),
+                       [&affectedBox](const Segment &s) {
+                         return getSegmentBox(s).overlaps(affectedBox);
+                       }),
+        segments.end());
+
+    std::vector<Segment> regionSegments =
+        computeSegments(r->extract(regionBox), distance, angle);
+
+    TPoint offset = regionBox.getP00();
+    for (Segment s : regionSegments) {
+      s.first += offset, s.second += offset;
+      if (getSegmentBox(s).overlaps(affectedBox) &&
+          trustedBox.contains(s.first) && trustedBox.contains(s.second))
+        segments.push_back(s);
+    }
+  }
+};
+
 //-----------------------------------------------------------------------------
 }  // namespace
 //-----------------------------------------------------------------------------
@@ -518,10 +708,16 @@ bool fill(const TRasterCM32P &r, const FillParameters &params,
   bool gapsClosed = false, refGapsClosed = false;
 
   if (fillGaps) {
-    tempRaster = r->clone();
-    gapsClosed = TAutocloser(tempRaster, autoCloseDistance, AutocloseAngle,
-                             styleIndex, AutocloseOpacity)
-                     .exec();
+    std::vector<TAutocloser::Segment> closingSegments;
+    GapClosingCache::instance()->getSegments(r, autoCloseDistance,
+                                             AutocloseAngle, closingSegments);
+    gapsClosed = !closingSegments.empty();
+    if (gapsClosed) {
+      tempRaster = r->clone();
+      TAutocloser(tempRaster, autoCloseDistance, AutocloseAngle, styleIndex,
+                  AutocloseOpacity)
+          .draw(closingSegments);
+    }
   }
   if (!gapsClosed) {
     tempRaster = r;
@@ -548,23 +744,21 @@ bool fill(const TRasterCM32P &r, const FillParameters &params,
   TPixel32 clickedPosColor, color(255, 255, 255);
 
   std::map<int, std::vector<std::pair<int, int>>> segments;
+  TPoint renderOffset;
 
   if (xsheet) {
-    ToonzScene *scene = xsheet->getScene();
-    TCamera *camera   = scene->getCurrentCamera();
-    TRaster32P tmpRaster(camera->getRes());
-
     // Render for reference
-    scene->renderFrame(tmpRaster, frameIndex, xsheet, false, false, true);
+    TRaster32P tmpRaster =
+        FillReferenceCache::instance()->getRender(xsheet, frameIndex);
 
     refRaster->lock();
 
-    TPoint offset((params.m_imageSize.lx - tmpRaster->getLx()) / 2,
-                  (params.m_imageSize.ly - tmpRaster->getLy()) / 2);
-    offset -= params.m_imageOffset;
+    renderOffset = TPoint((params.m_imageSize.lx - tmpRaster->getLx()) / 2,
+                          (params.m_imageSize.ly - tmpRaster->getLy()) / 2);
+    renderOffset -= params.m_imageOffset;
 
     refRaster->fill(color);
-    refRaster->copy(tmpRaster, offset);
+    refRaster->copy(tmpRaster, renderOffset);
 
     refpix          = refRaster->pixels(p.y) + p.x;
     clickedPosColor = *refpix;
@@ -768,6 +962,11 @@ bool fill(const TRasterCM32P &r, const FillParameters &params,
     }
   }
 
+  // The cached renders no longer show the filled areas as they are
+  if (xsheet)
+    FillReferenceCache::instance()->update(
+        xsheet, getSegmentsBox(segments, bbbox) - renderOffset);
+
   return saveBoxChanged;
 }
 
@@ -996,19 +1195,18 @@ void fullColorFill(const TRaster32P &ras, const FillParameters &params,
   TPixel32 gapColor  = plt->getStyle(closeStyleIndex)->getMainColor();
   int styleIndex     = GAP_CLOSE_TEMP;
   int fakeStyleIndex = GAP_CLOSE_USED;
+  TPoint renderOffset;
 
   if (xsheet) {
-    ToonzScene *scene = xsheet->getScene();
-    TCamera *camera   = scene->getCurrentCamera();
-    TRaster32P tmpRaster(camera->getRes());
-    scene->renderFrame(tmpRaster, frameIndex, xsheet, false, false, true);
+    TRaster32P tmpRaster =
+        FillReferenceCache::instance()->getRender(xsheet, frameIndex);
 
     refRas->lock();
 
-    TPoint offset((refRas->getLx() - tmpRaster->getLx()) / 2,
-                  (refRas->getLy() - tmpRaster->getLy()) / 2);
+    renderOffset = TPoint((refRas->getLx() - tmpRaster->getLx()) / 2,
+                          (refRas->getLy() - tmpRaster->getLy()) / 2);
     refRas->fill(color);
-    refRas->copy(tmpRaster, offset);
+    refRas->copy(tmpRaster, renderOffset);
 
     clickedPosColor = *(refRas->pixels(y) + x);
   } else if (fillGaps) {
@@ -1234,4 +1432,72 @@ void fullColorFill(const TRaster32P &ras, const FillParameters &params,
       }
     }
   }
+
+  // The cached renders no longer show the filled areas as they are
+  if (xsheet)
+    FillReferenceCache::instance()->update(
+        xsheet, getSegmentsBox(segments, bbbox) - renderOffset);
+}
+
+//=============================================================================
+// FillReferenceCache
+//-----------------------------------------------------------------------------
+
+FillReferenceCache *FillReferenceCache::instance() {
+  static FillReferenceCache theInstance;
+  return &theInstance;
+}
+
+//-----------------------------------------------------------------------------
+
+TRaster32P FillReferenceCache::getRender(const TXsheet *xsheet,
+                                         int frameIndex) {
+  // Camera resolution renders are large: a few frames are enough to fill
+  // around the current one
+  static const int maxEntriesCount = 4;
+
+  ToonzScene *scene    = xsheet->getScene();
+  TDimension cameraRes = scene->getCurrentCamera()->getRes();
+
+  for (int i = 0; i < (int)m_entries.size(); ++i) {
+    Entry &entry = m_entries[i];
+    if (entry.m_xsheet == xsheet && entry.m_frameIndex == frameIndex &&
+        entry.m_render->getSize() == cameraRes) {
+      std::rotate(m_entries.begin(), m_entries.begin() + i,
+                  m_entries.begin() + i + 1);
+      return m_entries.front().m_render;
+    }
+  }
+
+  TRaster32P render(cameraRes);
+  scene->renderFrame(render, frameIndex, xsheet, false, false, true);
+
+  Entry entry = {xsheet, frameIndex, render};
+  m_entries.insert(m_entries.begin(), entry);
+  if ((int)m_entries.size() > maxEntriesCount) m_entries.pop_back();
+
+  return render;
+}
+
+//-----------------------------------------------------------------------------
+
+void FillReferenceCache::update(const TXsheet *xsheet, const TRect &rect) {
+  ToonzScene *scene = xsheet->getScene();
+
+  for (int i = (int)m_entries.size() - 1; i >= 0; --i) {
+    Entry &entry = m_entries[i];
+    if (entry.m_xsheet != xsheet) {
+      m_entries.erase(m_entries.begin() + i);
+      continue;
+    }
+
+    TRect patchRect = rect * entry.m_render->getBounds();
+    if (patchRect.isEmpty()) continue;
+
+    TRaster32P patch(patchRect.getSize());
+    patch->clear();
+    scene->renderFrame(patch, patchRect, entry.m_render->getSize(),
+                       entry.m_frameIndex, xsheet, false, false, true);
+    entry.m_render->copy(patch, patchRect.getP00());
+  }
 }
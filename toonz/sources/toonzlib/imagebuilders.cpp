@@ -101,21 +101,30 @@ TImageP ImageLoader::build(int imFlags, void *extData) {
     m_path = data->m_fullPath;
 
   try {
-    // Initialize level reader
-    TLevelReaderP lr(m_path);
-    if (!lr) return TImageP();
+    bool isTlvIcon = data->m_icon && m_path.getType() == "tlv";
 
-    // Load info in cases where it's required first
-    lr->doReadPalette(false);
+    // Initialize level reader. A shared reader is already initialized, and
+    // may be in use by other threads - so its state must not be altered.
+    bool sharedReader = data->m_levelReader &&
+                        data->m_levelReader->getFilePath() == m_path;
 
-    if ((m_path.getType() == "pli") || (m_path.getType() == "svg") ||
-        (m_path.getType() == "psd"))
-      lr->loadInfo();
+    TSmartPointerT<TLevelReader> lr;
+    if (sharedReader)
+      lr = data->m_levelReader;
+    else {
+      lr = TLevelReaderP(m_path);
+      if (!lr) return TImageP();
 
-    bool isTlvIcon = data->m_icon && m_path.getType() == "tlv";
+      // Load info in cases where it's required first
+      lr->doReadPalette(false);
+
+      if ((m_path.getType() == "pli") || (m_path.getType() == "svg") ||
+          (m_path.getType() == "psd"))
+        lr->loadInfo();
 
-    // for TLV icons, palettes will be applied in IconGenerator later
-    if (!isTlvIcon) lr->doReadPalette(true);  // Allow palette loading
+      // for TLV icons, palettes will be applied in IconGenerator later
+      if (!isTlvIcon) lr->doReadPalette(true);  // Allow palette loading
+    }
 
     TImageReaderP ir = lr->getFrameReader(m_fid);
 
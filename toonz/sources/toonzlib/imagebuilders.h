@@ -13,6 +13,7 @@
 
 class TImageInfo;
 class TXshSimpleLevel;
+class TLevelReader;
 
 //======================================================
 
@@ -42,6 +43,10 @@ public:
 
     TFilePath m_fullPath;
 
+    TLevelReader *m_levelReader;  //!< An already opened reader to load the
+                                  //!< image with, if any. It is used only if
+                                  //!< it reads the loader's path
+
   public:
     BuildExtData(const TXshSimpleLevel *sl, const TFrameId &fid, int subs = 0,
                  bool icon = false, TFilePath fullPath = TFilePath())
@@ -49,7 +54,8 @@ public:
         , m_fid(fid)
         , m_subs(subs)
         , m_icon(icon)
-        , m_fullPath(fullPath) {}
+        , m_fullPath(fullPath)
+        , m_levelReader(0) {}
   };
 
 public:
@@ -70,6 +76,8 @@ public:
   */
   void setFid(const TFrameId &fid) override;
 
+  const TFilePath &getPath() const { return m_path; }
+
 protected:
   bool getInfo(TImageInfo &info, int imFlags, void *extData) override;
   TImageP build(int imFlags, void *extData) override;
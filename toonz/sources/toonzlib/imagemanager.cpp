@@ -6,6 +6,8 @@
 #include "ttoonzimage.h"
 #include "tmeshimage.h"
 #include "timage_io.h"
+#include "tlevel_io.h"
+#include "tthread.h"
 
 // Qt includes (mutexing classes)
 #include <QMutex>
@@ -13,10 +15,14 @@
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QAtomicInt>
+#include <QThread>
 
 #include "toonz/imagemanager.h"
 #include "toonz/txshsimplelevel.h"
 
+#include "imagebuilders.h"
+
 /* EXPLANATION (by Daniele):
 
   Images / Image Infos retrieval is quite a frequent task throughout Toonz - in
@@ -175,6 +181,79 @@ public:
   void clear() { m_builders.clear(); }
 };
 
+//-----------------------------------------------------------------------------
+
+namespace {
+
+//! Builds the images of ImageManager::prefetch(), taking frames from a shared
+//! counter until none remains.
+class PrefetchWorker final : public QThread {
+  TXshSimpleLevel *m_level;
+  const std::vector<TFrameId> &m_fids;
+  TLevelReader *m_levelReader;
+  int m_imFlags;
+  QAtomicInt &m_next;
+
+public:
+  PrefetchWorker(TXshSimpleLevel *level, const std::vector<TFrameId> &fids,
+                 TLevelReader *levelReader, int imFlags, QAtomicInt &next)
+      : m_level(level)
+      , m_fids(fids)
+      , m_levelReader(levelReader)
+      , m_imFlags(imFlags)
+      , m_next(next) {}
+
+  void run() override {
+    int f;
+    while ((f = m_next.fetchAndAddOrdered(1)) < (int)m_fids.size()) {
+      ImageLoader::BuildExtData extData(m_level, m_fids[f]);
+      extData.m_levelReader = m_levelReader;
+
+      try {
+        ImageManager::instance()->getImage(m_level->getImageId(m_fids[f]),
+                                           m_imFlags, &extData);
+      } catch (...) {
+      }
+    }
+  }
+};
+
+//-----------------------------------------------------------------------------
+
+//! Serves an ImageManager::prefetchInBackground() request.
+class PrefetchTask final : public TThread::Runnable {
+  TXshSimpleLevelP m_level;
+  std::vector<TFrameId> m_fids;
+  int m_imFlags;
+
+public:
+  PrefetchTask(TXshSimpleLevel *level, const std::vector<TFrameId> &fids,
+               int imFlags)
+      : m_level(level), m_fids(fids), m_imFlags(imFlags) {}
+
+  void run() override {
+    ImageManager::instance()->prefetch(m_level.getPointer(), m_fids,
+                                       m_imFlags);
+  }
+
+  QThread::Priority runningPriority() override { return QThread::LowPriority; }
+};
+
+//-----------------------------------------------------------------------------
+
+class PrefetchExecutor final : public TThread::Executor {
+public:
+  PrefetchExecutor() { setMaxActiveTasks(1); }
+};
+
+// Built on first use, as executors require TThread::init()
+TThread::Executor &prefetchExecutor() {
+  static PrefetchExecutor executor;
+  return executor;
+}
+
+}  // namespace
+
 //************************************************************************************
 //    Image Manager implementation
 //************************************************************************************
@@ -423,6 +502,76 @@ void ImageManager::loadAllTlvIconsAndPutInCache(
 
 //-----------------------------------------------------------------------------
 
+void ImageManager::prefetch(TXshSimpleLevel *level,
+                            const std::vector<TFrameId> &fids, int imFlags) {
+  assert(!(imFlags & (dontPutInCache | toBeModified)));
+  if (!TImageCache::instance()->isEnabled()) return;
+
+  // Collect the frames to be built, and the level file they are loaded from
+  std::vector<TFrameId> buildFids;
+  TFilePath path;
+  {
+    QReadLocker tableLocker(&m_imp->m_tableLock);
+
+    for (int f = 0; f < (int)fids.size(); ++f) {
+      std::map<std::string, ImageBuilderP>::iterator it =
+          m_imp->m_builders.find(level->getImageId(fids[f]));
+      if (it == m_imp->m_builders.end() || it->second->m_cached) continue;
+
+      buildFids.push_back(fids[f]);
+      if (path.isEmpty())
+        if (ImageLoader *loader =
+                dynamic_cast<ImageLoader *>(it->second.getPointer()))
+          path = loader->getPath();
+    }
+  }
+
+  if (buildFids.empty()) return;
+
+  // Tlv levels are read concurrently through the same level reader
+  TLevelReaderP lr;
+  if (path.getType() == "tlv") {
+    try {
+      lr = TLevelReaderP(path);
+      if (lr) lr->loadInfo();  // Reads the palette once and for all
+    } catch (...) {
+      lr = TLevelReaderP();
+    }
+  }
+
+  int threadsCount =
+      std::max(1, std::min(QThread::idealThreadCount(), (int)buildFids.size()));
+
+  QAtomicInt next(0);
+  std::vector<PrefetchWorker *> workers;
+  for (int t = 0; t < threadsCount; ++t) {
+    workers.push_back(new PrefetchWorker(level, buildFids, lr.getPointer(),
+                                         imFlags, next));
+    workers.back()->start();
+  }
+
+  for (int t = 0; t < threadsCount; ++t) {
+    workers[t]->wait();
+    delete workers[t];
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void ImageManager::prefetchInBackground(TXshSimpleLevel *level,
+                                        const std::vector<TFrameId> &fids,
+                                        int imFlags) {
+  if (fids.empty() || !TImageCache::instance()->isEnabled()) return;
+
+  prefetchExecutor().addTask(new PrefetchTask(level, fids, imFlags));
+}
+
+//-----------------------------------------------------------------------------
+
+void ImageManager::cancelPrefetches() { prefetchExecutor().cancelAll(); }
+
+//-----------------------------------------------------------------------------
+
 bool ImageManager::invalidate(const std::string &id) {
   QWriteLocker locker(&m_imp->m_tableLock);
 
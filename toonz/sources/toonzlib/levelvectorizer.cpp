@@ -0,0 +1,264 @@
+#include "toonz/levelvectorizer.h"
+
+// TnzLib includes
+#include "toonz/tcenterlinevectorizer.h"
+
+// TnzCore includes
+#include "trasterimage.h"
+#include "ttoonzimage.h"
+#include "tcolorstyles.h"
+
+// Qt includes
+#include <QMutexLocker>
+#include <QThread>
+
+// STD includes
+#include <map>
+
+//*****************************************************************************
+//    LevelVectorizer::Frame  definition
+//*****************************************************************************
+
+struct LevelVectorizer::Frame {
+  TFrameId m_fid;
+  TImageP m_image;  //!< Released once vectorized
+
+  CenterlineConfiguration m_cConf;
+  NewOutlineConfiguration m_oConf;
+  bool m_isOutline;
+
+  TPaletteP m_palette;   //!< Copy of the level palette used by the frame
+  int m_baseStyleCount;  //!< Styles count of the level palette when copied
+
+  VectorizerCore *m_core;  //!< The running vectorizer, if any
+  TVectorImageP m_result;
+  bool m_done;
+
+  Frame() : m_isOutline(false), m_baseStyleCount(0), m_core(0), m_done(false) {}
+
+  const VectorizerConfiguration &configuration() const {
+    return m_isOutline
+               ? static_cast<const VectorizerConfiguration &>(m_oConf)
+               : static_cast<const VectorizerConfiguration &>(m_cConf);
+  }
+};
+
+//*****************************************************************************
+//    LevelVectorizer::FrameTask  definition
+//*****************************************************************************
+
+class LevelVectorizer::FrameTask final : public TThread::Runnable {
+  LevelVectorizer *m_owner;
+  std::shared_ptr<Frame> m_frame;
+
+public:
+  FrameTask(LevelVectorizer *owner, const std::shared_ptr<Frame> &frame)
+      : m_owner(owner), m_frame(frame) {}
+
+  void run() override {
+    VectorizerCore vCore;
+    QObject::connect(&vCore, &VectorizerCore::partialDone,
+                     [this](int partial, int total) {
+                       notifyProgress(partial, total);
+                     });
+
+    bool canceled;
+    {
+      QMutexLocker sl(&m_owner->m_mutex);
+      canceled = m_owner->m_isCanceled;
+      if (!canceled) m_frame->m_core = &vCore;
+    }
+
+    TVectorImageP vi;
+    if (!canceled) {
+      try {
+        vi = vCore.vectorize(m_frame->m_image, m_frame->configuration(),
+                             m_frame->m_palette.getPointer());
+      } catch (...) {
+      }
+    }
+
+    QMutexLocker sl(&m_owner->m_mutex);
+
+    m_frame->m_core   = 0;
+    m_frame->m_image  = TImageP();
+    m_frame->m_result = m_owner->m_isCanceled ? TVectorImageP() : vi;
+    m_frame->m_done   = true;
+
+    m_owner->m_frameDone.wakeAll();
+  }
+
+private:
+  void notifyProgress(int partial, int total) {
+    if (!m_owner->m_progressCallback) return;
+
+    bool isOldest;
+    {
+      QMutexLocker sl(&m_owner->m_mutex);
+      isOldest = !m_owner->m_frames.empty() &&
+                 m_owner->m_frames.front() == m_frame;
+    }
+
+    if (isOldest) m_owner->m_progressCallback(partial, total);
+  }
+};
+
+//*****************************************************************************
+//    LevelVectorizer  implementation
+//*****************************************************************************
+
+LevelVectorizer::LevelVectorizer(const VectorizerParameters &params,
+                                 const TPaletteP &palette, int threadsCount)
+    : m_params(params)
+    , m_palette(palette)
+    , m_threadsCount(threadsCount > 0 ? threadsCount
+                                      : QThread::idealThreadCount())
+    , m_isCanceled(false) {
+  if (m_threadsCount < 1) m_threadsCount = 1;
+  m_executor.setMaxActiveTasks(m_threadsCount);
+}
+
+//-----------------------------------------------------------------------------
+
+LevelVectorizer::~LevelVectorizer() {
+  cancel();
+
+  // Tasks refer to this object, so all of them must end here. Canceled ones
+  // end immediately once started.
+  QMutexLocker sl(&m_mutex);
+  for (const std::shared_ptr<Frame> &frame : m_frames)
+    while (!frame->m_done) m_frameDone.wait(&m_mutex);
+}
+
+//-----------------------------------------------------------------------------
+
+void LevelVectorizer::addFrame(const TFrameId &fid, const TImageP &img,
+                               const TAffine &dpiAff, double weight) {
+  std::shared_ptr<Frame> frame(new Frame);
+  frame->m_fid   = fid;
+  frame->m_image = img;
+
+  // Build the image-to-level transform
+  TPointD center;
+  if (TToonzImageP ti = img)
+    center = ti->getRaster()->getCenterD();
+  else if (TRasterImageP ri = img)
+    center = ri->getRaster()->getCenterD();
+
+  frame->m_isOutline = m_params.m_isOutline;
+  if (frame->m_isOutline)
+    frame->m_oConf = m_params.getOutlineConfiguration(weight);
+  else
+    frame->m_cConf = m_params.getCenterlineConfiguration(weight);
+
+  VectorizerConfiguration &configuration =
+      frame->m_isOutline
+          ? static_cast<VectorizerConfiguration &>(frame->m_oConf)
+          : static_cast<VectorizerConfiguration &>(frame->m_cConf);
+
+  configuration.m_affine     = dpiAff * TTranslation(-center);
+  configuration.m_thickScale = norm(dpiAff * TPointD(1, 0));
+
+  // The palette copy includes the styles merged by the frames taken so far
+  frame->m_palette        = m_palette->clone();
+  frame->m_baseStyleCount = m_palette->getStyleCount();
+
+  {
+    QMutexLocker sl(&m_mutex);
+    m_frames.push_back(frame);
+  }
+
+  m_executor.addTask(new FrameTask(this, frame));
+}
+
+//-----------------------------------------------------------------------------
+
+TVectorImageP LevelVectorizer::takeFrame(TFrameId &fid) {
+  assert(!m_frames.empty());
+
+  std::shared_ptr<Frame> frame;
+  {
+    QMutexLocker sl(&m_mutex);
+
+    frame = m_frames.front();
+    while (!frame->m_done) m_frameDone.wait(&m_mutex);
+
+    m_frames.pop_front();
+  }
+
+  fid = frame->m_fid;
+
+  TVectorImageP vi = frame->m_result;
+  if (vi) {
+    mergeStyles(*frame, vi.getPointer());
+    vi->setPalette(m_palette.getPointer());
+  }
+
+  return vi;
+}
+
+//-----------------------------------------------------------------------------
+
+void LevelVectorizer::cancel() {
+  QMutexLocker sl(&m_mutex);
+
+  m_isCanceled = true;
+
+  // VectorizerCore::onCancel() is a protected slot, just raising a flag
+  for (const std::shared_ptr<Frame> &frame : m_frames)
+    if (frame->m_core)
+      QMetaObject::invokeMethod(frame->m_core, "onCancel",
+                                Qt::DirectConnection);
+}
+
+//-----------------------------------------------------------------------------
+
+bool LevelVectorizer::isCanceled() const {
+  QMutexLocker sl(&m_mutex);
+  return m_isCanceled;
+}
+
+//-----------------------------------------------------------------------------
+
+void LevelVectorizer::mergeStyles(Frame &frame, TVectorImage *vi) {
+  TPalette *framePalette = frame.m_palette.getPointer();
+
+  std::map<int, int> table;
+
+  int s, sCount = framePalette->getStyleCount();
+  for (s = frame.m_baseStyleCount; s < sCount; ++s) {
+    TColorStyle *style = framePalette->getStyle(s);
+    TPixel32 color     = style->getMainColor();
+
+    // Look for the same color among the styles added by the frames taken
+    // after this one was queued - the frame didn't know about them
+    int styleId = -1;
+
+    int t, tCount = m_palette->getStyleCount();
+    for (t = frame.m_baseStyleCount; t < tCount; ++t)
+      if (m_palette->getStyle(t)->getMainColor() == color) {
+        styleId = t;
+        break;
+      }
+
+    if (styleId < 0) {
+      // Add the style to the same page it was added to in the frame palette
+      TPalette::Page *framePage = framePalette->getStylePage(s);
+      TPalette::Page *page      = 0;
+      if (framePage && framePage->getIndex() < m_palette->getPageCount())
+        page = m_palette->getPage(framePage->getIndex());
+
+      if (page) {
+        int indexInPage = page->addStyle(style->clone());
+        if (indexInPage >= 0) styleId = page->getStyleId(indexInPage);
+      } else
+        styleId = m_palette->addStyle(style->clone());
+
+      if (styleId < 0) styleId = 0;
+    }
+
+    if (styleId != s) table[s] = styleId;
+  }
+
+  if (!table.empty()) vi->reassignStyles(table);
+}
@@ -23,6 +23,8 @@
 #include "toonz/levelupdater.h"
 #include "toutputproperties.h"
 #include "toonz/boardsettings.h"
+#include "toonz/imagemanager.h"
+#include "toonz/txshsimplelevel.h"
 
 // tcg includes
 #include "tcg/tcg_macros.h"
@@ -122,6 +124,10 @@ public:
 
   std::map<double, std::pair<TRasterP, TRasterP>> m_toBeSaved;
   std::vector<std::pair<double, TFxPair>> m_framesToBeRendered;
+  // Tlv frames exposed by each frame to be rendered, collected at start() so
+  // that render threads never walk the xsheet
+  std::vector<std::vector<std::pair<TXshSimpleLevelP, std::vector<TFrameId>>>>
+      m_tlvFrames;
   std::string m_renderCacheId;
   /*--- When caching the same raster, gamma only the first one and use the
   result in subsequent frames
@@ -150,6 +156,7 @@ public:
 
   // TRenderPort methods
 
+  void onRenderRasterStarted(const RenderData &renderData) override;
   void onRenderRasterCompleted(const RenderData &renderData) override;
   void onRenderFailure(const RenderData &renderData, TException &e) override;
 
@@ -162,6 +169,8 @@ public:
   // Helper methods
 
   void prepareForStart();
+  void collectTlvFrames();
+  void prefetchFrames(int first);
   void addSoundtrack(int r0, int r1, double fps, int boardDuration = 0);
 
   // writeInLinearColorSpace : Whether the format will save image in linear
@@ -373,6 +382,59 @@ void MovieRenderer::Imp::addSoundtrack(int r0, int r1, double fps,
 
 //---------------------------------------------------------
 
+void MovieRenderer::Imp::collectTlvFrames() {
+  TXsheet *xsh = m_scene->getXsheet();
+
+  m_tlvFrames.clear();
+  m_tlvFrames.resize(m_framesToBeRendered.size());
+
+  std::vector<std::pair<TXshSimpleLevel *, std::vector<TFrameId>>> levelFrames;
+  for (int f = 0; f < (int)m_framesToBeRendered.size(); ++f) {
+    xsh->getTlvFrames(std::vector<int>(1, (int)m_framesToBeRendered[f].first),
+                      levelFrames);
+    m_tlvFrames[f].assign(levelFrames.begin(), levelFrames.end());
+  }
+}
+
+//---------------------------------------------------------
+
+//! Loads in background the level images of the frames to be rendered starting
+//! from the specified index. Only reads the frames collected at start(), as it
+//! is called by render threads too.
+void MovieRenderer::Imp::prefetchFrames(int first) {
+  static const int PrefetchFrames = 8;
+
+  int last = std::min(first + PrefetchFrames, (int)m_tlvFrames.size());
+  if (first >= last) return;
+
+  std::map<TXshSimpleLevel *, std::vector<TFrameId>> levelFrames;
+  for (int f = first; f < last; ++f)
+    for (const auto &lf : m_tlvFrames[f]) {
+      std::vector<TFrameId> &fids = levelFrames[lf.first.getPointer()];
+      for (const TFrameId &fid : lf.second)
+        if (std::find(fids.begin(), fids.end(), fid) == fids.end())
+          fids.push_back(fid);
+    }
+
+  for (const auto &lf : levelFrames)
+    ImageManager::instance()->prefetchInBackground(lf.first, lf.second);
+}
+
+//---------------------------------------------------------
+
+void MovieRenderer::Imp::onRenderRasterStarted(const RenderData &renderData) {
+  // Keep loading ahead of the render, past the frames of the cluster
+  if (renderData.m_frames.empty()) return;
+  double frame = renderData.m_frames.back();
+  for (int f = 0; f < (int)m_framesToBeRendered.size(); ++f)
+    if (m_framesToBeRendered[f].first == frame) {
+      prefetchFrames(f + 1);
+      break;
+    }
+}
+
+//---------------------------------------------------------
+
 void MovieRenderer::Imp::onRenderRasterCompleted(const RenderData &renderData) {
   if (m_preview)
     doPreviewRasterCompleted(renderData);
@@ -926,6 +988,8 @@ bool MovieRenderer::isPrecomputingEnabled() const {
 
 void MovieRenderer::start() {
   m_imp->prepareForStart();
+  m_imp->collectTlvFrames();
+  m_imp->prefetchFrames(0);
 
   // Add a reference to MovieRenderer's Imp. The reference is 'owned' by
   // TRenderer's render process - when it
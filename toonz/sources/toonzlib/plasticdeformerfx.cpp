@@ -18,6 +18,7 @@
 #include "ext/ttexturesstorage.h"
 #include "ext/plasticvisualsettings.h"
 #include "ext/meshutils.h"
+#include "ext/meshrasterizer.h"
 
 // TnzBase includes
 #include "trenderer.h"
@@ -140,7 +141,7 @@ std::string PlasticDeformerFx::getAlias(double frame,
     TRasterFxP ifx = m_port.getFx();
     assert(ifx);
 
-    alias += ifx->getAlias(frame, info);
+    alias += ifx->getCachedAlias(frame, info);
   }
 
   TStageObject *meshColumnObj =
@@ -364,7 +365,47 @@ void PlasticDeformerFx::doCompute(TTile &tile, double frame,
 
   TTile origTile(tile.getRaster()->clone());
 
-  QOpenGLContext *context;
+  const TAffine &meshToTileAff =
+      TTranslation(-tile.m_pos) * info.m_affine * meshToWorldMeshAff;
+
+  // Software rendering needs no OpenGL context - render nodes without a
+  // display may not be able to provide one
+  bool cpuRendering = Preferences::instance()->isCpuMeshRenderingEnabled();
+
+  QOpenGLContext *context = 0;
+  if (!cpuRendering) {
+    context = new QOpenGLContext();
+    if (QOpenGLContext::currentContext())
+      context->setShareContext(QOpenGLContext::currentContext());
+    context->setFormat(QSurfaceFormat::defaultFormat());
+
+    if (!context->create()) {
+      delete context;
+      cpuRendering = true;
+    }
+  }
+
+  if (cpuRendering) {
+    // The texture stays premultiplied, and the mesh is drawn the same way
+    // tglDraw() does
+    TRasterP tileRas(tile.getRaster());
+    TRaster32P ras32(tileRas);
+    if (!ras32) ras32 = TRaster32P(tileRas->getSize());
+    ras32->clear();
+
+    MeshRasterizer::rasterize(
+        ras32, *mi, inTile.getRaster(), bbox, meshToTextureAff, *dataGroup,
+        meshToTileAff,
+        info.m_quality == TRenderSettings::HighResampleQuality
+            ? MeshRasterizer::BICUBIC
+            : MeshRasterizer::BILINEAR,
+        info.m_applyMask);
+
+    if (ras32.getPointer() != tileRas.getPointer()) {
+      TRop::convert(tileRas, ras32);
+      texInfo.m_bpp = 64;
+    }
+  } else
   // Draw the textured mesh
   {
     // Prepare texture
@@ -374,12 +415,7 @@ void PlasticDeformerFx::doCompute(TTile &tile, double frame,
     static TAtomicVar var;
     const std::string &texId = "render_tex " + std::to_string(++var);
 
-    // Prepare an OpenGL context
-    context = new QOpenGLContext();
-    if (QOpenGLContext::currentContext())
-      context->setShareContext(QOpenGLContext::currentContext());
-    context->setFormat(QSurfaceFormat::defaultFormat());
-    context->create();
+    // Prepare the OpenGL context
     context->makeCurrent(info.m_offScreenSurface.get());
 
     TDimension d = tile.getRaster()->getSize();
@@ -402,8 +438,7 @@ void PlasticDeformerFx::doCompute(TTile &tile, double frame,
 
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
-    tglMultMatrix(TTranslation(-tile.m_pos) * info.m_affine *
-                  meshToWorldMeshAff);
+    tglMultMatrix(meshToTileAff);
 
     glEnable(GL_BLEND);
     glEnable(GL_TEXTURE_2D);
@@ -458,14 +493,15 @@ void PlasticDeformerFx::doCompute(TTile &tile, double frame,
     context->doneCurrent();
     delete context;
 
-    if (info.m_applyMask) {
-      if (texInfo.m_invertedMask)
-        TRop::ropout(origTile.getRaster(), tile.getRaster(), tile.getRaster());
-      else
-        TRop::ropin(origTile.getRaster(), tile.getRaster(), tile.getRaster());
-    }
+    assert(glGetError() == GL_NO_ERROR);
+  }
+
+  if (info.m_applyMask) {
+    if (texInfo.m_invertedMask)
+      TRop::ropout(origTile.getRaster(), tile.getRaster(), tile.getRaster());
+    else
+      TRop::ropin(origTile.getRaster(), tile.getRaster(), tile.getRaster());
   }
-  assert(glGetError() == GL_NO_ERROR);
 }
 
 //-----------------------------------------------------------------------------------
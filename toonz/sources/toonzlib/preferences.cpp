@@ -474,6 +474,8 @@ void Preferences::definePreferenceItems() {
   // Visualization
   define(show0ThickLines, "show0ThickLines", QMetaType::Bool, true);
   define(regionAntialias, "regionAntialias", QMetaType::Bool, false);
+  define(cpuVectorRendering, "cpuVectorRendering", QMetaType::Bool, false);
+  define(cpuMeshRendering, "cpuMeshRendering", QMetaType::Bool, false);
 
   // Loading
   define(importPolicy, "importPolicy", QMetaType::Int, 0);  // Always ask
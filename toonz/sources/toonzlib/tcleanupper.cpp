@@ -18,6 +18,12 @@
 
 #include "toonz/tcleanupper.h"
 
+// Qt includes
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
 using namespace CleanupTypes;
 
 /*  The Cleanup Process Reworked   -   EXPLANATION (by Daniele)
@@ -311,6 +317,19 @@ void transparencyCheck(const TRasterCM32P &cmin, const TRaster32P &rasout) {
   }
 }
 
+//-------------------------------------------------------------------------
+
+// The autocenter and auto-adjust algorithms keep their state in static
+// variables, so frames processed concurrently must take turns there
+QMutex l_staticsMutex;
+
+//-------------------------------------------------------------------------
+
+inline bool isMainThread() {
+  return !QCoreApplication::instance() ||
+         QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
 }  // namespace
 
 //**************************************************************************************
@@ -330,6 +349,22 @@ void TCleanupper::setParameters(CleanupParameters *parameters) {
 
 //------------------------------------------------------------------------------------
 
+void TCleanupper::freezeTargetColors(bool frozen) {
+  if (frozen) updateTargetColors();
+  m_targetColorsFrozen = frozen;
+}
+
+//------------------------------------------------------------------------------------
+
+void TCleanupper::updateTargetColors() {
+  if (m_targetColorsFrozen) return;
+
+  m_parameters->m_colors.update(m_parameters->m_cleanupPalette.getPointer(),
+                                m_parameters->m_noAntialias);
+}
+
+//------------------------------------------------------------------------------------
+
 TPalette *TCleanupper::createToonzPaletteFromCleanupPalette() {
   TPalette *cleanupPalette = m_parameters->m_cleanupPalette.getPointer();
   return createToonzPalette(cleanupPalette, 1);
@@ -463,9 +498,13 @@ bool TCleanupper::getResampleValues(const TRasterImageP &image, TAffine &aff,
   TAffine pre_aff;
   image->getRaster()->lock();
 
-  bool autocentered =
-      doAutocenter(angle, skew, cxin, cyin, cqout, cpout, dpi.x, dpi.y,
-                   raster_is_savebox, saveBox, image, scalex);
+  bool autocentered;
+  {
+    QMutexLocker sl(&l_staticsMutex);
+    autocentered =
+        doAutocenter(angle, skew, cxin, cyin, cqout, cpout, dpi.x, dpi.y,
+                     raster_is_savebox, saveBox, image, scalex);
+  }
   image->getRaster()->unlock();
 
   // Build the image transform as deduced by the autocenter
@@ -512,8 +551,7 @@ TRasterP TCleanupper::processColors(const TRasterP &rin) {
   }
 
   // Copy current cleanup palette to parameters' colors
-  m_parameters->m_colors.update(m_parameters->m_cleanupPalette.getPointer(),
-                                m_parameters->m_noAntialias);
+  updateTargetColors();
 
   bool toGr8 = (m_parameters->m_lineProcessingMode == lpGrey);
   if (toGr8) {
@@ -578,7 +616,9 @@ CleanupPreprocessedImage *TCleanupper::process(
   bool isSameDpi    = false;
   bool autocentered = getResampleValues(image, aff, blur, outDim, outDpi,
                                         isCameraTest, isSameDpi);
-  if (m_parameters->m_autocenterType != AUTOCENTER_NONE && !autocentered)
+  // Frames processed on other threads report the failure in the result
+  if (m_parameters->m_autocenterType != AUTOCENTER_NONE && !autocentered &&
+      isMainThread())
     DVGui::warning(
         QObject::tr("The autocentering failed on the current drawing."));
 
@@ -588,6 +628,8 @@ CleanupPreprocessedImage *TCleanupper::process(
   // If necessary, perform auto-adjust
   if (!isCameraTest && m_parameters->m_lineProcessingMode != lpNone && toGr8 &&
       m_parameters->m_autoAdjustMode != AUTO_ADJ_NONE && !onlyForSwatch) {
+    QMutexLocker sl(&l_staticsMutex);
+
     static int ref_cum[256];
     UCHAR lut[256];
     int cum[256];
@@ -730,8 +772,7 @@ CleanupPreprocessedImage *TCleanupper::process(
   assert(finalRas);
 
   // Copy current cleanup palette to parameters' colors
-  m_parameters->m_colors.update(m_parameters->m_cleanupPalette.getPointer(),
-                                m_parameters->m_noAntialias);
+  updateTargetColors();
 
   if (toGr8) {
     // No (color) processing. Not even thresholding. This just means that all
@@ -12,9 +12,11 @@
 #include "tvectorimage.h"
 #include "timagecache.h"
 #include "timageinfo.h"
+#include "trop.h"
 #include "tropcm.h"
 #include "tofflinegl.h"
 #include "tvectorrenderdata.h"
+#include "tvectorrasterizer.h"
 
 // TnzBase includes
 #include "ttzpimagefx.h"
@@ -182,7 +184,7 @@ std::string getAlias(TXsheet *xsh, double frame, const TRenderSettings &info) {
     assert(fx);
     if (!fx) continue;
 
-    alias += fx->getAlias(frame, info) + ";";
+    alias += fx->getCachedAlias(frame, info) + ";";
   }
 
   return alias;
@@ -1074,6 +1076,33 @@ void TLevelColumnFx::doCompute(TTile &tile, double frame,
       if (info.m_quality == TRenderSettings::ClosestPixel_FilterResampleQuality)
         rd.m_antiAliasing = false;
 
+      if (!info.m_applyMask &&
+          Preferences::instance()->isCpuVectorRenderingEnabled() &&
+          TVectorRasterizer::isSupported(vectorImage.getPointer(), rd)) {
+        // Software rendering needs no GL context, so renders of this fx
+        // don't have to be serialized. The palette frame is still set under
+        // the fx mutex, and animated palettes stay locked until drawn.
+        bool lockPalette = !m_isCachable;
+        if (lockPalette) vpalette->mutex()->lock();
+        vpalette->setFrame((int)frame);
+
+        m.unlock();
+
+        TRasterP tileRas(tile.getRaster());
+        TRaster32P ras32(tileRas);
+        if (!ras32) ras32 = TRaster32P(size);
+        ras32->clear();
+
+        TVectorRasterizer::rasterize(ras32, vectorImage.getPointer(), rd);
+
+        vpalette->setFrame(oldFrame);
+        if (lockPalette) vpalette->mutex()->unlock();
+
+        if (ras32.getPointer() != tileRas.getPointer())
+          TRop::copy(tileRas, ras32);
+        return;
+      }
+
       if (!m_offlineContext || m_offlineContext->getLx() < size.lx ||
           m_offlineContext->getLy() < size.ly) {
         if (m_offlineContext) delete m_offlineContext;
@@ -1917,7 +1946,7 @@ std::string TZeraryColumnFx::getAlias(double frame,
     }
   }
 
-  return "TZeraryColumnFx[" + m_fx->getAlias(frame, info) + rdata + "]";
+  return "TZeraryColumnFx[" + m_fx->getCachedAlias(frame, info) + rdata + "]";
 }
 
 //-------------------------------------------------------------------
@@ -1996,9 +2025,9 @@ std::string TXsheetFx::getAlias(double frame,
   TFxSet *terminalFxs = m_fxDag->getTerminalFxs();
   int i, fxsCount = terminalFxs->getFxCount();
   for (i = 0; i < fxsCount; ++i) {
-    alias +=
-        static_cast<TRasterFx *>(terminalFxs->getFx(i))->getAlias(frame, info) +
-        ",";
+    alias += static_cast<TRasterFx *>(terminalFxs->getFx(i))
+                 ->getCachedAlias(frame, info) +
+             ",";
   }
 
   return alias + "]";
@@ -30,6 +30,7 @@
 #include "toonz/txshpalettelevel.h"
 #include "toonz/toonzfolders.h"
 #include "toonz/tcolumnfx.h"
+#include "toonz/imagemanager.h"
 
 #include "toonzqt/dvdialog.h"
 
@@ -747,6 +748,17 @@ int ToonzScene::getFrameCount() const {
 void ToonzScene::renderFrame(const TRaster32P &ras, int row, const TXsheet *xsh,
                              bool checkFlags, bool forSceneIcon,
                              bool forReference) const {
+  renderFrame(ras, ras->getBounds(), ras->getSize(), row, xsh, checkFlags,
+              forSceneIcon, forReference);
+}
+
+//-----------------------------------------------------------------------------
+
+void ToonzScene::renderFrame(const TRaster32P &ras, const TRect &rect,
+                             const TDimension &frameSize, int row,
+                             const TXsheet *xsh, bool checkFlags,
+                             bool forSceneIcon, bool forReference) const {
+  assert(ras->getSize() == rect.getSize());
   if (xsh == 0) xsh = getXsheet();
 
   TCamera *camera        = xsh->getStageObjectTree()->getCurrentCamera();
@@ -754,13 +766,18 @@ void ToonzScene::renderFrame(const TRaster32P &ras, int row, const TXsheet *xsh,
   TDimensionD cameraSize = camera->getSize();
 
   // voglio che la camera sia completamente contenuta dentro raster
-  double sx = (double)ras->getLx() / (double)cameraSize.lx;
-  double sy = (double)ras->getLy() / (double)cameraSize.ly;
+  double sx = (double)frameSize.lx / (double)cameraSize.lx;
+  double sy = (double)frameSize.ly / (double)cameraSize.ly;
   double sc = (sx < sy) ? sx : sy;
 
+  // Shift the frame so that rect lands on the raster, which is centered below
+  TPointD rectShift(0.5 * (frameSize.lx - ras->getLx()) - rect.x0,
+                    0.5 * (frameSize.ly - ras->getLy()) - rect.y0);
+
   const TAffine &cameraAff =
       xsh->getPlacement(xsh->getStageObjectTree()->getCurrentCameraId(), row);
-  const TAffine &viewAff = TScale(sc / Stage::inch) * cameraAff.inv();
+  const TAffine &viewAff =
+      TTranslation(rectShift) * TScale(sc / Stage::inch) * cameraAff.inv();
 
   TRect clipRect(ras->getBounds());
   TOfflineGL ogl(ras->getSize());
@@ -1280,6 +1297,16 @@ TXshLevel *ToonzScene::loadLevel(const TFilePath &actualPath,
 
     m_levelSet->insertLevel(xl);
 
+    // Load in background the first frames, which are usually shown next
+    if (xl->getType() == TZP_XSHLEVEL && levelPath.getType() == "tlv") {
+      static const int PrefetchFrames = 8;
+
+      std::vector<TFrameId> fids;
+      xl->getFids(fids);
+      if ((int)fids.size() > PrefetchFrames) fids.resize(PrefetchFrames);
+      ImageManager::instance()->prefetchInBackground(xl, fids);
+    }
+
     return xl;
   }
 
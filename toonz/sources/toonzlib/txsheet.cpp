@@ -38,8 +38,10 @@
 
 #include "toonz/txsheet.h"
 #include "toonz/preferences.h"
+#include "toonz/imagemanager.h"
 
 // STD includes
+#include <algorithm>
 #include <set>
 
 using namespace std;
@@ -83,6 +85,45 @@ void setColumnName(TXsheet *xsh, int col) {
   if (!name.empty()) obj->setName(name);
 }
 
+//-----------------------------------------------------------------------------
+
+typedef std::vector<std::pair<TXshSimpleLevel *, std::vector<TFrameId>>>
+    LevelFrames;
+
+void collectTlvFrames(const TXsheet *xsh, const std::vector<int> &rows,
+                      LevelFrames &levelFrames) {
+  for (int c = 0; c < xsh->getColumnCount(); ++c) {
+    for (int i = 0; i < (int)rows.size(); ++i) {
+      const TXshCell &cell = xsh->getCell(rows[i], c);
+      if (cell.isEmpty()) continue;
+
+      if (TXshChildLevel *cl = cell.getChildLevel()) {
+        collectTlvFrames(cl->getXsheet(),
+                         std::vector<int>(1, cell.getFrameId().getNumber() - 1),
+                         levelFrames);
+        continue;
+      }
+
+      TXshSimpleLevel *sl = cell.getSimpleLevel();
+      if (!sl || sl->getType() != TZP_XSHLEVEL ||
+          sl->getPath().getType() != "tlv")
+        continue;
+
+      // Frames are kept in request order, as they are built in that order
+      LevelFrames::iterator lt = levelFrames.begin();
+      while (lt != levelFrames.end() && lt->first != sl) ++lt;
+      if (lt == levelFrames.end())
+        lt = levelFrames.insert(lt,
+                                std::make_pair(sl, std::vector<TFrameId>()));
+
+      const TFrameId &fid = cell.getFrameId();
+      if (std::find(lt->second.begin(), lt->second.end(), fid) ==
+          lt->second.end())
+        lt->second.push_back(fid);
+    }
+  }
+}
+
 }  // namespace
 
 //=============================================================================
@@ -388,6 +429,25 @@ void TXsheet::getCells(int row, int col, int rowCount, TXshCell cells[],
 
 //-----------------------------------------------------------------------------
 
+void TXsheet::getTlvFrames(const std::vector<int> &rows,
+                           LevelFrames &levelFrames) const {
+  levelFrames.clear();
+  collectTlvFrames(this, rows, levelFrames);
+}
+
+//-----------------------------------------------------------------------------
+
+void TXsheet::prefetchRows(const std::vector<int> &rows) const {
+  LevelFrames levelFrames;
+  getTlvFrames(rows, levelFrames);
+
+  for (int l = 0; l < (int)levelFrames.size(); ++l)
+    ImageManager::instance()->prefetchInBackground(levelFrames[l].first,
+                                                   levelFrames[l].second);
+}
+
+//-----------------------------------------------------------------------------
+
 bool TXsheet::setCells(int row, int col, int rowCount, const TXshCell cells[]) {
   static const TXshCell emptyCell;
   int i = 0;
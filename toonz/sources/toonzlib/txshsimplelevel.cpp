@@ -587,6 +587,17 @@ TImageP TXshSimpleLevel::getFrame(const TFrameId &fid, UCHAR imFlags,
 
 //-----------------------------------------------------------------------------
 
+TImageP TXshSimpleLevel::getFrameById(const std::string &imageId,
+                                      const TFrameId &fid) const {
+  assert(m_type != UNKNOWN_XSHLEVEL);
+
+  ImageLoader::BuildExtData extData(this, fid);
+  return ImageManager::instance()->getImage(imageId, ImageManager::none,
+                                            &extData);
+}
+
+//-----------------------------------------------------------------------------
+
 TImageInfo *TXshSimpleLevel::getFrameInfo(const TFrameId &fid,
                                           bool toBeModified) {
   assert(m_type != UNKNOWN_XSHLEVEL);
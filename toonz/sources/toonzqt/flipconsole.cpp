@@ -826,9 +826,15 @@ void FlipConsole::onNextFrame(int fps, QElapsedTimer *timer,
     playNextFrame(timer, targetInstant);
 
   if (fps == -1) return;
-  if (m_fpsLabel)
+  if (m_fpsLabel) {
     m_fpsLabel->setText(tr(" FPS ") + QString::number(fps * tsign(m_fps)) +
                         "/");
+    m_fpsLabel->setToolTip(tr("Achieved: %1 fps, target: %2 fps\n"
+                              "Frames ready in advance: %3%")
+                               .arg(fps)
+                               .arg(abs(m_fps))
+                               .arg(m_prefetcher.getReadyPercentage()));
+  }
   if (m_fpsField) {
     if (fps == abs(m_fps))
       m_fpsField->setLineEditBackgroundColor(Qt::green);
@@ -888,6 +894,8 @@ void FlipConsole::playNextFrame(QElapsedTimer *timer, qint64 targetInstant) {
     else
       m_currentFrame =
           ((m_currentFrame + m_step > to) ? from : m_currentFrame + m_step);
+
+    prefetchFrames(from, to);
   }
 
   m_currFrameSlider->setValue(m_currentFrame);
@@ -903,6 +911,32 @@ void FlipConsole::playNextFrame(QElapsedTimer *timer, qint64 targetInstant) {
 
 //-----------------------------------------------------------------------------
 
+//! Lets the owner build the frame about to be drawn and the following ones,
+//! in play order, on background threads.
+void FlipConsole::prefetchFrames(int from, int to) {
+  std::vector<int> frames(1, m_currentFrame);
+
+  // Follow playNextFrame()
+  int frame    = m_currentFrame;
+  bool reverse = m_reverse;
+  while ((int)frames.size() < m_prefetcher.getCapacity()) {
+    if (m_isPingPong && (frame <= from || frame >= to)) reverse = !reverse;
+    if (m_isPlay && frame == (reverse ? from : to)) break;
+
+    if (reverse)
+      frame = (frame - m_step < from) ? to : frame - m_step;
+    else
+      frame = (frame + m_step > to) ? from : frame + m_step;
+    frames.push_back(frame);
+  }
+
+  FlipConsoleOwner *owner = m_consoleOwner;
+  m_prefetcher.schedule(
+      frames, [owner](int frame) { return owner->getFrameBuilder(frame); });
+}
+
+//-----------------------------------------------------------------------------
+
 void FlipConsole::updateCurrentFPS(int val) {
   setCurrentFPS(val);
   m_fpsSlider->setValue(m_fps);
@@ -1750,6 +1784,9 @@ void FlipConsole::doButtonPressed(UINT button) {
       if (m_fpsField) m_fpsField->setLineEditBackgroundColor(Qt::red);
     }
 
+    m_prefetcher.clear();
+    m_prefetcher.resetStatistics();
+
     m_playbackExecutor.resetFps(m_isInbetweenFlip
                                     ? ((float)m_inbetweenFlipDrawings /
                                        ((float)m_inbetweenFlipSpeed / 1000.0))
@@ -1798,6 +1835,7 @@ void FlipConsole::doButtonPressed(UINT button) {
     m_isLinkedPlaying = false;
 
     if (m_playbackExecutor.isRunning()) m_playbackExecutor.abort();
+    m_prefetcher.clear();
     m_stopAt       = -1;
     m_startAt      = -1;
     m_isPlay       = false;
@@ -2074,6 +2112,7 @@ void FlipConsole::setFrameRange(int from, int to, int step, int current) {
     m_currFrameSlider->setRange(m_from, m_to);
     m_currFrameSlider->setSingleStep(m_step);
     m_currFrameSlider->blockSignals(false);
+    m_prefetcher.clear();
   }
 
   if (m_playbackExecutor.isRunning() ||
@@ -512,11 +512,17 @@ QPainterPath FunctionPanel::getSegmentPainterPath(TDoubleParam *curve,
     path.lineTo(getWinPos(curve, frame1, curve->getValue(frame1, true)));
   } else {
     // step = 1
-    path.moveTo(getWinPos(curve, frame));
+    std::vector<double> frames(1, frame);
     while (frame + df < frame1) {
       frame += df;
-      path.lineTo(getWinPos(curve, frame));
+      frames.push_back(frame);
     }
+    std::vector<double> values(frames.size());
+    curve->getValues(&frames[0], (int)frames.size(), &values[0]);
+
+    path.moveTo(getWinPos(curve, frames[0], values[0]));
+    for (int i = 1; i < (int)frames.size(); ++i)
+      path.lineTo(getWinPos(curve, frames[i], values[i]));
     path.lineTo(getWinPos(curve, frame1, curve->getValue(frame1, true)));
   }
   return path;
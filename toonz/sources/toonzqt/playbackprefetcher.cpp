@@ -0,0 +1,188 @@
+#include "toonzqt/playbackprefetcher.h"
+
+// Qt includes
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+// STD includes
+#include <algorithm>
+
+namespace {
+
+const int c_defaultCapacity = 8;
+
+}  // namespace
+
+//=============================================================================
+//    PlaybackPrefetcher::Ring
+//-----------------------------------------------------------------------------
+
+struct PlaybackPrefetcher::Ring {
+  struct Slot {
+    int m_frame;
+    TUINT64 m_id;  // Identifies the build of the frame
+    TImageP m_image;
+    bool m_built;
+  };
+
+  QMutex m_mutex;
+  std::vector<Slot> m_slots;  // In play order
+  TUINT64 m_lastId;
+
+  Ring() : m_lastId(0) {}
+
+  Slot *findSlot(int frame) {
+    for (Slot &slot : m_slots)
+      if (slot.m_frame == frame) return &slot;
+    return 0;
+  }
+};
+
+//=============================================================================
+//    PlaybackPrefetcher::BuildTask
+//-----------------------------------------------------------------------------
+
+class PlaybackPrefetcher::BuildTask final : public TThread::Runnable {
+  std::shared_ptr<Ring> m_ring;
+  int m_frame;
+  TUINT64 m_id;
+  FrameBuilder m_builder;
+
+public:
+  BuildTask(const std::shared_ptr<Ring> &ring, int frame, TUINT64 id,
+            const FrameBuilder &builder)
+      : m_ring(ring), m_frame(frame), m_id(id), m_builder(builder) {}
+
+  void run() override {
+    if (!isExpected()) return;
+
+    TImageP img;
+    try {
+      img = m_builder();
+    } catch (...) {
+    }
+
+    QMutexLocker sl(&m_ring->m_mutex);
+    Ring::Slot *slot = m_ring->findSlot(m_frame);
+    if (slot && slot->m_id == m_id) {
+      slot->m_image = img;
+      slot->m_built = true;
+    }
+  }
+
+private:
+  bool isExpected() {
+    QMutexLocker sl(&m_ring->m_mutex);
+    Ring::Slot *slot = m_ring->findSlot(m_frame);
+    return slot && slot->m_id == m_id;
+  }
+};
+
+//=============================================================================
+//    PlaybackPrefetcher
+//-----------------------------------------------------------------------------
+
+PlaybackPrefetcher::PlaybackPrefetcher()
+    : m_ring(new Ring)
+    , m_capacity(c_defaultCapacity)
+    , m_hitsCount(0)
+    , m_missesCount(0) {
+  // Leave a core to the playing thread
+  m_executor.setMaxActiveTasks(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+//-----------------------------------------------------------------------------
+
+PlaybackPrefetcher::~PlaybackPrefetcher() { clear(); }
+
+//-----------------------------------------------------------------------------
+
+void PlaybackPrefetcher::setCapacity(int framesCount) {
+  m_capacity = std::max(framesCount, 0);
+
+  QMutexLocker sl(&m_ring->m_mutex);
+  if ((int)m_ring->m_slots.size() > m_capacity)
+    m_ring->m_slots.resize(m_capacity);
+}
+
+//-----------------------------------------------------------------------------
+
+void PlaybackPrefetcher::schedule(
+    const std::vector<int> &frames,
+    const std::function<FrameBuilder(int frame)> &getBuilder) {
+  std::vector<Ring::Slot> newSlots;
+  {
+    QMutexLocker sl(&m_ring->m_mutex);
+
+    std::vector<Ring::Slot> expectedSlots;
+    for (int frame : frames) {
+      if ((int)expectedSlots.size() >= m_capacity) break;
+
+      // Ping-pong on short ranges may expect a frame twice
+      bool found = false;
+      for (const Ring::Slot &slot : expectedSlots)
+        if (slot.m_frame == frame) found = true;
+      if (found) continue;
+
+      if (Ring::Slot *slot = m_ring->findSlot(frame))
+        expectedSlots.push_back(*slot);
+      else {
+        Ring::Slot newSlot = {frame, ++m_ring->m_lastId, TImageP(), false};
+        expectedSlots.push_back(newSlot);
+        newSlots.push_back(newSlot);
+      }
+    }
+
+    // Frames left out are stale: their images are released, and their
+    // pending builds will find no slot
+    m_ring->m_slots.swap(expectedSlots);
+  }
+
+  // Builds are queued in play order, and the executor runs them first come,
+  // first served
+  for (const Ring::Slot &slot : newSlots) {
+    FrameBuilder builder = getBuilder(slot.m_frame);
+    if (builder)
+      m_executor.addTask(
+          new BuildTask(m_ring, slot.m_frame, slot.m_id, builder));
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+TImageP PlaybackPrefetcher::takeImage(int frame) {
+  TImageP img;
+  bool built;
+  {
+    QMutexLocker sl(&m_ring->m_mutex);
+    Ring::Slot *slot = m_ring->findSlot(frame);
+    if (!slot) return img;
+
+    std::swap(img, slot->m_image);
+    built = slot->m_built;
+  }
+
+  if (built)
+    ++m_hitsCount;
+  else
+    ++m_missesCount;
+
+  return img;
+}
+
+//-----------------------------------------------------------------------------
+
+void PlaybackPrefetcher::clear() {
+  m_executor.cancelAll();
+
+  QMutexLocker sl(&m_ring->m_mutex);
+  m_ring->m_slots.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+int PlaybackPrefetcher::getReadyPercentage() const {
+  int count = m_hitsCount + m_missesCount;
+  return count ? (100 * m_hitsCount) / count : 0;
+}
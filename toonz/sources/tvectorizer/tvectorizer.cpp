@@ -0,0 +1,284 @@
+// TnzLib includes
+#include "toonz/toonzscene.h"
+#include "toonz/preferences.h"
+#include "toonz/sceneproperties.h"
+#include "toonz/vectorizerparameters.h"
+#include "toonz/levelvectorizer.h"
+#include "toonz/stage.h"
+
+// TnzBase includes
+#include "tcli.h"
+#include "tenv.h"
+
+// TnzCore includes
+#include "tsystem.h"
+#include "tthread.h"
+#include "tconvert.h"
+#include "tiio_std.h"
+#include "timage_io.h"
+#include "tnzimage.h"
+#include "tlevel.h"
+#include "tlevel_io.h"
+#include "tpalette.h"
+#include "tcolorstyles.h"
+#include "trasterimage.h"
+#include "ttoonzimage.h"
+#include "tvectorimage.h"
+
+// Qt includes
+#include <QCoreApplication>
+
+// STD includes
+#include <algorithm>
+
+using namespace std;
+using namespace TCli;
+
+typedef QualifierT<TFilePath> FilePathQualifier;
+
+const char *rootVarName     = "TAHOMA2DROOT";
+const char *systemVarPrefix = "TAHOMA2D";
+
+namespace {
+
+//--------------------------------------------------------------------
+
+// Returns the frame ids of the level in the specified range
+vector<TFrameId> getFrameIds(const RangeQualifier &range,
+                             const TLevelP &level) {
+  TFrameId r0, r1;
+  if (range.isSelected()) {
+    r0 = TFrameId(range.getFrom());
+    r1 = TFrameId(range.getTo());
+    if (r1 < r0) std::swap(r0, r1);
+  }
+
+  vector<TFrameId> frames;
+
+  TLevel::Iterator it;
+  for (it = level->begin(); it != level->end(); ++it) {
+    if (range.isSelected() && (it->first < r0 || r1 < it->first)) continue;
+    frames.push_back(it->first);
+  }
+
+  return frames;
+}
+
+//--------------------------------------------------------------------
+
+// Builds the palette of the vectorized level. As in the Convert-to-Vector
+// popup, MyPaint styles of Toonz raster palettes are replaced by solid
+// color styles, which can be rendered in vector levels.
+TPalette *buildPalette(const TLevelP &level) {
+  TPalette *palette;
+  if (level->getPalette()) {
+    palette = level->getPalette()->clone();
+    for (int s = 0; s < palette->getStyleCount(); s++) {
+      TColorStyle *style = palette->getStyle(s);
+      if (style->getTagId() == 4001)  // TMyPaintBrushStyle
+        palette->setStyle(s, style->getMainColor());
+    }
+  } else
+    palette = new TPalette;
+
+  return palette;
+}
+
+//--------------------------------------------------------------------
+
+// Returns the image-to-level transform, from the image dpi
+TAffine getDpiAffine(const TImageP &img) {
+  double dpix = 0, dpiy = 0;
+  if (TToonzImageP ti = img)
+    ti->getDpi(dpix, dpiy);
+  else if (TRasterImageP ri = img)
+    ri->getDpi(dpix, dpiy);
+
+  if (dpix == 0 || dpiy == 0)
+    dpix = dpiy = Preferences::instance()->getDefLevelDpi();
+
+  return TScale(Stage::inch / dpix, Stage::inch / dpiy);
+}
+
+//--------------------------------------------------------------------
+
+// Writes the oldest vectorized frame. Frames are written in order, as soon
+// as they are done.
+void writeFrame(LevelVectorizer &levelVectorizer, const TLevelWriterP &lw) {
+  TFrameId fid;
+  TVectorImageP vi = levelVectorizer.takeFrame(fid);
+  if (!vi) {
+    cout << "Frame " << fid.expand() << ": vectorization failed!" << endl;
+    return;
+  }
+
+  try {
+    TFrameId dstFid = fid;
+    if (dstFid.getNumber() < 0) dstFid = TFrameId(1, fid.getLetter());
+
+    lw->getFrameWriter(dstFid)->save(vi);
+    cout << "Frame " << fid.expand() << " vectorized" << endl;
+  } catch (...) {
+    cout << "Frame " << fid.expand() << ": saving failed!" << endl;
+  }
+}
+
+//--------------------------------------------------------------------
+
+void vectorize(const TFilePath &source, const TFilePath &dest,
+               const RangeQualifier &range,
+               const VectorizerParameters &params, int threadsCount) {
+  TLevelReaderP lr(source);
+  TLevelP level = lr->loadInfo();
+
+  vector<TFrameId> frames = getFrameIds(range, level);
+  if (frames.empty()) {
+    cout << "No frames to vectorize." << endl;
+    return;
+  }
+
+  TPaletteP palette = buildPalette(level);
+  palette->setPaletteName(dest.getWideName());
+
+  cout << "Level loaded" << endl;
+  cout << "Vectorization in progress: wait please..." << endl;
+
+  double frameRange[2] = {static_cast<double>(frames.front().getNumber()) - 1,
+                          static_cast<double>(frames.back().getNumber()) - 1};
+
+  TLevelWriterP lw(dest);
+
+  {
+    LevelVectorizer levelVectorizer(params, palette, threadsCount);
+
+    for (const TFrameId &fid : frames) {
+      TImageP img;
+      try {
+        img = lr->getFrameReader(fid)->load();
+      } catch (...) {
+      }
+
+      if (!TToonzImageP(img) && !TRasterImageP(img)) {
+        cout << "Frame " << fid.expand() << ": loading failed!" << endl;
+        continue;
+      }
+
+      double weight = (fid.getNumber() - 1 - frameRange[0]) /
+                      std::max(frameRange[1] - frameRange[0], 1.0);
+      weight = tcrop(weight, 0.0, 1.0);
+
+      levelVectorizer.addFrame(fid, img, getDpiAffine(img), weight);
+
+      // Write the frames done before loading more
+      while (levelVectorizer.isFull()) writeFrame(levelVectorizer, lw);
+    }
+
+    while (levelVectorizer.getQueuedCount() > 0)
+      writeFrame(levelVectorizer, lw);
+  }
+
+  // The level, and its palette, are written when the writer is released
+  lw = TLevelWriterP();
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  TEnv::setRootVarName(rootVarName);
+  TEnv::setSystemVarPrefix(systemVarPrefix);
+  TEnv::setApplicationFileName(argv[0]);
+
+  string msg;
+  TCli::FilePathArgument srcName("srcName", "Source level");
+  TCli::FilePathArgument dstName("dstName", "Target pli level");
+  FilePathQualifier tnzName("-s sceneName",
+                            "Scene file providing the vectorizer settings");
+  SimpleQualifier outline("-outline", "Outline vectorization");
+  IntQualifier threads("-t threads", "Number of frames vectorized at once");
+  RangeQualifier range;
+
+  Usage usage(argv[0]);
+  usage.add(srcName + dstName + tnzName + outline + threads + range);
+  if (!usage.parse(argc, argv)) exit(1);
+
+  try {
+    Tiio::defineStd();
+    initImageIo();
+
+    TSystem::hasMainLoop(false);
+    TThread::init();
+
+    TFilePath srcFilePath = srcName.getValue();
+    TFilePath dstFilePath = dstName.getValue();
+    if (!TSystem::doesExistFileOrLevel(srcFilePath)) {
+      msg = srcFilePath.getLevelName() + " level doesn't exist.";
+      cout << endl << msg << endl;
+      exit(1);
+    }
+
+    string srcExt = srcFilePath.getType();
+    if (srcExt == "pli" || srcExt == "svg") {
+      cout << "Cannot vectorize a vector level." << endl;
+      exit(1);
+    }
+    if (dstFilePath.getType() != "pli") {
+      cout << "The target level must be a .pli level." << endl;
+      exit(1);
+    }
+    if (dstFilePath.getParentDir().isEmpty())
+      dstFilePath = srcFilePath.getParentDir() + dstFilePath;
+
+    VectorizerParameters params;
+    if (tnzName.isSelected()) {
+      TFilePath tnzFilePath = tnzName.getValue();
+      if (tnzFilePath.getType() != "tnz" ||
+          !TSystem::doesExistFileOrLevel(tnzFilePath)) {
+        cout << "Invalid scene file: vectorization terminated!" << endl;
+        exit(1);
+      }
+
+      ToonzScene scene;
+      try {
+        scene.loadTnzFile(tnzFilePath);
+      } catch (...) {
+        msg = "There were problems loading the scene " +
+              ::to_string(tnzFilePath) + ".\n Some files may be missing.";
+        cout << msg << endl;
+      }
+
+      params = *scene.getProperties()->getVectorizerParameters();
+    }
+    if (outline) params.m_isOutline = true;
+
+    int threadsCount = threads.isSelected() ? threads.getValue() : 0;
+
+    if (TSystem::doesExistFileOrLevel(dstFilePath)) {
+      cout << "Replacing " << dstFilePath.getLevelName() << endl;
+      TSystem::removeFileOrLevel(dstFilePath);
+    }
+
+    msg = "Loading " + srcFilePath.getLevelName();
+    cout << endl << msg << endl;
+
+    vectorize(srcFilePath, dstFilePath, range, params, threadsCount);
+  } catch (TException &e) {
+    msg = "Untrapped exception: " + ::to_string(e.getMessage());
+    cout << msg << endl;
+    TThread::shutdown();
+    return -1;
+  } catch (...) {
+    cout << "Unhandled exception" << endl;
+    TThread::shutdown();
+    return -1;
+  }
+
+  TThread::shutdown();
+
+  msg = "Vectorization terminated!";
+  cout << endl << msg << endl;
+  return 0;
+}